@@ -4,6 +4,8 @@
  * Implementation of the main game initialization functions.
  */
 #include <array>
+#include <string>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -26,10 +28,12 @@
 #include "drlg_l4.h"
 #include "dx.h"
 #include "encrypt.h"
+#include "engine/asset_preloader.hpp"
 #include "engine/cel_sprite.hpp"
 #include "engine/load_cel.hpp"
 #include "engine/load_file.hpp"
 #include "engine/random.hpp"
+#include "engine/render/dun_render.hpp"
 #include "error.h"
 #include "gamemenu.h"
 #include "gmenu.h"
@@ -50,6 +54,7 @@
 #include "qol/common.h"
 #include "qol/itemlabels.h"
 #include "restrict.h"
+#include "scrollrt.h"
 #include "setmaps.h"
 #include "stores.h"
 #include "storm/storm.h"
@@ -162,6 +167,11 @@ bool was_window_init = false;
 bool was_ui_init = false;
 bool was_snd_init = false;
 
+/** Files that were read while loading each dungeon level, used to preload the level on the next visit. */
+std::array<std::vector<std::string>, NUMLEVELS> LevelFileManifests;
+/** The level that PreloadLevelAssets() was last called for since the current level was loaded. */
+int PreloadedLevel = -1;
+
 void StartGame(interface_mode uMsg)
 {
 	zoomflag = true;
@@ -1057,6 +1067,7 @@ void DiabloDeinit()
 #endif
 	if (was_ui_init)
 		UiDestroy();
+	AssetPreloaderCleanup();
 	if (was_archives_init)
 		init_cleanup();
 	if (was_window_init)
@@ -1067,66 +1078,56 @@ void DiabloDeinit()
 		SDL_Quit();
 }
 
-void LoadLvlGFX()
-{
-	assert(pDungeonCels == nullptr);
-	constexpr int SpecialCelWidth = 64;
+/** @brief The tile graphics of a level type. */
+struct LevelGfxFiles {
+	const char *cel;
+	const char *til;
+	const char *min;
+	const char *special;
+};
 
-	switch (leveltype) {
+LevelGfxFiles GetLevelGfxFiles(dungeon_type type, int level)
+{
+	switch (type) {
 	case DTYPE_TOWN:
-		if (gbIsHellfire) {
-			pDungeonCels = LoadFileInMem("NLevels\\TownData\\Town.CEL");
-			pMegaTiles = LoadFileInMem<MegaTile>("NLevels\\TownData\\Town.TIL");
-			pLevelPieces = LoadFileInMem<uint16_t>("NLevels\\TownData\\Town.MIN");
-		} else {
-			pDungeonCels = LoadFileInMem("Levels\\TownData\\Town.CEL");
-			pMegaTiles = LoadFileInMem<MegaTile>("Levels\\TownData\\Town.TIL");
-			pLevelPieces = LoadFileInMem<uint16_t>("Levels\\TownData\\Town.MIN");
-		}
-		pSpecialCels = LoadCel("Levels\\TownData\\TownS.CEL", SpecialCelWidth);
-		break;
+		if (gbIsHellfire)
+			return { "NLevels\\TownData\\Town.CEL", "NLevels\\TownData\\Town.TIL", "NLevels\\TownData\\Town.MIN", "Levels\\TownData\\TownS.CEL" };
+		return { "Levels\\TownData\\Town.CEL", "Levels\\TownData\\Town.TIL", "Levels\\TownData\\Town.MIN", "Levels\\TownData\\TownS.CEL" };
 	case DTYPE_CATHEDRAL:
-		if (currlevel < 21) {
-			pDungeonCels = LoadFileInMem("Levels\\L1Data\\L1.CEL");
-			pMegaTiles = LoadFileInMem<MegaTile>("Levels\\L1Data\\L1.TIL");
-			pLevelPieces = LoadFileInMem<uint16_t>("Levels\\L1Data\\L1.MIN");
-			pSpecialCels = LoadCel("Levels\\L1Data\\L1S.CEL", SpecialCelWidth);
-		} else {
-			pDungeonCels = LoadFileInMem("NLevels\\L5Data\\L5.CEL");
-			pMegaTiles = LoadFileInMem<MegaTile>("NLevels\\L5Data\\L5.TIL");
-			pLevelPieces = LoadFileInMem<uint16_t>("NLevels\\L5Data\\L5.MIN");
-			pSpecialCels = LoadCel("NLevels\\L5Data\\L5S.CEL", SpecialCelWidth);
-		}
-		break;
+		if (level < 21)
+			return { "Levels\\L1Data\\L1.CEL", "Levels\\L1Data\\L1.TIL", "Levels\\L1Data\\L1.MIN", "Levels\\L1Data\\L1S.CEL" };
+		return { "NLevels\\L5Data\\L5.CEL", "NLevels\\L5Data\\L5.TIL", "NLevels\\L5Data\\L5.MIN", "NLevels\\L5Data\\L5S.CEL" };
 	case DTYPE_CATACOMBS:
-		pDungeonCels = LoadFileInMem("Levels\\L2Data\\L2.CEL");
-		pMegaTiles = LoadFileInMem<MegaTile>("Levels\\L2Data\\L2.TIL");
-		pLevelPieces = LoadFileInMem<uint16_t>("Levels\\L2Data\\L2.MIN");
-		pSpecialCels = LoadCel("Levels\\L2Data\\L2S.CEL", SpecialCelWidth);
-		break;
+		return { "Levels\\L2Data\\L2.CEL", "Levels\\L2Data\\L2.TIL", "Levels\\L2Data\\L2.MIN", "Levels\\L2Data\\L2S.CEL" };
 	case DTYPE_CAVES:
-		if (currlevel < 17) {
-			pDungeonCels = LoadFileInMem("Levels\\L3Data\\L3.CEL");
-			pMegaTiles = LoadFileInMem<MegaTile>("Levels\\L3Data\\L3.TIL");
-			pLevelPieces = LoadFileInMem<uint16_t>("Levels\\L3Data\\L3.MIN");
-		} else {
-			pDungeonCels = LoadFileInMem("NLevels\\L6Data\\L6.CEL");
-			pMegaTiles = LoadFileInMem<MegaTile>("NLevels\\L6Data\\L6.TIL");
-			pLevelPieces = LoadFileInMem<uint16_t>("NLevels\\L6Data\\L6.MIN");
-		}
-		pSpecialCels = LoadCel("Levels\\L1Data\\L1S.CEL", SpecialCelWidth);
-		break;
+		if (level < 17)
+			return { "Levels\\L3Data\\L3.CEL", "Levels\\L3Data\\L3.TIL", "Levels\\L3Data\\L3.MIN", "Levels\\L1Data\\L1S.CEL" };
+		return { "NLevels\\L6Data\\L6.CEL", "NLevels\\L6Data\\L6.TIL", "NLevels\\L6Data\\L6.MIN", "Levels\\L1Data\\L1S.CEL" };
 	case DTYPE_HELL:
-		pDungeonCels = LoadFileInMem("Levels\\L4Data\\L4.CEL");
-		pMegaTiles = LoadFileInMem<MegaTile>("Levels\\L4Data\\L4.TIL");
-		pLevelPieces = LoadFileInMem<uint16_t>("Levels\\L4Data\\L4.MIN");
-		pSpecialCels = LoadCel("Levels\\L2Data\\L2S.CEL", SpecialCelWidth);
-		break;
+		return { "Levels\\L4Data\\L4.CEL", "Levels\\L4Data\\L4.TIL", "Levels\\L4Data\\L4.MIN", "Levels\\L2Data\\L2S.CEL" };
 	default:
-		app_fatal("LoadLvlGFX");
+		return { nullptr, nullptr, nullptr, nullptr };
 	}
 }
 
+void LoadLvlGFX()
+{
+	assert(pDungeonCels.Data() == nullptr);
+	constexpr int SpecialCelWidth = 64;
+
+	const LevelGfxFiles files = GetLevelGfxFiles(leveltype, currlevel);
+	if (files.cel == nullptr)
+		app_fatal("LoadLvlGFX");
+
+	pDungeonCels = LoadAssetView(files.cel, alignof(std::uint32_t));
+	pMegaTiles = LoadFileInMem<MegaTile>(files.til);
+	size_t pieceCount;
+	pLevelPieces = LoadFileInMem<uint16_t>(files.min, &pieceCount);
+	pSpecialCels = LoadCel(files.special, SpecialCelWidth);
+	if (sgOptions.Graphics.bTileAtlas)
+		BuildTileAtlas(pLevelPieces.get(), pieceCount);
+}
+
 void LoadAllGFX()
 {
 	IncProgress();
@@ -1242,6 +1243,7 @@ void GameLogic()
 	sound_update();
 	ClearPlrMsg();
 	CheckTriggers();
+	PreloadNextLevel();
 	CheckQuests();
 	force_redraw |= 1;
 	pfile_update(false);
@@ -1584,7 +1586,9 @@ void FreeGameMem()
 {
 	music_stop();
 
-	pDungeonCels = nullptr;
+	FreeTileAtlas();
+	FreeFloorCache();
+	pDungeonCels = {};
 	pMegaTiles = nullptr;
 	pLevelPieces = nullptr;
 	pSpecialCels = std::nullopt;
@@ -1867,8 +1871,33 @@ void DisableInputWndProc(uint32_t uMsg, int32_t /*wParam*/, int32_t lParam)
 	MainWndProc(uMsg);
 }
 
+void PreloadLevelAssets(int level)
+{
+	if (level < 0 || level >= NUMLEVELS || level == PreloadedLevel || (level == currlevel && !setlevel))
+		return;
+	PreloadedLevel = level;
+
+	const std::vector<std::string> &manifest = LevelFileManifests[level];
+	if (!manifest.empty()) {
+		for (const std::string &path : manifest)
+			PreloadFile(path.c_str());
+		return;
+	}
+
+	// Not visited yet, at least the tiles are known up front
+	const LevelGfxFiles files = GetLevelGfxFiles(gnLevelTypeTbl[level], level);
+	if (files.cel == nullptr)
+		return;
+	PreloadFile(files.cel);
+	PreloadFile(files.til);
+	PreloadFile(files.min);
+	PreloadFile(files.special);
+}
+
 void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 {
+	StartRecordingLoadedFiles();
+
 	if (setseed != 0)
 		glSeedTbl[currlevel] = setseed;
 
@@ -1880,6 +1909,7 @@ void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 	IncProgress();
 	MakeLightTable();
 	LoadLvlGFX();
+	InvalidateFloorCache();
 	IncProgress();
 
 	if (firstflag) {
@@ -2104,6 +2134,13 @@ void LoadGameLevel(bool firstflag, lvl_entry lvldir)
 	while (!IncProgress())
 		;
 
+	std::vector<std::string> loadedFiles = StopRecordingLoadedFiles();
+	if (!setlevel)
+		LevelFileManifests[currlevel] = std::move(loadedFiles);
+	// Anything left in the staging cache was preloaded for a level we did not go to
+	ClearPreloadedFiles();
+	PreloadedLevel = -1;
+
 	if (!gbIsSpawn && setlevel && setlvlnum == SL_SKELKING && Quests[Q_SKELKING]._qactive == QUEST_ACTIVE)
 		PlaySFX(USFX_SKING1);
 }
@@ -2135,6 +2172,7 @@ void diablo_color_cyc_logic()
 
 	if (leveltype == DTYPE_HELL) {
 		lighting_color_cycling();
+		InvalidateFloorCache();
 	} else if (currlevel >= 21) {
 		palette_update_crypt();
 	} else if (currlevel >= 17) {
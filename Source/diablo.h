@@ -78,6 +78,11 @@ void diablo_pause_game();
 void diablo_focus_pause();
 bool PressEscKey();
 void DisableInputWndProc(uint32_t uMsg, int32_t wParam, int32_t lParam);
+/**
+ * @brief Starts reading the files of a dungeon level in the background, ahead of a level change.
+ * @param level The level the player is likely to enter next
+ */
+void PreloadLevelAssets(int level);
 void LoadGameLevel(bool firstflag, lvl_entry lvldir);
 void game_loop(bool bStartup);
 void diablo_color_cyc_logic();
@@ -5,6 +5,7 @@
  */
 #include "drlg_l1.h"
 
+#include "engine/asset_view.hpp"
 #include "engine/load_file.hpp"
 #include "engine/point.hpp"
 #include "engine/random.hpp"
@@ -2481,7 +2482,8 @@ void LoadL1Dungeon(const char *path, int vx, int vy)
 		}
 	}
 
-	auto dunData = LoadFileInMem<uint16_t>(path);
+	const AssetView dunFile = LoadAssetView<uint16_t>(path);
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
@@ -2512,8 +2514,8 @@ void LoadL1Dungeon(const char *path, int vx, int vy)
 	if (currlevel < 17)
 		InitDungeonPieces();
 
-	SetMapMonsters(dunData.get(), { 0, 0 });
-	SetMapObjects(dunData.get(), 0, 0);
+	SetMapMonsters(dunData, { 0, 0 });
+	SetMapObjects(dunData, 0, 0);
 }
 
 void LoadPreL1Dungeon(const char *path)
@@ -2530,7 +2532,8 @@ void LoadPreL1Dungeon(const char *path)
 	dmaxx = 96;
 	dmaxy = 96;
 
-	auto dunData = LoadFileInMem<uint16_t>(path);
+	const AssetView dunFile = LoadAssetView<uint16_t>(path);
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
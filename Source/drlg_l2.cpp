@@ -9,6 +9,7 @@
 #include <list>
 
 #include "diablo.h"
+#include "engine/asset_view.hpp"
 #include "engine/load_file.hpp"
 #include "engine/random.hpp"
 #include "gendung.h"
@@ -3185,9 +3186,10 @@ void Pass3()
 
 void LoadL2Dungeon(const char *path, int vx, int vy)
 {
-	auto dunData = LoadFileInMem<uint16_t>(path);
+	const AssetView dunFile = LoadAssetView<uint16_t>(path);
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
-	LoadDungeonData(dunData.get());
+	LoadDungeonData(dunData);
 
 	Pass3();
 	DRLG_Init_Globals();
@@ -3197,15 +3199,16 @@ void LoadL2Dungeon(const char *path, int vx, int vy)
 	ViewX = vx;
 	ViewY = vy;
 
-	SetMapMonsters(dunData.get(), { 0, 0 });
-	SetMapObjects(dunData.get(), 0, 0);
+	SetMapMonsters(dunData, { 0, 0 });
+	SetMapObjects(dunData, 0, 0);
 }
 
 void LoadPreL2Dungeon(const char *path)
 {
 	{
-		auto dunData = LoadFileInMem<uint16_t>(path);
-		LoadDungeonData(dunData.get());
+		const AssetView dunFile = LoadAssetView<uint16_t>(path);
+		const auto *dunData = dunFile.DataAs<uint16_t>();
+		LoadDungeonData(dunData);
 	}
 
 	for (int j = 0; j < DMAXY; j++) {
@@ -6,7 +6,7 @@
 
 #include <algorithm>
 
-#include "engine/load_file.hpp"
+#include "engine/asset_view.hpp"
 #include "engine/random.hpp"
 #include "gendung.h"
 #include "lighting.h"
@@ -2529,7 +2529,8 @@ void LoadL3Dungeon(const char *path, int vx, int vy)
 	InitDungeonFlags();
 	DRLG_InitTrans();
 
-	auto dunData = LoadFileInMem<uint16_t>(path);
+	const AssetView dunFile = LoadAssetView<uint16_t>(path);
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
@@ -2557,8 +2558,8 @@ void LoadL3Dungeon(const char *path, int vx, int vy)
 	ViewX = vx;
 	ViewY = vy;
 
-	SetMapMonsters(dunData.get(), { 0, 0 });
-	SetMapObjects(dunData.get(), 0, 0);
+	SetMapMonsters(dunData, { 0, 0 });
+	SetMapObjects(dunData, 0, 0);
 
 	for (int j = 0; j < MAXDUNY; j++) {
 		for (int i = 0; i < MAXDUNX; i++) {
@@ -2578,7 +2579,8 @@ void LoadPreL3Dungeon(const char *path)
 	InitDungeonFlags();
 	DRLG_InitTrans();
 
-	auto dunData = LoadFileInMem<uint16_t>(path);
+	const AssetView dunFile = LoadAssetView<uint16_t>(path);
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
@@ -5,6 +5,7 @@
  */
 #include "drlg_l4.h"
 
+#include "engine/asset_view.hpp"
 #include "engine/load_file.hpp"
 #include "engine/random.hpp"
 #include "gendung.h"
@@ -1156,28 +1157,32 @@ void SaveQuads()
 void LoadDiabQuads(bool preflag)
 {
 	{
-		auto dunData = LoadFileInMem<uint16_t>("Levels\\L4Data\\diab1.DUN");
+		const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L4Data\\diab1.DUN");
+		const auto *dunData = dunFile.DataAs<uint16_t>();
 		diabquad1x = 4 + l4holdx;
 		diabquad1y = 4 + l4holdy;
-		SetRoom(dunData.get(), diabquad1x, diabquad1y);
+		SetRoom(dunData, diabquad1x, diabquad1y);
 	}
 	{
-		auto dunData = LoadFileInMem<uint16_t>(preflag ? "Levels\\L4Data\\diab2b.DUN" : "Levels\\L4Data\\diab2a.DUN");
+		const AssetView dunFile = LoadAssetView<uint16_t>(preflag ? "Levels\\L4Data\\diab2b.DUN" : "Levels\\L4Data\\diab2a.DUN");
+		const auto *dunData = dunFile.DataAs<uint16_t>();
 		diabquad2x = 27 - l4holdx;
 		diabquad2y = 1 + l4holdy;
-		SetRoom(dunData.get(), diabquad2x, diabquad2y);
+		SetRoom(dunData, diabquad2x, diabquad2y);
 	}
 	{
-		auto dunData = LoadFileInMem<uint16_t>(preflag ? "Levels\\L4Data\\diab3b.DUN" : "Levels\\L4Data\\diab3a.DUN");
+		const AssetView dunFile = LoadAssetView<uint16_t>(preflag ? "Levels\\L4Data\\diab3b.DUN" : "Levels\\L4Data\\diab3a.DUN");
+		const auto *dunData = dunFile.DataAs<uint16_t>();
 		diabquad3x = 1 + l4holdx;
 		diabquad3y = 27 - l4holdy;
-		SetRoom(dunData.get(), diabquad3x, diabquad3y);
+		SetRoom(dunData, diabquad3x, diabquad3y);
 	}
 	{
-		auto dunData = LoadFileInMem<uint16_t>(preflag ? "Levels\\L4Data\\diab4b.DUN" : "Levels\\L4Data\\diab4a.DUN");
+		const AssetView dunFile = LoadAssetView<uint16_t>(preflag ? "Levels\\L4Data\\diab4b.DUN" : "Levels\\L4Data\\diab4a.DUN");
+		const auto *dunData = dunFile.DataAs<uint16_t>();
 		diabquad4x = 28 - l4holdx;
 		diabquad4y = 28 - l4holdy;
-		SetRoom(dunData.get(), diabquad4x, diabquad4y);
+		SetRoom(dunData, diabquad4x, diabquad4y);
 	}
 }
 
@@ -1556,9 +1561,10 @@ void LoadL4Dungeon(const char *path, int vx, int vy)
 	DRLG_InitTrans();
 	InitDungeonFlags();
 
-	auto dunData = LoadFileInMem<uint16_t>(path);
+	const AssetView dunFile = LoadAssetView<uint16_t>(path);
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
-	SetRoom(dunData.get(), 0, 0);
+	SetRoom(dunData, 0, 0);
 
 	ViewX = vx;
 	ViewY = vy;
@@ -1566,8 +1572,8 @@ void LoadL4Dungeon(const char *path, int vx, int vy)
 	Pass3();
 	DRLG_Init_Globals();
 
-	SetMapMonsters(dunData.get(), { 0, 0 });
-	SetMapObjects(dunData.get(), 0, 0);
+	SetMapMonsters(dunData, { 0, 0 });
+	SetMapObjects(dunData, 0, 0);
 }
 
 void LoadPreL4Dungeon(const char *path)
@@ -1579,9 +1585,10 @@ void LoadPreL4Dungeon(const char *path)
 
 	InitDungeonFlags();
 
-	auto dunData = LoadFileInMem<uint16_t>(path);
+	const AssetView dunFile = LoadAssetView<uint16_t>(path);
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
-	SetRoom(dunData.get(), 0, 0);
+	SetRoom(dunData, 0, 0);
 }
 
 } // namespace devilution
@@ -2,9 +2,19 @@
  * @file dthread.cpp
  *
  * Implementation of functions for updating game state from network commands.
+ *
+ * Deltas are handed to the sender thread through a bounded lock-free queue. The thread packs the
+ * deltas queued for the same player into as few network messages as possible and paces them to
+ * gdwDeltaBytesSec with a token bucket.
  */
 
+#include "dthread.h"
+
+#include <algorithm>
+
+#include "multi.h"
 #include "nthread.h"
+#include "pack.h"
 #include "storm/storm.h"
 #include "utils/thread.h"
 
@@ -12,48 +22,135 @@ namespace devilution {
 
 namespace {
 
-CCritSect sgMemCrit;
+/**
+ * Bytes sent to a joining player at most: the hero, the junk and a delta of every level. The
+ * message headers are far less than what compression saves on any real level delta.
+ */
+constexpr size_t JoinSize = sizeof(PkPlayerStruct) + (NUMLEVELS + 1) * (MaxDeltaLevelSize + 1);
+
+/**
+ * @brief Token bucket that paces the sent bytes to gdwDeltaBytesSec.
+ *
+ * The old sender paused at most 1 ms per delta, so a join was never held back by the rate. The bucket
+ * holds a whole join, so a join still goes out at once, and only joins that follow each other faster
+ * than the bucket refills are paced.
+ */
+class DeltaPacer {
+public:
+	/** @brief Starts with a full bucket. */
+	void Reset()
+	{
+		tokens_ = Capacity(gdwDeltaBytesSec);
+		lastTicks_ = SDL_GetTicks();
+	}
+
+	/** @brief Waits until `size` bytes may be sent and takes them from the bucket. */
+	void Take(size_t size)
+	{
+		const uint32_t rate = gdwDeltaBytesSec;
+		if (rate == 0)
+			return;
+
+		Refill(rate);
+		if (tokens_ < size) {
+			SDL_Delay(static_cast<uint32_t>((size - tokens_) * 1000 / rate) + 1);
+			Refill(rate);
+		}
+		tokens_ -= std::min<size_t>(tokens_, size);
+	}
+
+private:
+	static size_t Capacity(uint32_t rate)
+	{
+		return std::max<size_t>(rate / 10, JoinSize);
+	}
+
+	void Refill(uint32_t rate)
+	{
+		const uint32_t ticks = SDL_GetTicks();
+		const size_t capacity = Capacity(rate);
+		const uint64_t gained = static_cast<uint64_t>(ticks - lastTicks_) * rate / 1000;
+		// Saturate instead of adding first, a long idle period must not wrap the sum around
+		const size_t room = capacity - std::min(tokens_, capacity);
+		tokens_ = gained >= room ? capacity : tokens_ + static_cast<size_t>(gained);
+		lastTicks_ = ticks;
+	}
+
+	size_t tokens_ = 0;
+	uint32_t lastTicks_ = 0;
+};
+
+DeltaQueue sgDeltaQueue;
+/** Bumped when a player leaves, deltas queued for the player before that are dropped. */
+std::array<std::atomic<uint32_t>, MAX_PLRS> sgPlayerGeneration;
 SDL_threadID glpDThreadId;
-TMegaPkt *sgpInfoHead; /* may not be right struct */
-bool dthread_running;
+std::atomic<bool> dthread_running;
 event_emul *sghWorkToDoEvent;
 
 /* rdata */
 SDL_Thread *sghThread = nullptr;
 
+/**
+ * @brief Sends the deltas at the front of the queue that are for the same player.
+ *
+ * The deltas are cut into pieces with a TCmdPlrInfoHdr each, like the receiver reassembles them, and
+ * the pieces are packed into messages of up to gdwLargestMsgSize bytes.
+ */
+void SendDeltas(DeltaPacer &pacer)
+{
+	const uint8_t pnum = sgDeltaQueue.Front()->pnum;
+	const uint32_t generation = sgPlayerGeneration[pnum];
+	const size_t maxBody = std::min(gdwLargestMsgSize - sizeof(TPktHdr), sizeof(TPkt::body));
+	TPkt pkt;
+	size_t bodySize = 0;
+
+	const auto flush = [&]() {
+		if (bodySize == 0)
+			return;
+		if (generation == sgPlayerGeneration[pnum]) {
+			pacer.Take(sizeof(TPktHdr) + bodySize);
+			multi_send_zero_packet(pnum, pkt, bodySize);
+		}
+		bodySize = 0;
+	};
+
+	while (DeltaPacket *delta = sgDeltaQueue.FrontFor(pnum, generation, sgPlayerGeneration[pnum])) {
+		for (size_t offset = 0; offset < delta->data.size();) {
+			if (bodySize + sizeof(TCmdPlrInfoHdr) >= maxBody)
+				flush();
+			auto *hdr = reinterpret_cast<TCmdPlrInfoHdr *>(&pkt.body[bodySize]);
+			const size_t pieceSize = std::min(delta->data.size() - offset, maxBody - bodySize - sizeof(*hdr));
+			hdr->bCmd = delta->cmd;
+			hdr->wOffset = static_cast<uint16_t>(offset);
+			hdr->wBytes = static_cast<uint16_t>(pieceSize);
+			memcpy(&pkt.body[bodySize + sizeof(*hdr)], &delta->data[offset], pieceSize);
+			bodySize += sizeof(*hdr) + pieceSize;
+			offset += pieceSize;
+		}
+		sgDeltaQueue.Pop();
+	}
+
+	flush();
+}
+
 void DthreadHandler()
 {
 	const char *errorBuf;
-	TMegaPkt *pkt;
-	DWORD dwMilliseconds;
+	DeltaPacer pacer;
+	pacer.Reset();
 
 	while (dthread_running) {
-		if (sgpInfoHead == nullptr && WaitForEvent(sghWorkToDoEvent) == -1) {
-			errorBuf = SDL_GetError();
-			app_fatal("dthread4:\n%s", errorBuf);
-		}
-
-		sgMemCrit.Enter();
-		pkt = sgpInfoHead;
-		if (sgpInfoHead != nullptr)
-			sgpInfoHead = sgpInfoHead->pNext;
-		else
+		if (sgDeltaQueue.Front() == nullptr) {
+			// A delta queued after this reset sets the event again
 			ResetEvent(sghWorkToDoEvent);
-		sgMemCrit.Leave();
-
-		if (pkt != nullptr) {
-			if (pkt->dwSpaceLeft != MAX_PLRS)
-				multi_send_zero_packet(pkt->dwSpaceLeft, static_cast<_cmd_id>(pkt->data[0]), &pkt->data[8], *(DWORD *)&pkt->data[4]);
-
-			dwMilliseconds = 1000 * *(DWORD *)&pkt->data[4] / gdwDeltaBytesSec;
-			if (dwMilliseconds >= 1)
-				dwMilliseconds = 1;
-
-			std::free(pkt);
-
-			if (dwMilliseconds != 0)
-				SDL_Delay(dwMilliseconds);
+			if (sgDeltaQueue.Front() == nullptr && WaitForEvent(sghWorkToDoEvent) == -1) {
+				errorBuf = SDL_GetError();
+				app_fatal("dthread4:\n%s", errorBuf);
+			}
+			continue;
 		}
+
+		SendDeltas(pacer);
 	}
 }
 
@@ -61,40 +158,25 @@ void DthreadHandler()
 
 void dthread_remove_player(uint8_t pnum)
 {
-	TMegaPkt *pkt;
-
-	sgMemCrit.Enter();
-	for (pkt = sgpInfoHead; pkt != nullptr; pkt = pkt->pNext) {
-		if (pkt->dwSpaceLeft == pnum)
-			pkt->dwSpaceLeft = MAX_PLRS;
-	}
-	sgMemCrit.Leave();
+	sgPlayerGeneration[pnum]++;
 }
 
 void dthread_send_delta(int pnum, _cmd_id cmd, byte *pbSrc, int dwLen)
 {
-	TMegaPkt *pkt;
-	TMegaPkt *p;
-
 	if (!gbIsMultiplayer) {
 		return;
 	}
 
-	pkt = static_cast<TMegaPkt *>(std::malloc(dwLen + 20));
-	pkt->pNext = nullptr;
-	pkt->dwSpaceLeft = pnum;
-	pkt->data[0] = static_cast<byte>(cmd);
-	*(DWORD *)&pkt->data[4] = dwLen;
-	memcpy(&pkt->data[8], pbSrc, dwLen);
-	sgMemCrit.Enter();
-	p = (TMegaPkt *)&sgpInfoHead;
-	while (p->pNext != nullptr) {
-		p = p->pNext;
+	const uint32_t generation = sgPlayerGeneration[pnum].load(std::memory_order_relaxed);
+	while (!sgDeltaQueue.TryPush(pnum, generation, cmd, pbSrc, dwLen)) {
+		if (!dthread_running)
+			return;
+		// The queue is full, the sender thread frees cells as it sends
+		SetEvent(sghWorkToDoEvent);
+		SDL_Delay(1);
 	}
-	p->pNext = pkt;
 
 	SetEvent(sghWorkToDoEvent);
-	sgMemCrit.Leave();
 }
 
 void dthread_start()
@@ -122,8 +204,6 @@ void dthread_start()
 
 void DThreadCleanup()
 {
-	TMegaPkt *tmp;
-
 	if (sghWorkToDoEvent == nullptr) {
 		return;
 	}
@@ -137,11 +217,7 @@ void DThreadCleanup()
 	EndEvent(sghWorkToDoEvent);
 	sghWorkToDoEvent = nullptr;
 
-	while (sgpInfoHead != nullptr) {
-		tmp = sgpInfoHead->pNext;
-		std::free(sgpInfoHead);
-		sgpInfoHead = tmp;
-	}
+	sgDeltaQueue.Clear();
 }
 
 } // namespace devilution
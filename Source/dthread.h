@@ -5,8 +5,121 @@
  */
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "msg.h"
+#include "utils/stdcompat/cstddef.hpp"
+
 namespace devilution {
 
+/** Most deltas that can wait for the sender thread, a power of two. */
+constexpr size_t DeltaQueueSize = 128;
+
+struct DeltaPacket {
+	/** See DeltaQueue. */
+	std::atomic<size_t> sequence;
+	uint8_t pnum;
+	/** sgPlayerGeneration of the player when the delta was queued. */
+	uint32_t generation;
+	_cmd_id cmd;
+	/** Keeps its capacity between uses, so that the queue stops allocating once it has seen the largest delta. */
+	std::vector<byte> data;
+};
+
+/**
+ * @brief Bounded multi-producer single-consumer queue of deltas.
+ *
+ * Uses the sequence numbers of Dmitry Vyukov's bounded queue: a cell is free for the producer that
+ * claimed position `pos` when its sequence is `pos`, and holds a delta for the consumer when it is `pos + 1`.
+ */
+class DeltaQueue {
+public:
+	DeltaQueue()
+	{
+		Clear();
+	}
+
+	/** @brief Only call when no other thread uses the queue. */
+	void Clear()
+	{
+		for (size_t i = 0; i < DeltaQueueSize; i++)
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+		enqueuePos_.store(0, std::memory_order_relaxed);
+		dequeuePos_ = 0;
+	}
+
+	/** @return false if the queue is full */
+	bool TryPush(uint8_t pnum, uint32_t generation, _cmd_id cmd, const byte *src, size_t size)
+	{
+		size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+		DeltaPacket *cell;
+		while (true) {
+			cell = &cells_[pos % DeltaQueueSize];
+			const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			if (sequence == pos) {
+				if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (sequence < pos) {
+				return false;
+			} else {
+				pos = enqueuePos_.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->pnum = pnum;
+		cell->generation = generation;
+		cell->cmd = cmd;
+		cell->data.assign(src, src + size);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** @brief Returns the oldest delta, or nullptr if there is none. Only for the consumer. */
+	DeltaPacket *Front()
+	{
+		DeltaPacket &cell = cells_[dequeuePos_ % DeltaQueueSize];
+		if (cell.sequence.load(std::memory_order_acquire) != dequeuePos_ + 1)
+			return nullptr;
+		return &cell;
+	}
+
+	/**
+	 * @brief Returns the oldest delta if it belongs to a batch for the player, dropping the deltas that
+	 * were queued for the player before it left. Only for the consumer.
+	 * @param generation The generation of the player that the batch is for
+	 * @param currentGeneration The generation of the player in the slot now
+	 * @return nullptr if there is no delta, or the oldest one is for another player or a later player in the slot
+	 */
+	DeltaPacket *FrontFor(uint8_t pnum, uint32_t generation, uint32_t currentGeneration)
+	{
+		for (DeltaPacket *delta = Front(); delta != nullptr && delta->pnum == pnum; delta = Front()) {
+			if (delta->generation == generation)
+				return delta;
+			// Queued for the next player in the same slot
+			if (delta->generation == currentGeneration)
+				return nullptr;
+			Pop();
+		}
+		return nullptr;
+	}
+
+	/** @brief Hands the cell of the oldest delta back to the producers. Only for the consumer. */
+	void Pop()
+	{
+		cells_[dequeuePos_ % DeltaQueueSize].sequence.store(dequeuePos_ + DeltaQueueSize, std::memory_order_release);
+		dequeuePos_++;
+	}
+
+private:
+	std::array<DeltaPacket, DeltaQueueSize> cells_;
+	std::atomic<size_t> enqueuePos_;
+	size_t dequeuePos_;
+};
+
 void dthread_remove_player(uint8_t pnum);
 void dthread_send_delta(int pnum, _cmd_id cmd, byte *pbSrc, int dwLen);
 void dthread_start();
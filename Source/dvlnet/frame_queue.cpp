@@ -9,37 +9,35 @@ namespace net {
 
 framesize_t frame_queue::Size() const
 {
-	return current_size;
+	return write_pos - read_pos;
 }
 
-buffer_t frame_queue::Read(framesize_t s)
+unsigned char *frame_queue::PrepareWrite(size_t size)
 {
-	if (current_size < s)
-		throw frame_queue_exception();
-	buffer_t ret;
-	while (s > 0 && s >= buffer_deque.front().size()) {
-		s -= buffer_deque.front().size();
-		current_size -= buffer_deque.front().size();
-		ret.insert(ret.end(),
-		    buffer_deque.front().begin(),
-		    buffer_deque.front().end());
-		buffer_deque.pop_front();
+	if (read_pos == write_pos) {
+		read_pos = 0;
+		write_pos = 0;
+	} else if (buffer.size() - write_pos < size && read_pos != 0) {
+		std::memmove(buffer.data(), buffer.data() + read_pos, write_pos - read_pos);
+		write_pos -= read_pos;
+		read_pos = 0;
 	}
-	if (s > 0) {
-		ret.insert(ret.end(),
-		    buffer_deque.front().begin(),
-		    buffer_deque.front().begin() + s);
-		buffer_deque.front().erase(buffer_deque.front().begin(),
-		    buffer_deque.front().begin() + s);
-		current_size -= s;
-	}
-	return ret;
+	if (buffer.size() - write_pos < size)
+		buffer.resize(write_pos + size);
+	return buffer.data() + write_pos;
+}
+
+void frame_queue::CommitWrite(size_t size)
+{
+	if (size > buffer.size() - write_pos)
+		ABORT();
+	write_pos += size;
 }
 
-void frame_queue::Write(buffer_t buf)
+void frame_queue::Write(const unsigned char *data, size_t size)
 {
-	current_size += buf.size();
-	buffer_deque.push_back(std::move(buf));
+	std::memcpy(PrepareWrite(size), data, size);
+	CommitWrite(size);
 }
 
 bool frame_queue::PacketReady()
@@ -47,19 +45,20 @@ bool frame_queue::PacketReady()
 	if (nextsize == 0) {
 		if (Size() < sizeof(framesize_t))
 			return false;
-		auto szbuf = Read(sizeof(framesize_t));
-		std::memcpy(&nextsize, &szbuf[0], sizeof(framesize_t));
-		if (nextsize == 0)
+		std::memcpy(&nextsize, buffer.data() + read_pos, sizeof(framesize_t));
+		read_pos += sizeof(framesize_t);
+		if (nextsize == 0 || nextsize > max_frame_size)
 			throw frame_queue_exception();
 	}
 	return Size() >= nextsize;
 }
 
-buffer_t frame_queue::ReadPacket()
+frame_view frame_queue::ReadPacket()
 {
 	if (nextsize == 0 || Size() < nextsize)
 		throw frame_queue_exception();
-	auto ret = Read(nextsize);
+	frame_view ret { buffer.data() + read_pos, nextsize };
+	read_pos += nextsize;
 	nextsize = 0;
 	return ret;
 }
@@ -1,9 +1,9 @@
 #pragma once
 
-#include <deque>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <vector>
-#include <cstdint>
 
 namespace devilution {
 namespace net {
@@ -20,22 +20,50 @@ public:
 
 typedef uint32_t framesize_t;
 
+/** @brief Bytes of one frame, stored in the frame_queue. */
+struct frame_view {
+	const unsigned char *data;
+	framesize_t size;
+
+	const unsigned char *begin() const
+	{
+		return data;
+	}
+
+	const unsigned char *end() const
+	{
+		return data + size;
+	}
+};
+
+/**
+ * @brief Splits a stream of bytes into frames.
+ *
+ * The received bytes are kept in one buffer that keeps its capacity, so the queue stops allocating
+ * once it has seen the largest burst. Unread bytes are moved to the front of the buffer when a write
+ * does not fit behind them, which keeps every frame contiguous.
+ */
 class frame_queue {
 public:
 	constexpr static framesize_t max_frame_size = 0xFFFF;
 
 private:
-	framesize_t current_size = 0;
-	std::deque<buffer_t> buffer_deque;
+	buffer_t buffer;
+	/** Unread bytes are in [read_pos, write_pos). */
+	size_t read_pos = 0;
+	size_t write_pos = 0;
 	framesize_t nextsize = 0;
 
 	framesize_t Size() const;
-	buffer_t Read(framesize_t s);
 
 public:
 	bool PacketReady();
-	buffer_t ReadPacket();
-	void Write(buffer_t buf);
+	/** @brief Returns the next frame, it stays valid until the next write. */
+	frame_view ReadPacket();
+	/** @brief Returns room for `size` bytes at the end of the queue, to be filled and then committed. */
+	unsigned char *PrepareWrite(size_t size);
+	void CommitWrite(size_t size);
+	void Write(const unsigned char *data, size_t size);
 
 	static buffer_t MakeFrame(buffer_t packetbuf);
 };
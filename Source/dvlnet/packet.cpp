@@ -148,6 +148,15 @@ void packet_in::Create(buffer_t buf)
 	have_encrypted = true;
 }
 
+void packet_in::Create(frame_view frame)
+{
+	if (have_encrypted || have_decrypted)
+		ABORT();
+	// Data() hands the encrypted packet on to other players, so it is the one copy that is kept
+	encrypted_buffer.assign(frame.begin(), frame.end());
+	have_encrypted = true;
+}
+
 void packet_in::Decrypt()
 {
 	if (!have_encrypted)
@@ -172,12 +181,15 @@ void packet_in::Decrypt()
 		    key.data());
 		if (status != 0)
 			throw packet_exception();
+		parse_pos = decrypted_buffer.data();
+		parse_end = decrypted_buffer.data() + decrypted_buffer.size();
 	} else
 #endif
 	{
 		if (encrypted_buffer.size() < sizeof(packet_type) + 2 * sizeof(plr_t))
 			throw packet_exception();
-		decrypted_buffer = encrypted_buffer;
+		parse_pos = encrypted_buffer.data();
+		parse_end = encrypted_buffer.data() + encrypted_buffer.size();
 	}
 
 	process_data();
@@ -10,6 +10,7 @@
 #endif
 
 #include "dvlnet/abstract_net.h"
+#include "dvlnet/frame_queue.h"
 #include "utils/stubs.h"
 
 namespace devilution {
@@ -83,6 +84,9 @@ protected:
 	bool have_decrypted = false;
 	buffer_t encrypted_buffer;
 	buffer_t decrypted_buffer;
+	/** Part of the decrypted packet that packet_in has not parsed yet. */
+	const unsigned char *parse_pos = nullptr;
+	const unsigned char *parse_end = nullptr;
 
 public:
 	packet(const key_t &k)
@@ -112,6 +116,7 @@ class packet_in : public packet_proc<packet_in> {
 public:
 	using packet_proc<packet_in>::packet_proc;
 	void Create(buffer_t buf);
+	void Create(frame_view frame);
 	void process_element(buffer_t &x);
 	template <class T>
 	void process_element(T &x);
@@ -176,18 +181,17 @@ void packet_proc<P>::process_data()
 
 inline void packet_in::process_element(buffer_t &x)
 {
-	x.insert(x.begin(), decrypted_buffer.begin(), decrypted_buffer.end());
-	decrypted_buffer.resize(0);
+	x.assign(parse_pos, parse_end);
+	parse_pos = parse_end;
 }
 
 template <class T>
 void packet_in::process_element(T &x)
 {
-	if (decrypted_buffer.size() < sizeof(T))
+	if (static_cast<size_t>(parse_end - parse_pos) < sizeof(T))
 		throw packet_exception();
-	std::memcpy(&x, decrypted_buffer.data(), sizeof(T));
-	decrypted_buffer.erase(decrypted_buffer.begin(),
-	    decrypted_buffer.begin() + sizeof(T));
+	std::memcpy(&x, parse_pos, sizeof(T));
+	parse_pos += sizeof(T);
 }
 
 template <>
@@ -336,6 +340,7 @@ public:
 
 	packet_factory(std::string pw = "");
 	std::unique_ptr<packet> make_packet(buffer_t buf);
+	std::unique_ptr<packet> make_packet(frame_view frame);
 	template <packet_type t, typename... Args>
 	std::unique_ptr<packet> make_packet(Args... args);
 };
@@ -348,6 +353,14 @@ inline std::unique_ptr<packet> packet_factory::make_packet(buffer_t buf)
 	return ret;
 }
 
+inline std::unique_ptr<packet> packet_factory::make_packet(frame_view frame)
+{
+	auto ret = std::make_unique<packet_in>(key);
+	ret->Create(frame);
+	ret->Decrypt();
+	return ret;
+}
+
 template <packet_type t, typename... Args>
 std::unique_ptr<packet> packet_factory::make_packet(Args... args)
 {
@@ -88,9 +88,7 @@ void tcp_client::HandleReceive(const asio::error_code &error, size_t bytesRead)
 	if (bytesRead == 0) {
 		throw std::runtime_error(_("error: read 0 bytes from server"));
 	}
-	recv_buffer.resize(bytesRead);
-	recv_queue.Write(std::move(recv_buffer));
-	recv_buffer.resize(frame_queue::max_frame_size);
+	recv_queue.CommitWrite(bytesRead);
 	while (recv_queue.PacketReady()) {
 		auto pkt = pktfty->make_packet(recv_queue.ReadPacket());
 		RecvLocal(*pkt);
@@ -101,7 +99,7 @@ void tcp_client::HandleReceive(const asio::error_code &error, size_t bytesRead)
 void tcp_client::StartReceive()
 {
 	sock.async_receive(
-	    asio::buffer(recv_buffer),
+	    asio::buffer(recv_queue.PrepareWrite(frame_queue::max_frame_size), frame_queue::max_frame_size),
 	    std::bind(&tcp_client::HandleReceive, this, std::placeholders::_1, std::placeholders::_2));
 }
 
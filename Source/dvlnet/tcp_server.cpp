@@ -61,7 +61,7 @@ bool tcp_server::Empty()
 void tcp_server::StartReceive(const scc &con)
 {
 	con->socket.async_receive(
-	    asio::buffer(con->recv_buffer),
+	    asio::buffer(con->recv_queue.PrepareWrite(frame_queue::max_frame_size), frame_queue::max_frame_size),
 	    std::bind(&tcp_server::HandleReceive, this, con, std::placeholders::_1, std::placeholders::_2));
 }
 
@@ -72,9 +72,7 @@ void tcp_server::HandleReceive(const scc &con, const asio::error_code &ec,
 		DropConnection(con);
 		return;
 	}
-	con->recv_buffer.resize(bytesRead);
-	con->recv_queue.Write(std::move(con->recv_buffer));
-	con->recv_buffer.resize(frame_queue::max_frame_size);
+	con->recv_queue.CommitWrite(bytesRead);
 	while (con->recv_queue.PacketReady()) {
 		try {
 			auto pkt = pktfty.make_packet(con->recv_queue.ReadPacket());
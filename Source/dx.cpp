@@ -8,6 +8,7 @@
 #include <SDL.h>
 
 #include "engine.h"
+#include "engine/render/present.hpp"
 #include "options.h"
 #include "storm/storm.h"
 #include "utils/display.h"
@@ -44,6 +45,58 @@ int locktbl[256];
 #endif
 CCritSect sgMemCrit;
 
+#ifndef USE_SDL1
+/** Output surface pixel of every palette index, for BlitPalettedToOutput() */
+std::uint32_t OutputPalette[256];
+/** Value of pal_surface_palette_version that OutputPalette was made for */
+unsigned int OutputPaletteVersion;
+/** Pixel format that OutputPalette was made for */
+Uint32 OutputPaletteFormat = SDL_PIXELFORMAT_UNKNOWN;
+
+/**
+ * @brief Copies `pal_surface` to a 32-bit output surface without going through SDL's generic blitter.
+ * @return false if the surfaces or rectangles need anything more than a straight copy, in which case nothing is done
+ */
+bool BlitPalettedToOutput(SDL_Rect *srcRect, SDL_Rect *dstRect)
+{
+	SDL_Surface *dst = GetOutputSurface();
+	if (dst->format->BytesPerPixel != 4 || SDL_MUSTLOCK(dst) || pal_surface->format->palette == nullptr)
+		return false;
+
+	const SDL_Rect area = srcRect != nullptr ? *srcRect : SDL_Rect { 0, 0, pal_surface->w, pal_surface->h };
+	const int dstX = dstRect != nullptr ? dstRect->x : 0;
+	const int dstY = dstRect != nullptr ? dstRect->y : 0;
+	if (area.x < 0 || area.y < 0 || area.w <= 0 || area.h <= 0
+	    || area.x + area.w > pal_surface->w || area.y + area.h > pal_surface->h
+	    || dstX < 0 || dstY < 0 || dstX + area.w > dst->w || dstY + area.h > dst->h)
+		return false;
+
+	if (OutputPaletteVersion != pal_surface_palette_version || OutputPaletteFormat != dst->format->format) {
+		const SDL_Palette *palette = pal_surface->format->palette;
+		for (int i = 0; i < 256; i++) {
+			const SDL_Color &color = palette->colors[i < palette->ncolors ? i : 0];
+			OutputPalette[i] = SDL_MapRGBA(dst->format, color.r, color.g, color.b, color.a);
+		}
+		OutputPaletteVersion = pal_surface_palette_version;
+		OutputPaletteFormat = dst->format->format;
+	}
+
+	const auto *srcLine = static_cast<const std::uint8_t *>(pal_surface->pixels) + area.y * pal_surface->pitch + area.x;
+	auto *dstLine = static_cast<std::uint8_t *>(dst->pixels) + dstY * dst->pitch + dstX * 4;
+	for (int y = 0; y < area.h; y++) {
+		ExpandPalettedPixels(srcLine, reinterpret_cast<std::uint32_t *>(dstLine), area.w, OutputPalette);
+		srcLine += pal_surface->pitch;
+		dstLine += dst->pitch;
+	}
+
+	if (dstRect != nullptr) {
+		dstRect->w = area.w;
+		dstRect->h = area.h;
+	}
+	return true;
+}
+#endif
+
 bool CanRenderDirectlyToOutputSurface()
 {
 #ifdef USE_SDL1
@@ -205,6 +258,7 @@ void dx_cleanup()
 	SDL_FreePalette(Palette);
 	SDL_FreeSurface(renderer_texture_surface);
 #ifndef USE_SDL1
+	OutputPaletteFormat = SDL_PIXELFORMAT_UNKNOWN;
 	SDL_DestroyTexture(texture);
 	SDL_DestroyRenderer(renderer);
 #endif
@@ -246,6 +300,10 @@ void BltFast(SDL_Rect *srcRect, SDL_Rect *dstRect)
 {
 	if (RenderDirectlyToOutputSurface)
 		return;
+#ifndef USE_SDL1
+	if (BlitPalettedToOutput(srcRect, dstRect))
+		return;
+#endif
 	Blit(pal_surface, srcRect, dstRect);
 }
 
@@ -4,6 +4,7 @@
  * Implementation of functions for compression and decompressing MPQ data.
  */
 #include <SDL.h>
+#include <algorithm>
 #include <cctype>
 #include <memory>
 
@@ -35,8 +36,9 @@ void PkwareBufferWrite(char *buf, unsigned int *size, void *param) // NOLINT(rea
 {
 	auto *pInfo = (TDataInfo *)param;
 
-	memcpy(pInfo->destData + pInfo->destOffset, buf, *size);
-	pInfo->destOffset += *size;
+	const uint32_t dSize = std::min<uint32_t>(*size, pInfo->destSize - pInfo->destOffset);
+	memcpy(pInfo->destData + pInfo->destOffset, buf, dSize);
+	pInfo->destOffset += dSize;
 }
 
 } // namespace
@@ -99,36 +101,49 @@ void InitHash()
 	}
 }
 
-uint32_t PkwareCompress(byte *srcData, uint32_t size)
+PkwareCompressor::PkwareCompressor()
+    : workBuffer_(new char[CMP_BUFFER_SIZE])
 {
-	std::unique_ptr<char[]> ptr { new char[CMP_BUFFER_SIZE] };
+}
 
+uint32_t PkwareCompressor::Compress(byte *srcData, uint32_t size)
+{
 	unsigned destSize = 2 * size;
 	if (destSize < 2 * 4096)
 		destSize = 2 * 4096;
 
-	std::unique_ptr<byte[]> destData { new byte[destSize] };
+	if (destSize > destSize_) {
+		destData_.reset(new byte[destSize]);
+		destSize_ = destSize;
+	}
 
 	TDataInfo param;
 	param.srcData = srcData;
 	param.srcOffset = 0;
-	param.destData = destData.get();
+	param.destData = destData_.get();
 	param.destOffset = 0;
+	param.destSize = destSize_;
 	param.size = size;
 
 	unsigned type = 0;
 	unsigned dsize = 4096;
-	implode(PkwareBufferRead, PkwareBufferWrite, ptr.get(), &param, &type, &dsize);
+	implode(PkwareBufferRead, PkwareBufferWrite, workBuffer_.get(), &param, &type, &dsize);
 
 	if (param.destOffset < size) {
-		memcpy(srcData, destData.get(), param.destOffset);
+		memcpy(srcData, destData_.get(), param.destOffset);
 		size = param.destOffset;
 	}
 
 	return size;
 }
 
-void PkwareDecompress(byte *inBuff, int recvSize, int maxBytes)
+uint32_t PkwareCompress(byte *srcData, uint32_t size)
+{
+	PkwareCompressor compressor;
+	return compressor.Compress(srcData, size);
+}
+
+uint32_t PkwareDecompress(byte *inBuff, int recvSize, int maxBytes)
 {
 	TDataInfo info;
 
@@ -139,10 +154,13 @@ void PkwareDecompress(byte *inBuff, int recvSize, int maxBytes)
 	info.srcOffset = 0;
 	info.destData = outBuff.get();
 	info.destOffset = 0;
+	info.destSize = maxBytes;
 	info.size = recvSize;
 
 	explode(PkwareBufferRead, PkwareBufferWrite, ptr.get(), &info);
 	memcpy(inBuff, outBuff.get(), info.destOffset);
+
+	return info.destOffset;
 }
 
 } // namespace devilution
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 
 #include "utils/stdcompat/cstddef.hpp"
 
@@ -16,14 +17,41 @@ struct TDataInfo {
 	uint32_t srcOffset;
 	byte *destData;
 	uint32_t destOffset;
+	/** Size of destData, output past it is dropped */
+	uint32_t destSize;
 	uint32_t size;
 };
 
+/**
+ * @brief Implode work memory that is reused between compressions.
+ *
+ * Not thread-safe, threads that compress at the same time need an instance each.
+ */
+class PkwareCompressor {
+public:
+	PkwareCompressor();
+
+	/**
+	 * @brief Compresses the buffer in place.
+	 * @return The compressed size, or the original size if compression didn't make the data smaller
+	 */
+	uint32_t Compress(byte *srcData, uint32_t size);
+
+private:
+	std::unique_ptr<char[]> workBuffer_;
+	std::unique_ptr<byte[]> destData_;
+	uint32_t destSize_ = 0;
+};
+
 void Decrypt(uint32_t *castBlock, uint32_t size, uint32_t key);
 void Encrypt(uint32_t *castBlock, uint32_t size, uint32_t key);
 uint32_t Hash(const char *s, int type);
 void InitHash();
 uint32_t PkwareCompress(byte *srcData, uint32_t size);
-void PkwareDecompress(byte *inBuff, int recvSize, int maxBytes);
+/**
+ * @brief Decompresses the buffer in place.
+ * @return The size of the decompressed data
+ */
+uint32_t PkwareDecompress(byte *inBuff, int recvSize, int maxBytes);
 
 } // namespace devilution
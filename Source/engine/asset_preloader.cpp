@@ -0,0 +1,245 @@
+/**
+ * @file asset_preloader.cpp
+ *
+ * Background thread that reads game archive files ahead of time into a staging cache.
+ */
+#include "engine/asset_preloader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+#include <SDL.h>
+
+#include "storm/storm.h"
+#include "utils/log.hpp"
+#include "utils/thread.h"
+
+namespace devilution {
+
+namespace {
+
+/** Upper limit for the staging cache, files that don't fit are left to the synchronous loaders. */
+constexpr size_t MaxPreloadedBytes = 64 * 1024 * 1024;
+
+struct PreloadedFile {
+	std::unique_ptr<byte[]> data;
+	size_t size;
+};
+
+SDL_mutex *PreloadMutex;
+/** Signalled when files are queued, when a file has been read and on shutdown. */
+SDL_cond *PreloadCond;
+SDL_Thread *PreloadThread;
+SDL_threadID PreloadThreadId;
+bool PreloadRunning;
+
+std::deque<std::string> PendingFiles;
+std::unordered_map<std::string, PreloadedFile> PreloadedFiles;
+size_t PreloadedBytes;
+/** The file currently being read by the preload thread. */
+std::string LoadingFile;
+/** Incremented by ClearPreloadedFiles() so that a file that was being read at the time is discarded. */
+uint32_t PreloadGeneration;
+
+bool IsRecording;
+std::vector<std::string> RecordedFiles;
+
+PreloadedFile ReadArchiveFile(const char *path, size_t budget)
+{
+	PreloadedFile file {};
+
+	HANDLE handle;
+	if (!SFileOpenFile(path, &handle))
+		return file;
+
+	const size_t size = SFileGetFileSize(handle);
+	if (size != 0 && size <= budget) {
+		std::unique_ptr<byte[]> data { new byte[size] };
+		if (SFileReadFileThreadSafe(handle, data.get(), size)) {
+			file.data = std::move(data);
+			file.size = size;
+		}
+	}
+	SFileCloseFileThreadSafe(handle);
+
+	return file;
+}
+
+void PreloadHandler()
+{
+	SDL_LockMutex(PreloadMutex);
+	while (PreloadRunning) {
+		if (PendingFiles.empty()) {
+			SDL_CondWait(PreloadCond, PreloadMutex);
+			continue;
+		}
+
+		std::string path = std::move(PendingFiles.front());
+		PendingFiles.pop_front();
+		if (PreloadedFiles.count(path) != 0)
+			continue;
+
+		LoadingFile = path;
+		const uint32_t generation = PreloadGeneration;
+		const size_t budget = MaxPreloadedBytes - PreloadedBytes;
+		SDL_UnlockMutex(PreloadMutex);
+
+		PreloadedFile file = ReadArchiveFile(path.c_str(), budget);
+
+		SDL_LockMutex(PreloadMutex);
+		LoadingFile.clear();
+		if (file.data != nullptr && generation == PreloadGeneration && PreloadedBytes + file.size <= MaxPreloadedBytes) {
+			PreloadedBytes += file.size;
+			PreloadedFiles.emplace(std::move(path), std::move(file));
+		}
+		SDL_CondBroadcast(PreloadCond);
+	}
+	SDL_UnlockMutex(PreloadMutex);
+}
+
+bool StartPreloadThread()
+{
+	if (PreloadThread != nullptr)
+		return true;
+
+	PreloadMutex = SDL_CreateMutex();
+	PreloadCond = SDL_CreateCond();
+	if (PreloadMutex == nullptr || PreloadCond == nullptr) {
+		LogError("Failed to create the asset preloader: {}", SDL_GetError());
+		AssetPreloaderCleanup();
+		return false;
+	}
+
+	PreloadRunning = true;
+	PreloadThread = CreateThread(PreloadHandler, &PreloadThreadId);
+	return true;
+}
+
+} // namespace
+
+void PreloadFile(const char *path)
+{
+	if (!StartPreloadThread())
+		return;
+
+	SDL_LockMutex(PreloadMutex);
+	if (PreloadedFiles.count(path) == 0 && LoadingFile != path && std::find(PendingFiles.begin(), PendingFiles.end(), path) == PendingFiles.end()) {
+		PendingFiles.emplace_back(path);
+		SDL_CondBroadcast(PreloadCond);
+	}
+	SDL_UnlockMutex(PreloadMutex);
+}
+
+void ClearPreloadedFiles()
+{
+	if (PreloadMutex == nullptr)
+		return;
+
+	SDL_LockMutex(PreloadMutex);
+	PendingFiles.clear();
+	PreloadedFiles.clear();
+	PreloadedBytes = 0;
+	PreloadGeneration++;
+	SDL_UnlockMutex(PreloadMutex);
+}
+
+bool GetPreloadedFileSize(const char *path, size_t *size)
+{
+	if (PreloadMutex == nullptr)
+		return false;
+
+	SDL_LockMutex(PreloadMutex);
+	while (LoadingFile == path)
+		SDL_CondWait(PreloadCond, PreloadMutex);
+	const auto it = PreloadedFiles.find(path);
+	const bool found = it != PreloadedFiles.end();
+	if (found)
+		*size = it->second.size;
+	SDL_UnlockMutex(PreloadMutex);
+
+	return found;
+}
+
+bool TakePreloadedFile(const char *path, std::unique_ptr<byte[]> *data, size_t *size)
+{
+	if (IsRecording && std::find(RecordedFiles.begin(), RecordedFiles.end(), path) == RecordedFiles.end())
+		RecordedFiles.emplace_back(path);
+
+	if (PreloadMutex == nullptr)
+		return false;
+
+	SDL_LockMutex(PreloadMutex);
+	while (LoadingFile == path)
+		SDL_CondWait(PreloadCond, PreloadMutex);
+
+	bool found = false;
+	const auto it = PreloadedFiles.find(path);
+	if (it != PreloadedFiles.end()) {
+		*data = std::move(it->second.data);
+		*size = it->second.size;
+		PreloadedBytes -= it->second.size;
+		PreloadedFiles.erase(it);
+		found = true;
+	} else {
+		const auto pending = std::find(PendingFiles.begin(), PendingFiles.end(), path);
+		if (pending != PendingFiles.end())
+			PendingFiles.erase(pending);
+	}
+	SDL_UnlockMutex(PreloadMutex);
+
+	return found;
+}
+
+bool TakePreloadedFile(const char *path, byte *buffer, size_t fileLen)
+{
+	std::unique_ptr<byte[]> data;
+	size_t size;
+	if (!TakePreloadedFile(path, &data, &size))
+		return false;
+
+	memcpy(buffer, data.get(), std::min(fileLen, size));
+	return true;
+}
+
+void StartRecordingLoadedFiles()
+{
+	RecordedFiles.clear();
+	IsRecording = true;
+}
+
+std::vector<std::string> StopRecordingLoadedFiles()
+{
+	IsRecording = false;
+	return std::move(RecordedFiles);
+}
+
+void AssetPreloaderCleanup()
+{
+	if (PreloadThread != nullptr) {
+		SDL_LockMutex(PreloadMutex);
+		PreloadRunning = false;
+		SDL_CondBroadcast(PreloadCond);
+		SDL_UnlockMutex(PreloadMutex);
+		SDL_WaitThread(PreloadThread, nullptr);
+		PreloadThread = nullptr;
+	}
+
+	PendingFiles.clear();
+	PreloadedFiles.clear();
+	PreloadedBytes = 0;
+	LoadingFile.clear();
+
+	if (PreloadCond != nullptr) {
+		SDL_DestroyCond(PreloadCond);
+		PreloadCond = nullptr;
+	}
+	if (PreloadMutex != nullptr) {
+		SDL_DestroyMutex(PreloadMutex);
+		PreloadMutex = nullptr;
+	}
+}
+
+} // namespace devilution
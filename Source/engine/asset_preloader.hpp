@@ -0,0 +1,69 @@
+/**
+ * @file asset_preloader.hpp
+ *
+ * Background thread that reads game archive files ahead of time into a staging cache.
+ *
+ * GetFileSize() and LoadFileData() take files from the staging cache when present, so any loader
+ * built on top of them benefits without changes.
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "utils/stdcompat/cstddef.hpp"
+
+namespace devilution {
+
+/**
+ * @brief Queues a file to be read into the staging cache on the preload thread.
+ * @param path Path of the file in the game archives
+ */
+void PreloadFile(const char *path);
+
+/**
+ * @brief Drops all queued files and everything in the staging cache.
+ */
+void ClearPreloadedFiles();
+
+/**
+ * @brief Looks up the size of a file in the staging cache.
+ * @return false if the file has not been preloaded
+ */
+bool GetPreloadedFileSize(const char *path, size_t *size);
+
+/**
+ * @brief Copies a file out of the staging cache and releases it.
+ *
+ * If the file is currently being read by the preload thread this waits for it, if it is only queued
+ * it is removed from the queue, as the caller is going to read it itself.
+ *
+ * @return false if the file has not been preloaded
+ */
+bool TakePreloadedFile(const char *path, byte *buffer, size_t fileLen);
+
+/**
+ * @brief Moves a file out of the staging cache, see TakePreloadedFile() above.
+ * @return false if the file has not been preloaded
+ */
+bool TakePreloadedFile(const char *path, std::unique_ptr<byte[]> *data, size_t *size);
+
+/**
+ * @brief Starts collecting the paths of all files passed to TakePreloadedFile().
+ */
+void StartRecordingLoadedFiles();
+
+/**
+ * @brief Stops collecting file paths.
+ * @return The paths of the files loaded since StartRecordingLoadedFiles(), without duplicates
+ */
+std::vector<std::string> StopRecordingLoadedFiles();
+
+/**
+ * @brief Stops the preload thread and frees the staging cache.
+ */
+void AssetPreloaderCleanup();
+
+} // namespace devilution
@@ -0,0 +1,179 @@
+/**
+ * @file asset_view.cpp
+ *
+ * Read-only access to game assets that avoids copying them where possible.
+ */
+#include "engine/asset_view.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "diablo.h"
+#include "engine/asset_preloader.hpp"
+#include "storm/storm.h"
+#include "utils/log.hpp"
+
+#if defined(_WIN64) || defined(_WIN32)
+// Suppress definitions of `min` and `max` macros by <windows.h>:
+#define NOMINMAX 1
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include "utils/file_util.h"
+#define DEVILUTIONX_MAPPED_FILES
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef _POSIX_MAPPED_FILES
+#define DEVILUTIONX_MAPPED_FILES
+#endif
+#endif
+
+namespace devilution {
+
+namespace {
+
+/** Smaller files are cheaper to copy than to map. */
+constexpr size_t MinMappedSize = 16 * 1024;
+
+#ifdef DEVILUTIONX_MAPPED_FILES
+std::uint64_t GetMappingGranularity()
+{
+#if defined(_WIN64) || defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwAllocationGranularity;
+#else
+	return sysconf(_SC_PAGESIZE);
+#endif
+}
+#endif
+
+} // namespace
+
+AssetView::AssetView(AssetView &&other) noexcept
+    : owned_(std::move(other.owned_))
+    , mapping_(std::exchange(other.mapping_, nullptr))
+    , mappingSize_(std::exchange(other.mappingSize_, 0))
+    , data_(std::exchange(other.data_, nullptr))
+    , size_(std::exchange(other.size_, 0))
+{
+}
+
+AssetView &AssetView::operator=(AssetView &&other) noexcept
+{
+	if (this != &other) {
+		Unmap();
+		owned_ = std::move(other.owned_);
+		mapping_ = std::exchange(other.mapping_, nullptr);
+		mappingSize_ = std::exchange(other.mappingSize_, 0);
+		data_ = std::exchange(other.data_, nullptr);
+		size_ = std::exchange(other.size_, 0);
+	}
+	return *this;
+}
+
+AssetView::~AssetView()
+{
+	Unmap();
+}
+
+void AssetView::Unmap()
+{
+	if (mapping_ == nullptr)
+		return;
+
+#if defined(_WIN64) || defined(_WIN32)
+	UnmapViewOfFile(mapping_);
+#elif defined(DEVILUTIONX_MAPPED_FILES)
+	munmap(mapping_, mappingSize_);
+#endif
+	mapping_ = nullptr;
+	mappingSize_ = 0;
+}
+
+AssetView AssetView::Map(const char *path, std::uint64_t offset, size_t size)
+{
+	AssetView view;
+#ifdef DEVILUTIONX_MAPPED_FILES
+	// Mappings have to start at a multiple of the granularity
+	const std::uint64_t granularity = GetMappingGranularity();
+	const std::uint64_t mappingOffset = offset - offset % granularity;
+	const size_t mappingSize = static_cast<size_t>(offset - mappingOffset) + size;
+
+#if defined(_WIN64) || defined(_WIN32)
+	const auto pathUtf16 = ToWideChar(path);
+	if (pathUtf16 == nullptr)
+		return view;
+	HANDLE file = CreateFileW(pathUtf16.get(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return view;
+	HANDLE fileMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (fileMapping == nullptr)
+		return view;
+	void *mapping = MapViewOfFile(fileMapping, FILE_MAP_READ, static_cast<DWORD>(mappingOffset >> 32), static_cast<DWORD>(mappingOffset), mappingSize);
+	CloseHandle(fileMapping);
+	if (mapping == nullptr) {
+		LogVerbose("Failed to map {}: {}", path, GetLastError());
+		return view;
+	}
+#else
+	const int file = open(path, O_RDONLY);
+	if (file == -1)
+		return view;
+	void *mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, file, static_cast<off_t>(mappingOffset));
+	close(file);
+	if (mapping == MAP_FAILED) {
+		LogVerbose("Failed to map {}: {}", path, errno);
+		return view;
+	}
+#endif
+
+	view.mapping_ = mapping;
+	view.mappingSize_ = mappingSize;
+	view.data_ = static_cast<const byte *>(mapping) + (offset - mappingOffset);
+	view.size_ = size;
+#endif
+	return view;
+}
+
+AssetView LoadAssetView(const char *path, size_t alignment)
+{
+	std::unique_ptr<byte[]> preloaded;
+	size_t preloadedSize;
+	if (TakePreloadedFile(path, &preloaded, &preloadedSize))
+		return AssetView(std::move(preloaded), preloadedSize);
+
+	HANDLE file;
+	if (!SFileOpenFile(path, &file)) {
+		if (!gbQuietMode)
+			app_fatal("LoadAssetView - SFileOpenFile failed for file:\n%s", path);
+		return {};
+	}
+
+	const size_t size = SFileGetFileSize(file);
+	if (size == 0)
+		app_fatal("Zero length SFILE:\n%s", path);
+
+	std::string diskPath;
+	std::uint64_t offset;
+	if (size >= MinMappedSize && SFileGetRawFileLocation(file, &diskPath, &offset)) {
+		AssetView view = AssetView::Map(diskPath.c_str(), offset, size);
+		if (view.Data() != nullptr && reinterpret_cast<std::uintptr_t>(view.Data()) % alignment == 0) {
+			SFileCloseFileThreadSafe(file);
+			return view;
+		}
+	}
+
+	std::unique_ptr<byte[]> data { new byte[size] };
+	SFileReadFileThreadSafe(file, data.get(), size);
+	SFileCloseFileThreadSafe(file);
+
+	return AssetView(std::move(data), size);
+}
+
+} // namespace devilution
@@ -0,0 +1,103 @@
+/**
+ * @file asset_view.hpp
+ *
+ * Read-only access to game assets that avoids copying them where possible.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "appfat.h"
+#include "utils/stdcompat/cstddef.hpp"
+
+namespace devilution {
+
+/**
+ * @brief Read-only contents of an asset.
+ *
+ * Local files and archive entries that are stored uncompressed are memory-mapped,
+ * anything else is a heap copy.
+ */
+class AssetView {
+public:
+	AssetView() = default;
+
+	AssetView(std::unique_ptr<byte[]> data, size_t size)
+	    : owned_(std::move(data))
+	    , data_(owned_.get())
+	    , size_(size)
+	{
+	}
+
+	AssetView(AssetView &&other) noexcept;
+	AssetView &operator=(AssetView &&other) noexcept;
+	~AssetView();
+
+	[[nodiscard]] const byte *Data() const
+	{
+		return data_;
+	}
+
+	template <typename T>
+	[[nodiscard]] const T *DataAs() const
+	{
+		return reinterpret_cast<const T *>(data_);
+	}
+
+	[[nodiscard]] size_t Size() const
+	{
+		return size_;
+	}
+
+	[[nodiscard]] bool IsMapped() const
+	{
+		return mapping_ != nullptr;
+	}
+
+	/**
+	 * @brief Maps part of a file on disk.
+	 * @return An empty view if the platform doesn't support it or the mapping fails
+	 */
+	static AssetView Map(const char *path, std::uint64_t offset, size_t size);
+
+private:
+	void Unmap();
+
+	std::unique_ptr<byte[]> owned_;
+	/** Start of the mapped pages, the data itself may begin later in the first page. */
+	void *mapping_ = nullptr;
+	size_t mappingSize_ = 0;
+	const byte *data_ = nullptr;
+	size_t size_ = 0;
+};
+
+/**
+ * @brief Loads a file as a read-only view
+ * @param path Path of file
+ * @param alignment Required alignment of the data, mappings that don't satisfy it are copied instead
+ */
+AssetView LoadAssetView(const char *path, size_t alignment = 1);
+
+/**
+ * @brief Loads a file of T elements as a read-only view
+ * @param path Path of file
+ * @param elements Number of T elements in the file
+ */
+template <typename T>
+AssetView LoadAssetView(const char *path, size_t *elements = nullptr)
+{
+	AssetView view = LoadAssetView(path, alignof(T));
+
+	if ((view.Size() % sizeof(T)) != 0)
+		app_fatal("File size does not align with type\n%s", path);
+
+	if (elements != nullptr)
+		*elements = view.Size() / sizeof(T);
+
+	return view;
+}
+
+} // namespace devilution
@@ -1,8 +1,8 @@
 #pragma once
 
-#include <memory>
 #include <utility>
 
+#include "engine/asset_view.hpp"
 #include "utils/stdcompat/cstddef.hpp"
 
 namespace devilution {
@@ -15,16 +15,16 @@ namespace devilution {
  */
 class CelSprite {
 public:
-	CelSprite(std::unique_ptr<byte[]> data, int width)
+	CelSprite(AssetView data, int width)
 	    : data_(std::move(data))
-	    , data_ptr_(data_.get())
+	    , data_ptr_(data_.Data())
 	    , width_(width)
 	{
 	}
 
-	CelSprite(std::unique_ptr<byte[]> data, const int *widths)
+	CelSprite(AssetView data, const int *widths)
 	    : data_(std::move(data))
-	    , data_ptr_(data_.get())
+	    , data_ptr_(data_.Data())
 	    , widths_(widths)
 	{
 	}
@@ -53,7 +53,7 @@ public:
 	}
 
 private:
-	std::unique_ptr<byte[]> data_;
+	AssetView data_;
 	const byte *data_ptr_;
 	int width_ = 0;
 	const int *widths_ = nullptr; // unowned
@@ -1,17 +1,17 @@
 #include "engine/load_cel.hpp"
 
-#include "engine/load_file.hpp"
+#include "engine/asset_view.hpp"
 
 namespace devilution {
 
 CelSprite LoadCel(const char *pszName, int width)
 {
-	return CelSprite(LoadFileInMem(pszName), width);
+	return CelSprite(LoadAssetView(pszName), width);
 }
 
 CelSprite LoadCel(const char *pszName, const int *widths)
 {
-	return CelSprite(LoadFileInMem(pszName), widths);
+	return CelSprite(LoadAssetView(pszName), widths);
 }
 
 } // namespace devilution
@@ -1,12 +1,17 @@
 #include "load_file.hpp"
 
 #include "diablo.h"
+#include "engine/asset_preloader.hpp"
 #include "storm/storm.h"
 
 namespace devilution {
 
 size_t GetFileSize(const char *pszName)
 {
+	size_t preloadedLen;
+	if (GetPreloadedFileSize(pszName, &preloadedLen))
+		return preloadedLen;
+
 	HANDLE file;
 	if (!SFileOpenFile(pszName, &file)) {
 		if (!gbQuietMode)
@@ -21,6 +26,9 @@ size_t GetFileSize(const char *pszName)
 
 void LoadFileData(const char *pszName, byte *buffer, size_t fileLen)
 {
+	if (TakePreloadedFile(pszName, buffer, fileLen))
+		return;
+
 	HANDLE file;
 	if (!SFileOpenFile(pszName, &file)) {
 		if (!gbQuietMode)
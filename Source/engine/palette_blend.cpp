@@ -0,0 +1,145 @@
+/**
+ * @file palette_blend.cpp
+ *
+ * Nearest color search and blended transparency lookup table generation.
+ */
+#include "engine/palette_blend.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace devilution {
+
+namespace {
+
+std::uint32_t ColorDistance(int r1, int g1, int b1, int r2, int g2, int b2)
+{
+	const int diffr = r1 - r2;
+	const int diffg = g1 - g2;
+	const int diffb = b1 - b2;
+	return diffr * diffr + diffg * diffg + diffb * diffb;
+}
+
+/** @brief Distance along one axis from a value to the closest value of the cell range. */
+int MinAxisDistance(int value, int cellMin, int cellMax)
+{
+	if (value < cellMin)
+		return cellMin - value;
+	if (value > cellMax)
+		return value - cellMax;
+	return 0;
+}
+
+/** @brief Distance along one axis from a value to the furthest value of the cell range. */
+int MaxAxisDistance(int value, int cellMin, int cellMax)
+{
+	return std::max(std::abs(value - cellMin), std::abs(value - cellMax));
+}
+
+} // namespace
+
+PaletteColorGrid::PaletteColorGrid(const SDL_Color *palette, int skipFrom, int skipTo)
+    : cells_(CellCount)
+{
+	entries_.reserve(256);
+	for (int i = 0; i < 256; i++) {
+		if (i >= skipFrom && i <= skipTo)
+			continue;
+		entries_.push_back(Entry { palette[i].r, palette[i].g, palette[i].b, static_cast<std::uint8_t>(i) });
+	}
+}
+
+void PaletteColorGrid::BuildCell(Cell &cell, int r, int g, int b)
+{
+	constexpr int CellSize = 1 << CellBits;
+	const int minR = r << CellBits;
+	const int minG = g << CellBits;
+	const int minB = b << CellBits;
+	const int maxR = minR + CellSize - 1;
+	const int maxG = minG + CellSize - 1;
+	const int maxB = minB + CellSize - 1;
+
+	// Every color in the cell is at most this far away from its closest entry
+	std::uint32_t bound = std::numeric_limits<std::uint32_t>::max();
+	for (const Entry &entry : entries_) {
+		const int dr = MaxAxisDistance(entry.r, minR, maxR);
+		const int dg = MaxAxisDistance(entry.g, minG, maxG);
+		const int db = MaxAxisDistance(entry.b, minB, maxB);
+		bound = std::min(bound, static_cast<std::uint32_t>(dr * dr + dg * dg + db * db));
+	}
+
+	cell.start = static_cast<std::int32_t>(candidates_.size());
+	for (const Entry &entry : entries_) {
+		const int dr = MinAxisDistance(entry.r, minR, maxR);
+		const int dg = MinAxisDistance(entry.g, minG, maxG);
+		const int db = MinAxisDistance(entry.b, minB, maxB);
+		if (static_cast<std::uint32_t>(dr * dr + dg * dg + db * db) <= bound)
+			candidates_.push_back(entry);
+	}
+	cell.count = static_cast<std::int32_t>(candidates_.size()) - cell.start;
+}
+
+std::uint8_t PaletteColorGrid::FindBestMatch(SDL_Color color)
+{
+	const int r = color.r >> CellBits;
+	const int g = color.g >> CellBits;
+	const int b = color.b >> CellBits;
+	Cell &cell = cells_[(r * CellsPerAxis + g) * CellsPerAxis + b];
+	if (cell.start < 0)
+		BuildCell(cell, r, g, b);
+
+	std::uint8_t best = 0;
+	std::uint32_t bestDiff = std::numeric_limits<std::uint32_t>::max();
+	const Entry *candidate = candidates_.data() + cell.start;
+	for (int i = 0; i < cell.count; i++, candidate++) {
+		const std::uint32_t diff = ColorDistance(candidate->r, candidate->g, candidate->b, color.r, color.g, color.b);
+		if (bestDiff > diff) {
+			best = candidate->index;
+			bestDiff = diff;
+		}
+	}
+	return best;
+}
+
+std::uint8_t FindBestMatchForColorLinear(const SDL_Color *palette, SDL_Color color, int skipFrom, int skipTo)
+{
+	std::uint8_t best = 0;
+	std::uint32_t bestDiff = std::numeric_limits<std::uint32_t>::max();
+	for (int i = 0; i < 256; i++) {
+		if (i >= skipFrom && i <= skipTo)
+			continue;
+		const std::uint32_t diff = ColorDistance(palette[i].r, palette[i].g, palette[i].b, color.r, color.g, color.b);
+		if (bestDiff > diff) {
+			best = i;
+			bestDiff = diff;
+		}
+	}
+	return best;
+}
+
+void GenerateBlendedLookupTable(const SDL_Color *palette, int skipFrom, int skipTo, std::uint8_t table[256][256])
+{
+	PaletteColorGrid grid(palette, skipFrom, skipTo);
+
+	for (int i = 0; i < 256; i++) {
+		for (int j = 0; j < 256; j++) {
+			if (i == j) { // No need to calculate transparency between 2 identical colors
+				table[i][j] = j;
+				continue;
+			}
+			if (i > j) { // Half the blends will be mirror identical ([i][j] is the same as [j][i]), so simply copy the existing combination.
+				table[i][j] = table[j][i];
+				continue;
+			}
+
+			SDL_Color blendedColor;
+			blendedColor.r = ((int)palette[i].r + (int)palette[j].r) / 2;
+			blendedColor.g = ((int)palette[i].g + (int)palette[j].g) / 2;
+			blendedColor.b = ((int)palette[i].b + (int)palette[j].b) / 2;
+			table[i][j] = grid.FindBestMatch(blendedColor);
+		}
+	}
+}
+
+} // namespace devilution
@@ -0,0 +1,83 @@
+/**
+ * @file palette_blend.hpp
+ *
+ * Nearest color search and blended transparency lookup table generation.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDL.h>
+
+namespace devilution {
+
+/**
+ * @brief Spatial index of a palette for finding the closest entry to an arbitrary RGB color.
+ *
+ * The RGB cube is split into an 8x8x8 grid of cells. The first time a color in a cell is looked up,
+ * the cell gets a list of every palette entry that can be the closest one for some color inside the
+ * cell: entries that are no further away from the cell than the furthest point of the cell is from the
+ * best single entry. Searching that short list gives the exact same result as a linear scan of the
+ * palette, including the lowest index winning ties.
+ */
+class PaletteColorGrid {
+public:
+	/**
+	 * @param palette The 256 colors to index
+	 * @param skipFrom Do not use colors between this index and skipTo
+	 * @param skipTo Do not use colors between skipFrom and this index
+	 */
+	PaletteColorGrid(const SDL_Color *palette, int skipFrom, int skipTo);
+
+	/** @brief Returns the index of the palette entry with the smallest squared RGB distance to the color. */
+	std::uint8_t FindBestMatch(SDL_Color color);
+
+private:
+	static constexpr int CellBits = 5;
+	static constexpr int CellsPerAxis = 256 >> CellBits;
+	static constexpr int CellCount = CellsPerAxis * CellsPerAxis * CellsPerAxis;
+
+	struct Entry {
+		std::uint8_t r;
+		std::uint8_t g;
+		std::uint8_t b;
+		std::uint8_t index;
+	};
+
+	struct Cell {
+		/** Offset of the first candidate in candidates_, or -1 if the cell has not been used yet. */
+		std::int32_t start = -1;
+		std::int32_t count = 0;
+	};
+
+	void BuildCell(Cell &cell, int r, int g, int b);
+
+	/** The usable palette entries, in palette order. */
+	std::vector<Entry> entries_;
+	std::vector<Cell> cells_;
+	/** Candidate lists of all cells built so far, each sorted by palette index. */
+	std::vector<Entry> candidates_;
+};
+
+/**
+ * @brief Brute force reference implementation of PaletteColorGrid::FindBestMatch().
+ */
+std::uint8_t FindBestMatchForColorLinear(const SDL_Color *palette, SDL_Color color, int skipFrom, int skipTo);
+
+/**
+ * @brief Generate lookup table for transparency
+ *
+ * This is based of the same technique found in Quake2.
+ *
+ * To mimic 50% transparency we figure out what colors in the existing palette are the best match for the combination of any 2 colors.
+ * We save this into a lookup table for use during rendering.
+ *
+ * @param palette The colors to operate on
+ * @param skipFrom Do not use colors between this index and skipTo
+ * @param skipTo Do not use colors between skipFrom and this index
+ * @param table Output lookup table
+ */
+void GenerateBlendedLookupTable(const SDL_Color *palette, int skipFrom, int skipTo, std::uint8_t table[256][256]);
+
+} // namespace devilution
@@ -10,6 +10,7 @@
 
 #include "engine/cel_header.hpp"
 #include "engine/render/common_impl.h"
+#include "engine/render/render_stats.hpp"
 #include "options.h"
 #include "palette.h"
 #include "scrollrt.h"
@@ -170,21 +171,23 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderCel(
 	const ClipX clipX = CalculateClipX(position.x, srcWidth, out);
 	if (clipX.width <= 0)
 		return;
+	const auto countedRenderLine = [&renderLine](std::uint8_t *dst, const std::uint8_t *src, std::size_t w) {
+		CountRenderedPixels(w);
+		renderLine(dst, src, w);
+	};
 	if (static_cast<std::size_t>(clipX.width) == srcWidth) {
-		RenderCelClipY(out, position, src, srcSize, srcWidth, renderLine, lineEndFn);
+		RenderCelClipY(out, position, src, srcSize, srcWidth, countedRenderLine, lineEndFn);
 	} else {
-		RenderCelClipXY(out, position, src, srcSize, srcWidth, clipX, renderLine, lineEndFn);
+		RenderCelClipXY(out, position, src, srcSize, srcWidth, clipX, countedRenderLine, lineEndFn);
 	}
 }
 
+template <LightType Light>
 void RenderCelWithLightTable(const Surface &out, Point position, const byte *src, std::size_t srcSize, std::size_t srcWidth, const std::uint8_t *tbl)
 {
 	RenderCel(
 	    out, position, src, srcSize, srcWidth, [tbl](std::uint8_t *dst, const std::uint8_t *src, std::size_t w) {
-		    while (w-- > 0) {
-			    *dst++ = tbl[static_cast<std::uint8_t>(*src)];
-			    ++src;
-		    }
+		    RenderSpritePixels<Light>(dst, src, w, tbl);
 	    },
 	    NullLineEndFn);
 }
@@ -543,11 +546,12 @@ void CelBlitSafeTo(const Surface &out, Point position, const byte *pRLEBytes, in
  * @param position Target buffer coordinate
  * @param pRLEBytes CEL pixel stream (run-length encoded)
  * @param nDataSize Size of CEL in bytes
+ * @param tbl Palette translation table, only used when partially lit
  */
-void CelBlitLightTransSafeTo(const Surface &out, Point position, const byte *pRLEBytes, int nDataSize, int nWidth)
+template <LightType Light>
+void CelBlitLightTransSafeTo(const Surface &out, Point position, const byte *pRLEBytes, int nDataSize, int nWidth, const uint8_t *tbl)
 {
 	assert(pRLEBytes != nullptr);
-	const std::uint8_t *tbl = &LightTables[LightTableIndex * 256];
 	bool shift = (reinterpret_cast<uintptr_t>(&out[position]) % 2 == 1);
 	const bool pitchIsEven = (out.pitch() % 2 == 0);
 	RenderCel(
@@ -556,9 +560,7 @@ void CelBlitLightTransSafeTo(const Surface &out, Point position, const byte *pRL
 		    if (reinterpret_cast<uintptr_t>(dst) % 2 == (shift ? 1 : 0)) {
 			    ++dst, ++src, --width;
 		    }
-		    for (const auto *dstEnd = dst + width; dst < dstEnd; dst += 2, src += 2) {
-			    *dst = tbl[*src];
-		    }
+		    RenderSpritePixelsStippled<Light>(dst, src, width, tbl);
 	    },
 	    [pitchIsEven, &shift]() { if (pitchIsEven) shift = !shift; });
 }
@@ -569,20 +571,15 @@ void CelBlitLightTransSafeTo(const Surface &out, Point position, const byte *pRL
  * @param pRLEBytes CEL pixel stream (run-length encoded)
  * @param nDataSize Size of CEL in bytes
  * @param nWidth Width of sprite
- * @param tbl Palette translation table
+ * @param tbl Palette translation table, only used when partially lit
  */
+template <LightType Light>
 void CelBlitLightBlendedSafeTo(const Surface &out, Point position, const byte *pRLEBytes, int nDataSize, int nWidth, const uint8_t *tbl)
 {
 	assert(pRLEBytes != nullptr);
-	if (tbl == nullptr)
-		tbl = &LightTables[LightTableIndex * 256];
-
 	RenderCel(
 	    out, position, pRLEBytes, nDataSize, nWidth, [tbl](std::uint8_t *dst, const uint8_t *src, std::size_t w) {
-		    while (w-- > 0) {
-			    *dst = paletteTransparencyLookup[*dst][tbl[*src++]];
-			    ++dst;
-		    }
+		    RenderSpritePixelsBlended<Light>(dst, src, w, tbl);
 	    },
 	    NullLineEndFn);
 }
@@ -593,14 +590,43 @@ void CelBlitLightBlendedSafeTo(const Surface &out, Point position, const byte *p
  * @param position Target buffer coordinate
  * @param pRLEBytes CEL pixel stream (run-length encoded)
  * @param nDataSize Size of CEL in bytes
- * @param tbl Palette translation table
+ * @param tbl Palette translation table, the current light level is used if null
  */
-void CelBlitLightSafeTo(const Surface &out, Point position, const byte *pRLEBytes, int nDataSize, int nWidth, uint8_t *tbl)
+void CelBlitLightSafeTo(const Surface &out, Point position, const byte *pRLEBytes, int nDataSize, int nWidth, const uint8_t *tbl)
 {
 	assert(pRLEBytes != nullptr);
-	if (tbl == nullptr)
-		tbl = &LightTables[LightTableIndex * 256];
-	RenderCelWithLightTable(out, position, pRLEBytes, nDataSize, nWidth, tbl);
+	if (tbl != nullptr)
+		RenderCelWithLightTable<LightType::PartiallyLit>(out, position, pRLEBytes, nDataSize, nWidth, tbl);
+	else if (LightTableIndex == LightsMax)
+		RenderCelWithLightTable<LightType::FullyDark>(out, position, pRLEBytes, nDataSize, nWidth, nullptr);
+	else if (LightTableIndex == 0)
+		CelBlitSafeTo(out, position, pRLEBytes, nDataSize, nWidth);
+	else
+		RenderCelWithLightTable<LightType::PartiallyLit>(out, position, pRLEBytes, nDataSize, nWidth, &LightTables[LightTableIndex * 256]);
+}
+
+/**
+ * @brief Blit CEL sprite with the current light level and the given kind of transparency
+ */
+template <TransparencyType Transparency>
+void CelBlitLightTransparentSafeTo(const Surface &out, Point position, const byte *pRLEBytes, int nDataSize, int nWidth)
+{
+	const uint8_t *tbl = &LightTables[LightTableIndex * 256];
+	if (Transparency == TransparencyType::Blended) {
+		if (LightTableIndex == LightsMax)
+			CelBlitLightBlendedSafeTo<LightType::FullyDark>(out, position, pRLEBytes, nDataSize, nWidth, tbl);
+		else if (LightTableIndex == 0)
+			CelBlitLightBlendedSafeTo<LightType::FullyLit>(out, position, pRLEBytes, nDataSize, nWidth, tbl);
+		else
+			CelBlitLightBlendedSafeTo<LightType::PartiallyLit>(out, position, pRLEBytes, nDataSize, nWidth, tbl);
+	} else {
+		if (LightTableIndex == LightsMax)
+			CelBlitLightTransSafeTo<LightType::FullyDark>(out, position, pRLEBytes, nDataSize, nWidth, tbl);
+		else if (LightTableIndex == 0)
+			CelBlitLightTransSafeTo<LightType::FullyLit>(out, position, pRLEBytes, nDataSize, nWidth, tbl);
+		else
+			CelBlitLightTransSafeTo<LightType::PartiallyLit>(out, position, pRLEBytes, nDataSize, nWidth, tbl);
+	}
 }
 
 } // namespace
@@ -614,6 +640,7 @@ void CelDrawTo(const Surface &out, Point position, const CelSprite &cel, int fra
 
 void CelClippedDrawTo(const Surface &out, Point position, const CelSprite &cel, int frame)
 {
+	RenderStatsScope stats(RenderPrimitive::CelClippedDrawTo);
 	int nDataSize;
 	const auto *pRLEBytes = CelGetFrameClipped(cel.Data(), frame, &nDataSize);
 
@@ -625,28 +652,23 @@ void CelDrawLightTo(const Surface &out, Point position, const CelSprite &cel, in
 	int nDataSize;
 	const auto *pRLEBytes = CelGetFrame(cel.Data(), frame, &nDataSize);
 
-	if (LightTableIndex != 0 || tbl != nullptr)
-		CelBlitLightSafeTo(out, position, pRLEBytes, nDataSize, cel.Width(frame), tbl);
-	else
-		CelBlitSafeTo(out, position, pRLEBytes, nDataSize, cel.Width(frame));
+	CelBlitLightSafeTo(out, position, pRLEBytes, nDataSize, cel.Width(frame), tbl);
 }
 
 void CelClippedDrawLightTo(const Surface &out, Point position, const CelSprite &cel, int frame)
 {
+	RenderStatsScope stats(RenderPrimitive::CelClippedDrawLightTo);
 	int nDataSize;
 	const auto *pRLEBytes = CelGetFrameClipped(cel.Data(), frame, &nDataSize);
 
-	if (LightTableIndex != 0)
-		CelBlitLightSafeTo(out, position, pRLEBytes, nDataSize, cel.Width(frame), nullptr);
-	else
-		CelBlitSafeTo(out, position, pRLEBytes, nDataSize, cel.Width(frame));
+	CelBlitLightSafeTo(out, position, pRLEBytes, nDataSize, cel.Width(frame), nullptr);
 }
 
 void CelDrawLightRedTo(const Surface &out, Point position, const CelSprite &cel, int frame)
 {
 	int nDataSize;
 	const auto *pRLEBytes = CelGetFrameClipped(cel.Data(), frame, &nDataSize);
-	RenderCelWithLightTable(out, position, pRLEBytes, nDataSize, cel.Width(frame), GetLightTable(1));
+	RenderCelWithLightTable<LightType::PartiallyLit>(out, position, pRLEBytes, nDataSize, cel.Width(frame), GetLightTable(1));
 }
 
 void CelDrawItem(const ItemStruct &item, const Surface &out, Point position, const CelSprite &cel, int frame)
@@ -661,18 +683,16 @@ void CelDrawItem(const ItemStruct &item, const Surface &out, Point position, con
 
 void CelClippedBlitLightTransTo(const Surface &out, Point position, const CelSprite &cel, int frame)
 {
+	RenderStatsScope stats(RenderPrimitive::CelClippedBlitLightTransTo);
 	int nDataSize;
 	const byte *pRLEBytes = CelGetFrameClipped(cel.Data(), frame, &nDataSize);
 
-	if (cel_transparency_active) {
-		if (sgOptions.Graphics.bBlendedTransparancy)
-			CelBlitLightBlendedSafeTo(out, position, pRLEBytes, nDataSize, cel.Width(frame), nullptr);
-		else
-			CelBlitLightTransSafeTo(out, position, pRLEBytes, nDataSize, cel.Width(frame));
-	} else if (LightTableIndex != 0)
+	if (!cel_transparency_active)
 		CelBlitLightSafeTo(out, position, pRLEBytes, nDataSize, cel.Width(frame), nullptr);
+	else if (sgOptions.Graphics.bBlendedTransparancy)
+		CelBlitLightTransparentSafeTo<TransparencyType::Blended>(out, position, pRLEBytes, nDataSize, cel.Width(frame));
 	else
-		CelBlitSafeTo(out, position, pRLEBytes, nDataSize, cel.Width(frame));
+		CelBlitLightTransparentSafeTo<TransparencyType::Stippled>(out, position, pRLEBytes, nDataSize, cel.Width(frame));
 }
 
 void CelDrawUnsafeTo(const Surface &out, Point position, const CelSprite &cel, int frame)
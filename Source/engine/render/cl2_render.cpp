@@ -9,6 +9,7 @@
 
 #include "engine/cel_header.hpp"
 #include "engine/render/common_impl.h"
+#include "engine/render/render_stats.hpp"
 #include "scrollrt.h"
 #include "utils/attributes.h"
 
@@ -255,72 +256,49 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderCl2(
 	const ClipX clipX = CalculateClipX(position.x, srcWidth, out);
 	if (clipX.width <= 0)
 		return;
+	const auto countedRenderPixels = [&renderPixels](std::uint8_t *dst, const std::uint8_t *src, std::size_t w) {
+		CountRenderedPixels(w);
+		renderPixels(dst, src, w);
+	};
+	const auto countedRenderFill = [&renderFill](std::uint8_t *dst, std::uint8_t color, std::size_t w) {
+		CountRenderedPixels(w);
+		renderFill(dst, color, w);
+	};
 	if (static_cast<std::size_t>(clipX.width) == srcWidth) {
-		RenderCl2ClipY(out, position, src, srcSize, srcWidth, renderPixels, renderFill);
+		RenderCl2ClipY(out, position, src, srcSize, srcWidth, countedRenderPixels, countedRenderFill);
 	} else {
-		RenderCl2ClipXY(out, position, src, srcSize, srcWidth, clipX, renderPixels, renderFill);
+		RenderCl2ClipXY(out, position, src, srcSize, srcWidth, clipX, countedRenderPixels, countedRenderFill);
 	}
 }
 
 /**
- * @brief Blit CL2 sprite to the given buffer
+ * @brief Blit CL2 sprite to the given buffer, specialised on the lighting
  * @param out Target buffer
  * @param sx Target buffer coordinate
  * @param sy Target buffer coordinate
  * @param pRLEBytes CL2 pixel stream (run-length encoded)
  * @param nDataSize Size of CL2 in bytes
  * @param nWidth Width of sprite
+ * @param pTable Light color table, only used when partially lit
  */
-void Cl2BlitSafe(const Surface &out, int sx, int sy, const byte *pRLEBytes, int nDataSize, int nWidth)
-{
-	RenderCl2(
-	    out, { sx, sy }, pRLEBytes, nDataSize, nWidth,
-#ifndef DEBUG_RENDER_COLOR
-	    [](std::uint8_t *dst, const std::uint8_t *src, std::size_t w) {
-		    std::memcpy(dst, src, w);
-	    },
-	    [](std::uint8_t *dst, std::uint8_t color, std::size_t w) {
-		    std::memset(dst, color, w);
-	    }
-#else
-	    [](std::uint8_t *dst, [[maybe_unused]] const std::uint8_t *src, std::size_t w) {
-		    std::memset(dst, DEBUG_RENDER_COLOR, w);
-	    },
-	    [](std::uint8_t *dst, [[maybe_unused]] std::uint8_t color, std::size_t w) {
-		    std::memset(dst, DEBUG_RENDER_COLOR, w);
-	    }
-#endif
-	);
-}
-
-/**
- * @brief Blit CL2 sprite, and apply lighting, to the given buffer
- * @param out Target buffer
- * @param sx Target buffer coordinate
- * @param sy Target buffer coordinate
- * @param pRLEBytes CL2 pixel stream (run-length encoded)
- * @param nDataSize Size of CL2 in bytes
- * @param nWidth With of CL2 sprite
- * @param pTable Light color table
- */
-void Cl2BlitLightSafe(const Surface &out, int sx, int sy, const byte *pRLEBytes, int nDataSize, int nWidth, uint8_t *pTable)
+template <LightType Light>
+void Cl2BlitSafe(const Surface &out, int sx, int sy, const byte *pRLEBytes, int nDataSize, int nWidth, const uint8_t *pTable)
 {
 	RenderCl2(
 	    out, { sx, sy }, pRLEBytes, nDataSize, nWidth,
 #ifndef DEBUG_RENDER_COLOR
 	    [pTable](std::uint8_t *dst, const std::uint8_t *src, std::size_t w) {
-		    while (w-- > 0)
-			    *dst++ = pTable[static_cast<std::uint8_t>(*src++)];
+		    RenderSpritePixels<Light>(dst, src, w, pTable);
 	    },
 	    [pTable](std::uint8_t *dst, std::uint8_t color, std::size_t w) {
-		    std::memset(dst, pTable[color], w);
+		    RenderSpriteFill<Light>(dst, color, w, pTable);
 	    }
 #else
 	    [pTable](std::uint8_t *dst, [[maybe_unused]] const std::uint8_t *src, std::size_t w) {
-		    std::memset(dst, pTable[DEBUG_RENDER_COLOR], w);
+		    RenderSpriteFill<Light>(dst, DEBUG_RENDER_COLOR, w, pTable);
 	    },
 	    [pTable](std::uint8_t *dst, [[maybe_unused]] std::uint8_t color, std::size_t w) {
-		    std::memset(dst, pTable[DEBUG_RENDER_COLOR], w);
+		    RenderSpriteFill<Light>(dst, DEBUG_RENDER_COLOR, w, pTable);
 	    }
 #endif
 	);
@@ -447,6 +425,7 @@ std::uint8_t *RenderCl2OutlinePixels(
 {
 	if (Fill && *src == 0)
 		return dst + width;
+	CountRenderedPixels(width);
 
 	if (CheckFirstColumn && dstX <= 0) {
 		return RenderCl2OutlinePixelsCheckFirstColumn<Fill, North, West, South, East>(
@@ -765,16 +744,18 @@ void Cl2ApplyTrans(byte *p, const std::array<uint8_t, 256> &ttbl, int nCel)
 
 void Cl2Draw(const Surface &out, int sx, int sy, const CelSprite &cel, int frame)
 {
+	RenderStatsScope stats(RenderPrimitive::Cl2Draw);
 	assert(frame > 0);
 
 	int nDataSize;
 	const byte *pRLEBytes = CelGetFrameClipped(cel.Data(), frame, &nDataSize);
 
-	Cl2BlitSafe(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame));
+	Cl2BlitSafe<LightType::FullyLit>(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame), nullptr);
 }
 
 void Cl2DrawOutline(const Surface &out, uint8_t col, int sx, int sy, const CelSprite &cel, int frame)
 {
+	RenderStatsScope stats(RenderPrimitive::Cl2DrawOutline);
 	assert(frame > 0);
 
 	int nDataSize;
@@ -785,24 +766,28 @@ void Cl2DrawOutline(const Surface &out, uint8_t col, int sx, int sy, const CelSp
 
 void Cl2DrawLightTbl(const Surface &out, int sx, int sy, const CelSprite &cel, int frame, char light)
 {
+	RenderStatsScope stats(RenderPrimitive::Cl2DrawLightTbl);
 	assert(frame > 0);
 
 	int nDataSize;
 	const byte *pRLEBytes = CelGetFrameClipped(cel.Data(), frame, &nDataSize);
-	Cl2BlitLightSafe(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame), GetLightTable(light));
+	Cl2BlitSafe<LightType::PartiallyLit>(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame), GetLightTable(light));
 }
 
 void Cl2DrawLight(const Surface &out, int sx, int sy, const CelSprite &cel, int frame)
 {
+	RenderStatsScope stats(RenderPrimitive::Cl2DrawLight);
 	assert(frame > 0);
 
 	int nDataSize;
 	const byte *pRLEBytes = CelGetFrameClipped(cel.Data(), frame, &nDataSize);
 
-	if (LightTableIndex != 0)
-		Cl2BlitLightSafe(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame), &LightTables[LightTableIndex * 256]);
+	if (LightTableIndex == LightsMax)
+		Cl2BlitSafe<LightType::FullyDark>(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame), nullptr);
+	else if (LightTableIndex == 0)
+		Cl2BlitSafe<LightType::FullyLit>(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame), nullptr);
 	else
-		Cl2BlitSafe(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame));
+		Cl2BlitSafe<LightType::PartiallyLit>(out, sx, sy, pRLEBytes, nDataSize, cel.Width(frame), &LightTables[LightTableIndex * 256]);
 }
 
 } // namespace devilution
@@ -5,14 +5,111 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 
 #include "engine.h"
+#include "engine/render/translate.hpp"
 #include "lighting.h"
+#include "palette.h"
+#include "utils/attributes.h"
 
 namespace devilution {
 
+enum class TransparencyType {
+	Solid,
+	Blended,
+	Stippled,
+};
+
+enum class LightType {
+	FullyDark,
+	PartiallyLit,
+	FullyLit,
+};
+
+/**
+ * @brief Draws a run of sprite pixels.
+ * @param tbl Light table, only used when partially lit
+ */
+template <LightType Light>
+DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderSpritePixels(std::uint8_t *dst, const std::uint8_t *src, std::size_t n, const std::uint8_t *tbl)
+{
+	if (Light == LightType::FullyDark) {
+		memset(dst, 0, n);
+	} else if (Light == LightType::FullyLit) {
+		memcpy(dst, src, n);
+	} else { // Partially lit
+		TranslatePixels(src, dst, n, tbl);
+	}
+}
+
+/**
+ * @brief Draws a run of sprite pixels of a single color.
+ * @param tbl Light table, only used when partially lit
+ */
+template <LightType Light>
+DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderSpriteFill(std::uint8_t *dst, std::uint8_t color, std::size_t n, const std::uint8_t *tbl)
+{
+	if (Light == LightType::FullyDark) {
+		memset(dst, 0, n);
+	} else if (Light == LightType::FullyLit) {
+		memset(dst, color, n);
+	} else { // Partially lit
+		memset(dst, tbl[color], n);
+	}
+}
+
+/**
+ * @brief Blends a run of sprite pixels with the pixels already in the buffer.
+ * @param tbl Light table, only used when partially lit
+ */
+template <LightType Light>
+DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderSpritePixelsBlended(std::uint8_t *dst, const std::uint8_t *src, std::size_t n, const std::uint8_t *tbl)
+{
+	if (Light == LightType::FullyDark) {
+		for (std::size_t i = 0; i < n; i++)
+			dst[i] = paletteTransparencyLookup[dst[i]][0];
+	} else if (Light == LightType::FullyLit) {
+		for (std::size_t i = 0; i < n; i++)
+			dst[i] = paletteTransparencyLookup[dst[i]][src[i]];
+	} else if (n >= TranslateVectorMinimum) { // Partially lit
+		// Translate in chunks with the vector kernel, the blend table is too big for it
+		std::uint8_t lit[128];
+		while (n > 0) {
+			const std::size_t chunk = std::min(n, sizeof(lit));
+			TranslatePixels(src, lit, chunk, tbl);
+			for (std::size_t i = 0; i < chunk; i++)
+				dst[i] = paletteTransparencyLookup[dst[i]][lit[i]];
+			src += chunk;
+			dst += chunk;
+			n -= chunk;
+		}
+	} else { // Partially lit
+		for (std::size_t i = 0; i < n; i++)
+			dst[i] = paletteTransparencyLookup[dst[i]][tbl[src[i]]];
+	}
+}
+
+/**
+ * @brief Draws every other pixel of a run of sprite pixels, starting with the first one.
+ * @param tbl Light table, only used when partially lit
+ */
+template <LightType Light>
+DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderSpritePixelsStippled(std::uint8_t *dst, const std::uint8_t *src, std::size_t n, const std::uint8_t *tbl)
+{
+	for (std::size_t i = 0; i < n; i += 2) {
+		if (Light == LightType::FullyDark)
+			dst[i] = 0;
+		else if (Light == LightType::FullyLit)
+			dst[i] = src[i];
+		else // Partially lit
+			dst[i] = tbl[src[i]];
+	}
+}
+
 inline std::uint8_t *GetLightTable(char light)
 {
 	int idx = 4096;
@@ -8,7 +8,12 @@
 #include <algorithm>
 #include <climits>
 #include <cstdint>
+#include <cstring>
+#include <vector>
 
+#include "engine/render/common_impl.h"
+#include "engine/render/render_stats.hpp"
+#include "engine/render/translate.hpp"
 #include "lighting.h"
 #include "options.h"
 #include "utils/attributes.h"
@@ -488,18 +493,6 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void ForEachSetBit(std::uint32_t mask, const
 	}
 }
 
-enum class TransparencyType {
-	Solid,
-	Blended,
-	Stippled,
-};
-
-enum class LightType {
-	FullyDark,
-	PartiallyLit,
-	FullyLit,
-};
-
 template <LightType Light>
 DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderLineOpaque(std::uint8_t *dst, const std::uint8_t *src, std::uint_fast8_t n, const std::uint8_t *tbl)
 {
@@ -513,9 +506,7 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderLineOpaque(std::uint8_t *dst, con
 #endif
 	} else { // Partially lit
 #ifndef DEBUG_RENDER_COLOR
-		for (size_t i = 0; i < n; i++) {
-			dst[i] = tbl[src[i]];
-		}
+		TranslatePixels(src, dst, n, tbl);
 #else
 		memset(dst, tbl[DBGCOLOR], n);
 #endif
@@ -540,6 +531,15 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderLineBlended(std::uint8_t *dst, co
 			else
 				dst[i] = paletteTransparencyLookup[dst[i]][src[i]];
 		}
+	} else if (n >= TranslateVectorMinimum) { // Partially lit
+		std::uint8_t lit[Width];
+		TranslatePixels(src, lit, n, tbl);
+		for (size_t i = 0; i < n; i++, mask <<= 1) {
+			if ((mask & 0x80000000) != 0)
+				dst[i] = lit[i];
+			else
+				dst[i] = paletteTransparencyLookup[dst[i]][lit[i]];
+		}
 	} else { // Partially lit
 		for (size_t i = 0; i < n; i++, mask <<= 1) {
 			if ((mask & 0x80000000) != 0)
@@ -577,6 +577,7 @@ DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderLineStippled(std::uint8_t *dst, c
 template <TransparencyType Transparency, LightType Light>
 DVL_ALWAYS_INLINE DVL_ATTRIBUTE_HOT void RenderLine(std::uint8_t *dst, const std::uint8_t *src, std::uint_fast8_t n, const std::uint8_t *tbl, std::uint32_t mask)
 {
+	CountRenderedPixels(n);
 	if (Transparency == TransparencyType::Solid) {
 		RenderLineOpaque<Light>(dst, src, n, tbl);
 	} else {
@@ -704,7 +705,7 @@ DVL_ATTRIBUTE_HOT void RenderTransparentSquareClipped(std::uint8_t *dst, int dst
 			if (v > 0) {
 				if (v > remainingLeftClip) {
 					const auto overshoot = v - remainingLeftClip;
-					RenderLine<Transparency, Light>(dst, src + remainingLeftClip, overshoot, tbl, m);
+					RenderLine<Transparency, Light>(dst, src + remainingLeftClip, overshoot, tbl, m << remainingLeftClip);
 					dst += overshoot;
 					drawWidth -= overshoot;
 				}
@@ -1216,6 +1217,69 @@ DVL_ATTRIBUTE_HOT void RenderRightTrapezoid(std::uint8_t *dst, int dstPitch, con
 	}
 }
 
+/**
+ * @brief A transparent square decoded into a plain 32x32 block of pixels.
+ *
+ * Rows are stored bottom to top, the same order as in the CEL data.
+ */
+struct AtlasTile {
+	std::uint8_t pixels[Height][Width];
+	/** Opaque pixels of each row, the most significant bit is the leftmost pixel. */
+	std::uint32_t coverage[Height];
+	/** Whether a level piece uses the frame as a transparent square. */
+	bool decoded;
+};
+
+/**
+ * Decoded transparent squares of the level, indexed by CEL frame. Empty unless the "Tile Atlas" option
+ * is enabled.
+ *
+ * The other tile types are stored as plain rows of pixels already and are always drawn from the CEL data.
+ */
+std::vector<AtlasTile> TileAtlas;
+
+void DecodeTransparentSquare(AtlasTile &tile, const std::uint8_t *src)
+{
+	for (auto row = 0; row < Height; ++row) {
+		for (std::int_fast16_t x = 0; x < Width;) {
+			const auto v = static_cast<std::int8_t>(*src++);
+			if (v > 0) {
+				memcpy(&tile.pixels[row][x], src, v);
+				tile.coverage[row] |= (v == Width ? std::uint32_t(-1) : ((std::uint32_t(1) << v) - 1)) << (Width - x - v);
+				src += v;
+				x += v;
+			} else {
+				x -= v;
+			}
+		}
+	}
+	tile.decoded = true;
+}
+
+template <TransparencyType Transparency, LightType Light>
+DVL_ATTRIBUTE_HOT void RenderAtlasTile(std::uint8_t *dst, int dstPitch, const AtlasTile &tile, const std::uint32_t *mask, const std::uint8_t *tbl, Clip clip)
+{
+	// dst points at the first visible column, clip.left pixels to the right of the tile's left edge
+	const std::uint32_t columns = (std::uint32_t(-1) >> clip.left) & (std::uint32_t(-1) << clip.right);
+	const auto endRow = clip.bottom + clip.height;
+	for (auto row = clip.bottom; row < endRow; ++row, dst -= dstPitch, --mask) {
+		std::uint32_t coverage = tile.coverage[row] & columns;
+		const std::uint8_t *src = tile.pixels[row];
+		if (coverage == std::uint32_t(-1)) {
+			// A constant width lets the compiler inline the copy
+			RenderLine<Transparency, Light>(dst, src, Width, tbl, *mask);
+			continue;
+		}
+		while (coverage != 0) {
+			const int start = CountLeadingZeros(coverage);
+			const std::uint32_t rest = ~(coverage << start);
+			const int n = rest == 0 ? Width : CountLeadingZeros(rest);
+			RenderLine<Transparency, Light>(dst + start - clip.left, src + start, n, tbl, *mask << start);
+			coverage = start + n == Width ? 0 : coverage & (std::uint32_t(-1) >> (start + n));
+		}
+	}
+}
+
 template <TransparencyType Transparency, LightType Light>
 DVL_ATTRIBUTE_HOT void RenderTileType(TileType tile, std::uint8_t *dst, int dstPitch, const std::uint8_t *src, const std::uint32_t *mask, const std::uint8_t *tbl, Clip clip)
 {
@@ -1224,7 +1288,10 @@ DVL_ATTRIBUTE_HOT void RenderTileType(TileType tile, std::uint8_t *dst, int dstP
 		RenderSquare<Transparency, Light>(dst, dstPitch, src, mask, tbl, clip);
 		break;
 	case TileType::TransparentSquare:
-		RenderTransparentSquare<Transparency, Light>(dst, dstPitch, src, mask, tbl, clip);
+		if (src == nullptr) // Decoded in the tile atlas
+			RenderAtlasTile<Transparency, Light>(dst, dstPitch, TileAtlas[level_cel_block & 0xFFF], mask, tbl, clip);
+		else
+			RenderTransparentSquare<Transparency, Light>(dst, dstPitch, src, mask, tbl, clip);
 		break;
 	case TileType::LeftTriangle:
 		RenderLeftTriangle<Transparency, Light>(dst, dstPitch, src, mask, tbl, clip);
@@ -1283,6 +1350,12 @@ const std::uint32_t *GetMask(TileType tile)
 	return &SolidMask[TILE_HEIGHT - 1];
 }
 
+DVL_ALWAYS_INLINE void FillBlack(std::uint8_t *dst, std::size_t width)
+{
+	CountRenderedPixels(width);
+	memset(dst, 0, width);
+}
+
 // Blit with left and vertical clipping.
 void RenderBlackTileClipLeftAndVertical(std::uint8_t *dst, int dstPitch, int sx, DiamondClipY clipY)
 {
@@ -1293,9 +1366,9 @@ void RenderBlackTileClipLeftAndVertical(std::uint8_t *dst, int dstPitch, int sx,
 		const auto w = 2 * XStep * i;
 		const auto curX = sx + TILE_WIDTH / 2 - XStep * i;
 		if (curX >= 0) {
-			memset(dst, 0, w);
+			FillBlack(dst, w);
 		} else if (-curX <= w) {
-			memset(dst - curX, 0, w + curX);
+			FillBlack(dst - curX, w + curX);
 		}
 	}
 	dst += 2 * XStep + XStep * clipY.upperBottom;
@@ -1305,9 +1378,9 @@ void RenderBlackTileClipLeftAndVertical(std::uint8_t *dst, int dstPitch, int sx,
 		const auto w = 2 * XStep * (TriangleUpperHeight - i);
 		const auto curX = sx + TILE_WIDTH / 2 - XStep * (TriangleUpperHeight - i);
 		if (curX >= 0) {
-			memset(dst, 0, w);
+			FillBlack(dst, w);
 		} else if (-curX <= w) {
-			memset(dst - curX, 0, w + curX);
+			FillBlack(dst - curX, w + curX);
 		} else {
 			break;
 		}
@@ -1325,7 +1398,7 @@ void RenderBlackTileClipRightAndVertical(std::uint8_t *dst, int dstPitch, std::i
 		const auto endX = TILE_WIDTH / 2 + XStep * i;
 		const auto skip = endX > maxWidth ? endX - maxWidth : 0;
 		if (width > skip)
-			memset(dst, 0, width - skip);
+			FillBlack(dst, width - skip);
 	}
 	dst += 2 * XStep + XStep * clipY.upperBottom;
 	// Upper triangle (drawn bottom to top):
@@ -1336,7 +1409,7 @@ void RenderBlackTileClipRightAndVertical(std::uint8_t *dst, int dstPitch, std::i
 		const auto skip = endX > maxWidth ? endX - maxWidth : 0;
 		if (width <= skip)
 			break;
-		memset(dst, 0, width - skip);
+		FillBlack(dst, width - skip);
 	}
 }
 
@@ -1347,13 +1420,13 @@ void RenderBlackTileClipY(std::uint8_t *dst, int dstPitch, DiamondClipY clipY)
 	// Lower triangle (drawn bottom to top):
 	const auto lowerMax = LowerHeight - clipY.lowerTop;
 	for (auto i = 1 + clipY.lowerBottom; i <= lowerMax; ++i, dst -= dstPitch + XStep) {
-		memset(dst, 0, 2 * XStep * i);
+		FillBlack(dst, 2 * XStep * i);
 	}
 	dst += 2 * XStep + XStep * clipY.upperBottom;
 	// Upper triangle (drawn bottom to top):
 	const auto upperMax = TriangleUpperHeight - clipY.upperTop;
 	for (auto i = 1 + clipY.upperBottom; i <= upperMax; ++i, dst -= dstPitch - XStep) {
-		memset(dst, 0, TILE_WIDTH - 2 * XStep * i);
+		FillBlack(dst, TILE_WIDTH - 2 * XStep * i);
 	}
 }
 
@@ -1364,19 +1437,42 @@ void RenderBlackTileFull(std::uint8_t *dst, int dstPitch)
 	// Tile is fully in bounds, can use constant loop boundaries.
 	// Lower triangle (drawn bottom to top):
 	for (unsigned i = 1; i <= LowerHeight; ++i, dst -= dstPitch + XStep) {
-		memset(dst, 0, 2 * XStep * i);
+		FillBlack(dst, 2 * XStep * i);
 	}
 	dst += 2 * XStep;
 	// Upper triangle (drawn bottom to to top):
 	for (unsigned i = 1; i <= TriangleUpperHeight; ++i, dst -= dstPitch - XStep) {
-		memset(dst, 0, TILE_WIDTH - 2 * XStep * i);
+		FillBlack(dst, TILE_WIDTH - 2 * XStep * i);
 	}
 }
 
 } // namespace
 
+void BuildTileAtlas(const std::uint16_t *pieces, std::size_t count)
+{
+	const auto *pFrameTable = pDungeonCels.DataAs<std::uint32_t>();
+	const std::uint32_t frameCount = SDL_SwapLE32(pFrameTable[0]);
+	TileAtlas.assign(frameCount + 1, AtlasTile {});
+
+	for (std::size_t i = 0; i < count; i++) {
+		const std::uint16_t block = SDL_SwapLE16(pieces[i]);
+		const std::uint16_t frame = block & 0xFFF;
+		const auto type = static_cast<TileType>((block & 0x7000) >> 12);
+		if (type != TileType::TransparentSquare || frame == 0 || frame > frameCount || TileAtlas[frame].decoded)
+			continue;
+		DecodeTransparentSquare(TileAtlas[frame], reinterpret_cast<const std::uint8_t *>(&pDungeonCels.Data()[SDL_SwapLE32(pFrameTable[frame])]));
+	}
+}
+
+void FreeTileAtlas()
+{
+	TileAtlas = std::vector<AtlasTile>();
+}
+
 void RenderTile(const Surface &out, int x, int y)
 {
+	RenderStatsScope stats(RenderPrimitive::RenderTile);
+
 	const auto tile = static_cast<TileType>((level_cel_block & 0x7000) >> 12);
 	const auto *mask = GetMask(tile);
 	if (mask == nullptr)
@@ -1397,8 +1493,13 @@ void RenderTile(const Surface &out, int x, int y)
 		return;
 
 	const std::uint8_t *tbl = &LightTables[256 * LightTableIndex];
-	const auto *pFrameTable = reinterpret_cast<const std::uint32_t *>(pDungeonCels.get());
-	const auto *src = reinterpret_cast<const std::uint8_t *>(&pDungeonCels[SDL_SwapLE32(pFrameTable[level_cel_block & 0xFFF])]);
+	// A null source selects the decoded transparent square from the atlas
+	const std::uint8_t *src = nullptr;
+	const auto frame = level_cel_block & 0xFFF;
+	if (tile != TileType::TransparentSquare || frame >= TileAtlas.size() || !TileAtlas[frame].decoded) {
+		const auto *pFrameTable = pDungeonCels.DataAs<std::uint32_t>();
+		src = reinterpret_cast<const std::uint8_t *>(&pDungeonCels.Data()[SDL_SwapLE32(pFrameTable[frame])]);
+	}
 	std::uint8_t *dst = out.at(static_cast<int>(x + clip.left), static_cast<int>(y - clip.bottom));
 	const auto dstPitch = out.pitch();
 
@@ -1434,6 +1535,8 @@ void RenderTile(const Surface &out, int x, int y)
 
 void world_draw_black_tile(const Surface &out, int sx, int sy)
 {
+	RenderStatsScope stats(RenderPrimitive::BlackTile);
+
 #ifdef DEBUG_RENDER_OFFSET_X
 	sx += DEBUG_RENDER_OFFSET_X;
 #endif
@@ -5,10 +5,28 @@
  */
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 #include "engine.h"
 
 namespace devilution {
 
+/**
+ * @brief Decodes the RLE encoded micro tiles of the level into 32x32 blocks of pixels that RenderTile()
+ * draws with plain row copies.
+ *
+ * Only used when the "Tile Atlas" graphics option is enabled. Needs pDungeonCels to be loaded.
+ * @param pieces Contents of the level's MIN file
+ * @param count Number of entries in pieces
+ */
+void BuildTileAtlas(const std::uint16_t *pieces, std::size_t count);
+
+/**
+ * @brief Frees the tile atlas, RenderTile() decodes the CEL data again until the next BuildTileAtlas().
+ */
+void FreeTileAtlas();
+
 /**
  * @brief Blit current world CEL to the given buffer
  * @param out Target buffer
@@ -0,0 +1,92 @@
+/**
+ * @file present.cpp
+ *
+ * Pixel kernels for getting the 8-bit back buffer onto the screen.
+ */
+#include "engine/render/present.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DEVILUTION_PRESENT_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DEVILUTION_PRESENT_NEON
+#include <arm_neon.h>
+#endif
+
+namespace devilution {
+
+void DoublePixels(const std::uint8_t *src, std::uint8_t *dst, int srcWidth)
+{
+	// Going from right to left, every block is read before anything at or after it is written.
+	int i = srcWidth;
+#if defined(DEVILUTION_PRESENT_SSE2)
+	while (i >= 16) {
+		i -= 16;
+		const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&src[i]));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(&dst[2 * i + 16]), _mm_unpackhi_epi8(pixels, pixels));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(&dst[2 * i]), _mm_unpacklo_epi8(pixels, pixels));
+	}
+#elif defined(DEVILUTION_PRESENT_NEON)
+	while (i >= 16) {
+		i -= 16;
+		uint8x16x2_t pixels;
+		pixels.val[0] = vld1q_u8(&src[i]);
+		pixels.val[1] = pixels.val[0];
+		vst2q_u8(&dst[2 * i], pixels);
+	}
+#endif
+	while (i > 0) {
+		i--;
+		const std::uint8_t pixel = src[i];
+		dst[2 * i + 1] = pixel;
+		dst[2 * i] = pixel;
+	}
+}
+
+void ZoomBuffer(std::uint8_t *buffer, int pitch, int offsetX, int width, int height)
+{
+	const int extraColumns = width % 2;
+	const int extraRows = height % 2;
+	const int doubleableWidth = width / 2;
+
+	// Source row extraRows + y becomes rows extraRows + 2 * y and the one below. Going from the bottom
+	// up, the rows written are always at or below the row read.
+	for (int y = height / 2 - 1; y >= 0; y--) {
+		const std::uint8_t *src = &buffer[(extraRows + y) * pitch];
+		std::uint8_t *upper = &buffer[(extraRows + 2 * y) * pitch + offsetX];
+		std::uint8_t *lower = upper + pitch;
+		DoublePixels(src + extraColumns, lower + extraColumns, doubleableWidth);
+		if (extraColumns != 0)
+			lower[0] = src[0];
+		memcpy(upper, lower, width);
+	}
+
+	if (extraRows != 0) {
+		DoublePixels(buffer + extraColumns, buffer + offsetX + extraColumns, doubleableWidth);
+		if (extraColumns != 0)
+			buffer[offsetX] = buffer[0];
+	}
+}
+
+void ExpandPalettedPixels(const std::uint8_t *src, std::uint32_t *dst, int count, const std::uint32_t lut[256])
+{
+	// Neither SSE2 nor NEON can gather 32-bit values by byte index, so this is plain table lookups
+	// unrolled to keep several loads in flight.
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const std::uint32_t a = lut[src[i]];
+		const std::uint32_t b = lut[src[i + 1]];
+		const std::uint32_t c = lut[src[i + 2]];
+		const std::uint32_t d = lut[src[i + 3]];
+		dst[i] = a;
+		dst[i + 1] = b;
+		dst[i + 2] = c;
+		dst[i + 3] = d;
+	}
+	for (; i < count; i++)
+		dst[i] = lut[src[i]];
+}
+
+} // namespace devilution
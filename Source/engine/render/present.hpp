@@ -0,0 +1,43 @@
+/**
+ * @file present.hpp
+ *
+ * Pixel kernels for getting the 8-bit back buffer onto the screen: 2x upscaling of the
+ * viewport and expansion of palette indices to 32-bit output pixels.
+ *
+ * SSE2 and NEON versions are used when the target has them, otherwise a portable loop.
+ * All versions produce the same output.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace devilution {
+
+/**
+ * @brief Writes every source pixel twice: dst[2 * i] = dst[2 * i + 1] = src[i].
+ *
+ * The line is processed from right to left, so `dst` may start at or after `src` in the same buffer.
+ */
+void DoublePixels(const std::uint8_t *src, std::uint8_t *dst, int srcWidth);
+
+/**
+ * @brief Scales up the top left part of a buffer 2x in place.
+ *
+ * The source is the top left `(width + 1) / 2` x `(height + 1) / 2` pixels. If the width or height is
+ * odd, the first source column / row is copied once and the rest doubled.
+ *
+ * @param buffer Top left pixel of the buffer
+ * @param pitch Distance in bytes between the starts of two lines
+ * @param offsetX Column of the buffer where the scaled output starts
+ * @param width Width of the scaled output
+ * @param height Height of the scaled output
+ */
+void ZoomBuffer(std::uint8_t *buffer, int pitch, int offsetX, int width, int height);
+
+/**
+ * @brief Converts palette indices to output pixels.
+ * @param lut Output pixel of every palette index
+ */
+void ExpandPalettedPixels(const std::uint8_t *src, std::uint32_t *dst, int count, const std::uint32_t lut[256]);
+
+} // namespace devilution
@@ -0,0 +1,48 @@
+/**
+ * @file render_stats.cpp
+ *
+ * Call and pixel counters for the low-level render primitives.
+ */
+#include "engine/render/render_stats.hpp"
+
+namespace devilution {
+
+#ifdef BUILD_BENCHMARKS
+
+std::array<RenderPrimitiveStats, RenderPrimitiveCount> RenderStats;
+std::uint64_t RenderedPixels;
+
+void ResetRenderStats()
+{
+	RenderStats = {};
+	RenderedPixels = 0;
+}
+
+#endif
+
+const char *RenderPrimitiveName(RenderPrimitive primitive)
+{
+	switch (primitive) {
+	case RenderPrimitive::RenderTile:
+		return "RenderTile";
+	case RenderPrimitive::BlackTile:
+		return "world_draw_black_tile";
+	case RenderPrimitive::Cl2Draw:
+		return "Cl2Draw";
+	case RenderPrimitive::Cl2DrawOutline:
+		return "Cl2DrawOutline";
+	case RenderPrimitive::Cl2DrawLightTbl:
+		return "Cl2DrawLightTbl";
+	case RenderPrimitive::Cl2DrawLight:
+		return "Cl2DrawLight";
+	case RenderPrimitive::CelClippedDrawTo:
+		return "CelClippedDrawTo";
+	case RenderPrimitive::CelClippedDrawLightTo:
+		return "CelClippedDrawLightTo";
+	case RenderPrimitive::CelClippedBlitLightTransTo:
+		return "CelClippedBlitLightTransTo";
+	}
+	return "";
+}
+
+} // namespace devilution
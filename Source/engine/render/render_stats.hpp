@@ -0,0 +1,96 @@
+/**
+ * @file render_stats.hpp
+ *
+ * Call and pixel counters for the low-level render primitives.
+ *
+ * The counters are only compiled in when building the benchmark harness (BUILD_BENCHMARKS),
+ * otherwise every hook is an empty inline function.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace devilution {
+
+enum class RenderPrimitive : std::uint8_t {
+	RenderTile,
+	BlackTile,
+	Cl2Draw,
+	Cl2DrawOutline,
+	Cl2DrawLightTbl,
+	Cl2DrawLight,
+	CelClippedDrawTo,
+	CelClippedDrawLightTo,
+	CelClippedBlitLightTransTo,
+};
+
+constexpr std::size_t RenderPrimitiveCount = static_cast<std::size_t>(RenderPrimitive::CelClippedBlitLightTransTo) + 1;
+
+struct RenderPrimitiveStats {
+	/** Number of times the primitive was called, including calls that were fully clipped. */
+	std::uint64_t calls;
+	/**
+	 * Number of destination pixels in the spans written by the primitive after clipping.
+	 * Tile lines with a transparency mask are counted in full.
+	 */
+	std::uint64_t pixels;
+};
+
+const char *RenderPrimitiveName(RenderPrimitive primitive);
+
+#ifdef BUILD_BENCHMARKS
+
+extern std::array<RenderPrimitiveStats, RenderPrimitiveCount> RenderStats;
+/** Running total of pixels written by all primitives, used to attribute pixels to the active primitive. */
+extern std::uint64_t RenderedPixels;
+
+void ResetRenderStats();
+
+inline void CountRenderedPixels(std::size_t pixels)
+{
+	RenderedPixels += pixels;
+}
+
+/**
+ * @brief Counts a call of a render primitive and the pixels written until the end of the scope.
+ */
+class RenderStatsScope {
+public:
+	explicit RenderStatsScope(RenderPrimitive primitive)
+	    : stats_(RenderStats[static_cast<std::size_t>(primitive)])
+	    , pixelsBefore_(RenderedPixels)
+	{
+		stats_.calls++;
+	}
+
+	RenderStatsScope(const RenderStatsScope &) = delete;
+	RenderStatsScope &operator=(const RenderStatsScope &) = delete;
+
+	~RenderStatsScope()
+	{
+		stats_.pixels += RenderedPixels - pixelsBefore_;
+	}
+
+private:
+	RenderPrimitiveStats &stats_;
+	std::uint64_t pixelsBefore_;
+};
+
+#else
+
+inline void CountRenderedPixels(std::size_t /*pixels*/)
+{
+}
+
+class RenderStatsScope {
+public:
+	explicit RenderStatsScope(RenderPrimitive /*primitive*/)
+	{
+	}
+};
+
+#endif
+
+} // namespace devilution
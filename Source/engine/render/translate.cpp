@@ -0,0 +1,151 @@
+/**
+ * @file translate.cpp
+ *
+ * Color table translation kernels.
+ */
+#include "engine/render/translate.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DEVILUTION_TRANSLATE_AVX2
+#define DVL_TARGET(features) __attribute__((target(features)))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define DEVILUTION_TRANSLATE_AVX2
+#define DVL_TARGET(features)
+#include <immintrin.h>
+#include <intrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define DEVILUTION_TRANSLATE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace devilution {
+
+namespace {
+
+void TranslatePixelsScalar(const std::uint8_t *src, std::uint8_t *dst, std::size_t n, const std::uint8_t *tbl)
+{
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const std::uint8_t a = tbl[src[i]];
+		const std::uint8_t b = tbl[src[i + 1]];
+		const std::uint8_t c = tbl[src[i + 2]];
+		const std::uint8_t d = tbl[src[i + 3]];
+		dst[i] = a;
+		dst[i + 1] = b;
+		dst[i + 2] = c;
+		dst[i + 3] = d;
+	}
+	for (; i < n; i++)
+		dst[i] = tbl[src[i]];
+}
+
+#ifdef DEVILUTION_TRANSLATE_AVX2
+/*
+ * The table is split into 16 lanes of 16 entries, VPSHUFB looks up the low nibble of every pixel in each
+ * of them. Subtracting 16 * lane from the pixels and adding 0x70 with unsigned saturation leaves the low
+ * nibble of the pixels in that lane with bit 7 clear, and sets bit 7 of all others, which VPSHUFB turns
+ * into 0. OR-ing the 16 lookups together gives the translated pixels.
+ *
+ * That is 64 instructions for 32 pixels. It only beats plain table loads on long runs, and the 128-bit
+ * SSSE3 version of it never does, so there is none.
+ */
+DVL_TARGET("avx2")
+void TranslatePixelsAvx2(const std::uint8_t *src, std::uint8_t *dst, std::size_t n, const std::uint8_t *tbl)
+{
+	// VPSHUFB shuffles within each 128-bit half, so both halves get a copy of the lane.
+	__m256i lanes[16];
+	for (int lane = 0; lane < 16; lane++)
+		lanes[lane] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&tbl[16 * lane])));
+	const __m256i laneStep = _mm256_set1_epi8(16);
+	const __m256i outsideLane = _mm256_set1_epi8(0x70);
+
+	std::size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		__m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&src[i]));
+		__m256i result = _mm256_shuffle_epi8(lanes[0], _mm256_adds_epu8(index, outsideLane));
+		for (int lane = 1; lane < 16; lane++) {
+			index = _mm256_sub_epi8(index, laneStep);
+			result = _mm256_or_si256(result, _mm256_shuffle_epi8(lanes[lane], _mm256_adds_epu8(index, outsideLane)));
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(&dst[i]), result);
+	}
+	TranslatePixelsScalar(&src[i], &dst[i], n - i, tbl);
+}
+
+bool CpuSupportsAvx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	// The OS must also save the upper halves of the YMM registers
+	__cpuid(info, 1);
+	constexpr int OsXSave = 1 << 27;
+	constexpr int Avx = 1 << 28;
+	if ((info[2] & (OsXSave | Avx)) != (OsXSave | Avx) || (_xgetbv(0) & 6) != 6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#ifdef DEVILUTION_TRANSLATE_NEON
+void TranslatePixelsNeon(const std::uint8_t *src, std::uint8_t *dst, std::size_t n, const std::uint8_t *tbl)
+{
+	// TBL looks up 64 table entries at once and gives 0 for larger indices, TBX leaves those pixels as they
+	// are. 4 lookups translate 16 pixels.
+	uint8x16x4_t quarters[4];
+	for (int quarter = 0; quarter < 4; quarter++) {
+		for (int part = 0; part < 4; part++)
+			quarters[quarter].val[part] = vld1q_u8(&tbl[64 * quarter + 16 * part]);
+	}
+	const uint8x16_t quarterStep = vdupq_n_u8(64);
+
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		uint8x16_t index = vld1q_u8(&src[i]);
+		uint8x16_t result = vqtbl4q_u8(quarters[0], index);
+		for (int quarter = 1; quarter < 4; quarter++) {
+			index = vsubq_u8(index, quarterStep);
+			result = vqtbx4q_u8(result, quarters[quarter], index);
+		}
+		vst1q_u8(&dst[i], result);
+	}
+	TranslatePixelsScalar(&src[i], &dst[i], n - i, tbl);
+}
+#endif
+
+std::vector<TranslateKernel> FindSupportedKernels()
+{
+	std::vector<TranslateKernel> kernels { { "scalar", TranslatePixelsScalar } };
+#ifdef DEVILUTION_TRANSLATE_AVX2
+	if (CpuSupportsAvx2())
+		kernels.push_back({ "avx2", TranslatePixelsAvx2 });
+#endif
+#ifdef DEVILUTION_TRANSLATE_NEON
+	kernels.push_back({ "neon", TranslatePixelsNeon });
+#endif
+	return kernels;
+}
+
+void (*const BestTranslateKernel)(const std::uint8_t *, std::uint8_t *, std::size_t, const std::uint8_t *) = FindSupportedKernels().back().translate;
+
+} // namespace
+
+void TranslatePixelsVector(const std::uint8_t *src, std::uint8_t *dst, std::size_t n, const std::uint8_t *tbl)
+{
+	BestTranslateKernel(src, dst, n, tbl);
+}
+
+std::vector<TranslateKernel> SupportedTranslateKernels()
+{
+	return FindSupportedKernels();
+}
+
+} // namespace devilution
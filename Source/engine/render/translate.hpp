@@ -0,0 +1,60 @@
+/**
+ * @file translate.hpp
+ *
+ * Translation of pixels through a 256-byte color table, such as a light table or a TRN file.
+ *
+ * Long runs are translated with table lookup instructions: TBL on AArch64, 16 pixels at a time, and
+ * VPSHUFB on x86 CPUs with AVX2, 32 pixels at a time. AVX2 support is checked at startup. All versions
+ * produce the same output.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "utils/attributes.h"
+
+namespace devilution {
+
+/** @brief Runs shorter than this are translated inline, a vector kernel is not worth its setup for them. */
+#if defined(__aarch64__) || defined(_M_ARM64)
+constexpr std::size_t TranslateVectorMinimum = 16;
+#else
+constexpr std::size_t TranslateVectorMinimum = 64;
+#endif
+
+/**
+ * @brief Translates a run of at least TranslateVectorMinimum pixels with the best kernel for the CPU.
+ *
+ * `dst` may be the same as `src`.
+ */
+void TranslatePixelsVector(const std::uint8_t *src, std::uint8_t *dst, std::size_t n, const std::uint8_t *tbl);
+
+/**
+ * @brief Writes dst[i] = tbl[src[i]] for every pixel of the run.
+ *
+ * `dst` may be the same as `src`.
+ */
+DVL_ALWAYS_INLINE void TranslatePixels(const std::uint8_t *src, std::uint8_t *dst, std::size_t n, const std::uint8_t *tbl)
+{
+	if (n >= TranslateVectorMinimum) {
+		TranslatePixelsVector(src, dst, n, tbl);
+		return;
+	}
+	for (std::size_t i = 0; i < n; i++)
+		dst[i] = tbl[src[i]];
+}
+
+struct TranslateKernel {
+	const char *name;
+	void (*translate)(const std::uint8_t *src, std::uint8_t *dst, std::size_t n, const std::uint8_t *tbl);
+};
+
+/**
+ * @brief Returns every kernel that the CPU can run, the portable one first and the one used by
+ * TranslatePixelsVector() last.
+ */
+std::vector<TranslateKernel> SupportedTranslateKernels();
+
+} // namespace devilution
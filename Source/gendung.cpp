@@ -25,7 +25,7 @@ bool setloadflag;
 std::optional<CelSprite> pSpecialCels;
 std::unique_ptr<MegaTile[]> pMegaTiles;
 std::unique_ptr<uint16_t[]> pLevelPieces;
-std::unique_ptr<byte[]> pDungeonCels;
+AssetView pDungeonCels;
 std::array<uint8_t, MAXTILES + 1> block_lvid;
 std::array<bool, MAXTILES + 1> nBlockTable;
 std::array<bool, MAXTILES + 1> nSolidTable;
@@ -289,6 +289,9 @@ void FillSolidBlockTbls()
 
 void SetDungeonMicros()
 {
+	// Called after dPiece changes, which may have opened or closed lines of sight
+	ClearVisionCache();
+
 	MicroTileLen = 10;
 	int blocks = 10;
 
@@ -9,6 +9,7 @@
 #include <memory>
 
 #include "engine.h"
+#include "engine/asset_view.hpp"
 #include "engine/cel_sprite.hpp"
 #include "engine/point.hpp"
 #include "scrollrt.h"
@@ -143,7 +144,7 @@ extern std::optional<CelSprite> pSpecialCels;
 /** Specifies the tile definitions of the active dungeon type; (e.g. levels/l1data/l1.til). */
 extern std::unique_ptr<MegaTile[]> pMegaTiles;
 extern std::unique_ptr<uint16_t[]> pLevelPieces;
-extern std::unique_ptr<byte[]> pDungeonCels;
+extern AssetView pDungeonCels;
 /**
  * List of transparancy masks to use for dPieces
  */
@@ -59,7 +59,7 @@ HANDLE LoadMPQ(const std::vector<std::string> &paths, const char *mpqName)
 	std::string mpqAbsPath;
 	for (const auto &path : paths) {
 		mpqAbsPath = path + mpqName;
-		if (SFileOpenArchive(mpqAbsPath.c_str(), 0, MPQ_OPEN_READ_ONLY, &archive)) {
+		if (SFileOpenSharedArchive(mpqAbsPath.c_str(), &archive)) {
 			LogVerbose("  Found: {} in {}", mpqName, path);
 			SFileSetBasePath(path.c_str());
 			return archive;
@@ -82,7 +82,9 @@ void init_cleanup()
 	if (gbIsMultiplayer && gbRunGame) {
 		pfile_write_hero(/*writeGameData=*/false, /*clearTables=*/true);
 	}
+	pfile_wait_for_save();
 
+	SFileCloseThreadArchives();
 	if (spawn_mpq != nullptr) {
 		SFileCloseArchive(spawn_mpq);
 		spawn_mpq = nullptr;
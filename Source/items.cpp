@@ -9,6 +9,9 @@
 #include <bitset>
 #include <climits>
 #include <cstdint>
+#include <initializer_list>
+#include <unordered_map>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -363,6 +366,74 @@ bool IsSuffixValidForItemType(int i, int flgs)
 	return (flgs & itemTypes) != 0;
 }
 
+/**
+ * @brief Candidate lists of the random item and affix picks.
+ *
+ * A list only depends on the item tables, the game mode and the arguments of the pick, so it is
+ * built once by the original scan and then reused. Lists keep the order of the scan, which keeps
+ * the picked ids the same for a given seed.
+ */
+class CandidateCache {
+public:
+	/**
+	 * @brief Returns the list for the given pick, building it with collect(ids) on first use.
+	 * @param collect Writes up to 512 ids and returns how many it wrote
+	 */
+	template <typename Collect>
+	const std::vector<int16_t> &Get(uint64_t key, Collect collect)
+	{
+		const uint32_t gameMode = GetGameMode();
+		if (gameMode != gameMode_) {
+			lists_.clear();
+			gameMode_ = gameMode;
+		}
+
+		auto it = lists_.find(key);
+		if (it == lists_.end()) {
+			int ids[512];
+			const int count = collect(ids);
+			it = lists_.emplace(key, std::vector<int16_t>(ids, ids + std::max(count, 0))).first;
+		}
+		return it->second;
+	}
+
+private:
+	/** Everything besides the arguments that decides which items and affixes can drop. */
+	static uint32_t GetGameMode()
+	{
+		return (gbIsHellfire ? 1 : 0)
+		    | (gbIsSpawn ? 2 : 0)
+		    | (gbIsMultiplayer ? 4 : 0)
+		    | (sgOptions.Gameplay.bTestBard ? 8 : 0);
+	}
+
+	uint32_t gameMode_ = UINT32_MAX;
+	std::unordered_map<uint64_t, std::vector<int16_t>> lists_;
+};
+
+CandidateCache StaffPrefixCandidates;
+CandidateCache PrefixCandidates;
+CandidateCache SuffixCandidates;
+CandidateCache UniqueDropCandidates;
+CandidateCache AllItemCandidates;
+CandidateCache TypeItemCandidates;
+
+/** @brief Packs up to four pick arguments into a cache key. */
+uint64_t CandidateKey(std::initializer_list<int> arguments)
+{
+	uint64_t key = 0;
+	for (int argument : arguments)
+		key = (key << 16) | static_cast<uint16_t>(argument);
+	return key;
+}
+
+/** @brief Picks a random entry, consuming the same random number the original scans did. */
+int PickCandidate(const std::vector<int16_t> &candidates)
+{
+	const int index = GenerateRnd(candidates.size());
+	return candidates.empty() ? 0 : candidates[index];
+}
+
 int ItemsGetCurrlevel()
 {
 	int lvl = currlevel;
@@ -1148,22 +1219,24 @@ void GetStaffPower(int i, int lvl, int bs, bool onlygood)
 {
 	int preidx = -1;
 	if (GenerateRnd(10) == 0 || onlygood) {
-		int nl = 0;
-		int l[256];
-		for (int j = 0; ItemPrefixes[j].power.type != IPL_INVALID; j++) {
-			if (!IsPrefixValidForItemType(j, PLT_STAFF) || ItemPrefixes[j].PLMinLvl > lvl)
-				continue;
-			if (onlygood && !ItemPrefixes[j].PLOk)
-				continue;
-			l[nl] = j;
-			nl++;
-			if (ItemPrefixes[j].PLDouble) {
+		const auto &candidates = StaffPrefixCandidates.Get(CandidateKey({ lvl, onlygood ? 1 : 0 }), [&](int *l) {
+			int nl = 0;
+			for (int j = 0; ItemPrefixes[j].power.type != IPL_INVALID; j++) {
+				if (!IsPrefixValidForItemType(j, PLT_STAFF) || ItemPrefixes[j].PLMinLvl > lvl)
+					continue;
+				if (onlygood && !ItemPrefixes[j].PLOk)
+					continue;
 				l[nl] = j;
 				nl++;
+				if (ItemPrefixes[j].PLDouble) {
+					l[nl] = j;
+					nl++;
+				}
 			}
-		}
-		if (nl != 0) {
-			preidx = l[GenerateRnd(nl)];
+			return nl;
+		});
+		if (!candidates.empty()) {
+			preidx = PickCandidate(candidates);
 			char istr[128];
 			sprintf(istr, "%s %s", _(ItemPrefixes[preidx].PLName), Items[i]._iIName);
 			strcpy(Items[i]._iIName, istr);
@@ -1189,7 +1262,6 @@ void GetStaffPower(int i, int lvl, int bs, bool onlygood)
 
 void GetItemPower(int i, int minlvl, int maxlvl, affix_item_type flgs, bool onlygood)
 {
-	int l[256];
 	char istr[128];
 	goodorevil goe;
 
@@ -1207,25 +1279,28 @@ void GetItemPower(int i, int minlvl, int maxlvl, affix_item_type flgs, bool only
 	if (!onlygood && GenerateRnd(3) != 0)
 		onlygood = true;
 	if (pre == 0) {
-		int nt = 0;
-		for (int j = 0; ItemPrefixes[j].power.type != IPL_INVALID; j++) {
-			if (!IsPrefixValidForItemType(j, flgs))
-				continue;
-			if (ItemPrefixes[j].PLMinLvl < minlvl || ItemPrefixes[j].PLMinLvl > maxlvl)
-				continue;
-			if (onlygood && !ItemPrefixes[j].PLOk)
-				continue;
-			if (flgs == PLT_STAFF && ItemPrefixes[j].power.type == IPL_CHARGES)
-				continue;
-			l[nt] = j;
-			nt++;
-			if (ItemPrefixes[j].PLDouble) {
+		const auto &candidates = PrefixCandidates.Get(CandidateKey({ flgs, minlvl, maxlvl, onlygood ? 1 : 0 }), [&](int *l) {
+			int nt = 0;
+			for (int j = 0; ItemPrefixes[j].power.type != IPL_INVALID; j++) {
+				if (!IsPrefixValidForItemType(j, flgs))
+					continue;
+				if (ItemPrefixes[j].PLMinLvl < minlvl || ItemPrefixes[j].PLMinLvl > maxlvl)
+					continue;
+				if (onlygood && !ItemPrefixes[j].PLOk)
+					continue;
+				if (flgs == PLT_STAFF && ItemPrefixes[j].power.type == IPL_CHARGES)
+					continue;
 				l[nt] = j;
 				nt++;
+				if (ItemPrefixes[j].PLDouble) {
+					l[nt] = j;
+					nt++;
+				}
 			}
-		}
-		if (nt != 0) {
-			preidx = l[GenerateRnd(nt)];
+			return nt;
+		});
+		if (!candidates.empty()) {
+			preidx = PickCandidate(candidates);
 			sprintf(istr, "%s %s", _(ItemPrefixes[preidx].PLName), Items[i]._iIName);
 			strcpy(Items[i]._iIName, istr);
 			Items[i]._iMagical = ITEM_QUALITY_MAGIC;
@@ -1235,18 +1310,21 @@ void GetItemPower(int i, int minlvl, int maxlvl, affix_item_type flgs, bool only
 		}
 	}
 	if (post != 0) {
-		int nl = 0;
-		for (int j = 0; ItemSuffixes[j].power.type != IPL_INVALID; j++) {
-			if (IsSuffixValidForItemType(j, flgs)
-			    && ItemSuffixes[j].PLMinLvl >= minlvl && ItemSuffixes[j].PLMinLvl <= maxlvl
-			    && !((goe == GOE_GOOD && ItemSuffixes[j].PLGOE == GOE_EVIL) || (goe == GOE_EVIL && ItemSuffixes[j].PLGOE == GOE_GOOD))
-			    && (!onlygood || ItemSuffixes[j].PLOk)) {
-				l[nl] = j;
-				nl++;
+		const auto &candidates = SuffixCandidates.Get(CandidateKey({ flgs, minlvl, maxlvl, (onlygood ? 1 : 0) | (goe << 1) }), [&](int *l) {
+			int nl = 0;
+			for (int j = 0; ItemSuffixes[j].power.type != IPL_INVALID; j++) {
+				if (IsSuffixValidForItemType(j, flgs)
+				    && ItemSuffixes[j].PLMinLvl >= minlvl && ItemSuffixes[j].PLMinLvl <= maxlvl
+				    && !((goe == GOE_GOOD && ItemSuffixes[j].PLGOE == GOE_EVIL) || (goe == GOE_EVIL && ItemSuffixes[j].PLGOE == GOE_GOOD))
+				    && (!onlygood || ItemSuffixes[j].PLOk)) {
+					l[nl] = j;
+					nl++;
+				}
 			}
-		}
-		if (nl != 0) {
-			sufidx = l[GenerateRnd(nl)];
+			return nl;
+		});
+		if (!candidates.empty()) {
+			sufidx = PickCandidate(candidates);
 			strcpy(istr, fmt::format(_("{:s} of {:s}"), Items[i]._iIName, _(ItemSuffixes[sufidx].PLName)).c_str());
 			strcpy(Items[i]._iIName, istr);
 			Items[i]._iMagical = ITEM_QUALITY_MAGIC;
@@ -1399,41 +1477,35 @@ int RndUItem(int m)
 	if (m != -1 && (Monsters[m].MData->mTreasure & 0x8000) != 0 && !gbIsMultiplayer)
 		return -((Monsters[m].MData->mTreasure & 0xFFF) + 1);
 
-	int ril[512];
-
-	int curlv = ItemsGetCurrlevel();
-	int ri = 0;
-	for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
-		if (!IsItemAvailable(i))
-			continue;
+	const int maxLevel = m != -1 ? Monsters[m].mLevel : 2 * ItemsGetCurrlevel();
+	return PickCandidate(UniqueDropCandidates.Get(CandidateKey({ maxLevel }), [&](int *ril) {
+		int ri = 0;
+		for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
+			if (!IsItemAvailable(i))
+				continue;
 
-		bool okflag = true;
-		if (AllItemsList[i].iRnd == IDROP_NEVER)
-			okflag = false;
-		if (m != -1) {
-			if (Monsters[m].mLevel < AllItemsList[i].iMinMLvl)
+			bool okflag = true;
+			if (AllItemsList[i].iRnd == IDROP_NEVER)
 				okflag = false;
-		} else {
-			if (2 * curlv < AllItemsList[i].iMinMLvl)
+			if (maxLevel < AllItemsList[i].iMinMLvl)
 				okflag = false;
+			if (AllItemsList[i].itype == ITYPE_MISC)
+				okflag = false;
+			if (AllItemsList[i].itype == ITYPE_GOLD)
+				okflag = false;
+			if (AllItemsList[i].iMiscId == IMISC_BOOK)
+				okflag = true;
+			if (AllItemsList[i].iSpell == SPL_RESURRECT && !gbIsMultiplayer)
+				okflag = false;
+			if (AllItemsList[i].iSpell == SPL_HEALOTHER && !gbIsMultiplayer)
+				okflag = false;
+			if (okflag && ri < 512) {
+				ril[ri] = i;
+				ri++;
+			}
 		}
-		if (AllItemsList[i].itype == ITYPE_MISC)
-			okflag = false;
-		if (AllItemsList[i].itype == ITYPE_GOLD)
-			okflag = false;
-		if (AllItemsList[i].iMiscId == IMISC_BOOK)
-			okflag = true;
-		if (AllItemsList[i].iSpell == SPL_RESURRECT && !gbIsMultiplayer)
-			okflag = false;
-		if (AllItemsList[i].iSpell == SPL_HEALOTHER && !gbIsMultiplayer)
-			okflag = false;
-		if (okflag && ri < 512) {
-			ril[ri] = i;
-			ri++;
-		}
-	}
-
-	return ril[GenerateRnd(ri)];
+		return ri;
+	}));
 }
 
 int RndAllItems()
@@ -1441,52 +1513,50 @@ int RndAllItems()
 	if (GenerateRnd(100) > 25)
 		return 0;
 
-	int ril[512];
-
 	int curlv = ItemsGetCurrlevel();
-	int ri = 0;
-	for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
-		if (!IsItemAvailable(i))
-			continue;
+	return PickCandidate(AllItemCandidates.Get(CandidateKey({ curlv }), [&](int *ril) {
+		int ri = 0;
+		for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
+			if (!IsItemAvailable(i))
+				continue;
 
-		if (AllItemsList[i].iRnd != IDROP_NEVER && 2 * curlv >= AllItemsList[i].iMinMLvl && ri < 512) {
-			ril[ri] = i;
-			ri++;
+			if (AllItemsList[i].iRnd != IDROP_NEVER && 2 * curlv >= AllItemsList[i].iMinMLvl && ri < 512) {
+				ril[ri] = i;
+				ri++;
+			}
+			if (AllItemsList[i].iSpell == SPL_RESURRECT && !gbIsMultiplayer)
+				ri--;
+			if (AllItemsList[i].iSpell == SPL_HEALOTHER && !gbIsMultiplayer)
+				ri--;
 		}
-		if (AllItemsList[i].iSpell == SPL_RESURRECT && !gbIsMultiplayer)
-			ri--;
-		if (AllItemsList[i].iSpell == SPL_HEALOTHER && !gbIsMultiplayer)
-			ri--;
-	}
-
-	return ril[GenerateRnd(ri)];
+		return ri;
+	}));
 }
 
 int RndTypeItems(int itype, int imid, int lvl)
 {
-	int ril[512];
-
-	int ri = 0;
-	for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
-		if (!IsItemAvailable(i))
-			continue;
+	return PickCandidate(TypeItemCandidates.Get(CandidateKey({ itype, imid, lvl }), [&](int *ril) {
+		int ri = 0;
+		for (int i = 0; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
+			if (!IsItemAvailable(i))
+				continue;
 
-		bool okflag = true;
-		if (AllItemsList[i].iRnd == IDROP_NEVER)
-			okflag = false;
-		if (lvl * 2 < AllItemsList[i].iMinMLvl)
-			okflag = false;
-		if (AllItemsList[i].itype != itype)
-			okflag = false;
-		if (imid != -1 && AllItemsList[i].iMiscId != imid)
-			okflag = false;
-		if (okflag && ri < 512) {
-			ril[ri] = i;
-			ri++;
+			bool okflag = true;
+			if (AllItemsList[i].iRnd == IDROP_NEVER)
+				okflag = false;
+			if (lvl * 2 < AllItemsList[i].iMinMLvl)
+				okflag = false;
+			if (AllItemsList[i].itype != itype)
+				okflag = false;
+			if (imid != -1 && AllItemsList[i].iMiscId != imid)
+				okflag = false;
+			if (okflag && ri < 512) {
+				ril[ri] = i;
+				ri++;
+			}
 		}
-	}
-
-	return ril[GenerateRnd(ri)];
+		return ri;
+	}));
 }
 
 _unique_items CheckUnique(int i, int lvl, int uper, bool recreate)
@@ -2122,37 +2192,42 @@ bool SmithItemOk(int i)
 	return true;
 }
 
+/**
+ * @param okState Everything besides the item tables and the game mode that Ok() depends on, as part
+ * of the key of the cached candidate list
+ */
 template <bool (*Ok)(int), bool ConsiderDropRate = false>
-int RndVendorItem(int minlvl, int maxlvl)
+int RndVendorItem(int minlvl, int maxlvl, int okState = 0)
 {
-	int ril[512];
-
-	int ri = 0;
-	for (int i = 1; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
-		if (!IsItemAvailable(i))
-			continue;
-		if (AllItemsList[i].iRnd == IDROP_NEVER)
-			continue;
-		if (!Ok(i))
-			continue;
-		if (AllItemsList[i].iMinMLvl < minlvl || AllItemsList[i].iMinMLvl > maxlvl)
-			continue;
+	static CandidateCache vendorCandidates;
 
-		ril[ri] = i;
-		ri++;
-		if (ri == 512)
-			break;
+	return PickCandidate(vendorCandidates.Get(CandidateKey({ minlvl, maxlvl, okState }), [&](int *ril) {
+		int ri = 0;
+		for (int i = 1; AllItemsList[i].iLoc != ILOC_INVALID; i++) {
+			if (!IsItemAvailable(i))
+				continue;
+			if (AllItemsList[i].iRnd == IDROP_NEVER)
+				continue;
+			if (!Ok(i))
+				continue;
+			if (AllItemsList[i].iMinMLvl < minlvl || AllItemsList[i].iMinMLvl > maxlvl)
+				continue;
 
-		if (!ConsiderDropRate || AllItemsList[i].iRnd != IDROP_DOUBLE)
-			continue;
+			ril[ri] = i;
+			ri++;
+			if (ri == 512)
+				break;
 
-		ril[ri] = i;
-		ri++;
-		if (ri == 512)
-			break;
-	}
+			if (!ConsiderDropRate || AllItemsList[i].iRnd != IDROP_DOUBLE)
+				continue;
 
-	return ril[GenerateRnd(ri)] + 1;
+			ril[ri] = i;
+			ri++;
+			if (ri == 512)
+				break;
+		}
+		return ri;
+	})) + 1;
 }
 
 int RndSmithItem(int lvl)
@@ -2350,9 +2425,22 @@ bool HealerItemOk(int i)
 	return false;
 }
 
+/** @brief Returns which elixirs HealerItemOk() lets the hero buy, one bit per base attribute. */
+int HealerElixirState()
+{
+	if (gbIsMultiplayer || !gbIsHellfire)
+		return 0;
+
+	auto &myPlayer = Players[MyPlayerId];
+	return (myPlayer._pBaseStr < myPlayer.GetMaximumAttributeValue(CharacterAttribute::Strength) ? 1 : 0)
+	    | (myPlayer._pBaseMag < myPlayer.GetMaximumAttributeValue(CharacterAttribute::Magic) ? 2 : 0)
+	    | (myPlayer._pBaseDex < myPlayer.GetMaximumAttributeValue(CharacterAttribute::Dexterity) ? 4 : 0)
+	    | (myPlayer._pBaseVit < myPlayer.GetMaximumAttributeValue(CharacterAttribute::Vitality) ? 8 : 0);
+}
+
 int RndHealerItem(int lvl)
 {
-	return RndVendorItem<HealerItemOk>(0, lvl);
+	return RndVendorItem<HealerItemOk>(0, lvl, HealerElixirState());
 }
 
 void RecreateSmithItem(int ii, int lvl, int iseed)
@@ -5,19 +5,30 @@
  */
 #include "lighting.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "automap.h"
 #include "diablo.h"
 #include "engine/load_file.hpp"
+#include "engine/rectangle.hpp"
+#include "multi.h"
 #include "player.h"
 
 namespace devilution {
 
-LightStruct VisionList[MAXVISION];
+std::vector<LightStruct> VisionList;
 int VisionCount;
 int VisionId;
-LightStruct Lights[MAXLIGHTS];
-uint8_t ActiveLights[MAXLIGHTS];
+std::vector<LightStruct> Lights(MAXLIGHTS);
+std::vector<int> ActiveLights;
 int ActiveLightCount;
+int LightBudget = 64;
+LightingStats LightStats;
 char LightsMax;
 std::array<uint8_t, LIGHTSIZE> LightTables;
 bool DisableLighting;
@@ -447,12 +458,51 @@ const uint8_t VisionCrawlTable[23][30] = {
 namespace {
 
 uint8_t lightradius[16][128];
+/** Whether a light of the first radius is at least as bright as one of the second radius on every tile. */
+bool lightCovers[16][16];
 bool dovision;
 uint8_t lightblock[64][16][16];
 
 /** RadiusAdj maps from VisionCrawlTable index to lighting vision radius adjustment. */
 const BYTE RadiusAdj[23] = { 0, 0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 4, 3, 2, 2, 2, 1, 1, 1, 0, 0, 0, 0 };
 
+/** The rays of DoVision() reach tiles up to this far away, and look one tile further for blockers. */
+constexpr int VisionReach = 16;
+
+struct VisibleTile {
+	uint8_t x;
+	uint8_t y;
+	/** Reached by more than one ray. */
+	bool repeated;
+};
+
+/** @brief The tiles and rooms DoVision() reveals from one position with one radius. */
+struct VisionField {
+	std::vector<VisibleTile> tiles;
+	/** dTransVal of the rooms that are seen, each one once. */
+	std::vector<int8_t> rooms;
+
+	/** @brief Memory held by the field, roughly including its cache entry. */
+	size_t Bytes() const
+	{
+		return sizeof(uint32_t) + sizeof(VisionField) + tiles.capacity() * sizeof(VisibleTile) + rooms.capacity() * sizeof(int8_t);
+	}
+};
+
+/**
+ * Vision fields keyed by position and radius. The level only changes where doors open and close, so
+ * vision sources that move over the same tiles again get their field without casting the rays.
+ */
+std::unordered_map<uint32_t, VisionField> VisionCache;
+/** Sum of VisionField::Bytes() of the fields in VisionCache. */
+size_t VisionCacheBytes;
+
+/**
+ * The cache is dropped when it would grow past this, which holds several hundred fields of the
+ * largest radius.
+ */
+constexpr size_t MaxVisionCacheBytes = 1024 * 1024;
+
 void RotateRadius(int *x, int *y, int *dx, int *dy, int *lx, int *ly, int *bx, int *by)
 {
 	*bx = 0;
@@ -494,26 +544,184 @@ char GetLight(Point position)
 	return dLight[position.x][position.y];
 }
 
-void DoUnLight(int nXPos, int nYPos, int nRadius)
+/**
+ * @brief Returns the area of the map that DoLighting() can change for a light with the given position and radius.
+ */
+Rectangle GetLightFootprint(Point position, int nRadius)
 {
-	nRadius++;
+	// Tiles up to nRadius + 1 away are lit, plus one for a negative light offset. Hellfire's light
+	// radius tables are not cut off, so those lights can reach the whole area DoLighting() visits.
+	const int reach = currlevel >= 17 ? 15 : std::min(nRadius + 2, 15);
+
+	const int minX = std::max(position.x - reach, 0);
+	const int minY = std::max(position.y - reach, 0);
+	const int maxX = std::min(position.x + reach + 1, MAXDUNX);
+	const int maxY = std::min(position.y + reach + 1, MAXDUNY);
+
+	return { { minX, minY }, { std::max(maxX - minX, 0), std::max(maxY - minY, 0) } };
+}
+
+bool RectanglesOverlap(const Rectangle &a, const Rectangle &b)
+{
+	return a.position.x < b.position.x + b.size.width
+	    && b.position.x < a.position.x + a.size.width
+	    && a.position.y < b.position.y + b.size.height
+	    && b.position.y < a.position.y + a.size.height;
+}
+
+/**
+ * @brief Resets an area of the light map to the static level lighting, removing the dynamic lights from it.
+ */
+void DoUnLight(const Rectangle &area)
+{
+	for (int x = area.position.x; x < area.position.x + area.size.width; x++)
+		memcpy(&dLight[x][area.position.y], &dPreLight[x][area.position.y], area.size.height);
+}
+
+/**
+ * @brief Marks a light as changed, remembering the position and radius it was last drawn with.
+ */
+void MarkLightChanged(LightStruct &light)
+{
+	if (light._lunflag)
+		return;
+
+	light._lunflag = true;
+	light.position.old = light.position.tile;
+	light.oldRadius = light._lradius;
+}
 
-	int minX = nXPos - nRadius;
-	int maxX = nXPos + nRadius;
-	int minY = nYPos - nRadius;
-	int maxY = nYPos + nRadius;
+std::vector<Rectangle> DirtyLightAreas;
+/** Ids of the lights that are not being removed, in order of where they are drawn. */
+std::vector<int> LightOrder;
+std::vector<int> LightsToDraw;
+/** Lights that are drawn by the stamp of another light, with the id of that light. */
+std::vector<std::pair<int, int>> MergedLights;
 
-	minX = std::max(minX, 0);
-	maxX = std::max(maxX, MAXDUNX);
-	minY = std::max(minY, 0);
-	maxY = std::max(maxY, MAXDUNY);
+bool NeedsRedraw(const LightStruct &light)
+{
+	if (light._lunflag)
+		return true;
+	const Rectangle footprint = GetLightFootprint(light.position.tile, light._lradius);
+	return std::any_of(DirtyLightAreas.begin(), DirtyLightAreas.end(), [&](const Rectangle &area) { return RectanglesOverlap(footprint, area); });
+}
 
-	for (int y = minY; y < maxY; y++) {
-		for (int x = minX; x < maxX; x++) {
-			if (x >= 0 && x < MAXDUNX && y >= 0 && y < MAXDUNY)
-				dLight[x][y] = dPreLight[x][y];
+bool SameSpot(const LightStruct &a, const LightStruct &b)
+{
+	return a.position.tile == b.position.tile && a.position.offset == b.position.offset;
+}
+
+void MarkLightDrawn(LightStruct &light)
+{
+	light._lunflag = false;
+	light.undrawn = false;
+}
+
+/**
+ * @brief Leaves a light for a later frame.
+ *
+ * A changed light had the area it was drawn on reset this frame, so nothing of it is left in the light
+ * map. An unchanged one is still partly there, its area is reset when it is drawn.
+ */
+void DeferLight(LightStruct &light)
+{
+	if (light._lunflag)
+		light.undrawn = true;
+	else
+		MarkLightChanged(light);
+	LightStats.deferred++;
+	UpdateLighting = true;
+}
+
+/**
+ * @brief Casts the rays of DoVision() through the level and collects the tiles and rooms they reach.
+ */
+VisionField CastVisionRays(Point position, int nRadius)
+{
+	VisionField field;
+	// Index + 1 in field.tiles of each tile around the position that was reached
+	uint16_t reached[2 * VisionReach + 1][2 * VisionReach + 1] = {};
+	bool roomSeen[256] = {};
+
+	const auto reach = [&](int x, int y) {
+		uint16_t &index = reached[x - position.x + VisionReach][y - position.y + VisionReach];
+		if (index != 0) {
+			field.tiles[index - 1].repeated = true;
+			return;
 		}
+		field.tiles.push_back({ static_cast<uint8_t>(x), static_cast<uint8_t>(y), false });
+		index = static_cast<uint16_t>(field.tiles.size());
+	};
+
+	if (position.x >= 0 && position.x < MAXDUNX && position.y >= 0 && position.y < MAXDUNY) {
+		reach(position.x, position.y);
 	}
+	for (int v = 0; v < 4; v++) {
+		for (int j = 0; j < 23; j++) {
+			bool nBlockerFlag = false;
+			int nLineLen = 2 * (nRadius - RadiusAdj[j]);
+			for (int k = 0; k < nLineLen && !nBlockerFlag; k += 2) {
+				int x1adj = 0;
+				int x2adj = 0;
+				int y1adj = 0;
+				int y2adj = 0;
+				int nCrawlX = 0;
+				int nCrawlY = 0;
+				switch (v) {
+				case 0:
+					nCrawlX = position.x + VisionCrawlTable[j][k];
+					nCrawlY = position.y + VisionCrawlTable[j][k + 1];
+					if (VisionCrawlTable[j][k] > 0 && VisionCrawlTable[j][k + 1] > 0) {
+						x1adj = -1;
+						y2adj = -1;
+					}
+					break;
+				case 1:
+					nCrawlX = position.x - VisionCrawlTable[j][k];
+					nCrawlY = position.y - VisionCrawlTable[j][k + 1];
+					if (VisionCrawlTable[j][k] > 0 && VisionCrawlTable[j][k + 1] > 0) {
+						y1adj = 1;
+						x2adj = 1;
+					}
+					break;
+				case 2:
+					nCrawlX = position.x + VisionCrawlTable[j][k];
+					nCrawlY = position.y - VisionCrawlTable[j][k + 1];
+					if (VisionCrawlTable[j][k] > 0 && VisionCrawlTable[j][k + 1] > 0) {
+						x1adj = -1;
+						y2adj = 1;
+					}
+					break;
+				case 3:
+					nCrawlX = position.x - VisionCrawlTable[j][k];
+					nCrawlY = position.y + VisionCrawlTable[j][k + 1];
+					if (VisionCrawlTable[j][k] > 0 && VisionCrawlTable[j][k + 1] > 0) {
+						y1adj = -1;
+						x2adj = 1;
+					}
+					break;
+				}
+				if (nCrawlX >= 0 && nCrawlX < MAXDUNX && nCrawlY >= 0 && nCrawlY < MAXDUNY) {
+					nBlockerFlag = nBlockTable[dPiece[nCrawlX][nCrawlY]];
+					if ((x1adj + nCrawlX >= 0 && x1adj + nCrawlX < MAXDUNX && y1adj + nCrawlY >= 0 && y1adj + nCrawlY < MAXDUNY
+					        && !nBlockTable[dPiece[x1adj + nCrawlX][y1adj + nCrawlY]])
+					    || (x2adj + nCrawlX >= 0 && x2adj + nCrawlX < MAXDUNX && y2adj + nCrawlY >= 0 && y2adj + nCrawlY < MAXDUNY
+					        && !nBlockTable[dPiece[x2adj + nCrawlX][y2adj + nCrawlY]])) {
+						reach(nCrawlX, nCrawlY);
+						if (!nBlockerFlag) {
+							int8_t nTrans = dTransVal[nCrawlX][nCrawlY];
+							if (nTrans != 0 && !roomSeen[static_cast<uint8_t>(nTrans)]) {
+								roomSeen[static_cast<uint8_t>(nTrans)] = true;
+								field.rooms.push_back(nTrans);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return field;
 }
 
 } // namespace
@@ -656,94 +864,55 @@ void DoUnVision(Point position, int nRadius)
 
 void DoVision(Point position, int nRadius, bool doautomap, bool visible)
 {
+	const auto key = static_cast<uint32_t>(position.x | (position.y << 8) | (nRadius << 16));
+	auto field = VisionCache.find(key);
+	if (field == VisionCache.end()) {
+		VisionField newField = CastVisionRays(position, nRadius);
+		const size_t bytes = newField.Bytes();
+		if (VisionCacheBytes + bytes > MaxVisionCacheBytes)
+			ClearVisionCache();
+		VisionCacheBytes += bytes;
+		field = VisionCache.emplace(key, std::move(newField)).first;
+	}
 
-	if (position.x >= 0 && position.x <= MAXDUNX && position.y >= 0 && position.y <= MAXDUNY) {
+	for (const VisibleTile &tile : field->second.tiles) {
+		int8_t &flags = dFlags[tile.x][tile.y];
 		if (doautomap) {
-			if (dFlags[position.x][position.y] != 0) {
-				SetAutomapView(position);
+			// A tile reached by more than one ray was explored by the first one when the second one gets there
+			if (flags != 0 || tile.repeated) {
+				SetAutomapView({ tile.x, tile.y });
 			}
-			dFlags[position.x][position.y] |= BFLAG_EXPLORED;
+			flags |= BFLAG_EXPLORED;
 		}
 		if (visible) {
-			dFlags[position.x][position.y] |= BFLAG_LIT;
+			flags |= BFLAG_LIT;
 		}
-		dFlags[position.x][position.y] |= BFLAG_VISIBLE;
+		flags |= BFLAG_VISIBLE;
 	}
+	for (const int8_t room : field->second.rooms) {
+		TransList[room] = true;
+	}
+}
 
-	for (int v = 0; v < 4; v++) {
-		for (int j = 0; j < 23; j++) {
-			bool nBlockerFlag = false;
-			int nLineLen = 2 * (nRadius - RadiusAdj[j]);
-			for (int k = 0; k < nLineLen && !nBlockerFlag; k += 2) {
-				int x1adj = 0;
-				int x2adj = 0;
-				int y1adj = 0;
-				int y2adj = 0;
-				int nCrawlX = 0;
-				int nCrawlY = 0;
-				switch (v) {
-				case 0:
-					nCrawlX = position.x + VisionCrawlTable[j][k];
-					nCrawlY = position.y + VisionCrawlTable[j][k + 1];
-					if (VisionCrawlTable[j][k] > 0 && VisionCrawlTable[j][k + 1] > 0) {
-						x1adj = -1;
-						y2adj = -1;
-					}
-					break;
-				case 1:
-					nCrawlX = position.x - VisionCrawlTable[j][k];
-					nCrawlY = position.y - VisionCrawlTable[j][k + 1];
-					if (VisionCrawlTable[j][k] > 0 && VisionCrawlTable[j][k + 1] > 0) {
-						y1adj = 1;
-						x2adj = 1;
-					}
-					break;
-				case 2:
-					nCrawlX = position.x + VisionCrawlTable[j][k];
-					nCrawlY = position.y - VisionCrawlTable[j][k + 1];
-					if (VisionCrawlTable[j][k] > 0 && VisionCrawlTable[j][k + 1] > 0) {
-						x1adj = -1;
-						y2adj = 1;
-					}
-					break;
-				case 3:
-					nCrawlX = position.x - VisionCrawlTable[j][k];
-					nCrawlY = position.y + VisionCrawlTable[j][k + 1];
-					if (VisionCrawlTable[j][k] > 0 && VisionCrawlTable[j][k + 1] > 0) {
-						y1adj = -1;
-						x2adj = 1;
-					}
-					break;
-				}
-				if (nCrawlX >= 0 && nCrawlX < MAXDUNX && nCrawlY >= 0 && nCrawlY < MAXDUNY) {
-					nBlockerFlag = nBlockTable[dPiece[nCrawlX][nCrawlY]];
-					if ((x1adj + nCrawlX >= 0 && x1adj + nCrawlX < MAXDUNX && y1adj + nCrawlY >= 0 && y1adj + nCrawlY < MAXDUNY
-					        && !nBlockTable[dPiece[x1adj + nCrawlX][y1adj + nCrawlY]])
-					    || (x2adj + nCrawlX >= 0 && x2adj + nCrawlX < MAXDUNX && y2adj + nCrawlY >= 0 && y2adj + nCrawlY < MAXDUNY
-					        && !nBlockTable[dPiece[x2adj + nCrawlX][y2adj + nCrawlY]])) {
-						if (doautomap) {
-							if (dFlags[nCrawlX][nCrawlY] != 0) {
-								SetAutomapView({ nCrawlX, nCrawlY });
-							}
-							dFlags[nCrawlX][nCrawlY] |= BFLAG_EXPLORED;
-						}
-						if (visible) {
-							dFlags[nCrawlX][nCrawlY] |= BFLAG_LIT;
-						}
-						dFlags[nCrawlX][nCrawlY] |= BFLAG_VISIBLE;
-						if (!nBlockerFlag) {
-							int8_t nTrans = dTransVal[nCrawlX][nCrawlY];
-							if (nTrans != 0) {
-								TransList[nTrans] = true;
-							}
-						}
-					}
-				}
-			}
+void InvalidateVision(Point position)
+{
+	for (auto it = VisionCache.begin(); it != VisionCache.end();) {
+		const Point origin { static_cast<int>(it->first & 0xFF), static_cast<int>((it->first >> 8) & 0xFF) };
+		if (std::abs(origin.x - position.x) <= VisionReach && std::abs(origin.y - position.y) <= VisionReach) {
+			VisionCacheBytes -= it->second.Bytes();
+			it = VisionCache.erase(it);
+		} else {
+			++it;
 		}
 	}
 }
 
+void ClearVisionCache()
+{
+	VisionCache.clear();
+	VisionCacheBytes = 0;
+}
+
 void MakeLightTable()
 {
 	uint8_t *tbl = LightTables.data();
@@ -916,6 +1085,11 @@ void MakeLightTable()
 			}
 		}
 	}
+	for (int big = 0; big < 16; big++) {
+		for (int small = 0; small < 16; small++) {
+			lightCovers[big][small] = std::equal(&lightradius[big][0], &lightradius[big][128], &lightradius[small][0], std::less_equal<uint8_t>());
+		}
+	}
 	for (int j = 0; j < 8; j++) {
 		for (int i = 0; i < 8; i++) {
 			for (int k = 0; k < 16; k++) {
@@ -959,6 +1133,8 @@ void InitLighting()
 	UpdateLighting = false;
 	DisableLighting = false;
 
+	Lights.assign(MAXLIGHTS, {});
+	ActiveLights.resize(MAXLIGHTS);
 	for (int i = 0; i < MAXLIGHTS; i++) {
 		ActiveLights[i] = i;
 	}
@@ -966,23 +1142,26 @@ void InitLighting()
 
 int AddLight(Point position, int r)
 {
-	int lid;
-
 	if (DisableLighting) {
 		return NO_LIGHT;
 	}
 
-	lid = NO_LIGHT;
-
-	if (ActiveLightCount < MAXLIGHTS) {
-		lid = ActiveLights[ActiveLightCount++];
-		Lights[lid].position.tile = position;
-		Lights[lid]._lradius = r;
-		Lights[lid].position.offset = { 0, 0 };
-		Lights[lid]._ldel = false;
-		Lights[lid]._lunflag = false;
-		UpdateLighting = true;
+	if (ActiveLightCount == static_cast<int>(ActiveLights.size())) {
+		ActiveLights.push_back(static_cast<int>(Lights.size()));
+		Lights.emplace_back();
 	}
+	// Hand out the lowest free id, so that the lights fit in a savegame whenever they can
+	auto lowest = std::min_element(ActiveLights.begin() + ActiveLightCount, ActiveLights.end());
+	std::swap(*lowest, ActiveLights[ActiveLightCount]);
+	const int lid = ActiveLights[ActiveLightCount++];
+
+	Lights[lid].position.tile = position;
+	Lights[lid]._lradius = r;
+	Lights[lid].position.offset = { 0, 0 };
+	Lights[lid]._ldel = false;
+	Lights[lid]._lunflag = true;
+	Lights[lid].undrawn = true;
+	UpdateLighting = true;
 
 	return lid;
 }
@@ -1003,9 +1182,7 @@ void ChangeLightRadius(int i, int r)
 		return;
 	}
 
-	Lights[i]._lunflag = true;
-	Lights[i].position.old = Lights[i].position.tile;
-	Lights[i].oldRadius = Lights[i]._lradius;
+	MarkLightChanged(Lights[i]);
 	Lights[i]._lradius = r;
 	UpdateLighting = true;
 }
@@ -1016,9 +1193,7 @@ void ChangeLightXY(int i, Point position)
 		return;
 	}
 
-	Lights[i]._lunflag = true;
-	Lights[i].position.old = Lights[i].position.tile;
-	Lights[i].oldRadius = Lights[i]._lradius;
+	MarkLightChanged(Lights[i]);
 	Lights[i].position.tile = position;
 	UpdateLighting = true;
 }
@@ -1029,9 +1204,7 @@ void ChangeLightOffset(int i, Point position)
 		return;
 	}
 
-	Lights[i]._lunflag = true;
-	Lights[i].position.old = Lights[i].position.tile;
-	Lights[i].oldRadius = Lights[i]._lradius;
+	MarkLightChanged(Lights[i]);
 	Lights[i].position.offset = position;
 	UpdateLighting = true;
 }
@@ -1042,9 +1215,7 @@ void ChangeLight(int i, Point position, int r)
 		return;
 	}
 
-	Lights[i]._lunflag = true;
-	Lights[i].position.old = Lights[i].position.tile;
-	Lights[i].oldRadius = Lights[i]._lradius;
+	MarkLightChanged(Lights[i]);
 	Lights[i].position.tile = position;
 	Lights[i]._lradius = r;
 	UpdateLighting = true;
@@ -1056,37 +1227,100 @@ void ProcessLightList()
 		return;
 	}
 
-	if (UpdateLighting) {
-		for (int i = 0; i < ActiveLightCount; i++) {
-			int j = ActiveLights[i];
-			if (Lights[j]._ldel) {
-				DoUnLight(Lights[j].position.tile.x, Lights[j].position.tile.y, Lights[j]._lradius);
-			}
-			if (Lights[j]._lunflag) {
-				DoUnLight(Lights[j].position.old.x, Lights[j].position.old.y, Lights[j].oldRadius);
-				Lights[j]._lunflag = false;
-			}
+	if (!UpdateLighting) {
+		return;
+	}
+	UpdateLighting = false;
+
+	// Lights are combined by taking the brightest value of every tile, so only the areas that
+	// removed or moved lights were drawn on need to be reset and redrawn by the lights covering them.
+	DirtyLightAreas.clear();
+	LightOrder.clear();
+	for (int i = 0; i < ActiveLightCount; i++) {
+		const LightStruct &light = Lights[ActiveLights[i]];
+		if (light._ldel && !light.undrawn) {
+			DirtyLightAreas.push_back(GetLightFootprint(light.position.tile, light._lradius));
 		}
-		for (int i = 0; i < ActiveLightCount; i++) {
-			int j = ActiveLights[i];
-			if (!Lights[j]._ldel) {
-				DoLighting(Lights[j].position.tile, Lights[j]._lradius, j);
-			}
+		if (light._lunflag && !light.undrawn) {
+			DirtyLightAreas.push_back(GetLightFootprint(light.position.old, light.oldRadius));
+		}
+		if (!light._ldel) {
+			LightOrder.push_back(ActiveLights[i]);
+		}
+	}
+	for (const Rectangle &area : DirtyLightAreas) {
+		DoUnLight(area);
+	}
+
+	// A light on the same spot as a brighter one changes nothing, so each spot is drawn once by its
+	// brightest light. Fire walls and burning monsters stack many lights like that.
+	std::sort(LightOrder.begin(), LightOrder.end(), [](int a, int b) {
+		const LightPosition &posA = Lights[a].position;
+		const LightPosition &posB = Lights[b].position;
+		return std::tie(posA.tile.x, posA.tile.y, posA.offset.x, posA.offset.y, Lights[b]._lradius)
+		    < std::tie(posB.tile.x, posB.tile.y, posB.offset.x, posB.offset.y, Lights[a]._lradius);
+	});
+	LightsToDraw.clear();
+	MergedLights.clear();
+	for (size_t i = 0; i < LightOrder.size();) {
+		const int brightest = LightOrder[i];
+		const bool redraw = NeedsRedraw(Lights[brightest]);
+		if (redraw) {
+			LightsToDraw.push_back(brightest);
 		}
-		int i = 0;
-		while (i < ActiveLightCount) {
-			if (Lights[ActiveLights[i]]._ldel) {
-				ActiveLightCount--;
-				BYTE temp = ActiveLights[ActiveLightCount];
-				ActiveLights[ActiveLightCount] = ActiveLights[i];
-				ActiveLights[i] = temp;
+		for (i++; i < LightOrder.size() && SameSpot(Lights[LightOrder[i]], Lights[brightest]); i++) {
+			LightStruct &light = Lights[LightOrder[i]];
+			if (!NeedsRedraw(light)) {
+				continue;
+			}
+			if (!lightCovers[Lights[brightest]._lradius][light._lradius]) {
+				LightsToDraw.push_back(LightOrder[i]);
+			} else if (redraw) {
+				MergedLights.emplace_back(LightOrder[i], brightest);
 			} else {
-				i++;
+				MarkLightDrawn(light);
+				LightStats.merged++;
 			}
 		}
 	}
 
-	UpdateLighting = false;
+	// dLight is game state, SneakAi() looks for dark tiles in it. The lights that are put off depend on the
+	// view and on when the level was entered, which differ between the players of a multiplayer game.
+	auto drawEnd = LightsToDraw.end();
+	if (!gbIsMultiplayer && LightBudget < static_cast<int>(LightsToDraw.size())) {
+		drawEnd = LightsToDraw.begin() + LightBudget;
+		std::nth_element(LightsToDraw.begin(), drawEnd, LightsToDraw.end(), [](int a, int b) {
+			const Point view { ViewX, ViewY };
+			return view.ApproxDistance(Lights[a].position.tile) < view.ApproxDistance(Lights[b].position.tile);
+		});
+	}
+	for (auto it = LightsToDraw.begin(); it != drawEnd; it++) {
+		DoLighting(Lights[*it].position.tile, Lights[*it]._lradius, *it);
+		MarkLightDrawn(Lights[*it]);
+		LightStats.stamped++;
+	}
+	for (auto it = drawEnd; it != LightsToDraw.end(); it++) {
+		DeferLight(Lights[*it]);
+	}
+	for (const auto &merged : MergedLights) {
+		LightStruct &light = Lights[merged.first];
+		if (Lights[merged.second].undrawn || Lights[merged.second]._lunflag) {
+			DeferLight(light);
+		} else {
+			MarkLightDrawn(light);
+			LightStats.merged++;
+		}
+	}
+
+	int i = 0;
+	while (i < ActiveLightCount) {
+		if (Lights[ActiveLights[i]]._ldel) {
+			ActiveLightCount--;
+			std::swap(ActiveLights[i], ActiveLights[ActiveLightCount]);
+		} else {
+			i++;
+		}
+	}
 }
 
 void SavePreLighting()
@@ -1096,6 +1330,7 @@ void SavePreLighting()
 
 void InitVision()
 {
+	ClearVisionCache();
 	VisionCount = 0;
 	dovision = false;
 	VisionId = 1;
@@ -1107,20 +1342,20 @@ void InitVision()
 
 int AddVision(Point position, int r, bool mine)
 {
-	int vid = -1; // BUGFIX: if VisionCount >= MAXVISION behavior is undefined (fixed)
-
-	if (VisionCount < MAXVISION) {
-		VisionList[VisionCount].position.tile = position;
-		VisionList[VisionCount]._lradius = r;
-		vid = VisionId++;
-		VisionList[VisionCount]._lid = vid;
-		VisionList[VisionCount]._ldel = false;
-		VisionList[VisionCount]._lunflag = false;
-		VisionList[VisionCount]._lflags = mine;
-		VisionCount++;
-		dovision = true;
+	if (VisionCount == static_cast<int>(VisionList.size())) {
+		VisionList.emplace_back();
 	}
 
+	VisionList[VisionCount].position.tile = position;
+	VisionList[VisionCount]._lradius = r;
+	int vid = VisionId++;
+	VisionList[VisionCount]._lid = vid;
+	VisionList[VisionCount]._ldel = false;
+	VisionList[VisionCount]._lunflag = false;
+	VisionList[VisionCount]._lflags = mine;
+	VisionCount++;
+	dovision = true;
+
 	return vid;
 }
 
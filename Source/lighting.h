@@ -6,6 +6,8 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
+#include <vector>
 
 #include "engine.h"
 #include "engine/point.hpp"
@@ -13,7 +15,9 @@
 
 namespace devilution {
 
+/** The light pool starts with this many lights and grows past it, a savegame holds this many. */
 #define MAXLIGHTS 32
+/** A savegame holds this many visions. */
 #define MAXVISION 32
 #define LIGHTSIZE (27 * 256)
 #define NO_LIGHT -1
@@ -34,14 +38,30 @@ struct LightStruct {
 	bool _lunflag;
 	int oldRadius;
 	bool _lflags;
+	/** The light is not in the light map, it was added or its area was reset and it has not been drawn since. */
+	bool undrawn;
 };
 
-extern LightStruct VisionList[MAXVISION];
+/** @brief Work done by ProcessLightList(), counted for profiling. */
+struct LightingStats {
+	/** Lights drawn into the light map. */
+	uint64_t stamped;
+	/** Lights that needed drawing but are covered by the stamp of a brighter light on the same spot. */
+	uint64_t merged;
+	/** Lights put off to a later frame because the budget of the frame was used up. */
+	uint64_t deferred;
+};
+
+extern std::vector<LightStruct> VisionList;
 extern int VisionCount;
 extern int VisionId;
-extern LightStruct Lights[MAXLIGHTS];
-extern uint8_t ActiveLights[MAXLIGHTS];
+extern std::vector<LightStruct> Lights;
+/** Ids of the active lights followed by the free ids of the pool. */
+extern std::vector<int> ActiveLights;
 extern int ActiveLightCount;
+/** Most lights ProcessLightList() draws per frame in single player games, the ones closest to the view go first. */
+extern int LightBudget;
+extern LightingStats LightStats;
 extern char LightsMax;
 extern std::array<uint8_t, LIGHTSIZE> LightTables;
 extern bool DisableLighting;
@@ -50,6 +70,14 @@ extern bool UpdateLighting;
 void DoLighting(Point position, int nRadius, int Lnum);
 void DoUnVision(Point position, int nRadius);
 void DoVision(Point position, int nRadius, bool doautomap, bool visible);
+/**
+ * @brief Forgets what DoVision() has seen near a tile, call it when the tile changes between blocking and not blocking vision.
+ */
+void InvalidateVision(Point position);
+/**
+ * @brief Forgets everything DoVision() has seen, call it when the level changes.
+ */
+void ClearVisionCache();
 void MakeLightTable();
 #ifdef _DEBUG
 void ToggleLighting();
@@ -5,8 +5,10 @@
  */
 #include "loadsave.h"
 
+#include <algorithm>
 #include <climits>
 #include <cstring>
+#include <vector>
 
 #include <SDL.h>
 
@@ -23,7 +25,6 @@
 #include "inv.h"
 #include "lighting.h"
 #include "missiles.h"
-#include "mpqapi.h"
 #include "pfile.h"
 #include "stores.h"
 #include "utils/endian.hpp"
@@ -200,13 +201,38 @@ public:
 
 	~SaveHelper()
 	{
-		const auto encodedLen = codec_get_encoded_len(m_cur_);
-		const char *const password = pfile_get_password();
-		codec_encode(m_buffer_.get(), m_cur_, encodedLen, password);
-		mpqapi_write_file(m_szFileName_, m_buffer_.get(), encodedLen);
+		pfile_write_save_file(m_szFileName_, std::move(m_buffer_), m_cur_);
 	}
 };
 
+/** @brief Owners of the lights that are saved after the table of MAXLIGHTS ids, see SaveExtraLights(). */
+enum class LightOwner : uint8_t {
+	Player,
+	Monster,
+	Missile,
+	Object,
+};
+
+/**
+ * @brief Drops references to lights that are not in the table of the savegame.
+ *
+ * The table only has room for the lights with the first MAXLIGHTS ids, the others are recreated by
+ * LoadExtraLights().
+ */
+int LoadLightId(int lid)
+{
+	if (lid < 0 || lid >= MAXLIGHTS)
+		return NO_LIGHT;
+	return lid;
+}
+
+int SaveLightId(int lid)
+{
+	if (lid >= MAXLIGHTS)
+		return NO_LIGHT;
+	return lid;
+}
+
 void LoadItemData(LoadHelper *file, ItemStruct *pItem)
 {
 	pItem->_iSeed = file->NextLE<int32_t>();
@@ -346,7 +372,7 @@ void LoadPlayer(LoadHelper *file, int p)
 	file->Skip(4); // Skip _pAnimWidth
 	file->Skip(4); // Skip _pAnimWidth2
 	file->Skip(4); // Skip _peflag
-	player._plid = file->NextLE<int32_t>();
+	player._plid = LoadLightId(file->NextLE<int32_t>());
 	player._pvid = file->NextLE<int32_t>();
 
 	player._pSpell = static_cast<spell_id>(file->NextLE<int32_t>());
@@ -623,7 +649,7 @@ void LoadMonster(LoadHelper *file, int i)
 	pMonster->leader = file->NextLE<uint8_t>();
 	pMonster->leaderflag = file->NextLE<uint8_t>();
 	pMonster->packsize = file->NextLE<uint8_t>();
-	pMonster->mlid = file->NextLE<int8_t>();
+	pMonster->mlid = LoadLightId(file->NextLE<int8_t>());
 	if (pMonster->mlid == Players[MyPlayerId]._plid)
 		pMonster->mlid = NO_LIGHT; // Correct incorect values in old saves
 
@@ -676,7 +702,7 @@ void LoadMissile(LoadHelper *file, int i)
 	pMissile->_midam = file->NextLE<int32_t>();
 	pMissile->_miHitFlag = file->NextBool32();
 	pMissile->_midist = file->NextLE<int32_t>();
-	pMissile->_mlid = file->NextLE<int32_t>();
+	pMissile->_mlid = LoadLightId(file->NextLE<int32_t>());
 	pMissile->_mirnd = file->NextLE<int32_t>();
 	pMissile->_miVar1 = file->NextLE<int32_t>();
 	pMissile->_miVar2 = file->NextLE<int32_t>();
@@ -715,7 +741,7 @@ void LoadObject(LoadHelper *file, int i)
 	pObject->_oPreFlag = file->NextBool32();
 	pObject->_oTrapFlag = file->NextBool32();
 	pObject->_oDoorFlag = file->NextBool32();
-	pObject->_olid = file->NextLE<int32_t>();
+	pObject->_olid = LoadLightId(file->NextLE<int32_t>());
 	pObject->_oRndSeed = file->NextLE<uint32_t>();
 	pObject->_oVar1 = file->NextLE<int32_t>();
 	pObject->_oVar2 = file->NextLE<int32_t>();
@@ -787,6 +813,51 @@ void LoadLighting(LoadHelper *file, LightStruct *pLight)
 	pLight->_lflags = file->NextBool32();
 }
 
+/**
+ * @brief Recreates the lights and visions that did not fit in the tables of the savegame.
+ *
+ * Savegames from before the light pool could grow end before them.
+ */
+void LoadExtraLights(LoadHelper &file)
+{
+	if (!file.IsValid())
+		return;
+
+	const int lightCount = file.NextBE<int32_t>();
+	for (int i = 0; i < lightCount && file.IsValid(); i++) {
+		const auto owner = static_cast<LightOwner>(file.NextLE<uint8_t>());
+		const int index = file.NextBE<int32_t>();
+		LightStruct saved {};
+		LoadLighting(&file, &saved);
+
+		int *lid = nullptr;
+		if (owner == LightOwner::Player && index == MyPlayerId)
+			lid = &Players[index]._plid;
+		else if (owner == LightOwner::Monster && index >= 0 && index < MAXMONSTERS)
+			lid = &Monsters[index].mlid;
+		else if (owner == LightOwner::Missile && index >= 0 && index < MAXMISSILES)
+			lid = &Missiles[index]._mlid;
+		else if (owner == LightOwner::Object && index >= 0 && index < MAXOBJECTS)
+			lid = &Objects[index]._olid;
+		if (lid == nullptr || saved._ldel)
+			continue;
+
+		*lid = AddLight(saved.position.tile, saved._lradius);
+		if (*lid != NO_LIGHT) {
+			Lights[*lid].position.offset = saved.position.offset;
+			Lights[*lid]._lflags = saved._lflags;
+		}
+	}
+
+	const int visionCount = file.NextBE<int32_t>();
+	VisionList.resize(VisionCount);
+	for (int i = 0; i < visionCount && file.IsValid(); i++) {
+		VisionList.emplace_back();
+		LoadLighting(&file, &VisionList.back());
+		VisionCount++;
+	}
+}
+
 void LoadPortal(LoadHelper *file, int i)
 {
 	PortalStruct *pPortal = &Portals[i];
@@ -1021,7 +1092,7 @@ void SavePlayer(SaveHelper *file, int p)
 	// write _pAnimWidth2 for vanilla compatibility
 	file->WriteLE<int32_t>(CalculateWidth2(animWidth));
 	file->Skip<uint32_t>(); // Skip _peflag
-	file->WriteLE<int32_t>(player._plid);
+	file->WriteLE<int32_t>(SaveLightId(player._plid));
 	file->WriteLE<int32_t>(player._pvid);
 
 	file->WriteLE<int32_t>(player._pSpell);
@@ -1281,7 +1352,7 @@ void SaveMonster(SaveHelper *file, int i)
 	file->WriteLE<uint8_t>(pMonster->leader);
 	file->WriteLE<uint8_t>(pMonster->leaderflag);
 	file->WriteLE<uint8_t>(pMonster->packsize);
-	file->WriteLE<int8_t>(pMonster->mlid);
+	file->WriteLE<int8_t>(SaveLightId(pMonster->mlid));
 
 	// Omit pointer mName;
 	// Omit pointer MType;
@@ -1327,7 +1398,7 @@ void SaveMissile(SaveHelper *file, int i)
 	file->WriteLE<int32_t>(pMissile->_midam);
 	file->WriteLE<uint32_t>(pMissile->_miHitFlag ? 1 : 0);
 	file->WriteLE<int32_t>(pMissile->_midist);
-	file->WriteLE<int32_t>(pMissile->_mlid);
+	file->WriteLE<int32_t>(SaveLightId(pMissile->_mlid));
 	file->WriteLE<int32_t>(pMissile->_mirnd);
 	file->WriteLE<int32_t>(pMissile->_miVar1);
 	file->WriteLE<int32_t>(pMissile->_miVar2);
@@ -1366,7 +1437,7 @@ void SaveObject(SaveHelper *file, int i)
 	file->WriteLE<uint32_t>(pObject->_oPreFlag ? 1 : 0);
 	file->WriteLE<uint32_t>(pObject->_oTrapFlag ? 1 : 0);
 	file->WriteLE<uint32_t>(pObject->_oDoorFlag ? 1 : 0);
-	file->WriteLE<int32_t>(pObject->_olid);
+	file->WriteLE<int32_t>(SaveLightId(pObject->_olid));
 	file->WriteLE<uint32_t>(pObject->_oRndSeed);
 	file->WriteLE<int32_t>(pObject->_oVar1);
 	file->WriteLE<int32_t>(pObject->_oVar2);
@@ -1447,6 +1518,75 @@ void SavePortal(SaveHelper *file, int i)
 const int DiabloItemSaveSize = 368;
 const int HellfireItemSaveSize = 372;
 
+/**
+ * @brief Saves the active lights in the table of MAXLIGHTS ids of the savegame.
+ *
+ * The light pool only grows past that when more lights are active at once, those extra lights are
+ * left out and LoadLightId() drops the references to them.
+ */
+void SaveLights(SaveHelper &file)
+{
+	std::vector<int> savedIds;
+	for (int i = 0; i < ActiveLightCount; i++) {
+		if (ActiveLights[i] < MAXLIGHTS)
+			savedIds.push_back(ActiveLights[i]);
+	}
+	const int savedCount = static_cast<int>(savedIds.size());
+	for (size_t i = ActiveLightCount; i < ActiveLights.size(); i++) {
+		if (ActiveLights[i] < MAXLIGHTS)
+			savedIds.push_back(ActiveLights[i]);
+	}
+
+	file.WriteBE<int32_t>(savedCount);
+
+	for (int lightId : savedIds)
+		file.WriteLE<uint8_t>(lightId);
+	for (int i = 0; i < savedCount; i++)
+		SaveLighting(&file, &Lights[savedIds[i]]);
+}
+
+/**
+ * @brief Saves the lights and visions that do not fit in the tables of the savegame.
+ *
+ * They go at the end of the savegame, where older versions do not look. The lights are saved with the
+ * player, monster, missile or object that owns them, which gets a new id for them when they are loaded.
+ */
+void SaveExtraLights(SaveHelper &file)
+{
+	std::vector<bool> active(Lights.size());
+	for (int i = 0; i < ActiveLightCount; i++)
+		active[ActiveLights[i]] = true;
+
+	struct ExtraLight {
+		LightOwner owner;
+		int index;
+		int lid;
+	};
+	std::vector<ExtraLight> extraLights;
+	const auto addOwner = [&](LightOwner owner, int index, int lid) {
+		if (lid >= MAXLIGHTS && lid < static_cast<int>(Lights.size()) && active[lid])
+			extraLights.push_back({ owner, index, lid });
+	};
+	addOwner(LightOwner::Player, MyPlayerId, Players[MyPlayerId]._plid);
+	for (int i = 0; i < ActiveMonsterCount; i++)
+		addOwner(LightOwner::Monster, ActiveMonsters[i], Monsters[ActiveMonsters[i]].mlid);
+	for (int i = 0; i < ActiveMissileCount; i++)
+		addOwner(LightOwner::Missile, ActiveMissiles[i], Missiles[ActiveMissiles[i]]._mlid);
+	for (int i = 0; i < ActiveObjectCount; i++)
+		addOwner(LightOwner::Object, ActiveObjects[i], Objects[ActiveObjects[i]]._olid);
+
+	file.WriteBE<int32_t>(extraLights.size());
+	for (const ExtraLight &extraLight : extraLights) {
+		file.WriteLE<uint8_t>(static_cast<uint8_t>(extraLight.owner));
+		file.WriteBE<int32_t>(extraLight.index);
+		SaveLighting(&file, &Lights[extraLight.lid]);
+	}
+
+	file.WriteBE<int32_t>(std::max(VisionCount - MAXVISION, 0));
+	for (int i = MAXVISION; i < VisionCount; i++)
+		SaveLighting(&file, &VisionList[i]);
+}
+
 } // namespace
 
 void RemoveInvalidItem(ItemStruct *pItem)
@@ -1757,7 +1897,9 @@ void LoadGame(bool firstflag)
 
 		ActiveLightCount = file.NextBE<int32_t>();
 
-		for (uint8_t &lightId : ActiveLights)
+		Lights.assign(MAXLIGHTS, {});
+		ActiveLights.resize(MAXLIGHTS);
+		for (int &lightId : ActiveLights)
 			lightId = file.NextLE<uint8_t>();
 		for (int i = 0; i < ActiveLightCount; i++)
 			LoadLighting(&file, &Lights[ActiveLights[i]]);
@@ -1765,6 +1907,7 @@ void LoadGame(bool firstflag)
 		VisionId = file.NextBE<int32_t>();
 		VisionCount = file.NextBE<int32_t>();
 
+		VisionList.resize(std::max(VisionCount, 0));
 		for (int i = 0; i < VisionCount; i++)
 			LoadLighting(&file, &VisionList[i]);
 	}
@@ -1836,6 +1979,8 @@ void LoadGame(bool firstflag)
 
 	AutomapActive = file.NextBool8();
 	AutoMapScale = file.NextBE<int32_t>();
+	if (leveltype != DTYPE_TOWN)
+		LoadExtraLights(file);
 	AutomapZoomReset();
 	ResyncQuests();
 
@@ -1944,17 +2089,12 @@ void SaveGameData()
 		for (int i = 0; i < ActiveObjectCount; i++)
 			SaveObject(&file, ActiveObjects[i]);
 
-		file.WriteBE<int32_t>(ActiveLightCount);
-
-		for (uint8_t lightId : ActiveLights)
-			file.WriteLE<uint8_t>(lightId);
-		for (int i = 0; i < ActiveLightCount; i++)
-			SaveLighting(&file, &Lights[ActiveLights[i]]);
+		SaveLights(file);
 
 		file.WriteBE<int32_t>(VisionId);
-		file.WriteBE<int32_t>(VisionCount);
+		file.WriteBE<int32_t>(std::min(VisionCount, MAXVISION));
 
-		for (int i = 0; i < VisionCount; i++)
+		for (int i = 0; i < std::min(VisionCount, MAXVISION); i++)
 			SaveLighting(&file, &VisionList[i]);
 	}
 
@@ -2023,6 +2163,8 @@ void SaveGameData()
 
 	file.WriteLE<uint8_t>(AutomapActive ? 1 : 0);
 	file.WriteBE<int32_t>(AutoMapScale);
+	if (leveltype != DTYPE_TOWN)
+		SaveExtraLights(file);
 }
 
 void SaveGame()
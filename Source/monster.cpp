@@ -16,6 +16,7 @@
 #include "dead.h"
 #include "drlg_l1.h"
 #include "drlg_l4.h"
+#include "engine/asset_view.hpp"
 #include "engine/cel_header.hpp"
 #include "engine/load_file.hpp"
 #include "engine/random.hpp"
@@ -64,6 +65,18 @@ namespace {
 #define NIGHTMARE_AC_BONUS 50
 #define HELL_AC_BONUS 80
 
+/**
+ * Golems and berserked monsters (which are flagged as golems too), in the order of ActiveMonsters.
+ * These are the only monsters that other monsters target unless they are golems or berserk themselves.
+ */
+int GolemTargets[MAXMONSTERS];
+int GolemTargetCount;
+/**
+ * Set while ProcessMonsters() runs. No monster turns into a golem and ActiveMonsters is only appended
+ * to during that time, so GolemTargets stays a superset of the golems in the right order.
+ */
+bool GolemTargetsValid;
+
 /** Tracks which missile files are already loaded */
 int MissileFileFlag;
 int totalmonsters;
@@ -713,24 +726,29 @@ void PlaceQuestMonsters()
 		}
 
 		if (QuestStatus(Q_LTBANNER)) {
-			auto dunData = LoadFileInMem<uint16_t>("Levels\\L1Data\\Banner1.DUN");
-			SetMapMonsters(dunData.get(), Point { setpc_x, setpc_y } * 2);
+			const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L1Data\\Banner1.DUN");
+			const auto *dunData = dunFile.DataAs<uint16_t>();
+			SetMapMonsters(dunData, Point { setpc_x, setpc_y } * 2);
 		}
 		if (QuestStatus(Q_BLOOD)) {
-			auto dunData = LoadFileInMem<uint16_t>("Levels\\L2Data\\Blood2.DUN");
-			SetMapMonsters(dunData.get(), Point { setpc_x, setpc_y } * 2);
+			const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L2Data\\Blood2.DUN");
+			const auto *dunData = dunFile.DataAs<uint16_t>();
+			SetMapMonsters(dunData, Point { setpc_x, setpc_y } * 2);
 		}
 		if (QuestStatus(Q_BLIND)) {
-			auto dunData = LoadFileInMem<uint16_t>("Levels\\L2Data\\Blind2.DUN");
-			SetMapMonsters(dunData.get(), Point { setpc_x, setpc_y } * 2);
+			const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L2Data\\Blind2.DUN");
+			const auto *dunData = dunFile.DataAs<uint16_t>();
+			SetMapMonsters(dunData, Point { setpc_x, setpc_y } * 2);
 		}
 		if (QuestStatus(Q_ANVIL)) {
-			auto dunData = LoadFileInMem<uint16_t>("Levels\\L3Data\\Anvil.DUN");
-			SetMapMonsters(dunData.get(), Point { setpc_x + 2, setpc_y + 2 } * 2);
+			const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L3Data\\Anvil.DUN");
+			const auto *dunData = dunFile.DataAs<uint16_t>();
+			SetMapMonsters(dunData, Point { setpc_x + 2, setpc_y + 2 } * 2);
 		}
 		if (QuestStatus(Q_WARLORD)) {
-			auto dunData = LoadFileInMem<uint16_t>("Levels\\L4Data\\Warlord.DUN");
-			SetMapMonsters(dunData.get(), Point { setpc_x, setpc_y } * 2);
+			const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L4Data\\Warlord.DUN");
+			const auto *dunData = dunFile.DataAs<uint16_t>();
+			SetMapMonsters(dunData, Point { setpc_x, setpc_y } * 2);
 			AddMonsterType(UniqMonst[UMT_WARLORD].mtype, PLACE_SCATTER);
 		}
 		if (QuestStatus(Q_VEIL)) {
@@ -746,8 +764,9 @@ void PlaceQuestMonsters()
 			PlaceUniqueMonst(UMT_LAZARUS, 0, 0);
 			PlaceUniqueMonst(UMT_RED_VEX, 0, 0);
 			PlaceUniqueMonst(UMT_BLACKJADE, 0, 0);
-			auto dunData = LoadFileInMem<uint16_t>("Levels\\L4Data\\Vile1.DUN");
-			SetMapMonsters(dunData.get(), Point { setpc_x, setpc_y } * 2);
+			const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L4Data\\Vile1.DUN");
+			const auto *dunData = dunFile.DataAs<uint16_t>();
+			SetMapMonsters(dunData, Point { setpc_x, setpc_y } * 2);
 		}
 
 		if (currlevel == 24) {
@@ -777,20 +796,24 @@ void PlaceQuestMonsters()
 void LoadDiabMonsts()
 {
 	{
-		auto dunData = LoadFileInMem<uint16_t>("Levels\\L4Data\\diab1.DUN");
-		SetMapMonsters(dunData.get(), Point { diabquad1x, diabquad1y } * 2);
+		const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L4Data\\diab1.DUN");
+		const auto *dunData = dunFile.DataAs<uint16_t>();
+		SetMapMonsters(dunData, Point { diabquad1x, diabquad1y } * 2);
 	}
 	{
-		auto dunData = LoadFileInMem<uint16_t>("Levels\\L4Data\\diab2a.DUN");
-		SetMapMonsters(dunData.get(), Point { diabquad2x, diabquad2y } * 2);
+		const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L4Data\\diab2a.DUN");
+		const auto *dunData = dunFile.DataAs<uint16_t>();
+		SetMapMonsters(dunData, Point { diabquad2x, diabquad2y } * 2);
 	}
 	{
-		auto dunData = LoadFileInMem<uint16_t>("Levels\\L4Data\\diab3a.DUN");
-		SetMapMonsters(dunData.get(), Point { diabquad3x, diabquad3y } * 2);
+		const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L4Data\\diab3a.DUN");
+		const auto *dunData = dunFile.DataAs<uint16_t>();
+		SetMapMonsters(dunData, Point { diabquad3x, diabquad3y } * 2);
 	}
 	{
-		auto dunData = LoadFileInMem<uint16_t>("Levels\\L4Data\\diab4a.DUN");
-		SetMapMonsters(dunData.get(), Point { diabquad4x, diabquad4y } * 2);
+		const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L4Data\\diab4a.DUN");
+		const auto *dunData = dunFile.DataAs<uint16_t>();
+		SetMapMonsters(dunData, Point { diabquad4x, diabquad4y } * 2);
 	}
 }
 
@@ -830,6 +853,17 @@ bool IsRanged(int i)
 	return IsAnyOf(Monsters[i]._mAi, AI_SKELBOW, AI_GOATBOW, AI_SUCC, AI_LAZHELP);
 }
 
+void CollectGolemTargets()
+{
+	GolemTargetCount = 0;
+	for (int j = 0; j < ActiveMonsterCount; j++) {
+		int mi = ActiveMonsters[j];
+		if ((Monsters[mi]._mFlags & MFLAG_GOLEM) != 0)
+			GolemTargets[GolemTargetCount++] = mi;
+	}
+	GolemTargetsValid = true;
+}
+
 void UpdateEnemy(int i)
 {
 	Point target;
@@ -855,18 +889,17 @@ void UpdateEnemy(int i)
 			}
 		}
 	}
-	for (int j = 0; j < ActiveMonsterCount; j++) {
-		int mi = ActiveMonsters[j];
+	const auto considerMonster = [&](int mi) {
 		if (mi == i)
-			continue;
+			return;
 		if ((Monsters[mi]._mhitpoints >> 6) <= 0)
-			continue;
+			return;
 		if (Monsters[mi].position.tile.x == 1 && Monsters[mi].position.tile.y == 0)
-			continue;
+			return;
 		if (M_Talker(mi) && Monsters[mi].mtalkmsg != TEXT_NONE)
-			continue;
+			return;
 		if ((monst->_mFlags & MFLAG_GOLEM) != 0 && (Monsters[mi]._mFlags & MFLAG_GOLEM) != 0) // prevent golems from fighting each other
-			continue;
+			return;
 
 		int dist = Monsters[mi].position.tile.WalkingDistance(monst->position.tile);
 		if (((monst->_mFlags & MFLAG_GOLEM) == 0
@@ -876,7 +909,7 @@ void UpdateEnemy(int i)
 		    || ((monst->_mFlags & MFLAG_GOLEM) == 0
 		        && (monst->_mFlags & MFLAG_BERSERK) == 0
 		        && (Monsters[mi]._mFlags & MFLAG_GOLEM) == 0)) {
-			continue;
+			return;
 		}
 		bool sameroom = dTransVal[monst->position.tile.x][monst->position.tile.y] == dTransVal[Monsters[mi].position.tile.x][Monsters[mi].position.tile.y];
 		if ((sameroom && !bestsameroom)
@@ -888,6 +921,14 @@ void UpdateEnemy(int i)
 			bestDist = dist;
 			bestsameroom = sameroom;
 		}
+	};
+	if (GolemTargetsValid && (monst->_mFlags & (MFLAG_GOLEM | MFLAG_BERSERK)) == 0) {
+		// Ordinary monsters reject everything but golems, so only visit those
+		for (int j = 0; j < GolemTargetCount; j++)
+			considerMonster(GolemTargets[j]);
+	} else {
+		for (int j = 0; j < ActiveMonsterCount; j++)
+			considerMonster(ActiveMonsters[j]);
 	}
 	if (menemy != -1) {
 		monst->_mFlags &= ~MFLAG_NO_ENEMY;
@@ -4462,6 +4503,7 @@ void DeleteMonsterList()
 void ProcessMonsters()
 {
 	DeleteMonsterList();
+	CollectGolemTargets();
 
 	assert((DWORD)ActiveMonsterCount <= MAXMONSTERS);
 	for (int i = 0; i < ActiveMonsterCount; i++) {
@@ -4582,6 +4624,7 @@ void ProcessMonsters()
 			monst->AnimInfo.ProcessAnimation((monst->_mFlags & MFLAG_LOCK_ANIMATION) != 0, (monst->_mFlags & MFLAG_ALLOW_SPECIAL) != 0);
 		}
 	}
+	GolemTargetsValid = false;
 
 	DeleteMonsterList();
 }
@@ -195,7 +195,7 @@ struct MonsterStruct { // note: missing field _mAFNum
 	uint8_t leader;
 	uint8_t leaderflag;
 	uint8_t packsize;
-	int8_t mlid; // BUGFIX -1 is used when not emitting light this should be signed (fixed)
+	int mlid; // BUGFIX -1 is used when not emitting light this should be signed (fixed), and wider than int8_t as the light pool grows past 127 lights
 	const char *mName;
 	CMonster *MType;
 	const MonsterDataStruct *MData;
@@ -5,6 +5,7 @@
  */
 #include "mpqapi.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <cinttypes>
 #include <cstddef>
@@ -14,12 +15,15 @@
 #include <memory>
 #include <type_traits>
 
+#include <SDL.h>
+
 #include "appfat.h"
 #include "encrypt.h"
 #include "engine.h"
 #include "utils/endian.hpp"
 #include "utils/file_util.h"
 #include "utils/log.hpp"
+#include "utils/thread.h"
 
 namespace devilution {
 
@@ -481,6 +485,155 @@ _BLOCKENTRY *AddFile(const char *pszName, _BLOCKENTRY *pBlk, int blockIndex)
 	return pBlk;
 }
 
+constexpr size_t SectorSize = 4096;
+/** Files with fewer sectors are compressed on the calling thread alone. */
+constexpr uint32_t MinParallelSectors = 4;
+constexpr int MaxCompressionWorkers = 3;
+
+/** @brief The sectors of the file that is being written, compressed in place by whichever thread claims them. */
+struct CompressionJob {
+	byte *sectors;
+	uint32_t *sectorSizes;
+	uint32_t numSectors;
+	uint32_t nextSector;
+	uint32_t completedSectors;
+};
+
+SDL_mutex *CompressionMutex;
+/** Signalled when a job is posted and on shutdown. */
+SDL_cond *CompressionWorkCond;
+/** Signalled when the last sector of a job is done. */
+SDL_cond *CompressionDoneCond;
+SDL_Thread *CompressionWorkers[MaxCompressionWorkers];
+int CompressionWorkerCount;
+bool CompressionRunning;
+CompressionJob *CurrentCompressionJob;
+
+/** Implode state of the thread that writes the archive. */
+std::unique_ptr<PkwareCompressor> WriterCompressor;
+/** Offset table followed by the sectors of the file that is being written, kept between files. */
+std::unique_ptr<byte[]> SectorBuffer;
+size_t SectorBufferSize;
+std::unique_ptr<uint32_t[]> SectorSizes;
+uint32_t SectorSizesCount;
+
+/**
+ * @brief Claims and compresses sectors of the current job until none are left.
+ *
+ * Must be called with CompressionMutex locked, returns with it locked.
+ */
+void CompressClaimedSectors(CompressionJob &job, PkwareCompressor &compressor)
+{
+	while (job.nextSector < job.numSectors) {
+		const uint32_t sector = job.nextSector++;
+		SDL_UnlockMutex(CompressionMutex);
+		job.sectorSizes[sector] = compressor.Compress(&job.sectors[sector * SectorSize], job.sectorSizes[sector]);
+		SDL_LockMutex(CompressionMutex);
+		job.completedSectors++;
+		if (job.completedSectors == job.numSectors)
+			SDL_CondBroadcast(CompressionDoneCond);
+	}
+}
+
+void CompressionHandler()
+{
+	PkwareCompressor compressor;
+
+	SDL_LockMutex(CompressionMutex);
+	while (CompressionRunning) {
+		if (CurrentCompressionJob == nullptr || CurrentCompressionJob->nextSector == CurrentCompressionJob->numSectors) {
+			SDL_CondWait(CompressionWorkCond, CompressionMutex);
+			continue;
+		}
+		CompressClaimedSectors(*CurrentCompressionJob, compressor);
+	}
+	SDL_UnlockMutex(CompressionMutex);
+}
+
+void StartCompressionWorkers()
+{
+	if (CompressionMutex != nullptr)
+		return;
+
+	CompressionMutex = SDL_CreateMutex();
+	CompressionWorkCond = SDL_CreateCond();
+	CompressionDoneCond = SDL_CreateCond();
+	if (CompressionMutex == nullptr || CompressionWorkCond == nullptr || CompressionDoneCond == nullptr) {
+		LogError("Failed to create the save compression workers: {}", SDL_GetError());
+		return;
+	}
+
+	// Leave a core for the game itself, the calling thread compresses as well
+	const int workerCount = std::min(SDL_GetCPUCount() - 2, MaxCompressionWorkers);
+	CompressionRunning = true;
+	for (CompressionWorkerCount = 0; CompressionWorkerCount < workerCount; CompressionWorkerCount++) {
+		SDL_threadID threadId;
+		CompressionWorkers[CompressionWorkerCount] = CreateThread(CompressionHandler, &threadId);
+	}
+}
+
+void StopCompressionWorkers()
+{
+	if (CompressionMutex != nullptr) {
+		SDL_LockMutex(CompressionMutex);
+		CompressionRunning = false;
+		SDL_CondBroadcast(CompressionWorkCond);
+		SDL_UnlockMutex(CompressionMutex);
+	}
+	for (int i = 0; i < CompressionWorkerCount; i++)
+		SDL_WaitThread(CompressionWorkers[i], nullptr);
+	CompressionWorkerCount = 0;
+
+	if (CompressionDoneCond != nullptr) {
+		SDL_DestroyCond(CompressionDoneCond);
+		CompressionDoneCond = nullptr;
+	}
+	if (CompressionWorkCond != nullptr) {
+		SDL_DestroyCond(CompressionWorkCond);
+		CompressionWorkCond = nullptr;
+	}
+	if (CompressionMutex != nullptr) {
+		SDL_DestroyMutex(CompressionMutex);
+		CompressionMutex = nullptr;
+	}
+
+	WriterCompressor = nullptr;
+	SectorBuffer = nullptr;
+	SectorBufferSize = 0;
+	SectorSizes = nullptr;
+	SectorSizesCount = 0;
+}
+
+/**
+ * @brief Compresses every sector of a file, spreading them over the worker threads.
+ * @param sectors Sector data, each sector starts at a multiple of SectorSize
+ * @param sectorSizes Uncompressed size of each sector, replaced by the compressed sizes
+ */
+void CompressSectors(byte *sectors, uint32_t *sectorSizes, uint32_t numSectors)
+{
+	if (WriterCompressor == nullptr)
+		WriterCompressor = std::make_unique<PkwareCompressor>();
+
+	if (numSectors >= MinParallelSectors)
+		StartCompressionWorkers();
+
+	if (numSectors < MinParallelSectors || CompressionWorkerCount == 0) {
+		for (uint32_t i = 0; i < numSectors; i++)
+			sectorSizes[i] = WriterCompressor->Compress(&sectors[i * SectorSize], sectorSizes[i]);
+		return;
+	}
+
+	CompressionJob job { sectors, sectorSizes, numSectors, 0, 0 };
+	SDL_LockMutex(CompressionMutex);
+	CurrentCompressionJob = &job;
+	SDL_CondBroadcast(CompressionWorkCond);
+	CompressClaimedSectors(job, *WriterCompressor);
+	while (job.completedSectors != job.numSectors)
+		SDL_CondWait(CompressionDoneCond, CompressionMutex);
+	CurrentCompressionJob = nullptr;
+	SDL_UnlockMutex(CompressionMutex);
+}
+
 bool WriteFileContents(const char *pszName, const byte *pbData, size_t dwLen, _BLOCKENTRY *pBlk)
 {
 	const char *tmp;
@@ -490,20 +643,44 @@ bool WriteFileContents(const char *pszName, const byte *pbData, size_t dwLen, _B
 		pszName = tmp + 1;
 	Hash(pszName, 3);
 
-	constexpr size_t SectorSize = 4096;
 	const uint32_t numSectors = (dwLen + (SectorSize - 1)) / SectorSize;
 	const uint32_t offsetTableByteSize = sizeof(uint32_t) * (numSectors + 1);
 	pBlk->offset = FindFreeBlock(dwLen + offsetTableByteSize, &pBlk->sizealloc);
 	pBlk->sizefile = dwLen;
 	pBlk->flags = 0x80000100;
 
-	// We populate the table of sector offset while we write the data.
-	// We can't pre-populate it because we don't know the compressed sector sizes yet.
+	// The offset table is followed by the sectors, each sector is compressed in its own
+	// SectorSize slot and then moved up against the previous one.
+	const size_t bufferSize = offsetTableByteSize + numSectors * SectorSize;
+	if (bufferSize > SectorBufferSize) {
+		SectorBuffer.reset(new byte[bufferSize]);
+		SectorBufferSize = bufferSize;
+	}
+	if (numSectors > SectorSizesCount) {
+		SectorSizes.reset(new uint32_t[numSectors]);
+		SectorSizesCount = numSectors;
+	}
+	byte *sectors = &SectorBuffer[offsetTableByteSize];
+	for (uint32_t i = 0; i < numSectors; i++) {
+		const uint32_t len = std::min<size_t>(dwLen - i * SectorSize, SectorSize);
+		memcpy(&sectors[i * SectorSize], &pbData[i * SectorSize], len);
+		SectorSizes[i] = len;
+	}
+
+	CompressSectors(sectors, SectorSizes.get(), numSectors);
+
 	// First offset is the start of the first sector, last offset is the end of the last sector.
-	std::unique_ptr<uint32_t[]> sectoroffsettable { new uint32_t[numSectors + 1] };
+	auto *sectoroffsettable = reinterpret_cast<uint32_t *>(SectorBuffer.get());
+	uint32_t destsize = offsetTableByteSize;
+	for (uint32_t i = 0; i < numSectors; i++) {
+		sectoroffsettable[i] = SDL_SwapLE32(destsize);
+		memmove(&SectorBuffer[destsize], &sectors[i * SectorSize], SectorSizes[i]);
+		destsize += SectorSizes[i]; // compressed length
+	}
+	sectoroffsettable[numSectors] = SDL_SwapLE32(destsize);
 
 #ifdef CAN_SEEKP_BEYOND_EOF
-	if (!cur_archive.stream.Seekp(pBlk->offset + offsetTableByteSize, std::ios::beg))
+	if (!cur_archive.stream.Seekp(pBlk->offset, std::ios::beg))
 		return false;
 #else
 	// Ensure we do not Seekp beyond EOF by filling the missing space.
@@ -511,44 +688,17 @@ bool WriteFileContents(const char *pszName, const byte *pbData, size_t dwLen, _B
 	if (!cur_archive.stream.Seekp(0, std::ios::end) || !cur_archive.stream.Tellp(&stream_end))
 		return false;
 	const std::uintmax_t cur_size = stream_end - cur_archive.stream_begin;
-	if (cur_size < pBlk->offset + offsetTableByteSize) {
-		if (cur_size < pBlk->offset) {
-			std::unique_ptr<char[]> filler { new char[pBlk->offset - cur_size] };
-			if (!cur_archive.stream.Write(filler.get(), pBlk->offset - cur_size))
-				return false;
-		}
-		if (!cur_archive.stream.Write(reinterpret_cast<const char *>(sectoroffsettable.get()), offsetTableByteSize))
+	if (cur_size < pBlk->offset) {
+		std::unique_ptr<char[]> filler { new char[pBlk->offset - cur_size] };
+		if (!cur_archive.stream.Write(filler.get(), pBlk->offset - cur_size))
 			return false;
 	} else {
-		if (!cur_archive.stream.Seekp(pBlk->offset + offsetTableByteSize, std::ios::beg))
+		if (!cur_archive.stream.Seekp(pBlk->offset, std::ios::beg))
 			return false;
 	}
 #endif
 
-	uint32_t destsize = offsetTableByteSize;
-	byte mpqBuf[SectorSize];
-	std::size_t curSector = 0;
-	while (true) {
-		uint32_t len = std::min(dwLen, SectorSize);
-		memcpy(mpqBuf, pbData, len);
-		pbData += len;
-		len = PkwareCompress(mpqBuf, len);
-		if (!cur_archive.stream.Write((char *)mpqBuf, len))
-			return false;
-		sectoroffsettable[curSector++] = SDL_SwapLE32(destsize);
-		destsize += len; // compressed length
-		if (dwLen > SectorSize)
-			dwLen -= SectorSize;
-		else
-			break;
-	}
-
-	sectoroffsettable[numSectors] = SDL_SwapLE32(destsize);
-	if (!cur_archive.stream.Seekp(pBlk->offset, std::ios::beg))
-		return false;
-	if (!cur_archive.stream.Write(reinterpret_cast<const char *>(sectoroffsettable.get()), offsetTableByteSize))
-		return false;
-	if (!cur_archive.stream.Seekp(destsize - offsetTableByteSize, std::ios::cur))
+	if (!cur_archive.stream.Write(reinterpret_cast<const char *>(SectorBuffer.get()), destsize))
 		return false;
 
 	if (destsize < pBlk->sizealloc) {
@@ -678,6 +828,7 @@ on_error:
 
 bool mpqapi_flush_and_close(bool bFree)
 {
+	StopCompressionWorkers();
 	return cur_archive.Close(/*clearTables=*/bFree);
 }
 
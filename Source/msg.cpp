@@ -41,20 +41,34 @@ namespace {
 
 #define MAX_CHUNKS (NUMLEVELS + 4)
 
+/** Layout of the level deltas sent to joining players, the first byte of every level chunk. */
+constexpr uint8_t DeltaLevelFormat = 1;
+
 DWORD sgdwOwnerWait;
 DWORD sgdwRecvOffset;
 int sgnCurrMegaPlayer;
 DLevel sgLevels[NUMLEVELS];
 BYTE sbLastCmd;
 TMegaPkt *sgpCurrPkt;
-byte sgRecvBuf[sizeof(DLevel) + 1];
+byte sgRecvBuf[MaxDeltaLevelSize + 1];
 BYTE sgbRecvCmd;
 LocalLevel sgLocals[NUMLEVELS];
 DJunk sgJunk;
 TMegaPkt *sgpMegaPkt;
 bool sgbDeltaChanged;
+/** Levels whose delta differs from the one delta_init() starts with. */
+bool sgbDeltaLevelChanged[NUMLEVELS];
 BYTE sgbDeltaChunks;
 
+/**
+ * @brief Marks the delta of a level as changed, so that it is sent to players that join.
+ */
+void MarkDeltaLevelChanged(int level)
+{
+	sgbDeltaChanged = true;
+	sgbDeltaLevelChanged[level] = true;
+}
+
 void GetNextPacket()
 {
 	TMegaPkt *result;
@@ -161,71 +175,48 @@ int WaitForTurns()
 	return 100 * sgbDeltaChunks / MAX_CHUNKS;
 }
 
-byte *DeltaExportItem(byte *dst, TCmdPItem *src)
-{
-	for (int i = 0; i < MAXITEMS; i++, src++) {
-		if (src->bCmd == 0xFF) {
-			*dst++ = byte { 0xFF };
-		} else {
-			memcpy(dst, src, sizeof(TCmdPItem));
-			dst += sizeof(TCmdPItem);
-		}
-	}
-
-	return dst;
-}
-
-byte *DeltaImportItem(byte *src, TCmdPItem *dst)
-{
-	for (int i = 0; i < MAXITEMS; i++, dst++) {
-		if (*src == byte { 0xFF }) {
-			memset(dst, 0xFF, sizeof(TCmdPItem));
-			src++;
-		} else {
-			memcpy(dst, src, sizeof(TCmdPItem));
-			src += sizeof(TCmdPItem);
-		}
-	}
-
-	return src;
-}
-
-byte *DeltaExportObject(byte *dst, DObjectStr *src)
-{
-	memcpy(dst, src, sizeof(DObjectStr) * MAXOBJECTS);
-	return dst + sizeof(DObjectStr) * MAXOBJECTS;
-}
-
-byte *DeltaImportObject(byte *src, DObjectStr *dst)
+/**
+ * @brief Writes the number of used entries of a delta array, then every used entry after its index.
+ *
+ * Unused entries are all 0xFF since delta_init() on every machine, so they are left out.
+ */
+template <typename T, size_t N, typename IsUnused>
+byte *DeltaExportEntries(byte *dst, const T (&entries)[N], IsUnused isUnused)
 {
-	memcpy(dst, src, sizeof(DObjectStr) * MAXOBJECTS);
-	return src + sizeof(DObjectStr) * MAXOBJECTS;
-}
+	static_assert(N <= UINT8_MAX, "Delta entries are counted and indexed with a byte");
 
-byte *DeltaExportMonster(byte *dst, DMonsterStr *src)
-{
-	for (int i = 0; i < MAXMONSTERS; i++, src++) {
-		if (src->_mx == 0xFF) {
-			*dst++ = byte { 0xFF };
-		} else {
-			memcpy(dst, src, sizeof(DMonsterStr));
-			dst += sizeof(DMonsterStr);
-		}
+	byte *count = dst++;
+	uint8_t used = 0;
+	for (size_t i = 0; i < N; i++) {
+		if (isUnused(entries[i]))
+			continue;
+		*dst++ = static_cast<byte>(i);
+		memcpy(dst, &entries[i], sizeof(T));
+		dst += sizeof(T);
+		used++;
 	}
+	*count = static_cast<byte>(used);
 
 	return dst;
 }
 
-byte *DeltaImportMonster(byte *src, DMonsterStr *dst)
+template <typename T, size_t N>
+const byte *DeltaImportEntries(const byte *src, const byte *end, T (&entries)[N])
 {
-	for (int i = 0; i < MAXMONSTERS; i++, dst++) {
-		if (*src == byte { 0xFF }) {
-			memset(dst, 0xFF, sizeof(DMonsterStr));
-			src++;
-		} else {
-			memcpy(dst, src, sizeof(DMonsterStr));
-			src += sizeof(DMonsterStr);
-		}
+	memset(entries, 0xFF, sizeof(entries));
+	if (src >= end)
+		app_fatal("Truncated level delta");
+	const auto used = static_cast<uint8_t>(*src++);
+	if (used > N)
+		app_fatal("Invalid level delta entry count: %i", used);
+	for (int i = 0; i < used; i++) {
+		if (static_cast<size_t>(end - src) < 1 + sizeof(T))
+			app_fatal("Truncated level delta");
+		const auto index = static_cast<uint8_t>(*src++);
+		if (index >= N)
+			app_fatal("Invalid level delta entry: %i", index);
+		memcpy(&entries[index], src, sizeof(T));
+		src += sizeof(T);
 	}
 
 	return src;
@@ -290,10 +281,10 @@ void DeltaImportJunk(byte *src)
 	}
 }
 
-DWORD CompressData(byte *buffer, byte *end)
+DWORD CompressData(PkwareCompressor &compressor, byte *buffer, byte *end)
 {
 	DWORD size = end - buffer - 1;
-	DWORD pkSize = PkwareCompress(buffer + 1, size);
+	DWORD pkSize = compressor.Compress(buffer + 1, size);
 
 	*buffer = size != pkSize ? byte { 1 } : byte { 0 };
 
@@ -302,17 +293,18 @@ DWORD CompressData(byte *buffer, byte *end)
 
 void DeltaImportData(BYTE cmd, DWORD recvOffset)
 {
+	// The received data starts with a flag that tells whether the rest is compressed
+	size_t size = recvOffset - 1;
 	if (sgRecvBuf[0] != byte { 0 })
-		PkwareDecompress(&sgRecvBuf[1], recvOffset, sizeof(sgRecvBuf) - 1);
+		size = PkwareDecompress(&sgRecvBuf[1], recvOffset, sizeof(sgRecvBuf) - 1);
 
 	byte *src = &sgRecvBuf[1];
 	if (cmd == CMD_DLEVEL_JUNK) {
 		DeltaImportJunk(src);
 	} else if (cmd >= CMD_DLEVEL_0 && cmd <= CMD_DLEVEL_24) {
 		BYTE i = cmd - CMD_DLEVEL_0;
-		src = DeltaImportItem(src, sgLevels[i].item);
-		src = DeltaImportObject(src, sgLevels[i].object);
-		DeltaImportMonster(src, sgLevels[i].monster);
+		DeltaImportLevel(src, src + size, sgLevels[i]);
+		MarkDeltaLevelChanged(i);
 	} else {
 		app_fatal("Unkown network message type: %i", cmd);
 	}
@@ -326,7 +318,7 @@ DWORD OnLevelData(int pnum, TCmd *pCmd)
 	auto *p = (TCmdPlrInfoHdr *)pCmd;
 
 	if (gbDeltaSender != pnum) {
-		if (p->bCmd == CMD_DLEVEL_END || (p->bCmd == CMD_DLEVEL_0 && p->wOffset == 0)) {
+		if (p->bCmd == CMD_DLEVEL_END || (p->bCmd == CMD_DLEVEL_JUNK && p->wOffset == 0)) {
 			gbDeltaSender = pnum;
 			sgbRecvCmd = CMD_DLEVEL_END;
 		} else {
@@ -338,7 +330,7 @@ DWORD OnLevelData(int pnum, TCmd *pCmd)
 			sgbDeltaChunks = MAX_CHUNKS - 1;
 			return p->wBytes + sizeof(*p);
 		}
-		if (p->bCmd == CMD_DLEVEL_0 && p->wOffset == 0) {
+		if (p->bCmd == CMD_DLEVEL_JUNK && p->wOffset == 0) {
 			sgdwRecvOffset = 0;
 			sgbRecvCmd = p->bCmd;
 		} else {
@@ -356,6 +348,8 @@ DWORD OnLevelData(int pnum, TCmd *pCmd)
 	}
 
 	assert(p->wOffset == sgdwRecvOffset);
+	if (p->wOffset + p->wBytes > sizeof(sgRecvBuf))
+		app_fatal("Level delta too large");
 	memcpy(&sgRecvBuf[p->wOffset], &p[1], p->wBytes);
 	sgdwRecvOffset += p->wBytes;
 	return p->wBytes + sizeof(*p);
@@ -366,7 +360,7 @@ void DeltaSyncGolem(TCmdGolem *pG, int pnum, BYTE bLevel)
 	if (!gbIsMultiplayer)
 		return;
 
-	sgbDeltaChanged = true;
+	MarkDeltaLevelChanged(bLevel);
 	DMonsterStr *pD = &sgLevels[bLevel].monster[pnum];
 	pD->_mx = pG->_mx;
 	pD->_my = pG->_my;
@@ -389,7 +383,7 @@ void DeltaLeaveSync(BYTE bLevel)
 		int ma = ActiveMonsters[i];
 		if (Monsters[ma]._mhitpoints == 0)
 			continue;
-		sgbDeltaChanged = true;
+		MarkDeltaLevelChanged(bLevel);
 		DMonsterStr *pD = &sgLevels[bLevel].monster[ma];
 		pD->_mx = Monsters[ma].position.tile.x;
 		pD->_my = Monsters[ma].position.tile.y;
@@ -406,7 +400,7 @@ void DeltaSyncObject(int oi, _cmd_id bCmd, BYTE bLevel)
 	if (!gbIsMultiplayer)
 		return;
 
-	sgbDeltaChanged = true;
+	MarkDeltaLevelChanged(bLevel);
 	sgLevels[bLevel].object[oi].bCmd = bCmd;
 }
 
@@ -424,12 +418,12 @@ bool DeltaGetItem(TCmdGItem *pI, BYTE bLevel)
 			return true;
 		}
 		if (pD->bCmd == CMD_STAND) {
-			sgbDeltaChanged = true;
+			MarkDeltaLevelChanged(bLevel);
 			pD->bCmd = CMD_WALKXY;
 			return true;
 		}
 		if (pD->bCmd == CMD_ACK_PLRINFO) {
-			sgbDeltaChanged = true;
+			MarkDeltaLevelChanged(bLevel);
 			pD->bCmd = CMD_INVALID;
 			return true;
 		}
@@ -443,7 +437,7 @@ bool DeltaGetItem(TCmdGItem *pI, BYTE bLevel)
 	pD = sgLevels[bLevel].item;
 	for (int i = 0; i < MAXITEMS; i++, pD++) {
 		if (pD->bCmd == CMD_INVALID) {
-			sgbDeltaChanged = true;
+			MarkDeltaLevelChanged(bLevel);
 			pD->bCmd = CMD_WALKXY;
 			pD->x = pI->x;
 			pD->y = pI->y;
@@ -490,7 +484,7 @@ void DeltaPutItem(TCmdPItem *pI, int x, int y, BYTE bLevel)
 	pD = sgLevels[bLevel].item;
 	for (int i = 0; i < MAXITEMS; i++, pD++) {
 		if (pD->bCmd == 0xFF) {
-			sgbDeltaChanged = true;
+			MarkDeltaLevelChanged(bLevel);
 			memcpy(pD, pI, sizeof(TCmdPItem));
 			pD->bCmd = CMD_ACK_PLRINFO;
 			pD->x = x;
@@ -1855,24 +1849,45 @@ void run_delta_info()
 	FreePackets();
 }
 
+byte *DeltaExportLevel(byte *dst, const DLevel &level)
+{
+	*dst++ = static_cast<byte>(DeltaLevelFormat);
+	dst = DeltaExportEntries(dst, level.item, [](const TCmdPItem &item) { return item.bCmd == CMD_INVALID; });
+	dst = DeltaExportEntries(dst, level.object, [](const DObjectStr &object) { return object.bCmd == CMD_INVALID; });
+	dst = DeltaExportEntries(dst, level.monster, [](const DMonsterStr &monster) { return monster._mx == 0xFF; });
+
+	return dst;
+}
+
+void DeltaImportLevel(const byte *src, const byte *end, DLevel &level)
+{
+	if (src >= end)
+		app_fatal("Truncated level delta");
+	if (static_cast<uint8_t>(*src) != DeltaLevelFormat)
+		app_fatal("Unsupported level delta format: %i", static_cast<int>(*src));
+	src++;
+	src = DeltaImportEntries(src, end, level.item);
+	src = DeltaImportEntries(src, end, level.object);
+	DeltaImportEntries(src, end, level.monster);
+}
+
 void DeltaExportData(int pnum)
 {
 	if (sgbDeltaChanged) {
-		int size;
-		std::unique_ptr<byte[]> dst { new byte[sizeof(DLevel) + 1] };
-		byte *dstEnd;
+		PkwareCompressor compressor;
+		std::unique_ptr<byte[]> dst { new byte[MaxDeltaLevelSize + 1] };
+		// The junk goes first, the receiver starts at it. Levels nobody changed are left out, the
+		// receiver has the same initial delta for them.
+		byte *dstEnd = DeltaExportJunk(&dst[1]);
+		int size = CompressData(compressor, dst.get(), dstEnd);
+		dthread_send_delta(pnum, CMD_DLEVEL_JUNK, dst.get(), size);
 		for (int i = 0; i < NUMLEVELS; i++) {
-			dstEnd = &dst[1];
-			dstEnd = DeltaExportItem(dstEnd, sgLevels[i].item);
-			dstEnd = DeltaExportObject(dstEnd, sgLevels[i].object);
-			dstEnd = DeltaExportMonster(dstEnd, sgLevels[i].monster);
-			size = CompressData(dst.get(), dstEnd);
+			if (!sgbDeltaLevelChanged[i])
+				continue;
+			dstEnd = DeltaExportLevel(&dst[1], sgLevels[i]);
+			size = CompressData(compressor, dst.get(), dstEnd);
 			dthread_send_delta(pnum, static_cast<_cmd_id>(i + CMD_DLEVEL_0), dst.get(), size);
 		}
-		dstEnd = &dst[1];
-		dstEnd = DeltaExportJunk(dstEnd);
-		size = CompressData(dst.get(), dstEnd);
-		dthread_send_delta(pnum, CMD_DLEVEL_JUNK, dst.get(), size);
 	}
 	byte src { 0 };
 	dthread_send_delta(pnum, CMD_DLEVEL_END, &src, 1);
@@ -1881,6 +1896,7 @@ void DeltaExportData(int pnum)
 void delta_init()
 {
 	sgbDeltaChanged = false;
+	memset(sgbDeltaLevelChanged, 0, sizeof(sgbDeltaLevelChanged));
 	memset(&sgJunk, 0xFF, sizeof(sgJunk));
 	memset(sgLevels, 0xFF, sizeof(sgLevels));
 	memset(sgLocals, 0, sizeof(sgLocals));
@@ -1892,7 +1908,7 @@ void delta_kill_monster(int mi, Point position, BYTE bLevel)
 	if (!gbIsMultiplayer)
 		return;
 
-	sgbDeltaChanged = true;
+	MarkDeltaLevelChanged(bLevel);
 	DMonsterStr *pD = &sgLevels[bLevel].monster[mi];
 	pD->_mx = position.x;
 	pD->_my = position.y;
@@ -1905,7 +1921,7 @@ void delta_monster_hp(int mi, int hp, BYTE bLevel)
 	if (!gbIsMultiplayer)
 		return;
 
-	sgbDeltaChanged = true;
+	MarkDeltaLevelChanged(bLevel);
 	DMonsterStr *pD = &sgLevels[bLevel].monster[mi];
 	if (pD->_mhitpoints > hp)
 		pD->_mhitpoints = hp;
@@ -1918,7 +1934,7 @@ void delta_sync_monster(const TSyncMonster *pSync, BYTE bLevel)
 
 	assert(pSync != nullptr);
 	assert(bLevel < NUMLEVELS);
-	sgbDeltaChanged = true;
+	MarkDeltaLevelChanged(bLevel);
 
 	DMonsterStr *pD = &sgLevels[bLevel].monster[pSync->_mndx];
 	if (pD->_mhitpoints == 0)
@@ -1959,7 +1975,7 @@ void DeltaAddItem(int ii)
 	pD = sgLevels[currlevel].item;
 	for (int i = 0; i < MAXITEMS; i++, pD++) {
 		if (pD->bCmd == 0xFF) {
-			sgbDeltaChanged = true;
+			MarkDeltaLevelChanged(currlevel);
 			pD->bCmd = CMD_STAND;
 			pD->x = Items[ii].position.x;
 			pD->y = Items[ii].position.y;
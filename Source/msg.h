@@ -374,6 +374,9 @@ struct DLevel {
 	DMonsterStr monster[MAXMONSTERS];
 };
 
+/** Size of the largest level delta sent to joining players, with every entry used. */
+constexpr size_t MaxDeltaLevelSize = 1 + 3 + MAXITEMS * (1 + sizeof(TCmdPItem)) + MAXOBJECTS * (1 + sizeof(DObjectStr)) + MAXMONSTERS * (1 + sizeof(DMonsterStr));
+
 struct LocalLevel {
 	uint8_t automapsv[DMAXX][DMAXY];
 };
@@ -419,6 +422,17 @@ void msg_send_drop_pkt(int pnum, int reason);
 bool msg_wait_resync();
 void run_delta_info();
 void DeltaExportData(int pnum);
+/**
+ * @brief Writes the delta of a level the way it is sent to joining players.
+ * @param dst Buffer of at least MaxDeltaLevelSize bytes
+ * @return End of the written data
+ */
+byte *DeltaExportLevel(byte *dst, const DLevel &level);
+/**
+ * @brief Reads a level delta written by DeltaExportLevel(), a malformed one is fatal.
+ * @param end End of the received data, nothing at or after it is read
+ */
+void DeltaImportLevel(const byte *src, const byte *end, DLevel &level);
 void delta_init();
 void delta_kill_monster(int mi, Point position, BYTE bLevel);
 void delta_monster_hp(int mi, int hp, BYTE bLevel);
@@ -57,7 +57,11 @@ void multi_player_left(int pnum, int reason);
 void multi_net_ping();
 bool multi_handle_delta();
 void multi_process_network_packets();
-void multi_send_zero_packet(int pnum, _cmd_id bCmd, byte *pbSrc, DWORD dwLen);
+/**
+ * @brief Sends a message of commands to one player, without the state of the local player in the header.
+ * @param bodySize Bytes of commands in the body of pkt
+ */
+void multi_send_zero_packet(int pnum, TPkt &pkt, size_t bodySize);
 void NetClose();
 bool NetInit(bool bSinglePlayer);
 void recv_plrinfo(int pnum, TCmdPlrInfoHdr *p, bool recv);
@@ -12,6 +12,7 @@
 #include "cursor.h"
 #include "drlg_l1.h"
 #include "drlg_l4.h"
+#include "engine/asset_view.hpp"
 #include "engine/load_file.hpp"
 #include "engine/random.hpp"
 #include "error.h"
@@ -280,7 +281,7 @@ _speech_id StoryText[3][3] = {
 	{ TEXT_BOOK31, TEXT_BOOK32, TEXT_BOOK33 }
 };
 
-void InitObjectGFX()
+void InitObjectGFX(bool loadGraphics)
 {
 	bool fileload[56] = {};
 
@@ -311,13 +312,15 @@ void InitObjectGFX()
 	for (int i = OFILE_L1BRAZ; i <= OFILE_LZSTAND; i++) {
 		if (fileload[i]) {
 			ObjFileList[numobjfiles] = static_cast<object_graphic_id>(i);
-			char filestr[32];
-			sprintf(filestr, "Objects\\%s.CEL", ObjMasterLoadList[i]);
-			if (currlevel >= 17 && currlevel < 21)
-				sprintf(filestr, "Objects\\%s.CEL", ObjHiveLoadList[i]);
-			else if (currlevel >= 21)
-				sprintf(filestr, "Objects\\%s.CEL", ObjCryptLoadList[i]);
-			pObjCels[numobjfiles] = LoadFileInMem(filestr);
+			if (loadGraphics) {
+				char filestr[32];
+				sprintf(filestr, "Objects\\%s.CEL", ObjMasterLoadList[i]);
+				if (currlevel >= 17 && currlevel < 21)
+					sprintf(filestr, "Objects\\%s.CEL", ObjHiveLoadList[i]);
+				else if (currlevel >= 21)
+					sprintf(filestr, "Objects\\%s.CEL", ObjCryptLoadList[i]);
+				pObjCels[numobjfiles] = LoadFileInMem(filestr);
+			}
 			numobjfiles++;
 		}
 	}
@@ -735,7 +738,8 @@ void LoadMapObjects(const char *path, Point start, Rectangle mapRange, int lever
 	LoadingMapObjects = true;
 	ApplyObjectLighting = true;
 
-	auto dunData = LoadFileInMem<uint16_t>(path);
+	const AssetView dunFile = LoadAssetView<uint16_t>(path);
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
@@ -769,7 +773,8 @@ void LoadMapObjs(const char *path, Point start)
 	LoadingMapObjects = true;
 	ApplyObjectLighting = true;
 
-	auto dunData = LoadFileInMem<uint16_t>(path);
+	const AssetView dunFile = LoadAssetView<uint16_t>(path);
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
@@ -2152,6 +2157,7 @@ void ProcessObjects()
 void ObjSetMicro(Point position, int pn)
 {
 	dPiece[position.x][position.y] = pn;
+	InvalidateVision(position);
 	pn--;
 
 	int blocks = leveltype != DTYPE_HELL ? 10 : 16;
@@ -129,7 +129,11 @@ extern int ActiveObjectCount;
 extern bool ApplyObjectLighting;
 extern bool LoadingMapObjects;
 
-void InitObjectGFX();
+/**
+ * @brief Builds the list of object graphics used on the current level and loads them.
+ * @param loadGraphics Only build the list, leaving the sprites unloaded (for headless simulation)
+ */
+void InitObjectGFX(bool loadGraphics = true);
 void FreeObjectGFX();
 void AddL1Objs(int x1, int y1, int x2, int y2);
 void AddL2Objs(int x1, int y1, int x2, int y2);
@@ -166,6 +166,7 @@ void LoadOptions()
 	sgOptions.Graphics.bIntegerScaling = GetIniBool("Graphics", "Integer Scaling", false);
 	sgOptions.Graphics.bVSync = GetIniBool("Graphics", "Vertical Sync", true);
 	sgOptions.Graphics.bBlendedTransparancy = GetIniBool("Graphics", "Blended Transparency", true);
+	sgOptions.Graphics.bBlendedTransparencyCache = GetIniBool("Graphics", "Blended Transparency Cache", true);
 	sgOptions.Graphics.nGammaCorrection = GetIniInt("Graphics", "Gamma Correction", 100);
 	sgOptions.Graphics.bColorCycling = GetIniBool("Graphics", "Color Cycling", true);
 #if SDL_VERSION_ATLEAST(2, 0, 0)
@@ -175,6 +176,8 @@ void LoadOptions()
 #endif
 	sgOptions.Graphics.bFPSLimit = GetIniBool("Graphics", "FPS Limiter", true);
 	sgOptions.Graphics.bShowFPS = (GetIniInt("Graphics", "Show FPS", 0) != 0);
+	sgOptions.Graphics.bTileCache = GetIniBool("Graphics", "Tile Cache", false);
+	sgOptions.Graphics.bTileAtlas = GetIniBool("Graphics", "Tile Atlas", false);
 
 	sgOptions.Gameplay.nTickRate = GetIniInt("Game", "Speed", 20);
 	sgOptions.Gameplay.bRunInTown = GetIniBool("Game", "Run in Town", false);
@@ -250,6 +253,7 @@ void SaveOptions()
 	SetIniValue("Graphics", "Integer Scaling", sgOptions.Graphics.bIntegerScaling);
 	SetIniValue("Graphics", "Vertical Sync", sgOptions.Graphics.bVSync);
 	SetIniValue("Graphics", "Blended Transparency", sgOptions.Graphics.bBlendedTransparancy);
+	SetIniValue("Graphics", "Blended Transparency Cache", sgOptions.Graphics.bBlendedTransparencyCache);
 	SetIniValue("Graphics", "Gamma Correction", sgOptions.Graphics.nGammaCorrection);
 	SetIniValue("Graphics", "Color Cycling", sgOptions.Graphics.bColorCycling);
 #if SDL_VERSION_ATLEAST(2, 0, 0)
@@ -259,6 +263,8 @@ void SaveOptions()
 #endif
 	SetIniValue("Graphics", "FPS Limiter", sgOptions.Graphics.bFPSLimit);
 	SetIniValue("Graphics", "Show FPS", sgOptions.Graphics.bShowFPS);
+	SetIniValue("Graphics", "Tile Cache", sgOptions.Graphics.bTileCache);
+	SetIniValue("Graphics", "Tile Atlas", sgOptions.Graphics.bTileAtlas);
 
 	SetIniValue("Game", "Speed", sgOptions.Gameplay.nTickRate);
 	SetIniValue("Game", "Run in Town", sgOptions.Gameplay.bRunInTown);
@@ -59,6 +59,8 @@ struct GraphicsOptions {
 	bool bVSync;
 	/** @brief Use blended transparency rather than stippled. */
 	bool bBlendedTransparancy;
+	/** @brief Keep the generated blended transparency tables in the config directory. */
+	bool bBlendedTransparencyCache;
 	/** @brief Gamma correction level. */
 	int nGammaCorrection;
 	/** @brief Enable color cycling animations. */
@@ -75,6 +77,10 @@ struct GraphicsOptions {
 	bool bFPSLimit;
 	/** @brief Show FPS, even without the -f command line flag. */
 	bool bShowFPS;
+	/** @brief Keep the rendered floor between frames and only redraw the tiles that changed. */
+	bool bTileCache;
+	/** @brief Decode the level tiles once when the level is loaded instead of every time they are drawn. */
+	bool bTileAtlas;
 };
 
 struct GameplayOptions {
@@ -4,12 +4,23 @@
  * Implementation of functions for handling the engines color palette.
  */
 
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
 #include "dx.h"
-#include "engine/load_file.hpp"
+#include "engine/asset_view.hpp"
+#include "engine/palette_blend.hpp"
 #include "engine/random.hpp"
 #include "hwcursor.hpp"
 #include "options.h"
 #include "utils/display.h"
+#include "utils/file_util.h"
+#include "utils/paths.h"
 #include "utils/sdl_compat.h"
 
 namespace devilution {
@@ -64,65 +75,144 @@ void palette_init()
 	InitPalette();
 }
 
-static Uint8 FindBestMatchForColor(SDL_Color *palette, SDL_Color color, int skipFrom, int skipTo)
+namespace {
+
+/** Number of blended transparency tables kept in memory, enough for all palettes of a dungeon type. */
+constexpr size_t BlendTableCacheSize = 8;
+
+/** @brief Everything the blended transparency table is generated from. */
+struct BlendTableKey {
+	std::array<Uint8, 256 * 3> colors;
+	int32_t skipFrom;
+	int32_t skipTo;
+
+	bool operator==(const BlendTableKey &other) const
+	{
+		return colors == other.colors && skipFrom == other.skipFrom && skipTo == other.skipTo;
+	}
+};
+
+struct CachedBlendTable {
+	BlendTableKey key;
+	std::unique_ptr<Uint8[][256]> table;
+};
+
+/** Recently generated tables, most recently used first. */
+std::vector<CachedBlendTable> BlendTableCache;
+
+constexpr char BlendTableFileMagic[4] = { 'D', 'V', 'B', 'T' };
+
+BlendTableKey GetBlendTableKey(const SDL_Color *palette, int skipFrom, int skipTo)
 {
-	Uint8 best;
-	Uint32 bestDiff = SDL_MAX_UINT32;
+	BlendTableKey key;
 	for (int i = 0; i < 256; i++) {
-		if (i >= skipFrom && i <= skipTo)
-			continue;
-		int diffr = palette[i].r - color.r;
-		int diffg = palette[i].g - color.g;
-		int diffb = palette[i].b - color.b;
-		Uint32 diff = diffr * diffr + diffg * diffg + diffb * diffb;
-
-		if (bestDiff > diff) {
-			best = i;
-			bestDiff = diff;
-		}
+		key.colors[i * 3 + 0] = palette[i].r;
+		key.colors[i * 3 + 1] = palette[i].g;
+		key.colors[i * 3 + 2] = palette[i].b;
+	}
+	key.skipFrom = skipFrom;
+	key.skipTo = skipTo;
+	return key;
+}
+
+std::string GetBlendTablePath(const BlendTableKey &key)
+{
+	// FNV-1a
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	auto addByte = [&hash](uint8_t byte) {
+		hash ^= byte;
+		hash *= 0x100000001B3ULL;
+	};
+	for (Uint8 value : key.colors)
+		addByte(value);
+	for (int32_t skip : { key.skipFrom, key.skipTo }) {
+		for (int i = 0; i < 4; i++)
+			addByte(static_cast<uint32_t>(skip) >> (i * 8));
+	}
+
+	return paths::ConfigPath() + fmt::format("blend_{:016x}.bin", hash);
+}
+
+bool ReadBlendTable(const BlendTableKey &key, Uint8 table[256][256])
+{
+	const std::string path = GetBlendTablePath(key);
+	if (!FileExists(path.c_str()))
+		return false;
+	auto stream = CreateFileStream(path.c_str(), std::fstream::in | std::fstream::binary);
+	if (stream == nullptr)
+		return false;
+
+	char magic[sizeof(BlendTableFileMagic)];
+	BlendTableKey fileKey;
+	if (!stream->read(magic, sizeof(magic))
+	    || !stream->read(reinterpret_cast<char *>(fileKey.colors.data()), fileKey.colors.size())
+	    || !stream->read(reinterpret_cast<char *>(&fileKey.skipFrom), sizeof(fileKey.skipFrom))
+	    || !stream->read(reinterpret_cast<char *>(&fileKey.skipTo), sizeof(fileKey.skipTo)))
+		return false;
+	// The file name is only a hash, so make sure the table was generated from the same palette
+	if (memcmp(magic, BlendTableFileMagic, sizeof(magic)) != 0 || !(fileKey == key))
+		return false;
+
+	return static_cast<bool>(stream->read(reinterpret_cast<char *>(table), 256 * 256));
+}
+
+void WriteBlendTable(const BlendTableKey &key, const Uint8 table[256][256])
+{
+	const std::string path = GetBlendTablePath(key);
+	auto stream = CreateFileStream(path.c_str(), std::fstream::out | std::fstream::trunc | std::fstream::binary);
+	if (stream == nullptr || stream->fail())
+		return;
+
+	stream->write(BlendTableFileMagic, sizeof(BlendTableFileMagic));
+	stream->write(reinterpret_cast<const char *>(key.colors.data()), key.colors.size());
+	stream->write(reinterpret_cast<const char *>(&key.skipFrom), sizeof(key.skipFrom));
+	stream->write(reinterpret_cast<const char *>(&key.skipTo), sizeof(key.skipTo));
+	stream->write(reinterpret_cast<const char *>(table), 256 * 256);
+	if (!*stream) {
+		stream = nullptr;
+		RemoveFile(path.c_str());
 	}
-	return best;
 }
 
 /**
- * @brief Generate lookup table for transparency
- *
- * This is based of the same technique found in Quake2.
+ * @brief Fill paletteTransparencyLookup for the given palette
  *
- * To mimic 50% transparency we figure out what colors in the existing palette are the best match for the combination of any 2 colors.
- * We save this into a lookup table for use during rendering.
+ * Generating the table takes a noticeable amount of time on slow devices, so the result is cached
+ * in memory and, if enabled, in the config directory.
  *
  * @param palette The colors to operate on
  * @param skipFrom Do not use colors between this index and skipTo
  * @param skipTo Do not use colors between skipFrom and this index
- * @param toUpdate Only update the first n colors
  */
-static void GenerateBlendedLookupTable(SDL_Color *palette, int skipFrom, int skipTo, int toUpdate = 256)
+void LoadBlendedLookupTable(const SDL_Color *palette, int skipFrom, int skipTo)
 {
-	for (int i = 0; i < 256; i++) {
-		for (int j = 0; j < 256; j++) {
-			if (i == j) { // No need to calculate transparency between 2 identical colors
-				paletteTransparencyLookup[i][j] = j;
-				continue;
-			}
-			if (i > j) { // Half the blends will be mirror identical ([i][j] is the same as [j][i]), so simply copy the existing combination.
-				paletteTransparencyLookup[i][j] = paletteTransparencyLookup[j][i];
-				continue;
-			}
-			if (i > toUpdate && j > toUpdate) {
-				continue;
-			}
+	const BlendTableKey key = GetBlendTableKey(palette, skipFrom, skipTo);
+
+	auto cached = std::find_if(BlendTableCache.begin(), BlendTableCache.end(), [&key](const CachedBlendTable &entry) {
+		return entry.key == key;
+	});
+	if (cached != BlendTableCache.end()) {
+		std::rotate(BlendTableCache.begin(), cached, cached + 1);
+		memcpy(paletteTransparencyLookup, BlendTableCache.front().table.get(), sizeof(paletteTransparencyLookup));
+		return;
+	}
 
-			SDL_Color blendedColor;
-			blendedColor.r = ((int)palette[i].r + (int)palette[j].r) / 2;
-			blendedColor.g = ((int)palette[i].g + (int)palette[j].g) / 2;
-			blendedColor.b = ((int)palette[i].b + (int)palette[j].b) / 2;
-			Uint8 best = FindBestMatchForColor(palette, blendedColor, skipFrom, skipTo);
-			paletteTransparencyLookup[i][j] = best;
-		}
+	const bool useDiskCache = sgOptions.Graphics.bBlendedTransparencyCache;
+	if (!useDiskCache || !ReadBlendTable(key, paletteTransparencyLookup)) {
+		GenerateBlendedLookupTable(palette, skipFrom, skipTo, paletteTransparencyLookup);
+		if (useDiskCache)
+			WriteBlendTable(key, paletteTransparencyLookup);
 	}
+
+	if (BlendTableCache.size() == BlendTableCacheSize)
+		BlendTableCache.pop_back();
+	CachedBlendTable entry { key, std::unique_ptr<Uint8[][256]>(new Uint8[256][256]) };
+	memcpy(entry.table.get(), paletteTransparencyLookup, sizeof(paletteTransparencyLookup));
+	BlendTableCache.insert(BlendTableCache.begin(), std::move(entry));
 }
 
+} // namespace
+
 void LoadPalette(const char *pszFileName, bool blend /*= true*/)
 {
 	assert(pszFileName);
@@ -133,11 +223,12 @@ void LoadPalette(const char *pszFileName, bool blend /*= true*/)
 		uint8_t b;
 	};
 
-	std::array<Color, 256> palData;
-
-	LoadFileInMem(pszFileName, palData);
+	const AssetView palFile = LoadAssetView(pszFileName);
+	if (palFile.Size() < 256 * sizeof(Color))
+		app_fatal("Invalid palette file\n%s", pszFileName);
+	const auto *palData = palFile.DataAs<Color>();
 
-	for (unsigned i = 0; i < palData.size(); i++) {
+	for (unsigned i = 0; i < 256; i++) {
 		orig_palette[i].r = palData[i].r;
 		orig_palette[i].g = palData[i].g;
 		orig_palette[i].b = palData[i].b;
@@ -148,11 +239,11 @@ void LoadPalette(const char *pszFileName, bool blend /*= true*/)
 
 	if (blend && sgOptions.Graphics.bBlendedTransparancy) {
 		if (leveltype == DTYPE_CAVES || leveltype == DTYPE_CRYPT) {
-			GenerateBlendedLookupTable(orig_palette, 1, 31);
+			LoadBlendedLookupTable(orig_palette, 1, 31);
 		} else if (leveltype == DTYPE_NEST) {
-			GenerateBlendedLookupTable(orig_palette, 1, 15);
+			LoadBlendedLookupTable(orig_palette, 1, 15);
 		} else {
-			GenerateBlendedLookupTable(orig_palette, -1, -1);
+			LoadBlendedLookupTable(orig_palette, -1, -1);
 		}
 	}
 }
@@ -401,6 +492,7 @@ void palette_update_quest_palette(int n)
 	palette_update();
 	if (sgOptions.Graphics.bBlendedTransparancy) {
 		// Update blended transparency, but only for the color that was updated
+		PaletteColorGrid grid(logical_palette, 1, 31);
 		for (int j = 0; j < 256; j++) {
 			if (i == j) { // No need to calculate transparency between 2 identical colors
 				paletteTransparencyLookup[i][j] = j;
@@ -410,7 +502,7 @@ void palette_update_quest_palette(int n)
 			blendedColor.r = ((int)logical_palette[i].r + (int)logical_palette[j].r) / 2;
 			blendedColor.g = ((int)logical_palette[i].g + (int)logical_palette[j].g) / 2;
 			blendedColor.b = ((int)logical_palette[i].b + (int)logical_palette[j].b) / 2;
-			Uint8 best = FindBestMatchForColor(logical_palette, blendedColor, 1, 31);
+			Uint8 best = grid.FindBestMatch(blendedColor);
 			paletteTransparencyLookup[i][j] = paletteTransparencyLookup[j][i] = best;
 		}
 	}
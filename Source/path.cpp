@@ -5,45 +5,49 @@
  */
 #include "path.h"
 
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
 #include "gendung.h"
 
 namespace devilution {
 
-#define MAXPATHNODES 300
+namespace {
+
+constexpr int TileCount = MAXDUNX * MAXDUNY;
 
-/** Notes visisted by the path finding algorithm. */
-PATHNODE path_nodes[MAXPATHNODES];
-/** size of the pnode_tblptr stack */
-int gdwCurPathStep;
-/** the number of in-use nodes in path_nodes */
-int gdwCurNodes;
 /**
- * for reconstructing the path after the A* search is done. The longest
- * possible path is actually 24 steps, even though we can fit 25
+ * Most tiles a search reaches before it gives up. Without it, a search for an unreachable target
+ * would explore every tile within MAX_PATH_LENGTH steps.
  */
-int8_t pnode_vals[MAX_PATH_LENGTH];
-/** A linked list of all visited nodes */
-PATHNODE *pnode_ptr;
-/** A stack for recursively searching nodes */
-PATHNODE *pnode_tblptr[MAXPATHNODES];
-/** A linked list of the A* frontier, sorted by distance */
-PATHNODE *path_2_nodes;
+constexpr int MaxPathNodes = 300;
 
-/** For iterating over the 8 possible movement directions */
-const Displacement PathDirs[8] = {
-	// clang-format off
-	{ -1, -1 },
-	{ -1,  1 },
-	{  1, -1 },
-	{  1,  1 },
-	{ -1,  0 },
-	{  0, -1 },
-	{  1,  0 },
-	{  0,  1 },
-	// clang-format on
+/**
+ * @brief A* search state of a tile.
+ *
+ * Only valid while `generation` matches SearchGeneration, so starting a new search doesn't need
+ * to clear anything.
+ */
+struct PathTile {
+	uint32_t generation;
+	/** Cost of the best known path from the start */
+	uint16_t g;
+	/** Estimated total cost of a path through this tile */
+	uint16_t f;
+	/** Tile index of the previous step on the best known path */
+	uint16_t parent;
+	/** Position in OpenTiles, or -1 if the tile is not on the frontier */
+	int16_t heapIndex;
+	/** Number of steps of the best known path from the start */
+	uint8_t steps;
 };
 
-/* data */
+PathTile PathTiles[TileCount];
+uint32_t SearchGeneration;
+/** Binary min-heap of the tile indices on the A* frontier, ordered by IsBetterStep(). */
+uint16_t OpenTiles[TileCount];
+int OpenTileCount;
 
 /**
  * each step direction is assigned a number like this:
@@ -54,329 +58,267 @@ const Displacement PathDirs[8] = {
  * dy 0|2 0 3
  *    1|8 4 7
  */
-int8_t path_directions[9] = { 5, 1, 6, 2, 0, 3, 8, 4, 7 };
+const int8_t PathDirections[9] = { 5, 1, 6, 2, 0, 3, 8, 4, 7 };
 
-/**
- * find the shortest path from (sx,sy) to (dx,dy), using PosOk(PosOkArg,x,y) to
- * check that each step is a valid position. Store the step directions (see
- * path_directions) in path, which must have room for 24 steps
- */
-int FindPath(bool (*posOk)(int, Point), int posOkArg, int sx, int sy, int dx, int dy, int8_t path[MAX_PATH_LENGTH])
+int TileIndex(Point position)
 {
-	// clear all nodes, create root nodes for the visited/frontier linked lists
-	gdwCurNodes = 0;
-	path_2_nodes = path_new_step();
-	pnode_ptr = path_new_step();
-	gdwCurPathStep = 0;
-	PATHNODE *pathStart = path_new_step();
-	pathStart->g = 0;
-	pathStart->h = path_get_h_cost(sx, sy, dx, dy);
-	pathStart->position.x = sx;
-	pathStart->f = pathStart->h + pathStart->g;
-	pathStart->position.y = sy;
-	path_2_nodes->NextNode = pathStart;
-	// A* search until we find (dx,dy) or fail
-	PATHNODE *nextNode;
-	while ((nextNode = GetNextPath()) != nullptr) {
-		// reached the end, success!
-		if (nextNode->position.x == dx && nextNode->position.y == dy) {
-			PATHNODE *current = nextNode;
-			int pathLength = 0;
-			while (current->Parent != nullptr) {
-				if (pathLength >= MAX_PATH_LENGTH)
-					break;
-				pnode_vals[pathLength++] = path_directions[3 * (current->position.y - current->Parent->position.y) - current->Parent->position.x + 4 + current->position.x];
-				current = current->Parent;
-			}
-			if (pathLength != MAX_PATH_LENGTH) {
-				int i;
-				for (i = 0; i < pathLength; i++)
-					path[i] = pnode_vals[pathLength - i - 1];
-				return i;
-			}
-			return 0;
-		}
-		// ran out of nodes, abort!
-		if (!path_get_path(posOk, posOkArg, nextNode, dx, dy))
-			return 0;
-	}
-	// frontier is empty, no path!
-	return 0;
+	return position.x * MAXDUNY + position.y;
+}
+
+Point TilePosition(int index)
+{
+	return { index / MAXDUNY, index % MAXDUNY };
+}
+
+bool IsInBounds(Point position)
+{
+	return position.x >= 0 && position.x < MAXDUNX && position.y >= 0 && position.y < MAXDUNY;
 }
 
 /**
- * @brief heuristic, estimated cost from (sx,sy) to (dx,dy)
+ * @brief heuristic, estimated cost from startPosition to destinationPosition
  */
-int path_get_h_cost(int sx, int sy, int dx, int dy)
+int GetHeuristicCost(Point startPosition, Point destinationPosition)
 {
-	int deltaX = abs(sx - dx);
-	int deltaY = abs(sy - dy);
-
-	int min = deltaX < deltaY ? deltaX : deltaY;
-	int max = deltaX > deltaY ? deltaX : deltaY;
+	int deltaX = abs(startPosition.x - destinationPosition.x);
+	int deltaY = abs(startPosition.y - destinationPosition.y);
 
-	// see path_check_equal for why this is times 2
-	return 2 * (min + max);
+	// see GetStepCost for why this is times 2
+	return 2 * (deltaX + deltaY);
 }
 
 /**
- * @brief return 2 if pPath is horizontally/vertically aligned with (dx,dy), else 3
+ * @brief return 2 if the step is horizontal/vertical, else 3
  *
  * This approximates that diagonal movement on a square grid should have a cost
  * of sqrt(2). That's approximately 1.5, so they multiply all step costs by 2,
  * except diagonal steps which are times 3
  */
-int path_check_equal(PATHNODE *pPath, int dx, int dy)
+int GetStepCost(Point startPosition, Point destinationPosition)
 {
-	if (pPath->position.x == dx || pPath->position.y == dy)
+	if (startPosition.x == destinationPosition.x || startPosition.y == destinationPosition.y)
 		return 2;
 
 	return 3;
 }
 
 /**
- * @brief get the next node on the A* frontier to explore (estimated to be closest to the goal), mark it as visited, and return it
+ * @brief Frontier order: lowest estimated total cost first, ties go to the tile closest to the goal.
  */
-PATHNODE *GetNextPath()
+bool IsBetterStep(int a, int b)
 {
-	PATHNODE *result;
-
-	result = path_2_nodes->NextNode;
-	if (result == nullptr) {
-		return result;
-	}
-
-	path_2_nodes->NextNode = result->NextNode;
-	result->NextNode = pnode_ptr->NextNode;
-	pnode_ptr->NextNode = result;
-	return result;
+	const PathTile &tileA = PathTiles[a];
+	const PathTile &tileB = PathTiles[b];
+	if (tileA.f != tileB.f)
+		return tileA.f < tileB.f;
+	return tileA.f - tileA.g < tileB.f - tileB.g;
 }
 
-/**
- * @brief check if stepping from pPath to (dx,dy) cuts a corner.
- *
- * If you step from A to B, both Xs need to be clear:
- *
- *  AX
- *  XB
- *
- *  @return true if step is allowed
- */
-bool path_solid_pieces(PATHNODE *pPath, int dx, int dy)
+void PlaceOpenTile(int heapIndex, int tile)
 {
-	bool rv = true;
-	switch (path_directions[3 * (dy - pPath->position.y) + 3 - pPath->position.x + 1 + dx]) {
-	case 5:
-		rv = !nSolidTable[dPiece[dx][dy + 1]] && !nSolidTable[dPiece[dx + 1][dy]];
-		break;
-	case 6:
-		rv = !nSolidTable[dPiece[dx][dy + 1]] && !nSolidTable[dPiece[dx - 1][dy]];
-		break;
-	case 7:
-		rv = !nSolidTable[dPiece[dx][dy - 1]] && !nSolidTable[dPiece[dx - 1][dy]];
-		break;
-	case 8:
-		rv = !nSolidTable[dPiece[dx + 1][dy]] && !nSolidTable[dPiece[dx][dy - 1]];
-		break;
-	}
-	return rv;
+	OpenTiles[heapIndex] = tile;
+	PathTiles[tile].heapIndex = heapIndex;
 }
 
-/**
- * @brief perform a single step of A* bread-first search by trying to step in every possible direction from pPath with goal (x,y). Check each step with PosOk
- *
- * @return false if we ran out of preallocated nodes to use, else true
- */
-bool path_get_path(bool (*posOk)(int, Point), int posOkArg, PATHNODE *pPath, int x, int y)
+void SiftUp(int heapIndex)
 {
-	for (auto dir : PathDirs) {
-		Point tile = pPath->position + dir;
-		bool ok = posOk(posOkArg, tile);
-		if ((ok && path_solid_pieces(pPath, tile.x, tile.y)) || (!ok && tile == Point { x, y })) {
-			if (!path_parent_path(pPath, tile.x, tile.y, x, y))
-				return false;
-		}
+	const int tile = OpenTiles[heapIndex];
+	while (heapIndex > 0) {
+		const int parentIndex = (heapIndex - 1) / 2;
+		if (!IsBetterStep(tile, OpenTiles[parentIndex]))
+			break;
+		PlaceOpenTile(heapIndex, OpenTiles[parentIndex]);
+		heapIndex = parentIndex;
 	}
-
-	return true;
+	PlaceOpenTile(heapIndex, tile);
 }
 
-/**
- * @brief add a step from pPath to (dx,dy), return 1 if successful, and update the frontier/visited nodes accordingly
- *
- * @return true if step successfully added, false if we ran out of nodes to use
- */
-bool path_parent_path(PATHNODE *pPath, int dx, int dy, int sx, int sy)
+void SiftDown(int heapIndex)
 {
-	int nextG = pPath->g + path_check_equal(pPath, dx, dy);
-
-	// 3 cases to consider
-	// case 1: (dx,dy) is already on the frontier
-	PATHNODE *dxdy = path_get_node1(dx, dy);
-	if (dxdy != nullptr) {
-		int i;
-		for (i = 0; i < 8; i++) {
-			if (pPath->Child[i] == nullptr)
-				break;
-		}
-		pPath->Child[i] = dxdy;
-		if (nextG < dxdy->g) {
-			if (path_solid_pieces(pPath, dx, dy)) {
-				// we'll explore it later, just update
-				dxdy->Parent = pPath;
-				dxdy->g = nextG;
-				dxdy->f = nextG + dxdy->h;
-			}
-		}
-	} else {
-		// case 2: (dx,dy) was already visited
-		dxdy = path_get_node2(dx, dy);
-		if (dxdy != nullptr) {
-			int i;
-			for (i = 0; i < 8; i++) {
-				if (pPath->Child[i] == nullptr)
-					break;
-			}
-			pPath->Child[i] = dxdy;
-			if (nextG < dxdy->g && path_solid_pieces(pPath, dx, dy)) {
-				// update the node
-				dxdy->Parent = pPath;
-				dxdy->g = nextG;
-				dxdy->f = nextG + dxdy->h;
-				// already explored, so re-update others starting from that node
-				path_set_coords(dxdy);
-			}
-		} else {
-			// case 3: (dx,dy) is totally new
-			dxdy = path_new_step();
-			if (dxdy == nullptr)
-				return false;
-			dxdy->Parent = pPath;
-			dxdy->g = nextG;
-			dxdy->h = path_get_h_cost(dx, dy, sx, sy);
-			dxdy->f = nextG + dxdy->h;
-			dxdy->position = { dx, dy };
-			// add it to the frontier
-			path_next_node(dxdy);
-
-			int i;
-			for (i = 0; i < 8; i++) {
-				if (pPath->Child[i] == nullptr)
-					break;
-			}
-			pPath->Child[i] = dxdy;
-		}
+	const int tile = OpenTiles[heapIndex];
+	while (true) {
+		int childIndex = 2 * heapIndex + 1;
+		if (childIndex >= OpenTileCount)
+			break;
+		if (childIndex + 1 < OpenTileCount && IsBetterStep(OpenTiles[childIndex + 1], OpenTiles[childIndex]))
+			childIndex++;
+		if (!IsBetterStep(OpenTiles[childIndex], tile))
+			break;
+		PlaceOpenTile(heapIndex, OpenTiles[childIndex]);
+		heapIndex = childIndex;
 	}
-	return true;
+	PlaceOpenTile(heapIndex, tile);
 }
 
 /**
- * @brief return a node for (dx,dy) on the frontier, or NULL if not found
+ * @brief Adds a tile to the frontier, or moves it forward if it already is on it.
  */
-PATHNODE *path_get_node1(int dx, int dy)
+void PushOpenTile(int tile)
 {
-	PATHNODE *result = path_2_nodes->NextNode;
-	while (result != nullptr) {
-		if (result->position.x == dx && result->position.y == dy)
-			return result;
-		result = result->NextNode;
+	int heapIndex = PathTiles[tile].heapIndex;
+	if (heapIndex == -1) {
+		heapIndex = OpenTileCount++;
+		OpenTiles[heapIndex] = tile;
 	}
-	return nullptr;
+	SiftUp(heapIndex);
 }
 
-/**
- * @brief return a node for (dx,dy) if it was visited, or NULL if not found
- */
-PATHNODE *path_get_node2(int dx, int dy)
+int PopOpenTile()
 {
-	PATHNODE *result = pnode_ptr->NextNode;
-	while (result != nullptr) {
-		if (result->position.x == dx && result->position.y == dy)
-			return result;
-		result = result->NextNode;
+	const int tile = OpenTiles[0];
+	PathTiles[tile].heapIndex = -1;
+	OpenTileCount--;
+	if (OpenTileCount > 0) {
+		PlaceOpenTile(0, OpenTiles[OpenTileCount]);
+		SiftDown(0);
 	}
-	return nullptr;
+	return tile;
 }
 
-/**
- * @brief insert pPath into the frontier (keeping the frontier sorted by total distance)
- */
-void path_next_node(PATHNODE *pPath)
+void StartSearch()
 {
-	if (path_2_nodes->NextNode == nullptr) {
-		path_2_nodes->NextNode = pPath;
-		return;
+	SearchGeneration++;
+	if (SearchGeneration == 0) {
+		// The counter wrapped around, so stale tiles could look current
+		memset(PathTiles, 0, sizeof(PathTiles));
+		SearchGeneration = 1;
 	}
-
-	PATHNODE *current = path_2_nodes;
-	PATHNODE *next = path_2_nodes->NextNode;
-	int f = pPath->f;
-	while (next != nullptr && next->f < f) {
-		current = next;
-		next = next->NextNode;
-	}
-	pPath->NextNode = next;
-	current->NextNode = pPath;
+	OpenTileCount = 0;
 }
 
 /**
- * @brief update all path costs using depth-first search starting at pPath
+ * @brief Writes the step directions (see PathDirections) leading to the given tile.
+ * @return The number of steps
  */
-void path_set_coords(PATHNODE *pPath)
+int ReconstructPath(int tile, int8_t path[MAX_PATH_LENGTH])
 {
-	path_push_active_step(pPath);
-	// while there are path nodes to check
-	while (gdwCurPathStep > 0) {
-		PATHNODE *pathOld = path_pop_active_step();
-		for (auto *pathAct : pathOld->Child) {
-			if (pathAct == nullptr)
-				break;
-
-			if (pathOld->g + path_check_equal(pathOld, pathAct->position.x, pathAct->position.y) < pathAct->g) {
-				if (path_solid_pieces(pathOld, pathAct->position.x, pathAct->position.y)) {
-					pathAct->Parent = pathOld;
-					pathAct->g = pathOld->g + path_check_equal(pathOld, pathAct->position.x, pathAct->position.y);
-					pathAct->f = pathAct->g + pathAct->h;
-					path_push_active_step(pathAct);
-				}
-			}
-		}
+	const int pathLength = PathTiles[tile].steps;
+	for (int i = pathLength - 1; i >= 0; i--) {
+		const Point position = TilePosition(tile);
+		tile = PathTiles[tile].parent;
+		const Point previous = TilePosition(tile);
+		path[i] = PathDirections[3 * (position.y - previous.y) - previous.x + 4 + position.x];
 	}
+	return pathLength;
 }
 
-/**
- * @brief push pPath onto the pnode_tblptr stack
- */
-void path_push_active_step(PATHNODE *pPath)
-{
-	int stackIndex = gdwCurPathStep;
-	gdwCurPathStep++;
-	pnode_tblptr[stackIndex] = pPath;
-}
+} // namespace
+
+/** For iterating over the 8 possible movement directions */
+const Displacement PathDirs[8] = {
+	// clang-format off
+	{ -1, -1 },
+	{ -1,  1 },
+	{  1, -1 },
+	{  1,  1 },
+	{ -1,  0 },
+	{  0, -1 },
+	{  1,  0 },
+	{  0,  1 },
+	// clang-format on
+};
 
 /**
- * @brief pop and return a node from the pnode_tblptr stack
+ * find the shortest path from (sx,sy) to (dx,dy), using PosOk(PosOkArg,x,y) to
+ * check that each step is a valid position. Store the step directions (see
+ * PathDirections) in path, which must have room for 24 steps
  */
-PATHNODE *path_pop_active_step()
+int FindPath(bool (*posOk)(int, Point), int posOkArg, int sx, int sy, int dx, int dy, int8_t path[MAX_PATH_LENGTH])
 {
-	gdwCurPathStep--;
-	return pnode_tblptr[gdwCurPathStep];
+	const Point startPosition { sx, sy };
+	const Point destinationPosition { dx, dy };
+	if (!IsInBounds(startPosition))
+		return 0;
+
+	StartSearch();
+	const int start = TileIndex(startPosition);
+	PathTile &startTile = PathTiles[start];
+	startTile.generation = SearchGeneration;
+	startTile.g = 0;
+	startTile.f = GetHeuristicCost(startPosition, destinationPosition);
+	startTile.parent = start;
+	startTile.heapIndex = -1;
+	startTile.steps = 0;
+	PushOpenTile(start);
+	int reachedTiles = 1;
+
+	// A* search until we find (dx,dy) or fail
+	while (OpenTileCount > 0) {
+		const int current = PopOpenTile();
+		const Point position = TilePosition(current);
+		const PathTile &currentTile = PathTiles[current];
+		// reached the end, success!
+		if (position == destinationPosition)
+			return ReconstructPath(current, path);
+		// The longest possible path is 24 steps, even though we can fit 25
+		if (currentTile.steps >= MAX_PATH_LENGTH - 1)
+			continue;
+
+		for (auto dir : PathDirs) {
+			const Point tile = position + dir;
+			if (!IsInBounds(tile))
+				continue;
+			bool ok = posOk(posOkArg, tile);
+			if (ok ? !path_solid_pieces(position, tile) : tile != destinationPosition)
+				continue;
+
+			const int next = TileIndex(tile);
+			const int nextG = currentTile.g + GetStepCost(position, tile);
+			PathTile &nextTile = PathTiles[next];
+			if (nextTile.generation == SearchGeneration) {
+				if (nextG >= nextTile.g)
+					continue;
+				// A cheaper way to a known tile, explore it again if it was already visited
+				nextTile.f = nextTile.f - nextTile.g + nextG;
+			} else {
+				// ran out of nodes, abort!
+				if (reachedTiles == MaxPathNodes)
+					return 0;
+				reachedTiles++;
+				nextTile.generation = SearchGeneration;
+				nextTile.heapIndex = -1;
+				nextTile.f = nextG + GetHeuristicCost(tile, destinationPosition);
+			}
+			nextTile.g = nextG;
+			nextTile.parent = current;
+			nextTile.steps = currentTile.steps + 1;
+			PushOpenTile(next);
+		}
+	}
+	// frontier is empty, no path!
+	return 0;
 }
 
 /**
- * @brief zero one of the preallocated nodes and return a pointer to it, or NULL if none are available
+ * @brief check if stepping from startPosition to destinationPosition cuts a corner.
+ *
+ * If you step from A to B, both Xs need to be clear:
+ *
+ *  AX
+ *  XB
+ *
+ *  @return true if step is allowed
  */
-PATHNODE *path_new_step()
+bool path_solid_pieces(Point startPosition, Point destinationPosition)
 {
-	PATHNODE *newNode;
-
-	if (gdwCurNodes == MAXPATHNODES)
-		return nullptr;
-
-	newNode = &path_nodes[gdwCurNodes];
-	gdwCurNodes++;
-	memset(newNode, 0, sizeof(PATHNODE));
-	return newNode;
+	const int dx = destinationPosition.x;
+	const int dy = destinationPosition.y;
+	bool rv = true;
+	switch (PathDirections[3 * (dy - startPosition.y) + 3 - startPosition.x + 1 + dx]) {
+	case 5:
+		rv = !nSolidTable[dPiece[dx][dy + 1]] && !nSolidTable[dPiece[dx + 1][dy]];
+		break;
+	case 6:
+		rv = !nSolidTable[dPiece[dx][dy + 1]] && !nSolidTable[dPiece[dx - 1][dy]];
+		break;
+	case 7:
+		rv = !nSolidTable[dPiece[dx][dy - 1]] && !nSolidTable[dPiece[dx - 1][dy]];
+		break;
+	case 8:
+		rv = !nSolidTable[dPiece[dx + 1][dy]] && !nSolidTable[dPiece[dx][dy - 1]];
+		break;
+	}
+	return rv;
 }
 
 } // namespace devilution
@@ -14,29 +14,20 @@ namespace devilution {
 
 #define MAX_PATH_LENGTH 25
 
-struct PATHNODE {
-	uint8_t f;
-	uint8_t h;
-	uint8_t g;
-	Point position;
-	struct PATHNODE *Parent;
-	struct PATHNODE *Child[8];
-	struct PATHNODE *NextNode;
-};
-
-int FindPath(bool (*PosOk)(int, Point), int PosOkArg, int sx, int sy, int dx, int dy, int8_t path[MAX_PATH_LENGTH]);
-int path_get_h_cost(int sx, int sy, int dx, int dy);
-PATHNODE *GetNextPath();
-bool path_solid_pieces(PATHNODE *pPath, int dx, int dy);
-bool path_get_path(bool (*PosOk)(int, Point), int PosOkArg, PATHNODE *pPath, int x, int y);
-bool path_parent_path(PATHNODE *pPath, int dx, int dy, int sx, int sy);
-PATHNODE *path_get_node1(int dx, int dy);
-PATHNODE *path_get_node2(int dx, int dy);
-void path_next_node(PATHNODE *pPath);
-void path_set_coords(PATHNODE *pPath);
-void path_push_active_step(PATHNODE *pPath);
-PATHNODE *path_pop_active_step();
-PATHNODE *path_new_step();
+/**
+ * @brief Find the shortest path from (sx,sy) to (dx,dy) with A*, using posOk(posOkArg, position) to check that each step is a valid position.
+ *
+ * The destination itself may fail posOk, so that paths can lead up to an occupied tile.
+ * @param path Receives the direction of every step, numbered 1-8 as described in path.cpp
+ * @return The number of steps, 0 if no path of at most 24 steps was found
+ */
+int FindPath(bool (*posOk)(int, Point), int posOkArg, int sx, int sy, int dx, int dy, int8_t path[MAX_PATH_LENGTH]);
+
+/**
+ * @brief Check that stepping between two adjacent tiles doesn't cut the corner of a solid tile.
+ * @return true if the step is allowed
+ */
+bool path_solid_pieces(Point startPosition, Point destinationPosition);
 
 /* rdata */
 
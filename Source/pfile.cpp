@@ -5,7 +5,11 @@
  */
 #include "pfile.h"
 
+#include <memory>
 #include <string>
+#include <vector>
+
+#include <SDL.h>
 
 #include "codec.h"
 #include "engine.h"
@@ -19,6 +23,7 @@
 #include "utils/file_util.h"
 #include "utils/language.h"
 #include "utils/paths.h"
+#include "utils/thread.h"
 
 namespace devilution {
 
@@ -34,6 +39,63 @@ namespace {
 /** List of character names for the character selection screen. */
 char hero_names[MAX_CHARACTERS][PLR_NAME_LEN];
 
+#pragma pack(push, 1)
+/** @brief Contents of the "heroinfo" file, what the hero selection shows without unpacking the hero. */
+struct HeroInfoIndex {
+	uint32_t version;
+	/** Copy of the "hero" file the entry was made for, the entry is stale if they differ */
+	PkPlayerStruct hero;
+	uint16_t strength;
+	uint16_t magic;
+	uint16_t dexterity;
+	uint16_t vitality;
+	uint8_t level;
+	uint8_t heroClass;
+	uint8_t heroRank;
+	uint8_t hasSaveGame;
+};
+#pragma pack(pop)
+
+constexpr uint32_t HeroInfoIndexVersion = 1;
+
+/** @brief A step of a save that is written to the archive by the save thread. */
+struct SaveStep {
+	enum class Type : uint8_t {
+		WriteFile,
+		RenameTempToPerm,
+	};
+
+	Type type;
+	std::string fileName;
+	/** Plain file contents, with room for codec_encode() to add its padding and signature */
+	std::unique_ptr<byte[]> data;
+	size_t size;
+};
+
+/** @brief Everything written between opening and closing the save archive by a PFileScopedArchiveWriter. */
+struct PendingSave {
+	std::string archivePath;
+	const char *password;
+	bool clearTables;
+	std::vector<SaveStep> steps;
+};
+
+/** The save that the game thread is currently filling, if any. */
+std::unique_ptr<PendingSave> RecordingSave;
+/** The save that the save thread is writing, owned by that thread until WaitForPendingSave(). */
+std::unique_ptr<PendingSave> WritingSave;
+SDL_Thread *SaveThread;
+SDL_threadID SaveThreadId;
+/** Set by the save thread when it couldn't open the archive. */
+bool SaveFailed;
+
+/**
+ * Save archive that is kept open for reading, so that StormLib only parses its header, hash table
+ * and block table once instead of on every read. Closed before anything writes to the archive.
+ */
+HANDLE ReadArchiveHandle;
+std::string ReadArchivePath;
+
 std::string GetSavePath(uint32_t saveNum)
 {
 	std::string path = paths::PrefPath();
@@ -133,13 +195,17 @@ std::unique_ptr<byte[]> ReadArchive(HANDLE archive, const char *pszName, size_t
 		return nullptr;
 
 	size_t length = SFileGetFileSize(file);
-	if (length == 0)
+	if (length == 0) {
+		SFileCloseFileThreadSafe(file);
 		return nullptr;
+	}
 
 	std::unique_ptr<byte[]> buf { new byte[length] };
-	if (!SFileReadFileThreadSafe(file, buf.get(), length))
-		return nullptr;
+	const bool read = SFileReadFileThreadSafe(file, buf.get(), length);
+	// The archive stays open, so the file handle must not leak
 	SFileCloseFileThreadSafe(file);
+	if (!read)
+		return nullptr;
 
 	length = codec_decode(buf.get(), length, pfile_get_password());
 	if (length == 0)
@@ -174,31 +240,100 @@ void EncodeHero(const PkPlayerStruct *pack)
 	std::unique_ptr<byte[]> packed { new byte[packedLen] };
 
 	memcpy(packed.get(), pack, sizeof(*pack));
-	codec_encode(packed.get(), sizeof(*pack), packedLen, pfile_get_password());
-	mpqapi_write_file("hero", packed.get(), packedLen);
+	pfile_write_save_file("hero", std::move(packed), sizeof(*pack));
 }
 
-bool OpenArchive(uint32_t saveNum)
+void WriteSaveFile(const char *fileName, byte *data, size_t size, const char *password)
 {
-	return OpenMPQ(GetSavePath(saveNum).c_str());
+	const size_t encodedLen = codec_get_encoded_len(size);
+	codec_encode(data, size, encodedLen, password);
+	mpqapi_write_file(fileName, data, encodedLen);
 }
 
-HANDLE OpenSaveArchive(uint32_t saveNum)
+void WritePendingSave(PendingSave &save)
 {
-	HANDLE archive;
+	if (!OpenMPQ(save.archivePath.c_str())) {
+		SaveFailed = true;
+		return;
+	}
+
+	for (SaveStep &step : save.steps) {
+		switch (step.type) {
+		case SaveStep::Type::WriteFile:
+			WriteSaveFile(step.fileName.c_str(), step.data.get(), step.size, save.password);
+			// Release the snapshot early, level files are large
+			step.data = nullptr;
+			break;
+		case SaveStep::Type::RenameTempToPerm:
+			RenameTempToPerm();
+			break;
+		}
+	}
+
+	mpqapi_flush_and_close(save.clearTables);
+}
+
+void SaveHandler()
+{
+	WritePendingSave(*WritingSave);
+}
+
+/**
+ * @brief Waits until the save thread has finished writing the archive.
+ *
+ * Must be called before anything else opens the save archive.
+ */
+void WaitForPendingSave()
+{
+	if (SaveThread != nullptr) {
+		SDL_WaitThread(SaveThread, nullptr);
+		SaveThread = nullptr;
+	}
+	WritingSave = nullptr;
 
-	if (SFileOpenArchive(GetSavePath(saveNum).c_str(), 0, 0, &archive))
-		return archive;
-	return nullptr;
+	if (SaveFailed) {
+		SaveFailed = false;
+		app_fatal("%s", _("Failed to open player archive for writing."));
+	}
 }
 
-void CloseArchive(HANDLE *hsArchive)
+void CloseSaveArchive()
 {
-	if (*hsArchive == nullptr)
+	if (ReadArchiveHandle == nullptr)
 		return;
 
-	SFileCloseArchive(*hsArchive);
-	*hsArchive = nullptr;
+	SFileCloseArchive(ReadArchiveHandle);
+	ReadArchiveHandle = nullptr;
+	ReadArchivePath.clear();
+}
+
+bool OpenArchive(uint32_t saveNum)
+{
+	WaitForPendingSave();
+	CloseSaveArchive();
+	return OpenMPQ(GetSavePath(saveNum).c_str());
+}
+
+/**
+ * @brief Returns a read handle for the given save archive, reusing the open one if possible.
+ *
+ * The handle stays owned by the session, callers must not close it.
+ */
+HANDLE GetSaveArchive(uint32_t saveNum)
+{
+	WaitForPendingSave();
+
+	std::string path = GetSavePath(saveNum);
+	if (ReadArchiveHandle != nullptr && ReadArchivePath == path)
+		return ReadArchiveHandle;
+
+	CloseSaveArchive();
+	if (!SFileOpenArchive(path.c_str(), 0, 0, &ReadArchiveHandle)) {
+		ReadArchiveHandle = nullptr;
+		return nullptr;
+	}
+	ReadArchivePath = std::move(path);
+	return ReadArchiveHandle;
 }
 
 void Game2UiPlayer(const PlayerStruct &player, _uiheroinfo *heroinfo, bool bHasSaveFile)
@@ -217,6 +352,62 @@ void Game2UiPlayer(const PlayerStruct &player, _uiheroinfo *heroinfo, bool bHasS
 	heroinfo->spawned = gbIsSpawn;
 }
 
+/**
+ * @brief Saves the hero selection fields of a player next to the packed hero.
+ * @param hero The packed hero that is saved together with the index
+ */
+void WriteHeroInfoIndex(const PkPlayerStruct &hero, const PlayerStruct &player, bool hasSaveGame)
+{
+	_uiheroinfo uihero;
+	Game2UiPlayer(player, &uihero, hasSaveGame);
+
+	HeroInfoIndex index;
+	index.version = SDL_SwapLE32(HeroInfoIndexVersion);
+	index.hero = hero;
+	index.strength = SDL_SwapLE16(uihero.strength);
+	index.magic = SDL_SwapLE16(uihero.magic);
+	index.dexterity = SDL_SwapLE16(uihero.dexterity);
+	index.vitality = SDL_SwapLE16(uihero.vitality);
+	index.level = uihero.level;
+	index.heroClass = static_cast<uint8_t>(uihero.heroclass);
+	index.heroRank = uihero.herorank;
+	index.hasSaveGame = uihero.hassaved ? 1 : 0;
+
+	std::unique_ptr<byte[]> data { new byte[codec_get_encoded_len(sizeof(index))] };
+	memcpy(data.get(), &index, sizeof(index));
+	pfile_write_save_file("heroinfo", std::move(data), sizeof(index));
+}
+
+/**
+ * @brief Fills the hero selection fields from the index saved with the hero.
+ * @return false if the archive has no index or it was saved for a different version of the hero
+ */
+bool ReadHeroInfoIndex(HANDLE archive, const PkPlayerStruct &hero, _uiheroinfo *uihero)
+{
+	size_t size;
+	auto data = ReadArchive(archive, "heroinfo", &size);
+	if (data == nullptr || size != sizeof(HeroInfoIndex))
+		return false;
+
+	HeroInfoIndex index;
+	memcpy(&index, data.get(), sizeof(index));
+	if (SDL_SwapLE32(index.version) != HeroInfoIndexVersion || memcmp(&index.hero, &hero, sizeof(hero)) != 0)
+		return false;
+
+	memset(uihero, 0, sizeof(*uihero));
+	strncpy(uihero->name, hero.pName, sizeof(uihero->name) - 1);
+	uihero->level = index.level;
+	uihero->heroclass = static_cast<HeroClass>(index.heroClass);
+	uihero->strength = SDL_SwapLE16(index.strength);
+	uihero->magic = SDL_SwapLE16(index.magic);
+	uihero->dexterity = SDL_SwapLE16(index.dexterity);
+	uihero->vitality = SDL_SwapLE16(index.vitality);
+	uihero->hassaved = index.hasSaveGame != 0;
+	uihero->herorank = index.heroRank;
+	uihero->spawned = gbIsSpawn;
+	return true;
+}
+
 bool GetFileName(uint8_t lvl, char *dst)
 {
 	const char *fmt;
@@ -269,13 +460,36 @@ PFileScopedArchiveWriter::PFileScopedArchiveWriter(bool clearTables)
     : save_num_(GetSaveNumberFromName(Players[MyPlayerId]._pName))
     , clear_tables_(clearTables)
 {
-	if (!OpenArchive(save_num_))
-		app_fatal("%s", _("Failed to open player archive for writing."));
+	WaitForPendingSave();
+	CloseSaveArchive();
+
+	RecordingSave = std::make_unique<PendingSave>();
+	RecordingSave->archivePath = GetSavePath(save_num_);
+	RecordingSave->password = pfile_get_password();
+	RecordingSave->clearTables = clear_tables_;
 }
 
 PFileScopedArchiveWriter::~PFileScopedArchiveWriter()
 {
-	mpqapi_flush_and_close(clear_tables_);
+	WritingSave = std::move(RecordingSave);
+	SaveThread = CreateThread(SaveHandler, &SaveThreadId);
+	if (SaveThread == nullptr)
+		WritePendingSave(*WritingSave);
+}
+
+void pfile_write_save_file(const char *fileName, std::unique_ptr<byte[]> data, size_t size)
+{
+	if (RecordingSave == nullptr) {
+		WriteSaveFile(fileName, data.get(), size, pfile_get_password());
+		return;
+	}
+
+	RecordingSave->steps.push_back({ SaveStep::Type::WriteFile, fileName, std::move(data), size });
+}
+
+void pfile_wait_for_save()
+{
+	WaitForPendingSave();
 }
 
 void pfile_write_hero(bool writeGameData, bool clearTables)
@@ -283,11 +497,14 @@ void pfile_write_hero(bool writeGameData, bool clearTables)
 	PFileScopedArchiveWriter scopedWriter(clearTables);
 	if (writeGameData) {
 		SaveGameData();
-		RenameTempToPerm();
+		RecordingSave->steps.push_back({ SaveStep::Type::RenameTempToPerm, {}, nullptr, 0 });
 	}
 	PkPlayerStruct pkplr;
 	PackPlayer(&pkplr, Players[MyPlayerId], !gbIsMultiplayer);
 	EncodeHero(&pkplr);
+	// A single player archive may hold a game from an earlier save, the index can only be written together with it
+	if (gbIsMultiplayer || writeGameData)
+		WriteHeroInfoIndex(pkplr, Players[MyPlayerId], !gbIsMultiplayer);
 	if (!gbVanilla) {
 		SaveHotkeys();
 		SaveHeroItems(Players[MyPlayerId]);
@@ -299,27 +516,27 @@ bool pfile_ui_set_hero_infos(bool (*uiAddHeroInfo)(_uiheroinfo *))
 	memset(hero_names, 0, sizeof(hero_names));
 
 	for (uint32_t i = 0; i < MAX_CHARACTERS; i++) {
-		HANDLE archive = OpenSaveArchive(i);
+		HANDLE archive = GetSaveArchive(i);
 		if (archive != nullptr) {
 			PkPlayerStruct pkplr;
 			if (ReadHero(archive, &pkplr)) {
 				_uiheroinfo uihero;
 				strcpy(hero_names[i], pkplr.pName);
-				bool hasSaveGame = ArchiveContainsGame(archive);
-				if (hasSaveGame)
-					pkplr.bIsHellfire = gbIsHellfireSaveGame ? 1 : 0;
+				if (!ReadHeroInfoIndex(archive, pkplr, &uihero)) {
+					bool hasSaveGame = ArchiveContainsGame(archive);
+					if (hasSaveGame)
+						pkplr.bIsHellfire = gbIsHellfireSaveGame ? 1 : 0;
 
-				UnPackPlayer(&pkplr, 0, false);
+					UnPackPlayer(&pkplr, 0, false);
 
-				CloseArchive(&archive);
-				LoadHeroItems(Players[0]);
-				RemoveEmptyInventory(Players[0]);
-				CalcPlrInv(0, false);
+					LoadHeroItems(Players[0]);
+					RemoveEmptyInventory(Players[0]);
+					CalcPlrInv(0, false);
 
-				Game2UiPlayer(Players[0], &uihero, hasSaveGame);
+					Game2UiPlayer(Players[0], &uihero, hasSaveGame);
+				}
 				uiAddHeroInfo(&uihero);
 			}
-			CloseArchive(&archive);
 		}
 	}
 
@@ -359,6 +576,7 @@ bool pfile_ui_save_create(_uiheroinfo *heroinfo)
 	player._pName[PLR_NAME_LEN - 1] = '\0';
 	PackPlayer(&pkplr, player, true);
 	EncodeHero(&pkplr);
+	WriteHeroInfoIndex(pkplr, player, false);
 	Game2UiPlayer(player, heroinfo, false);
 	if (!gbVanilla) {
 		SaveHotkeys();
@@ -374,6 +592,8 @@ bool pfile_delete_save(_uiheroinfo *heroInfo)
 	uint32_t saveNum = GetSaveNumberFromName(heroInfo->name);
 	if (saveNum < MAX_CHARACTERS) {
 		hero_names[saveNum][0] = '\0';
+		WaitForPendingSave();
+		CloseSaveArchive();
 		RemoveFile(GetSavePath(saveNum).c_str());
 	}
 	return true;
@@ -385,7 +605,7 @@ void pfile_read_player_from_save(char name[16], int playerId)
 	PkPlayerStruct pkplr;
 
 	uint32_t saveNum = GetSaveNumberFromName(name);
-	archive = OpenSaveArchive(saveNum);
+	archive = GetSaveArchive(saveNum);
 	if (archive == nullptr)
 		app_fatal("%s", _("Unable to open archive"));
 	if (!ReadHero(archive, &pkplr))
@@ -395,8 +615,6 @@ void pfile_read_player_from_save(char name[16], int playerId)
 	if (gbValidSaveFile)
 		pkplr.bIsHellfire = gbIsHellfireSaveGame ? 1 : 0;
 
-	CloseArchive(&archive);
-
 	UnPackPlayer(&pkplr, playerId, false);
 
 	LoadHeroItems(Players[playerId]);
@@ -411,12 +629,11 @@ bool LevelFileExists()
 	GetPermLevelNames(szName);
 
 	uint32_t saveNum = GetSaveNumberFromName(Players[MyPlayerId]._pName);
-	if (!OpenArchive(saveNum))
+	HANDLE archive = GetSaveArchive(saveNum);
+	if (archive == nullptr)
 		app_fatal("%s", _("Unable to read to save file archive"));
 
-	bool hasFile = mpqapi_has_file(szName);
-	mpqapi_flush_and_close(true);
-	return hasFile;
+	return SFileHasFile(archive, szName);
 }
 
 void GetTempLevelNames(char *szTemp)
@@ -431,12 +648,11 @@ void GetPermLevelNames(char *szPerm)
 {
 	uint32_t saveNum = GetSaveNumberFromName(Players[MyPlayerId]._pName);
 	GetTempLevelNames(szPerm);
-	if (!OpenArchive(saveNum))
+	HANDLE archive = GetSaveArchive(saveNum);
+	if (archive == nullptr)
 		app_fatal("%s", _("Unable to read to save file archive"));
 
-	bool hasFile = mpqapi_has_file(szPerm);
-	mpqapi_flush_and_close(true);
-	if (!hasFile) {
+	if (!SFileHasFile(archive, szPerm)) {
 		if (setlevel)
 			sprintf(szPerm, "perms%02d", setlvlnum);
 		else
@@ -461,12 +677,11 @@ std::unique_ptr<byte[]> pfile_read(const char *pszName, size_t *pdwLen)
 	HANDLE archive;
 
 	uint32_t saveNum = GetSaveNumberFromName(Players[MyPlayerId]._pName);
-	archive = OpenSaveArchive(saveNum);
+	archive = GetSaveArchive(saveNum);
 	if (archive == nullptr)
 		return nullptr;
 
 	auto buf = ReadArchive(archive, pszName, pdwLen);
-	CloseArchive(&archive);
 	if (buf == nullptr)
 		return nullptr;
 
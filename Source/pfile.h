@@ -5,6 +5,8 @@
  */
 #pragma once
 
+#include <memory>
+
 #include "player.h"
 #include "DiabloUI/diabloui.h"
 
@@ -14,12 +16,18 @@ namespace devilution {
 
 extern bool gbValidSaveFile;
 
+/**
+ * @brief Collects the files saved during its lifetime and writes them to the player save file in the background.
+ *
+ * The game thread only takes snapshots of the file contents, encoding, compressing and updating
+ * the archive happen on a separate thread.
+ */
 class PFileScopedArchiveWriter {
 public:
-	// Opens the player save file for writing
+	// Waits for the previous save to finish and starts collecting files for the player save file
 	PFileScopedArchiveWriter(bool clearTables = !gbIsMultiplayer);
 
-	// Finishes writing and closes the player save file.
+	// Starts writing the collected files to the player save file.
 	~PFileScopedArchiveWriter();
 
 private:
@@ -28,6 +36,18 @@ private:
 };
 
 const char *pfile_get_password();
+/**
+ * @brief Saves a file to the player save file.
+ *
+ * Inside a PFileScopedArchiveWriter the file is written in the background, otherwise the save
+ * archive must already be open and it is written immediately.
+ * @param data File contents, with room for codec_get_encoded_len(size) bytes
+ */
+void pfile_write_save_file(const char *fileName, std::unique_ptr<byte[]> data, size_t size);
+/**
+ * @brief Blocks until the save that is being written in the background, if any, is complete.
+ */
+void pfile_wait_for_save();
 void pfile_write_hero(bool writeGameData = false, bool clearTables = !gbIsMultiplayer);
 bool pfile_ui_set_hero_infos(bool (*uiAddHeroInfo)(_uiheroinfo *));
 void pfile_ui_set_class_stats(unsigned int playerClass, _uidefaultstats *classStats);
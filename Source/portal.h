@@ -21,6 +21,10 @@ struct PortalStruct {
 };
 
 extern PortalStruct Portals[MAXPORTAL];
+/** X-coordinate of each players portal in town. */
+extern int WarpDropX[MAXPORTAL];
+/** Y-coordinate of each players portal in town. */
+extern int WarpDropY[MAXPORTAL];
 
 void InitPortals();
 void SetPortalStats(int i, bool o, int x, int y, int lvl, dungeon_type lvltype);
@@ -9,7 +9,7 @@
 
 #include "control.h"
 #include "cursor.h"
-#include "engine/load_file.hpp"
+#include "engine/asset_view.hpp"
 #include "engine/random.hpp"
 #include "engine/render/cel_render.hpp"
 #include "engine/render/text_render.hpp"
@@ -370,7 +370,8 @@ void DrawSkelKing(int q, int x, int y)
 
 void DrawWarLord(int x, int y)
 {
-	auto dunData = LoadFileInMem<uint16_t>("Levels\\L4Data\\Warlord2.DUN");
+	const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L4Data\\Warlord2.DUN");
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
@@ -392,7 +393,8 @@ void DrawWarLord(int x, int y)
 
 void DrawSChamber(int q, int x, int y)
 {
-	auto dunData = LoadFileInMem<uint16_t>("Levels\\L2Data\\Bonestr1.DUN");
+	const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L2Data\\Bonestr1.DUN");
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
@@ -416,7 +418,8 @@ void DrawSChamber(int q, int x, int y)
 
 void DrawLTBanner(int x, int y)
 {
-	auto dunData = LoadFileInMem<uint16_t>("Levels\\L1Data\\Banner1.DUN");
+	const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L1Data\\Banner1.DUN");
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
@@ -440,7 +443,8 @@ void DrawLTBanner(int x, int y)
 
 void DrawBlind(int x, int y)
 {
-	auto dunData = LoadFileInMem<uint16_t>("Levels\\L2Data\\Blind1.DUN");
+	const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L2Data\\Blind1.DUN");
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
@@ -464,7 +468,8 @@ void DrawBlind(int x, int y)
 
 void DrawBlood(int x, int y)
 {
-	auto dunData = LoadFileInMem<uint16_t>("Levels\\L2Data\\Blood2.DUN");
+	const AssetView dunFile = LoadAssetView<uint16_t>("Levels\\L2Data\\Blood2.DUN");
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
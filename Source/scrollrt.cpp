@@ -12,6 +12,7 @@
 #include "engine/render/cel_render.hpp"
 #include "engine/render/cl2_render.hpp"
 #include "engine/render/dun_render.hpp"
+#include "engine/render/present.hpp"
 #include "engine/render/text_render.hpp"
 #include "error.h"
 #include "gmenu.h"
@@ -23,6 +24,7 @@
 #include "minitext.h"
 #include "missiles.h"
 #include "nthread.h"
+#include "options.h"
 #include "plrmsg.h"
 #include "qol/itemlabels.h"
 #include "qol/monhealthbar.h"
@@ -39,21 +41,6 @@
 namespace devilution {
 
 namespace {
-/**
- * @brief Hash algorithm for point
- */
-struct PointHash {
-	std::size_t operator()(Point const &s) const noexcept
-	{
-		return s.x ^ (s.y << 1);
-	}
-};
-
-/**
- * @brief Contains all Missile at rendering position
- */
-std::unordered_multimap<Point, MissileStruct *, PointHash> MissilesAtRenderingTile;
-
 /**
  * @brief Could the missile (at the next game tick) collide? This method is a simplified version of CheckMissileCol (for example without random).
  */
@@ -148,13 +135,10 @@ void UpdateMissileRendererData(MissileStruct &m)
 
 void UpdateMissilesRendererData()
 {
-	MissilesAtRenderingTile.clear();
-
 	for (int i = 0; i < ActiveMissileCount; i++) {
 		assert(ActiveMissiles[i] < MAXMISSILES);
 		MissileStruct &m = Missiles[ActiveMissiles[i]];
 		UpdateMissileRendererData(m);
-		MissilesAtRenderingTile.insert(std::make_pair(m.position.tileForRendering, &m));
 	}
 }
 
@@ -388,23 +372,6 @@ void DrawMissilePrivate(const Surface &out, const MissileStruct *m, int sx, int
 		Cl2Draw(out, mx, my, cel, m->_miAnimFrame);
 }
 
-/**
- * @brief Render a missile sprites for a given tile
- * @param out Output buffer
- * @param x dPiece coordinate
- * @param y dPiece coordinate
- * @param sx Output buffer coordinate
- * @param sy Output buffer coordinate
- * @param pre Is the sprite in the background
- */
-void DrawMissile(const Surface &out, int x, int y, int sx, int sy, bool pre)
-{
-	const auto range = MissilesAtRenderingTile.equal_range(Point { x, y });
-	for (auto it = range.first; it != range.second; it++) {
-		DrawMissilePrivate(out, it->second, sx, sy, pre);
-	}
-}
-
 /**
  * @brief Render a monster sprite
  * @param out Output buffer
@@ -842,6 +809,309 @@ static void DrawPlayerHelper(const Surface &out, int x, int y, int sx, int sy)
 	DrawPlayer(out, p, x, y, px, py);
 }
 
+/**
+ * @brief Render the body of a dead monster
+ * @param out Output buffer
+ * @param bDead Contents of dDead for the tile
+ * @param sx Output buffer coordinate
+ * @param sy Output buffer coordinate
+ */
+static void DrawDead(const Surface &out, int8_t bDead, int sx, int sy)
+{
+	DeadStruct *pDeadGuy = &Dead[(bDead & 0x1F) - 1];
+	auto dd = static_cast<Direction>((bDead >> 5) & 7);
+	int px = sx - CalculateWidth2(pDeadGuy->width);
+	const byte *pCelBuff = pDeadGuy->data[dd];
+	assert(pCelBuff != nullptr);
+	const auto *frameTable = reinterpret_cast<const uint32_t *>(pCelBuff);
+	int frames = SDL_SwapLE32(frameTable[0]);
+	int nCel = pDeadGuy->frame;
+	if (nCel < 1 || frames > 50 || nCel > frames) {
+		Log("Unclipped dead: frame {} of {}, deadnum=={}", nCel, frames, (bDead & 0x1F) - 1);
+		return;
+	}
+	if (pDeadGuy->translationPaletteIndex != 0) {
+		Cl2DrawLightTbl(out, px, sy, CelSprite(pCelBuff, pDeadGuy->width), nCel, pDeadGuy->translationPaletteIndex);
+	} else {
+		Cl2DrawLight(out, px, sy, CelSprite(pCelBuff, pDeadGuy->width), nCel);
+	}
+}
+
+namespace {
+
+/**
+ * @brief The sprites that can be drawn on a tile, in the order DrawDungeon() draws them.
+ */
+enum class DrawableKind : uint8_t {
+	PreMissile,
+	Dead,
+	PreObject,
+	PreItem,
+	/** A player walking between this tile and the one north of it (BFLAG_PLAYERLR) */
+	PlayerNorth,
+	/** A monster walking between this tile and the one north of it (BFLAG_MONSTLR) */
+	MonsterNorth,
+	DeadPlayer,
+	Player,
+	Monster,
+	Missile,
+	Object,
+	Item,
+};
+
+/**
+ * @brief A sprite found by CollectDrawables().
+ */
+struct Drawable {
+	/** Tile, kind and collection order packed so that sorting puts the sprites of a tile together in drawing order */
+	uint32_t key;
+	/** Missile number for missiles */
+	int16_t id;
+
+	int Tile() const
+	{
+		return key >> 12;
+	}
+
+	DrawableKind Kind() const
+	{
+		return static_cast<DrawableKind>((key >> 8) & 0xF);
+	}
+};
+
+static_assert(MAXMISSILES <= 256, "the missile order has to fit in the low byte of Drawable::key");
+
+/** @brief The part of Drawables that belongs to a tile, only valid if `generation` matches DrawableGeneration. */
+struct DrawableRange {
+	uint32_t generation;
+	uint32_t first;
+	uint32_t count;
+};
+
+/** The sprites of the tiles in view, sorted by tile and drawing order */
+std::vector<Drawable> Drawables;
+DrawableRange DrawableRanges[MAXDUNX][MAXDUNY];
+/** Incremented by every CollectDrawables() call, so the ranges of earlier frames don't need to be cleared */
+uint32_t DrawableGeneration;
+
+void AddDrawable(int x, int y, DrawableKind kind, int order = 0, int id = 0)
+{
+	Drawable drawable;
+	drawable.key = static_cast<uint32_t>(x * MAXDUNY + y) << 12 | static_cast<uint32_t>(kind) << 8 | order;
+	drawable.id = id;
+	Drawables.push_back(drawable);
+}
+
+/**
+ * @brief Adds the sprites stored in the dungeon maps for a tile, at most once per frame.
+ */
+void CollectTileDrawables(int x, int y)
+{
+	DrawableRange &range = DrawableRanges[x][y];
+	if (range.generation == DrawableGeneration)
+		return;
+	range.generation = DrawableGeneration;
+	range.count = 0;
+
+	const int8_t bFlag = dFlags[x][y];
+	const int8_t bDead = dDead[x][y];
+	const int8_t bObject = dObject[x][y];
+	const int8_t bItem = dItem[x][y];
+	if (bDead == 0 && bObject == 0 && bItem <= 0 && dPlayer[x][y] <= 0 && dMonster[x][y] <= 0
+	    && (bFlag & (BFLAG_PLAYERLR | BFLAG_MONSTLR | BFLAG_DEAD_PLAYER)) == 0)
+		return;
+
+	if (bDead != 0)
+		AddDrawable(x, y, DrawableKind::Dead);
+	if (bObject != 0) {
+		const int oi = bObject > 0 ? bObject - 1 : -(bObject + 1);
+		AddDrawable(x, y, Objects[oi]._oPreFlag ? DrawableKind::PreObject : DrawableKind::Object);
+	}
+	if (bItem > 0)
+		AddDrawable(x, y, Items[bItem - 1]._iPostDraw ? DrawableKind::Item : DrawableKind::PreItem);
+	if ((bFlag & BFLAG_PLAYERLR) != 0)
+		AddDrawable(x, y, DrawableKind::PlayerNorth);
+	if ((bFlag & BFLAG_MONSTLR) != 0 && y > 0 && dMonster[x][y - 1] < 0)
+		AddDrawable(x, y, DrawableKind::MonsterNorth);
+	if ((bFlag & BFLAG_DEAD_PLAYER) != 0)
+		AddDrawable(x, y, DrawableKind::DeadPlayer);
+	if (dPlayer[x][y] > 0)
+		AddDrawable(x, y, DrawableKind::Player);
+	if (dMonster[x][y] > 0)
+		AddDrawable(x, y, DrawableKind::Monster);
+}
+
+} // namespace
+
+void ClearDrawables()
+{
+	Drawables.clear();
+	DrawableGeneration++;
+	if (DrawableGeneration == 0) {
+		// The counter wrapped around, so stale ranges could look current
+		memset(DrawableRanges, 0, sizeof(DrawableRanges));
+		DrawableGeneration = 1;
+	}
+}
+
+void CollectDrawables(int x, int y, int rows, int columns)
+{
+	ClearDrawables();
+
+	// Same walk as DrawTileContent(), including the tiles behind walls it may draw early
+	rows += MicroTileLen;
+	for (int i = 0; i < rows; i++) {
+		for (int j = 0; j < columns; j++) {
+			if (x >= 0 && x < MAXDUNX && y >= 0 && y < MAXDUNY) {
+				if (x + 1 < MAXDUNX && y - 1 >= 0)
+					CollectTileDrawables(x + 1, y - 1);
+				CollectTileDrawables(x, y);
+			}
+			ShiftGrid(&x, &y, 1, 0);
+		}
+		ShiftGrid(&x, &y, -columns, 0);
+		if ((i & 1) != 0) {
+			x++;
+			columns--;
+		} else {
+			y++;
+			columns++;
+		}
+	}
+
+	for (int i = 0; i < ActiveMissileCount; i++) {
+		const MissileStruct &missile = Missiles[ActiveMissiles[i]];
+		const Point tile = missile.position.tileForRendering;
+		if (tile.x < 0 || tile.x >= MAXDUNX || tile.y < 0 || tile.y >= MAXDUNY || DrawableRanges[tile.x][tile.y].generation != DrawableGeneration)
+			continue;
+		if (missile._miPreFlag && !MissilePreFlag)
+			continue;
+		AddDrawable(tile.x, tile.y, missile._miPreFlag ? DrawableKind::PreMissile : DrawableKind::Missile, i, ActiveMissiles[i]);
+	}
+
+	std::sort(Drawables.begin(), Drawables.end(), [](const Drawable &a, const Drawable &b) {
+		return a.key < b.key;
+	});
+	for (uint32_t i = 0; i < Drawables.size(); i++) {
+		const int tile = Drawables[i].Tile();
+		DrawableRange &range = DrawableRanges[tile / MAXDUNY][tile % MAXDUNY];
+		if (range.count == 0)
+			range.first = i;
+		range.count++;
+	}
+}
+
+namespace {
+
+/**
+ * @brief Render one collected sprite
+ * @param out Target buffer
+ * @param drawable The sprite
+ * @param sx dPiece coordinate
+ * @param sy dPiece coordinate
+ * @param dx Target buffer coordinate
+ * @param dy Target buffer coordinate
+ */
+void DrawDrawable(const Surface &out, const Drawable &drawable, int sx, int sy, int dx, int dy)
+{
+	switch (drawable.Kind()) {
+	case DrawableKind::PreMissile:
+		DrawMissilePrivate(out, &Missiles[drawable.id], dx, dy, true);
+		break;
+	case DrawableKind::Dead:
+		if (LightTableIndex < LightsMax)
+			DrawDead(out, dDead[sx][sy], dx, dy);
+		break;
+	case DrawableKind::PreObject:
+		DrawObject(out, sx, sy, dx, dy, true);
+		break;
+	case DrawableKind::PreItem:
+		DrawItem(out, sx, sy, dx, dy, true);
+		break;
+	case DrawableKind::PlayerNorth:
+		assert((DWORD)(sy - 1) < MAXDUNY);
+		DrawPlayerHelper(out, sx, sy - 1, dx, dy);
+		break;
+	case DrawableKind::MonsterNorth:
+		DrawMonsterHelper(out, sx, sy, -1, dx, dy);
+		break;
+	case DrawableKind::DeadPlayer:
+		DrawDeadPlayer(out, sx, sy, dx, dy);
+		break;
+	case DrawableKind::Player:
+		DrawPlayerHelper(out, sx, sy, dx, dy);
+		break;
+	case DrawableKind::Monster:
+		DrawMonsterHelper(out, sx, sy, 0, dx, dy);
+		break;
+	case DrawableKind::Missile:
+		DrawMissilePrivate(out, &Missiles[drawable.id], dx, dy, false);
+		break;
+	case DrawableKind::Object:
+		DrawObject(out, sx, sy, dx, dy, false);
+		break;
+	case DrawableKind::Item:
+		DrawItem(out, sx, sy, dx, dy, false);
+		break;
+	}
+}
+
+/**
+ * @brief Render the missiles whose rendering position is on the given tile, in the order of the active list
+ * @param out Output buffer
+ * @param x dPiece coordinate
+ * @param y dPiece coordinate
+ * @param sx Output buffer coordinate
+ * @param sy Output buffer coordinate
+ * @param pre Is the sprite in the background
+ */
+void DrawMissiles(const Surface &out, int x, int y, int sx, int sy, bool pre)
+{
+	for (int i = 0; i < ActiveMissileCount; i++) {
+		const MissileStruct &missile = Missiles[ActiveMissiles[i]];
+		if (missile.position.tileForRendering == Point { x, y })
+			DrawMissilePrivate(out, &missile, sx, sy, pre);
+	}
+}
+
+/**
+ * @brief Render the sprites of a tile straight from the dungeon maps, for tiles CollectDrawables() didn't visit
+ * @param out Target buffer
+ * @param sx dPiece coordinate
+ * @param sy dPiece coordinate
+ * @param dx Target buffer coordinate
+ * @param dy Target buffer coordinate
+ */
+void DrawTileDrawables(const Surface &out, int sx, int sy, int dx, int dy)
+{
+	const int8_t bFlag = dFlags[sx][sy];
+	const int8_t bDead = dDead[sx][sy];
+
+	if (MissilePreFlag)
+		DrawMissiles(out, sx, sy, dx, dy, true);
+	if (LightTableIndex < LightsMax && bDead != 0)
+		DrawDead(out, bDead, dx, dy);
+	DrawObject(out, sx, sy, dx, dy, true);
+	DrawItem(out, sx, sy, dx, dy, true);
+	if ((bFlag & BFLAG_PLAYERLR) != 0) {
+		assert((DWORD)(sy - 1) < MAXDUNY);
+		DrawPlayerHelper(out, sx, sy - 1, dx, dy);
+	}
+	if ((bFlag & BFLAG_MONSTLR) != 0 && sy > 0 && dMonster[sx][sy - 1] < 0)
+		DrawMonsterHelper(out, sx, sy, -1, dx, dy);
+	if ((bFlag & BFLAG_DEAD_PLAYER) != 0)
+		DrawDeadPlayer(out, sx, sy, dx, dy);
+	if (dPlayer[sx][sy] > 0)
+		DrawPlayerHelper(out, sx, sy, dx, dy);
+	if (dMonster[sx][sy] > 0)
+		DrawMonsterHelper(out, sx, sy, 0, dx, dy);
+	DrawMissiles(out, sx, sy, dx, dy, false);
+	DrawObject(out, sx, sy, dx, dy, false);
+	DrawItem(out, sx, sy, dx, dy, false);
+}
+
+} // namespace
+
 /**
  * @brief Render object sprites
  * @param out Target buffer
@@ -863,66 +1133,21 @@ static void DrawDungeon(const Surface &out, int sx, int sy, int dx, int dy)
 
 	DrawCell(out, sx, sy, dx, dy);
 
-	int8_t bFlag = dFlags[sx][sy];
-	int8_t bDead = dDead[sx][sy];
 	int8_t bMap = dTransVal[sx][sy];
 
-	int negMon = 0;
-	if (sy > 0) // check for OOB
-		negMon = dMonster[sx][sy - 1];
-
 #ifdef _DEBUG
-	if (visiondebug && (bFlag & BFLAG_LIT) != 0) {
+	if (visiondebug && (dFlags[sx][sy] & BFLAG_LIT) != 0) {
 		CelClippedDrawTo(out, { dx, dy }, *pSquareCel, 1);
 	}
 #endif
 
-	if (MissilePreFlag) {
-		DrawMissile(out, sx, sy, dx, dy, true);
-	}
-
-	if (LightTableIndex < LightsMax && bDead != 0) {
-		do {
-			DeadStruct *pDeadGuy = &Dead[(bDead & 0x1F) - 1];
-			auto dd = static_cast<Direction>((bDead >> 5) & 7);
-			int px = dx - CalculateWidth2(pDeadGuy->width);
-			const byte *pCelBuff = pDeadGuy->data[dd];
-			assert(pCelBuff != nullptr);
-			const auto *frameTable = reinterpret_cast<const uint32_t *>(pCelBuff);
-			int frames = SDL_SwapLE32(frameTable[0]);
-			int nCel = pDeadGuy->frame;
-			if (nCel < 1 || frames > 50 || nCel > frames) {
-				Log("Unclipped dead: frame {} of {}, deadnum=={}", nCel, frames, (bDead & 0x1F) - 1);
-				break;
-			}
-			if (pDeadGuy->translationPaletteIndex != 0) {
-				Cl2DrawLightTbl(out, px, dy, CelSprite(pCelBuff, pDeadGuy->width), nCel, pDeadGuy->translationPaletteIndex);
-			} else {
-				Cl2DrawLight(out, px, dy, CelSprite(pCelBuff, pDeadGuy->width), nCel);
-			}
-		} while (false);
-	}
-	DrawObject(out, sx, sy, dx, dy, true);
-	DrawItem(out, sx, sy, dx, dy, true);
-	if ((bFlag & BFLAG_PLAYERLR) != 0) {
-		assert((DWORD)(sy - 1) < MAXDUNY);
-		DrawPlayerHelper(out, sx, sy - 1, dx, dy);
-	}
-	if ((bFlag & BFLAG_MONSTLR) != 0 && negMon < 0) {
-		DrawMonsterHelper(out, sx, sy, -1, dx, dy);
-	}
-	if ((bFlag & BFLAG_DEAD_PLAYER) != 0) {
-		DrawDeadPlayer(out, sx, sy, dx, dy);
-	}
-	if (dPlayer[sx][sy] > 0) {
-		DrawPlayerHelper(out, sx, sy, dx, dy);
-	}
-	if (dMonster[sx][sy] > 0) {
-		DrawMonsterHelper(out, sx, sy, 0, dx, dy);
+	const DrawableRange &range = DrawableRanges[sx][sy];
+	if (range.generation == DrawableGeneration) {
+		for (uint32_t i = range.first; i < range.first + range.count; i++)
+			DrawDrawable(out, Drawables[i], sx, sy, dx, dy);
+	} else {
+		DrawTileDrawables(out, sx, sy, dx, dy);
 	}
-	DrawMissile(out, sx, sy, dx, dy, false);
-	DrawObject(out, sx, sy, dx, dy, false);
-	DrawItem(out, sx, sy, dx, dy, false);
 
 	if (leveltype != DTYPE_TOWN) {
 		char bArch = dSpecial[sx][sy];
@@ -999,20 +1224,242 @@ static void DrawFloor(const Surface &out, int x, int y, int sx, int sy, int rows
 	}
 }
 
-#define IsWall(x, y) (dPiece[x][y] == 0 || nSolidTable[dPiece[x][y]] || dSpecial[x][y] != 0)
-#define IsWalkable(x, y) (dPiece[x][y] != 0 && !nSolidTable[dPiece[x][y]])
+namespace {
+
+/** @brief What the floor cache last rendered for a dungeon tile. */
+struct FloorCacheTile {
+	enum class Kind : uint8_t {
+		None,
+		Floor,
+		Black,
+	};
+
+	Kind kind;
+	uint8_t light;
+	uint16_t left;
+	uint16_t right;
+
+	bool operator==(const FloorCacheTile &other) const
+	{
+		return kind == other.kind && light == other.light && left == other.left && right == other.right;
+	}
+
+	bool operator!=(const FloorCacheTile &other) const
+	{
+		return !(*this == other);
+	}
+};
+
+/** How far the cached floor reaches past the view on each side, so small camera moves don't need new tiles */
+constexpr int FloorCacheMarginX = 2 * TILE_WIDTH;
+constexpr int FloorCacheMarginY = 2 * TILE_HEIGHT;
+
+/** Floor layer of the area around the view, as rendered by earlier frames. */
+Surface FloorCache;
+/** World pixel position of the top left corner of FloorCache, see FloorTileWorldPosition(). */
+Point FloorCacheOrigin;
+/** Whether FloorCache and FloorCacheTiles can be used, cleared by InvalidateFloorCache(). */
+bool FloorCacheValid;
+FloorCacheTile FloorCacheTiles[MAXDUNX][MAXDUNY];
+/** Tiles that need to be redrawn this frame, kept to reuse the allocation. */
+std::vector<Point> FloorCacheDirtyTiles;
+
+int FloorDiv(int value, int divisor)
+{
+	return value >= 0 ? value / divisor : -((divisor - 1 - value) / divisor);
+}
 
 /**
- * @brief Render a row of tile
- * @param out Output buffer
- * @param x dPiece coordinate
- * @param y dPiece coordinate
- * @param sx Buffer coordinate
- * @param sy Buffer coordinate
- * @param rows Number of rows
- * @param columns Tile in a row
+ * @brief Position of a dungeon tile in a fixed isometric pixel space, the same space the view is a window of.
+ * @return Left corner and bottom of the tile, like the sx and sy parameters of DrawFloor()
  */
-static void DrawTileContent(const Surface &out, int x, int y, int sx, int sy, int rows, int columns)
+Point FloorTileWorldPosition(int x, int y)
+{
+	return { (x - y) * (TILE_WIDTH / 2), (x + y) * (TILE_HEIGHT / 2) };
+}
+
+FloorCacheTile GetFloorCacheTile(int x, int y)
+{
+	FloorCacheTile tile {};
+	if (x < 0 || x >= MAXDUNX || y < 0 || y >= MAXDUNY || dPiece[x][y] == 0 || nSolidTable[dPiece[x][y]]) {
+		// Walls are drawn by DrawTileContent(), the cache keeps black underneath them
+		tile.kind = FloorCacheTile::Kind::Black;
+		return tile;
+	}
+	tile.kind = FloorCacheTile::Kind::Floor;
+	tile.light = dLight[x][y];
+	tile.left = dpiece_defs_map_2[x][y].mt[0];
+	tile.right = dpiece_defs_map_2[x][y].mt[1];
+	return tile;
+}
+
+void RenderFloorCacheTile(const Surface &out, int x, int y, int sx, int sy)
+{
+	if (GetFloorCacheTile(x, y).kind == FloorCacheTile::Kind::Floor)
+		DrawFloor(out, x, y, sx, sy);
+	else
+		world_draw_black_tile(out, sx, sy);
+}
+
+/**
+ * @brief Calls `func(x, y)` for every tile whose floor overlaps the given world rectangle, in the order DrawFloor() draws them.
+ */
+template <typename Func>
+void ForEachFloorTile(int left, int top, int right, int bottom, Func func)
+{
+	for (int sum = FloorDiv(top, TILE_HEIGHT / 2); sum <= FloorDiv(bottom + TILE_HEIGHT - 2, TILE_HEIGHT / 2); sum++) {
+		for (int difference = FloorDiv(left, TILE_WIDTH / 2) - 1; difference < FloorDiv(right - 1, TILE_WIDTH / 2) + 1; difference++) {
+			if (((sum + difference) & 1) != 0)
+				continue;
+			func((sum + difference) / 2, (sum - difference) / 2);
+		}
+	}
+}
+
+/**
+ * @brief Redraws the area of one tile in the cache, including the parts of the neighbouring tiles that overlap it.
+ */
+void RedrawFloorCacheTile(int x, int y)
+{
+	const Point position = FloorTileWorldPosition(x, y);
+	const int left = std::max(position.x - FloorCacheOrigin.x, 0);
+	const int top = std::max(position.y - TILE_HEIGHT + 1 - FloorCacheOrigin.y, 0);
+	const int right = std::min(position.x + TILE_WIDTH - FloorCacheOrigin.x, FloorCache.w());
+	const int bottom = std::min(position.y + 1 - FloorCacheOrigin.y, FloorCache.h());
+	if (left >= right || top >= bottom)
+		return;
+	const Surface area = FloorCache.subregion(left, top, right - left, bottom - top);
+
+	// The tiles one step away on the map are the ones half a tile away on screen, listed in drawing order
+	constexpr Displacement Overlapping[] = { { -1, 0 }, { 0, -1 }, { 0, 0 }, { 0, 1 }, { 1, 0 } };
+	for (Displacement offset : Overlapping) {
+		const int tileX = x + offset.deltaX;
+		const int tileY = y + offset.deltaY;
+		const Point tilePosition = FloorTileWorldPosition(tileX, tileY);
+		RenderFloorCacheTile(area, tileX, tileY, tilePosition.x - FloorCacheOrigin.x - left, tilePosition.y - FloorCacheOrigin.y - top);
+	}
+}
+
+/**
+ * @brief Moves the cache to a new origin, keeping the pixels of the area both windows cover.
+ */
+void ScrollFloorCache(Point origin)
+{
+	const Displacement shift = FloorCacheOrigin - origin;
+	const int width = FloorCache.w() - std::abs(shift.deltaX);
+	const int height = FloorCache.h() - std::abs(shift.deltaY);
+	FloorCacheOrigin = origin;
+	if (width <= 0 || height <= 0)
+		return;
+
+	const int srcX = std::max(-shift.deltaX, 0);
+	const int dstX = std::max(shift.deltaX, 0);
+	for (int i = 0; i < height; i++) {
+		// Go against the direction of the move so rows are read before they are overwritten
+		const int row = shift.deltaY > 0 ? height - 1 - i : i;
+		memmove(FloorCache.at(dstX, row + std::max(shift.deltaY, 0)), FloorCache.at(srcX, row + std::max(-shift.deltaY, 0)), width);
+	}
+}
+
+/**
+ * @brief Draws the floor layer of the view from the cache, only rendering tiles that changed or scrolled into it.
+ * @param out Target buffer
+ * @param viewX World position of the left edge of the buffer
+ * @param viewY World position of the top edge of the buffer
+ */
+void DrawCachedFloor(const Surface &out, int viewX, int viewY)
+{
+	const int width = std::max<int>(out.w(), gnScreenWidth) + 2 * FloorCacheMarginX;
+	const int height = std::max<int>(out.h(), gnViewportHeight) + 2 * FloorCacheMarginY;
+	if (FloorCache.surface == nullptr || FloorCache.w() != width || FloorCache.h() != height) {
+		if (FloorCache.surface != nullptr)
+			FloorCache.Free();
+		FloorCache = Surface::Alloc(width, height);
+		FloorCacheValid = false;
+	}
+
+	// The part of the cache that is still up to date, in world coordinates
+	int keptLeft = FloorCacheOrigin.x;
+	int keptTop = FloorCacheOrigin.y;
+	int keptRight = FloorCacheOrigin.x + width;
+	int keptBottom = FloorCacheOrigin.y + height;
+	if (!FloorCacheValid) {
+		FloorCacheOrigin = { viewX - FloorCacheMarginX, viewY - FloorCacheMarginY };
+		keptRight = keptLeft;
+	} else if (viewX < FloorCacheOrigin.x || viewY < FloorCacheOrigin.y
+	    || viewX + out.w() > FloorCacheOrigin.x + width || viewY + out.h() > FloorCacheOrigin.y + height) {
+		ScrollFloorCache({ viewX - FloorCacheMarginX, viewY - FloorCacheMarginY });
+		keptLeft = std::max(keptLeft, FloorCacheOrigin.x);
+		keptTop = std::max(keptTop, FloorCacheOrigin.y);
+		keptRight = std::min(keptRight, FloorCacheOrigin.x + width);
+		keptBottom = std::min(keptBottom, FloorCacheOrigin.y + height);
+	}
+
+	int tileCount = 0;
+	FloorCacheDirtyTiles.clear();
+	ForEachFloorTile(FloorCacheOrigin.x, FloorCacheOrigin.y, FloorCacheOrigin.x + width, FloorCacheOrigin.y + height, [&](int x, int y) {
+		tileCount++;
+		// Only the part of the tile inside the cache has to be up to date
+		const Point position = FloorTileWorldPosition(x, y);
+		bool dirty = std::max(position.x, FloorCacheOrigin.x) < keptLeft
+		    || std::max(position.y - TILE_HEIGHT + 1, FloorCacheOrigin.y) < keptTop
+		    || std::min(position.x + TILE_WIDTH, FloorCacheOrigin.x + width) > keptRight
+		    || std::min(position.y + 1, FloorCacheOrigin.y + height) > keptBottom;
+		if (x >= 0 && x < MAXDUNX && y >= 0 && y < MAXDUNY) {
+			const FloorCacheTile tile = GetFloorCacheTile(x, y);
+			if (FloorCacheTiles[x][y] != tile) {
+				FloorCacheTiles[x][y] = tile;
+				dirty = true;
+			}
+		}
+		if (dirty)
+			FloorCacheDirtyTiles.push_back({ x, y });
+	});
+
+	if (FloorCacheDirtyTiles.size() * 2 > static_cast<size_t>(tileCount)) {
+		// Most of it changed, rendering everything in order is cheaper than patching each tile
+		ForEachFloorTile(FloorCacheOrigin.x, FloorCacheOrigin.y, FloorCacheOrigin.x + width, FloorCacheOrigin.y + height, [](int x, int y) {
+			const Point position = FloorTileWorldPosition(x, y);
+			RenderFloorCacheTile(FloorCache, x, y, position.x - FloorCacheOrigin.x, position.y - FloorCacheOrigin.y);
+		});
+	} else {
+		for (Point tile : FloorCacheDirtyTiles)
+			RedrawFloorCacheTile(tile.x, tile.y);
+	}
+	FloorCacheValid = true;
+
+	for (int y = 0; y < out.h(); y++)
+		memcpy(out.at(0, y), FloorCache.at(viewX - FloorCacheOrigin.x, viewY - FloorCacheOrigin.y + y), out.w());
+}
+
+} // namespace
+
+void InvalidateFloorCache()
+{
+	FloorCacheValid = false;
+}
+
+void FreeFloorCache()
+{
+	if (FloorCache.surface != nullptr)
+		FloorCache.Free();
+	FloorCacheValid = false;
+}
+
+void DrawFloorLayer(const Surface &out, int x, int y, int sx, int sy, int rows, int columns)
+{
+	if (sgOptions.Graphics.bTileCache) {
+		const Point position = FloorTileWorldPosition(x, y);
+		DrawCachedFloor(out, position.x - sx, position.y - sy);
+	} else {
+		DrawFloor(out, x, y, sx, sy, rows, columns);
+	}
+}
+
+#define IsWall(x, y) (dPiece[x][y] == 0 || nSolidTable[dPiece[x][y]] || dSpecial[x][y] != 0)
+#define IsWalkable(x, y) (dPiece[x][y] != 0 && !nSolidTable[dPiece[x][y]])
+
+void DrawTileContent(const Surface &out, int x, int y, int sx, int sy, int rows, int columns)
 {
 	// Keep evaluating until MicroTiles can't affect screen
 	rows += MicroTileLen;
@@ -1073,43 +1520,7 @@ static void Zoom(const Surface &out)
 		}
 	}
 
-	// We round to even for the source width and height.
-	// If the width / height was odd, we copy just one extra pixel / row later on.
-	const int srcWidth = (viewportWidth + 1) / 2;
-	const int doubleableWidth = viewportWidth / 2;
-	const int srcHeight = (out.h() + 1) / 2;
-	const int doubleableHeight = out.h() / 2;
-
-	BYTE *src = out.at(srcWidth - 1, srcHeight - 1);
-	BYTE *dst = out.at(viewportOffsetX + viewportWidth - 1, out.h() - 1);
-	const bool oddViewportWidth = (viewportWidth % 2) == 1;
-
-	for (int hgt = 0; hgt < doubleableHeight; hgt++) {
-		// Double the pixels in the line.
-		for (int i = 0; i < doubleableWidth; i++) {
-			*dst-- = *src;
-			*dst-- = *src;
-			--src;
-		}
-
-		// Copy a single extra pixel if the output width is odd.
-		if (oddViewportWidth) {
-			*dst-- = *src;
-			--src;
-		}
-
-		// Skip the rest of the source line.
-		src -= (out.pitch() - srcWidth);
-
-		// Double the line.
-		memcpy(dst - out.pitch() + 1, dst + 1, viewportWidth);
-
-		// Skip the rest of the destination line.
-		dst -= 2 * out.pitch() - viewportWidth;
-	}
-	if ((out.h() % 2) == 1) {
-		memcpy(dst - out.pitch() + 1, dst + 1, viewportWidth);
-	}
+	ZoomBuffer(out.at(0, 0), out.pitch(), viewportOffsetX, viewportWidth, out.h());
 }
 
 /**
@@ -1353,7 +1764,9 @@ static void DrawGame(const Surface &fullOut, int x, int y)
 		break;
 	}
 
-	DrawFloor(out, x, y, sx, sy, rows, columns);
+	CollectDrawables(x, y, rows, columns);
+
+	DrawFloorLayer(out, x, y, sx, sy, rows, columns);
 	DrawTileContent(out, x, y, sx, sy, rows, columns);
 
 	if (!zoomflag) {
@@ -52,6 +52,56 @@ void CalcTileOffset(int *offsetX, int *offsetY);
 void TilesInView(int *columns, int *rows);
 void CalcViewportGeometry();
 
+/**
+ * @brief Makes the next frame render the whole floor again instead of reusing the cached one.
+ *
+ * Needed when the level graphics or light tables change, changes of dPiece and dLight are picked up by themselves.
+ */
+void InvalidateFloorCache();
+
+/**
+ * @brief Releases the surface of the floor cache, the next frame that uses the cache allocates it again.
+ */
+void FreeFloorCache();
+
+/**
+ * @brief Render the floor layer of the view, from the floor cache if it is enabled
+ * @param out Buffer to render to
+ * @param x dPiece coordinate of the first tile
+ * @param y dPiece coordinate of the first tile
+ * @param sx Target buffer coordinate of the first tile
+ * @param sy Target buffer coordinate of the first tile
+ * @param rows Number of rows
+ * @param columns Tile in a row
+ */
+void DrawFloorLayer(const Surface &out, int x, int y, int sx, int sy, int rows, int columns);
+
+/**
+ * @brief Gathers the sprites of every tile DrawTileContent() will visit and sorts them into drawing order.
+ * @param x dPiece coordinate
+ * @param y dPiece coordinate
+ * @param rows Number of rows
+ * @param columns Tile in a row
+ */
+void CollectDrawables(int x, int y, int rows, int columns);
+
+/**
+ * @brief Forgets the sprites gathered by CollectDrawables(), DrawTileContent() then looks them up in the dungeon maps per tile.
+ */
+void ClearDrawables();
+
+/**
+ * @brief Render a row of tile
+ * @param out Output buffer
+ * @param x dPiece coordinate
+ * @param y dPiece coordinate
+ * @param sx Buffer coordinate
+ * @param sy Buffer coordinate
+ * @param rows Number of rows
+ * @param columns Tile in a row
+ */
+void DrawTileContent(const Surface &out, int x, int y, int sx, int sy, int rows, int columns);
+
 /**
  * @brief Start rendering of screen, town variation
  * @param out Buffer to render to
@@ -8,7 +8,7 @@
 #include "drlg_l1.h"
 #include "drlg_l2.h"
 #include "drlg_l3.h"
-#include "engine/load_file.hpp"
+#include "engine/asset_view.hpp"
 #include "objdat.h"
 #include "objects.h"
 #include "palette.h"
@@ -122,7 +122,8 @@ void AddVileObjs()
 
 void DRLG_SetMapTrans(const char *path)
 {
-	auto dunData = LoadFileInMem<uint16_t>(path);
+	const AssetView dunFile = LoadAssetView<uint16_t>(path);
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
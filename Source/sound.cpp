@@ -251,7 +251,7 @@ void music_start(uint8_t nTrack)
 		else
 			trackPath = MusicTracks[nTrack];
 		HANDLE handle;
-		success = SFileOpenFile(trackPath, &handle);
+		success = SFileOpenStreamedFile(trackPath, &handle);
 		if (!success) {
 			handle = nullptr;
 		} else {
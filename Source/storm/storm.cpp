@@ -2,8 +2,13 @@
 #include <SDL_endian.h>
 #include <cstddef>
 #include <cstdint>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "DiabloUI/diabloui.h"
 #include "options.h"
@@ -27,25 +32,263 @@ extern "C" std::uint32_t GetLastError();
 #endif
 
 namespace devilution {
+
+/**
+ * @brief Finds where a file of an archive is stored as it is, neither compressed nor encrypted.
+ *
+ * Implemented in storm_raw_file.cpp.
+ *
+ * @param offset The offset of the file data in the archive file, including the offset of the MPQ header.
+ * @return false if the data of the file cannot be read from the archive file as it is.
+ */
+bool SFileGetStoredRawOffset(HANDLE hFile, HANDLE hArchive, std::uint64_t *offset);
+
 namespace {
 
 bool directFileAccess = false;
 std::string *SBasePath = nullptr;
 
+/** An archive that SFileOpenFile() searches, see SFileOpenSharedArchive(). */
+struct SharedArchive {
+	HANDLE handle;
+	std::string path;
+};
+
+/** Only changed while no other thread accesses files, so it is read without locking. */
+std::vector<SharedArchive> SharedArchives;
+/** The thread that opened the shared archives, it uses the original handles. */
+SDL_threadID SharedArchivesOwner;
+
+/**
+ * @brief A set of handles of the shared archives.
+ *
+ * StormLib archive handles keep state (such as the file position) that makes reading two files of the
+ * same archive handle at the same time unsafe. Every thread therefore gets its own handles, so threads
+ * only wait for each other when one reads a file that another thread has opened.
+ */
+struct ArchiveSet {
+	/** The thread that claimed the set, 0 while it is free and ExitedOwner after it exited. */
+	std::atomic<SDL_threadID> owner { 0 };
+	/** Handles in the order of SharedArchives, opened on the first use of the set. */
+	std::vector<HANDLE> archives;
+	/** Files opened from the handles that are not closed yet, guarded by mutex. */
+	size_t openFiles = 0;
+	/** Serialises the use of the handles of this set and the files opened from them. */
+	SdlMutex mutex;
+
+	/** @brief Opens this set's handles of any shared archives it doesn't have yet. */
+	bool Open()
+	{
+		while (archives.size() < SharedArchives.size()) {
+			const SharedArchive &shared = SharedArchives[archives.size()];
+			HANDLE archive;
+			if (!SFileOpenArchive(shared.path.c_str(), 0, MPQ_OPEN_READ_ONLY, &archive)) {
+				LogError("Failed to open {} for another thread: {}", shared.path, SErrGetLastError());
+				return false;
+			}
+			archives.push_back(archive);
+		}
+		return true;
+	}
+
+	void Close()
+	{
+		for (HANDLE archive : archives)
+			SFileCloseArchive(archive);
+		archives.clear();
+		openFiles = 0;
+	}
+
+	/** @brief Closes the handles and frees the set for other threads, call with mutex held. */
+	void Release()
+	{
+		Close();
+		owner.store(0, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Translates one of the shared archive handles to the handle of this set.
+	 *
+	 * Archives that were not opened with SFileOpenSharedArchive() are used as they are.
+	 */
+	HANDLE Get(HANDLE shared) const
+	{
+		for (size_t i = 0; i < archives.size(); i++) {
+			if (SharedArchives[i].handle == shared)
+				return archives[i];
+		}
+		return shared;
+	}
+};
+
+/**
+ * Every set holds another copy of the hash and block tables of all archives, and only a few threads
+ * ever read files at the same time.
+ */
+constexpr size_t MaxThreadArchiveSets = 4;
+
+/** Owner of a set whose thread exited while files opened from it were still open. */
+constexpr SDL_threadID ExitedOwner = ~static_cast<SDL_threadID>(0);
+
+/** Claimed by threads on their first SFileOpenFile() and released when they exit, see SFileReleaseThreadArchives(). */
+std::array<ArchiveSet, MaxThreadArchiveSets> ThreadArchiveSets;
+/** The original handles, used by the owning thread and by any thread once all other sets are taken. */
+ArchiveSet MainArchiveSet;
+/** Used for files that are read from another thread than the one that opens them, like audio streams. */
+ArchiveSet StreamArchiveSet;
+
+struct OpenFile {
+	ArchiveSet *set;
+	/** The shared handle of the archive the file was found in, nullptr for local files. */
+	HANDLE archive;
+	/** Path of local files opened through direct file access. */
+	std::string localPath;
+};
+
+/** Every file opened by SFileOpenFile(). */
+std::unordered_map<HANDLE, OpenFile> OpenFiles;
+/** Only held while looking up OpenFiles, never while reading. */
+SdlMutex OpenFilesMutex;
+/** Used for files that were not opened by SFileOpenFile(), such as the files of save games. */
 SdlMutex Mutex;
 
+ArchiveSet &GetThreadArchiveSet()
+{
+	const SDL_threadID thread = SDL_ThreadID();
+	if (thread == SharedArchivesOwner)
+		return MainArchiveSet;
+
+	// Only the owner releases its set, so a set found here stays with this thread. Sets released by
+	// other threads can leave free sets in front of it, so look for it before claiming one.
+	for (ArchiveSet &set : ThreadArchiveSets) {
+		if (set.owner.load(std::memory_order_acquire) == thread)
+			return set;
+	}
+	for (ArchiveSet &set : ThreadArchiveSets) {
+		SDL_threadID owner = 0;
+		if (set.owner.compare_exchange_strong(owner, thread, std::memory_order_acq_rel))
+			return set;
+	}
+
+	return MainArchiveSet;
+}
+
+SdlMutex &GetFileMutex(HANDLE hFile)
+{
+	const std::lock_guard<SdlMutex> lock(OpenFilesMutex);
+	const auto it = OpenFiles.find(hFile);
+	if (it == OpenFiles.end())
+		return Mutex;
+	return it->second.set->mutex;
+}
+
+bool OpenFileFromSet(ArchiveSet &set, const char *filename, HANDLE *phFile);
+
 } // namespace
 
 bool SFileReadFileThreadSafe(HANDLE hFile, void *buffer, DWORD nNumberOfBytesToRead, DWORD *read, int *lpDistanceToMoveHigh)
 {
-	const std::lock_guard<SdlMutex> lock(Mutex);
+	const std::lock_guard<SdlMutex> lock(GetFileMutex(hFile));
 	return SFileReadFile(hFile, buffer, nNumberOfBytesToRead, read, lpDistanceToMoveHigh);
 }
 
 bool SFileCloseFileThreadSafe(HANDLE hFile)
 {
-	const std::lock_guard<SdlMutex> lock(Mutex);
-	return SFileCloseFile(hFile);
+	ArchiveSet *set = nullptr;
+	{
+		const std::lock_guard<SdlMutex> lock(OpenFilesMutex);
+		const auto it = OpenFiles.find(hFile);
+		if (it != OpenFiles.end()) {
+			set = it->second.set;
+			OpenFiles.erase(it);
+		}
+	}
+
+	if (set == nullptr) {
+		const std::lock_guard<SdlMutex> lock(Mutex);
+		return SFileCloseFile(hFile);
+	}
+
+	const std::lock_guard<SdlMutex> lock(set->mutex);
+	const bool result = SFileCloseFile(hFile);
+	set->openFiles--;
+	if (set->openFiles == 0 && set->owner.load(std::memory_order_relaxed) == ExitedOwner)
+		set->Release();
+	return result;
+}
+
+bool SFileOpenSharedArchive(const char *szMpqName, HANDLE *phMpq)
+{
+	if (!SFileOpenArchive(szMpqName, 0, MPQ_OPEN_READ_ONLY, phMpq))
+		return false;
+
+	SharedArchives.push_back(SharedArchive { *phMpq, szMpqName });
+	SharedArchivesOwner = SDL_ThreadID();
+	return true;
+}
+
+void SFileCloseThreadArchives()
+{
+	for (ArchiveSet &set : ThreadArchiveSets)
+		set.Release();
+	StreamArchiveSet.Close();
+	SharedArchives.clear();
+}
+
+void SFileReleaseThreadArchives()
+{
+	const SDL_threadID thread = SDL_ThreadID();
+	for (ArchiveSet &set : ThreadArchiveSets) {
+		if (set.owner.load(std::memory_order_acquire) != thread)
+			continue;
+
+		const std::lock_guard<SdlMutex> lock(set.mutex);
+		// Files handed to other threads keep the handles open until the last one is closed
+		if (set.openFiles == 0)
+			set.Release();
+		else
+			set.owner.store(ExitedOwner, std::memory_order_release);
+		return;
+	}
+}
+
+bool SFileOpenFile(const char *filename, HANDLE *phFile)
+{
+	return OpenFileFromSet(GetThreadArchiveSet(), filename, phFile);
+}
+
+bool SFileOpenStreamedFile(const char *filename, HANDLE *phFile)
+{
+	return OpenFileFromSet(StreamArchiveSet, filename, phFile);
+}
+
+bool SFileGetRawFileLocation(HANDLE hFile, std::string *path, std::uint64_t *offset)
+{
+	HANDLE archive;
+	{
+		const std::lock_guard<SdlMutex> lock(OpenFilesMutex);
+		const auto it = OpenFiles.find(hFile);
+		if (it == OpenFiles.end())
+			return false;
+		if (it->second.archive == nullptr) {
+			*path = it->second.localPath;
+			*offset = 0;
+			return !path->empty();
+		}
+		archive = it->second.archive;
+	}
+
+	const auto shared = std::find_if(SharedArchives.begin(), SharedArchives.end(), [archive](const SharedArchive &candidate) {
+		return candidate.handle == archive;
+	});
+	if (shared == SharedArchives.end())
+		return false;
+
+	if (!SFileGetStoredRawOffset(hFile, archive, offset))
+		return false;
+
+	*path = shared->path;
+	return true;
 }
 
 // Converts ASCII characters to lowercase
@@ -77,67 +320,91 @@ unsigned char AsciiToLowerTable_Path[256] = {
 	0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
 };
 
-bool SFileOpenFile(const char *filename, HANDLE *phFile)
+namespace {
+
+bool OpenFileFromSet(ArchiveSet &set, const char *filename, HANDLE *phFile)
 {
+	const std::lock_guard<SdlMutex> lock(set.mutex);
+	if (&set != &MainArchiveSet && !set.Open())
+		return OpenFileFromSet(MainArchiveSet, filename, phFile);
+
 	bool result = false;
+	std::string localPath;
+	HANDLE archive = nullptr;
+	const auto openFromArchive = [&](HANDLE shared) {
+		if (!SFileOpenFileEx(set.Get(shared), filename, SFILE_OPEN_FROM_MPQ, phFile))
+			return false;
+		archive = shared;
+		return true;
+	};
 
 	if (directFileAccess && SBasePath != nullptr) {
 		std::string path = *SBasePath + filename;
 		for (std::size_t i = SBasePath->size(); i < path.size(); ++i)
 			path[i] = AsciiToLowerTable_Path[static_cast<unsigned char>(path[i])];
 		result = SFileOpenFileEx((HANDLE) nullptr, path.c_str(), SFILE_OPEN_LOCAL_FILE, phFile);
+		if (result)
+			localPath = std::move(path);
 	}
 
 	if (!result && devilutionx_mpq != nullptr) {
-		result = SFileOpenFileEx((HANDLE)devilutionx_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+		result = openFromArchive(devilutionx_mpq);
 	}
 	if (gbIsHellfire) {
 		if (!result && hfopt2_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfopt2_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+			result = openFromArchive(hfopt2_mpq);
 		}
 		if (!result && hfopt1_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfopt1_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+			result = openFromArchive(hfopt1_mpq);
 		}
 		if (!result && hfvoice_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfvoice_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+			result = openFromArchive(hfvoice_mpq);
 		}
 		if (!result && hfmusic_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfmusic_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+			result = openFromArchive(hfmusic_mpq);
 		}
 		if (!result && hfbarb_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfbarb_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+			result = openFromArchive(hfbarb_mpq);
 		}
 		if (!result && hfbard_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfbard_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+			result = openFromArchive(hfbard_mpq);
 		}
 		if (!result && hfmonk_mpq != nullptr) {
-			result = SFileOpenFileEx((HANDLE)hfmonk_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+			result = openFromArchive(hfmonk_mpq);
 		}
 		if (!result) {
-			result = SFileOpenFileEx((HANDLE)hellfire_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+			result = openFromArchive(hellfire_mpq);
 		}
 	}
 	if (!result && patch_rt_mpq != nullptr) {
-		result = SFileOpenFileEx((HANDLE)patch_rt_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+		result = openFromArchive(patch_rt_mpq);
 	}
 	if (!result && spawn_mpq != nullptr) {
-		result = SFileOpenFileEx((HANDLE)spawn_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+		result = openFromArchive(spawn_mpq);
 	}
 	if (!result && diabdat_mpq != nullptr) {
-		result = SFileOpenFileEx((HANDLE)diabdat_mpq, filename, SFILE_OPEN_FROM_MPQ, phFile);
+		result = openFromArchive(diabdat_mpq);
 	}
 
 	if (!result || (*phFile == nullptr)) {
 		const auto error = SErrGetLastError();
 		if (error == STORM_ERROR_FILE_NOT_FOUND) {
-			LogVerbose("{}(\"{}\") File not found", __FUNCTION__, filename);
+			LogVerbose("SFileOpenFile(\"{}\") File not found", filename);
 		} else {
-			LogError("{}(\"{}\") Failed with error code {}", __FUNCTION__, filename, error);
+			LogError("SFileOpenFile(\"{}\") Failed with error code {}", filename, error);
 		}
 	}
+	if (result) {
+		set.openFiles++;
+		const std::lock_guard<SdlMutex> openFilesLock(OpenFilesMutex);
+		OpenFiles[*phFile] = OpenFile { &set, archive, std::move(localPath) };
+	}
+
 	return result;
 }
 
+} // namespace
+
 DWORD SErrGetLastError()
 {
 	return ::GetLastError();
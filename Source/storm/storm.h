@@ -224,6 +224,7 @@ bool WINAPI SFileOpenArchive(const wchar_t *szMpqName, DWORD dwPriority, DWORD d
 bool WINAPI SFileOpenArchive(const char *szMpqName, DWORD dwPriority, DWORD dwFlags, HANDLE *phMpq);
 #endif
 bool WINAPI SFileCloseArchive(HANDLE hArchive);
+bool WINAPI SFileHasFile(HANDLE hMpq, const char *szFileName);
 bool WINAPI SFileOpenFileEx(HANDLE hMpq, const char *szFileName, DWORD dwSearchScope, HANDLE *phFile);
 bool WINAPI SFileReadFile(HANDLE hFile, void *buffer, DWORD nNumberOfBytesToRead, DWORD *read, int *lpDistanceToMoveHigh);
 DWORD WINAPI SFileGetFileSize(HANDLE hFile, uint32_t *lpFileSizeHigh = nullptr);
@@ -294,11 +295,34 @@ bool SFileEnableDirectAccess(bool enable);
 bool SFileOpenArchive(const char *szMpqName, DWORD dwPriority, DWORD dwFlags, HANDLE *phMpq);
 #endif
 
-// Locks ReadFile and CloseFile under a mutex.
+// Locks ReadFile and CloseFile under the mutex of the archive handles the file was opened from.
 // See https://github.com/ladislav-zezula/StormLib/issues/175
 bool SFileReadFileThreadSafe(HANDLE hFile, void *buffer, DWORD nNumberOfBytesToRead, DWORD *read = nullptr, int *lpDistanceToMoveHigh = nullptr);
 bool SFileCloseFileThreadSafe(HANDLE hFile);
 
+// Opens a read-only archive that SFileOpenFile() searches. Other threads lazily open their own handle
+// of the archive, so that threads can open and read files without waiting for each other.
+bool SFileOpenSharedArchive(const char *szMpqName, HANDLE *phMpq);
+
+// Closes the handles that other threads opened for the shared archives.
+// No other thread may access files while this runs.
+void SFileCloseThreadArchives();
+
+// Gives the archive handles of the calling thread back, so that another thread can use the slot.
+// Threads started with CreateThread() call this before they exit.
+void SFileReleaseThreadArchives();
+
+// Opens a file that is read from another thread than the calling one, such as an audio stream.
+// These files use their own archive handles, so streaming never waits for reads on the main thread.
+bool SFileOpenStreamedFile(const char *filename, HANDLE *phFile);
+
+// Finds the file on disk whose bytes at `offset` are the contents of an open file, so that they can be
+// memory-mapped. Fails for compressed or encrypted archive entries and for files not opened by SFileOpenFile().
+bool SFileGetRawFileLocation(HANDLE hFile, std::string *path, std::uint64_t *offset);
+
+// Sets up a loopback provider without going through hero selection. Used by headless tools.
+void SNetInitializeLoopbackProvider();
+
 // Sets the file's 64-bit seek position.
 inline std::uint64_t SFileSetFilePointer(HANDLE hFile, std::int64_t offset, int whence)
 {
@@ -147,6 +147,14 @@ bool SNetInitializeProvider(uint32_t provider, struct GameData *gameData)
 	return mainmenu_select_hero_dialog(gameData);
 }
 
+void SNetInitializeLoopbackProvider()
+{
+#ifndef NONET
+	std::lock_guard<SdlMutex> lg(storm_net_mutex);
+#endif
+	dvlnet_inst = net::abstract_net::MakeNet(SELCONN_LOOPBACK);
+}
+
 /**
  * @brief Called by engine for single, called by ui for multi
  */
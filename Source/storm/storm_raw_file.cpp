@@ -0,0 +1,36 @@
+/**
+ * @file storm_raw_file.cpp
+ *
+ * Locates files that are stored uncompressed in an archive.
+ *
+ * This is the only file that includes StormLib.h, as it conflicts with the types of storm.h.
+ */
+#include <cstdint>
+
+#define STORMLIB_NO_AUTO_LINK
+#include <StormLib.h>
+
+namespace devilution {
+
+bool SFileGetStoredRawOffset(HANDLE hFile, HANDLE hArchive, std::uint64_t *offset)
+{
+	constexpr DWORD StoredRawMask = MPQ_FILE_COMPRESS_MASK | MPQ_FILE_ENCRYPTED | MPQ_FILE_PATCH_FILE;
+
+	DWORD flags;
+	DWORD streamFlags;
+	ULONGLONG fileOffset;
+	ULONGLONG headerOffset;
+	if (!SFileGetFileInfo(hFile, SFileInfoFlags, &flags, sizeof(flags), nullptr)
+	    || !SFileGetFileInfo(hFile, SFileInfoByteOffset, &fileOffset, sizeof(fileOffset), nullptr)
+	    || !SFileGetFileInfo(hArchive, SFileMpqStreamFlags, &streamFlags, sizeof(streamFlags), nullptr)
+	    || !SFileGetFileInfo(hArchive, SFileMpqHeaderOffset, &headerOffset, sizeof(headerOffset), nullptr))
+		return false;
+	// Anything but a flat file on disk is not read with plain file reads
+	if ((flags & StoredRawMask) != 0 || (streamFlags & STREAM_PROVIDERS_MASK) != 0)
+		return false;
+
+	*offset = headerOffset + fileOffset;
+	return true;
+}
+
+} // namespace devilution
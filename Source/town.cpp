@@ -6,7 +6,7 @@
 #include "town.h"
 
 #include "drlg_l1.h"
-#include "engine/load_file.hpp"
+#include "engine/asset_view.hpp"
 #include "engine/random.hpp"
 #include "init.h"
 #include "player.h"
@@ -25,7 +25,8 @@ namespace {
  */
 void FillSector(const char *path, int xi, int yy)
 {
-	auto dunData = LoadFileInMem<uint16_t>(path);
+	const AssetView dunFile = LoadAssetView<uint16_t>(path);
+	const auto *dunData = dunFile.DataAs<uint16_t>();
 
 	int width = SDL_SwapLE16(dunData[0]);
 	int height = SDL_SwapLE16(dunData[1]);
@@ -9,8 +9,10 @@
 
 #include "control.h"
 #include "cursor.h"
+#include "diablo.h"
 #include "error.h"
 #include "init.h"
+#include "portal.h"
 #include "utils/language.h"
 
 namespace devilution {
@@ -863,4 +865,53 @@ void CheckTriggers()
 	}
 }
 
+void PreloadNextLevel()
+{
+	// Close enough to a transition to start reading its level, but far enough to be ahead of the load
+	constexpr int PreloadDistance = 6;
+
+	const auto &myPlayer = Players[MyPlayerId];
+	const Point position = myPlayer.position.future;
+
+	for (int i = 0; i < numtrigs; i++) {
+		if (position.WalkingDistance(trigs[i].position) > PreloadDistance)
+			continue;
+
+		switch (trigs[i]._tmsg) {
+		case WM_DIABNEXTLVL:
+			PreloadLevelAssets(currlevel + 1);
+			return;
+		case WM_DIABPREVLVL:
+			PreloadLevelAssets(currlevel - 1);
+			return;
+		case WM_DIABRTNLVL:
+			PreloadLevelAssets(ReturnLevel);
+			return;
+		case WM_DIABTOWNWARP:
+			PreloadLevelAssets(trigs[i]._tlvl);
+			return;
+		case WM_DIABTWARPUP:
+			PreloadLevelAssets(0);
+			return;
+		default:
+			break;
+		}
+	}
+
+	for (int i = 0; i < MAXPORTAL; i++) {
+		const PortalStruct &portal = Portals[i];
+		if (!portal.open || portal.setlvl)
+			continue;
+		if (currlevel == 0) {
+			if (position.WalkingDistance({ WarpDropX[i], WarpDropY[i] }) <= PreloadDistance) {
+				PreloadLevelAssets(portal.level);
+				return;
+			}
+		} else if (!setlevel && portal.level == currlevel && position.WalkingDistance(portal.position) <= PreloadDistance) {
+			PreloadLevelAssets(0);
+			return;
+		}
+	}
+}
+
 } // namespace devilution
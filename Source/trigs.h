@@ -36,5 +36,9 @@ void InitVPTriggers();
 void Freeupstairs();
 void CheckTrigForce();
 void CheckTriggers();
+/**
+ * @brief Preloads the level behind a nearby staircase or town portal, see PreloadLevelAssets().
+ */
+void PreloadNextLevel();
 
 } // namespace devilution
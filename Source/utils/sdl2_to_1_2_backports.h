@@ -101,6 +101,14 @@ inline void SDL_SetTextInputRect(const SDL_Rect *r)
 {
 }
 
+//== CPU info
+
+// SDL 1 can't query the number of cores, assume a single one
+inline int SDL_GetCPUCount()
+{
+	return 1;
+}
+
 //== Graphics helpers
 
 typedef struct SDL_Point {
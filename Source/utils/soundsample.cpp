@@ -118,8 +118,8 @@ int SoundSample::SetChunkStream(std::string filePath)
 {
 	file_path_ = std::move(filePath);
 	HANDLE handle;
-	if (!SFileOpenFile(file_path_.c_str(), &handle)) {
-		LogError(LogCategory::Audio, "SFileOpenFile failed (from SoundSample::SetChunkStream): {}", SErrGetLastError());
+	if (!SFileOpenStreamedFile(file_path_.c_str(), &handle)) {
+		LogError(LogCategory::Audio, "SFileOpenStreamedFile failed (from SoundSample::SetChunkStream): {}", SErrGetLastError());
 		return -1;
 	}
 
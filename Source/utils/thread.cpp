@@ -4,6 +4,7 @@
 #include <set>
 
 #include "appfat.h"
+#include "storm/storm.h"
 #include "utils/log.hpp"
 #include "utils/stubs.h"
 
@@ -14,6 +15,7 @@ static int SDLCALL ThreadTranslate(void *ptr)
 	auto handler = (void (*)())ptr;
 
 	handler();
+	SFileReleaseThreadArchives();
 
 	return 0;
 }
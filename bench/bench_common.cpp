@@ -0,0 +1,440 @@
+/**
+ * @file bench_common.cpp
+ *
+ * Shared helpers for the headless benchmark harness.
+ */
+#include "bench_common.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "appfat.h"
+#include "diablo.h"
+#include "drlg_l1.h"
+#include "drlg_l2.h"
+#include "drlg_l3.h"
+#include "drlg_l4.h"
+#include "engine/load_cel.hpp"
+#include "engine/load_file.hpp"
+#include "engine/random.hpp"
+#include "engine/render/dun_render.hpp"
+#include "gendung.h"
+#include "init.h"
+#include "lighting.h"
+#include "monster.h"
+#include "msg.h"
+#include "multi.h"
+#include "options.h"
+#include "path.h"
+#include "player.h"
+#include "storm/storm.h"
+#include "sync.h"
+#include "trigs.h"
+#include "utils/paths.h"
+
+namespace {
+
+std::atomic<std::uint64_t> AllocationCounter { 0 };
+std::atomic<std::uint64_t> AllocatedBytesCounter { 0 };
+
+void *CountedAllocate(std::size_t size)
+{
+	AllocationCounter.fetch_add(1, std::memory_order_relaxed);
+	AllocatedBytesCounter.fetch_add(size, std::memory_order_relaxed);
+	void *ptr = std::malloc(size == 0 ? 1 : size);
+	if (ptr == nullptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+} // namespace
+
+void *operator new(std::size_t size)
+{
+	return CountedAllocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+	return CountedAllocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t /*size*/) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t /*size*/) noexcept
+{
+	std::free(ptr);
+}
+
+namespace devilution {
+namespace bench {
+
+namespace {
+
+/** Pixel data of a frame is split in to blocks of 32 rows, the frame header points to the start of each block. */
+constexpr int Cl2HeaderBlockHeight = 32;
+constexpr int Cl2HeaderSize = 10;
+constexpr int Cl2MaxTransparentRun = 0x7F;
+constexpr int Cl2MaxFillRun = 0x3F;
+constexpr uint8_t Cl2FillEnd = 0xBF;
+constexpr uint8_t SyntheticSpriteColor = 0xC5;
+
+void AppendLE16(std::vector<byte> &out, uint16_t value)
+{
+	out.push_back(static_cast<byte>(value & 0xFF));
+	out.push_back(static_cast<byte>(value >> 8));
+}
+
+void WriteLE32(std::vector<byte> &out, size_t offset, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		out[offset + i] = static_cast<byte>((value >> (8 * i)) & 0xFF);
+}
+
+void AppendTransparentRun(std::vector<byte> &out, int width)
+{
+	while (width > 0) {
+		int run = std::min(width, Cl2MaxTransparentRun);
+		out.push_back(static_cast<byte>(run));
+		width -= run;
+	}
+}
+
+void AppendFillRun(std::vector<byte> &out, int width)
+{
+	while (width > 0) {
+		int run = std::min(width, Cl2MaxFillRun);
+		out.push_back(static_cast<byte>(Cl2FillEnd - run));
+		out.push_back(static_cast<byte>(SyntheticSpriteColor));
+		width -= run;
+	}
+}
+
+/**
+ * @brief Appends a single CL2 frame showing a box covering the middle half of the frame.
+ */
+void AppendSyntheticFrame(std::vector<byte> &out, int width, int height)
+{
+	const size_t frameStart = out.size();
+	out.resize(frameStart + Cl2HeaderSize);
+
+	const int boxStart = width / 4;
+	const int boxWidth = width / 2;
+	uint16_t blockOffsets[Cl2HeaderSize / 2] = { Cl2HeaderSize };
+
+	// Rows are stored bottom-up
+	for (int row = 0; row < height; row++) {
+		if (row != 0 && row % Cl2HeaderBlockHeight == 0 && row / Cl2HeaderBlockHeight < Cl2HeaderSize / 2)
+			blockOffsets[row / Cl2HeaderBlockHeight] = static_cast<uint16_t>(out.size() - frameStart);
+		if (row < height / 8 || row >= height - height / 8) {
+			AppendTransparentRun(out, width);
+			continue;
+		}
+		AppendTransparentRun(out, boxStart);
+		AppendFillRun(out, boxWidth);
+		AppendTransparentRun(out, width - boxStart - boxWidth);
+	}
+
+	std::vector<byte> header;
+	for (uint16_t blockOffset : blockOffsets)
+		AppendLE16(header, blockOffset);
+	std::copy(header.begin(), header.end(), out.begin() + frameStart);
+}
+
+void AppendSyntheticGroup(std::vector<byte> &out, int frames, int width, int height)
+{
+	const size_t groupStart = out.size();
+	out.resize(groupStart + (frames + 2) * sizeof(uint32_t));
+	WriteLE32(out, groupStart, frames);
+	for (int frame = 1; frame <= frames; frame++) {
+		WriteLE32(out, groupStart + frame * sizeof(uint32_t), static_cast<uint32_t>(out.size() - groupStart));
+		AppendSyntheticFrame(out, width, height);
+	}
+	WriteLE32(out, groupStart + (frames + 1) * sizeof(uint32_t), static_cast<uint32_t>(out.size() - groupStart));
+}
+
+dungeon_type GetLevelType(int level)
+{
+	if (level <= 4)
+		return DTYPE_CATHEDRAL;
+	if (level <= 8)
+		return DTYPE_CATACOMBS;
+	if (level <= 12)
+		return DTYPE_CAVES;
+	return DTYPE_HELL;
+}
+
+/** Number of entries in pLevelPieces. */
+size_t LevelPieceCount;
+
+} // namespace
+
+Options::Options(int argc, char **argv)
+{
+	for (int i = 0; i < argc; i++) {
+		std::string name = argv[i];
+		std::string value;
+		if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0)
+			value = argv[++i];
+		values_.emplace_back(std::move(name), std::move(value));
+	}
+}
+
+const std::string *Options::Find(const char *name) const
+{
+	for (const auto &entry : values_) {
+		if (entry.first == name)
+			return &entry.second;
+	}
+	return nullptr;
+}
+
+bool Options::Has(const char *name) const
+{
+	return Find(name) != nullptr;
+}
+
+int Options::GetInt(const char *name, int defaultValue) const
+{
+	const std::string *value = Find(name);
+	if (value == nullptr || value->empty())
+		return defaultValue;
+	return std::atoi(value->c_str());
+}
+
+std::string Options::GetString(const char *name, const char *defaultValue) const
+{
+	const std::string *value = Find(name);
+	if (value == nullptr)
+		return defaultValue;
+	return *value;
+}
+
+std::uint64_t AllocationCount()
+{
+	return AllocationCounter.load(std::memory_order_relaxed);
+}
+
+std::uint64_t AllocatedBytes()
+{
+	return AllocatedBytesCounter.load(std::memory_order_relaxed);
+}
+
+std::uint64_t NowNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SampleSet::Add(std::uint64_t nanoseconds)
+{
+	samples_.push_back(nanoseconds);
+	total_ += nanoseconds;
+}
+
+double SampleSet::MeanMicroseconds() const
+{
+	if (samples_.empty())
+		return 0;
+	return static_cast<double>(total_) / samples_.size() / 1000.0;
+}
+
+double SampleSet::PercentileMicroseconds(double percentile) const
+{
+	if (samples_.empty())
+		return 0;
+	std::vector<std::uint64_t> sorted = samples_;
+	std::sort(sorted.begin(), sorted.end());
+	auto index = static_cast<size_t>(std::ceil(percentile / 100.0 * sorted.size()));
+	index = std::min(std::max<size_t>(index, 1), sorted.size()) - 1;
+	return sorted[index] / 1000.0;
+}
+
+void StateHash::Add(const void *data, std::size_t size)
+{
+	const auto *bytes = static_cast<const uint8_t *>(data);
+	for (std::size_t i = 0; i < size; i++) {
+		hash_ ^= bytes[i];
+		hash_ *= 0x100000001B3ULL;
+	}
+}
+
+std::unique_ptr<byte[]> BuildSyntheticCl2(int frames, int width, int height, int directions)
+{
+	std::vector<byte> data;
+	if (directions > 1) {
+		data.resize(directions * sizeof(uint32_t));
+		for (int direction = 0; direction < directions; direction++) {
+			WriteLE32(data, direction * sizeof(uint32_t), static_cast<uint32_t>(data.size()));
+			AppendSyntheticGroup(data, frames, width, height);
+		}
+	} else {
+		AppendSyntheticGroup(data, frames, width, height);
+	}
+
+	std::unique_ptr<byte[]> buffer { new byte[data.size()] };
+	std::copy(data.begin(), data.end(), buffer.get());
+	return buffer;
+}
+
+void InitHeadlessEngine(const Options &options)
+{
+	gbQuietMode = true;
+
+	std::string dataDir = options.GetString("--data-dir", "");
+	if (!dataDir.empty())
+		paths::SetBasePath(dataDir);
+	init_archives();
+
+	sgGameInitInfo.size = sizeof(sgGameInitInfo);
+	sgGameInitInfo.dwSeed = 0;
+	sgGameInitInfo.programid = GAME_ID;
+	sgGameInitInfo.nDifficulty = DIFF_NORMAL;
+	sgGameInitInfo.nTickRate = 20;
+	SNetInitializeLoopbackProvider();
+	int unused = 0;
+	if (!SNetCreateGame("local", "local", (char *)&sgGameInitInfo, sizeof(sgGameInitInfo), &unused))
+		app_fatal("SNetCreateGame");
+	MyPlayerId = 0;
+	gbIsMultiplayer = false;
+	delta_init();
+	sync_init();
+}
+
+void GenerateLevel(int level, uint32_t seed)
+{
+	currlevel = level;
+	leveltype = GetLevelType(level);
+	setlevel = false;
+	glSeedTbl[currlevel] = seed;
+
+	SetRndSeed(seed);
+	MakeLightTable();
+
+	char path[64];
+	sprintf(path, "Levels\\L%iData\\L%i.TIL", static_cast<int>(leveltype), static_cast<int>(leveltype));
+	pMegaTiles = LoadFileInMem<MegaTile>(path);
+	sprintf(path, "Levels\\L%iData\\L%i.MIN", static_cast<int>(leveltype), static_cast<int>(leveltype));
+	pLevelPieces = LoadFileInMem<uint16_t>(path, &LevelPieceCount);
+
+	SetRndSeed(seed);
+	InitLighting();
+	InitVision();
+	InitLevelMonsters();
+
+	switch (leveltype) {
+	case DTYPE_CATHEDRAL:
+		CreateL5Dungeon(seed, ENTRY_MAIN);
+		InitL1Triggers();
+		break;
+	case DTYPE_CATACOMBS:
+		CreateL2Dungeon(seed, ENTRY_MAIN);
+		InitL2Triggers();
+		break;
+	case DTYPE_CAVES:
+		CreateL3Dungeon(seed, ENTRY_MAIN);
+		InitL3Triggers();
+		break;
+	default:
+		CreateL4Dungeon(seed, ENTRY_MAIN);
+		InitL4Triggers();
+		break;
+	}
+	Freeupstairs();
+	FillSolidBlockTbls();
+	SetRndSeed(seed);
+}
+
+void LoadLevelGraphics()
+{
+	constexpr int SpecialCelWidth = 64;
+
+	char path[64];
+	sprintf(path, "Levels\\L%iData\\L%i.CEL", static_cast<int>(leveltype), static_cast<int>(leveltype));
+	pDungeonCels = LoadAssetView(path, alignof(std::uint32_t));
+
+	switch (leveltype) {
+	case DTYPE_CATHEDRAL:
+	case DTYPE_CAVES:
+		pSpecialCels = LoadCel("Levels\\L1Data\\L1S.CEL", SpecialCelWidth);
+		break;
+	default:
+		pSpecialCels = LoadCel("Levels\\L2Data\\L2S.CEL", SpecialCelWidth);
+		break;
+	}
+
+	if (sgOptions.Graphics.bTileAtlas)
+		BuildTileAtlas(pLevelPieces.get(), LevelPieceCount);
+	else
+		FreeTileAtlas();
+}
+
+void SpawnHero()
+{
+	auto &player = Players[MyPlayerId];
+	player.plractive = true;
+	player.plrlevel = currlevel;
+	player._pLvlChanging = false;
+
+	// Same as the first time initialization in InitPlayer(), minus loading the hotkeys from the save game
+	player._pRSplType = RSPLTYPE_INVALID;
+	player._pRSpell = SPL_INVALID;
+	player._pSBkSpell = SPL_INVALID;
+	player._pSpell = player._pRSpell;
+	player._pSplType = player._pRSplType;
+	player._pwtype = WT_MELEE;
+	player.pManaShield = false;
+	InitPlayer(MyPlayerId, false);
+
+	dPlayer[player.position.tile.x][player.position.tile.y] = MyPlayerId + 1;
+	gbActivePlayers = 1;
+}
+
+bool IsFreeFloor(Point position)
+{
+	if (position.x < 0 || position.y < 0 || position.x >= MAXDUNX || position.y >= MAXDUNY)
+		return false;
+	return !SolidLoc(position)
+	    && dPlayer[position.x][position.y] == 0
+	    && dMonster[position.x][position.y] == 0
+	    && dObject[position.x][position.y] == 0
+	    && dItem[position.x][position.y] == 0;
+}
+
+void DriveHero(std::minstd_rand &rng)
+{
+	auto &player = Players[MyPlayerId];
+	if (player._pmode != PM_STAND || player.walkpath[0] != WALK_NONE)
+		return;
+
+	for (int attempt = 0; attempt < 16; attempt++) {
+		const Point target = player.position.tile + Displacement { static_cast<int>(rng() % 21) - 10, static_cast<int>(rng() % 21) - 10 };
+		if (!IsFreeFloor(target))
+			continue;
+		ClrPlrPath(player);
+		player.destAction = ACTION_NONE;
+		MakePlrPath(MyPlayerId, target, true);
+		return;
+	}
+}
+
+} // namespace bench
+} // namespace devilution
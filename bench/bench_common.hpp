@@ -0,0 +1,155 @@
+/**
+ * @file bench_common.hpp
+ *
+ * Shared helpers for the headless benchmark harness.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "engine/point.hpp"
+#include "path.h"
+#include "utils/stdcompat/cstddef.hpp"
+
+namespace devilution {
+namespace bench {
+
+/**
+ * @brief Command line options of a benchmark scenario, given as `--name value` pairs.
+ */
+class Options {
+public:
+	Options(int argc, char **argv);
+
+	[[nodiscard]] bool Has(const char *name) const;
+	[[nodiscard]] int GetInt(const char *name, int defaultValue) const;
+	[[nodiscard]] std::string GetString(const char *name, const char *defaultValue) const;
+
+private:
+	const std::string *Find(const char *name) const;
+
+	std::vector<std::pair<std::string, std::string>> values_;
+};
+
+/** @brief Number of heap allocations made through operator new since the program started. */
+std::uint64_t AllocationCount();
+
+/** @brief Number of bytes requested through operator new since the program started. */
+std::uint64_t AllocatedBytes();
+
+/** @brief Monotonic timestamp in nanoseconds. */
+std::uint64_t NowNanoseconds();
+
+/**
+ * @brief Collects timing samples and derives summary statistics from them.
+ */
+class SampleSet {
+public:
+	void Add(std::uint64_t nanoseconds);
+
+	[[nodiscard]] std::size_t Count() const
+	{
+		return samples_.size();
+	}
+
+	[[nodiscard]] std::uint64_t Total() const
+	{
+		return total_;
+	}
+
+	[[nodiscard]] double MeanMicroseconds() const;
+
+	/**
+	 * @brief Returns the given percentile of the collected samples in microseconds.
+	 * @param percentile Value between 0 and 100
+	 */
+	[[nodiscard]] double PercentileMicroseconds(double percentile) const;
+
+private:
+	std::vector<std::uint64_t> samples_;
+	std::uint64_t total_ = 0;
+};
+
+/**
+ * @brief 64-bit FNV-1a hash used to fingerprint the simulation state.
+ */
+class StateHash {
+public:
+	void Add(const void *data, std::size_t size);
+
+	template <typename T>
+	void Add(T value)
+	{
+		Add(&value, sizeof(value));
+	}
+
+	[[nodiscard]] std::uint64_t Value() const
+	{
+		return hash_;
+	}
+
+private:
+	std::uint64_t hash_ = 0xCBF29CE484222325ULL;
+};
+
+/**
+ * @brief Builds a CL2 sprite sheet containing a solid box for every frame.
+ *
+ * Used in place of the MPQ graphics so that the simulation can run without any art assets.
+ * @param frames Number of frames per direction
+ * @param width Width of every frame in pixels
+ * @param height Height of every frame in pixels
+ * @param directions Number of direction groups (1 for a plain sheet, 8 for a monster/player sheet)
+ */
+std::unique_ptr<byte[]> BuildSyntheticCl2(int frames, int width, int height, int directions);
+
+/**
+ * @brief Prepares the engine for a headless run: quiet mode, MPQ archives and a loopback network.
+ *
+ * Honours `--data-dir` to locate the game data.
+ */
+void InitHeadlessEngine(const Options &options);
+
+/**
+ * @brief Generates a dungeon level from the given seed using only the level data (TIL/MIN/SOL), no art.
+ * @param level Dungeon level in the range [1, 16]
+ * @param seed Level seed
+ */
+void GenerateLevel(int level, uint32_t seed);
+
+/**
+ * @brief Loads the dungeon and special CEL graphics of the generated level, like LoadLvlGFX() does.
+ */
+void LoadLevelGraphics();
+
+/**
+ * @brief Brings the local hero into the generated level at the entrance.
+ *
+ * The player graphics must already be set up.
+ */
+void SpawnHero();
+
+/** @brief Checks that a tile is walkable and not occupied by a player, monster, object or item. */
+bool IsFreeFloor(Point position);
+
+/**
+ * @brief Sends the hero to a random nearby tile whenever it stands still, so the player light and vision keep moving.
+ */
+void DriveHero(std::minstd_rand &rng);
+
+int RunGameLogicBenchmark(const Options &options);
+int RunRenderBenchmark(const Options &options);
+int RunPathBenchmark(const Options &options);
+int RunSpriteBenchmark(const Options &options);
+
+/** @brief The original FindPath() implementation, used as the baseline of the path benchmark. */
+int FindPathLegacy(bool (*posOk)(int, Point), int posOkArg, int sx, int sy, int dx, int dy, int8_t path[MAX_PATH_LENGTH]);
+
+} // namespace bench
+} // namespace devilution
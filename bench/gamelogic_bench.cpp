@@ -0,0 +1,349 @@
+/**
+ * @file gamelogic_bench.cpp
+ *
+ * Deterministic headless benchmark of the game logic tick.
+ *
+ * A dungeon level is generated from a fixed seed and populated with monsters, missiles and items.
+ * The phases of GameLogic() are then run for a number of ticks without a window, audio or any
+ * MPQ graphics, reporting the time and heap allocations of every phase plus a hash of the final
+ * simulation state so that optimisations can be checked for behavioural changes.
+ */
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "bench_common.hpp"
+#include "dead.h"
+#include "diablo.h"
+#include "engine/cel_header.hpp"
+#include "engine/random.hpp"
+#include "gendung.h"
+#include "items.h"
+#include "lighting.h"
+#include "missiles.h"
+#include "monster.h"
+#include "multi.h"
+#include "objects.h"
+#include "player.h"
+
+namespace devilution {
+namespace bench {
+
+namespace {
+
+/** Frames per direction of the synthetic player sheets, enough for the longest player animation. */
+constexpr int PlayerSpriteFrames = 20;
+constexpr int PlayerSpriteWidth = 128;
+constexpr int SpriteHeight = 128;
+/** Monsters and items are placed inside the same area the level generators use. */
+constexpr int PlacementMin = 16;
+constexpr int PlacementSize = 80;
+/** Keep some distance between the hero and freshly placed monsters. */
+constexpr int MinimumHeroDistance = 5;
+
+struct Phase {
+	const char *name;
+	GameLogicStep step;
+	void (*process)();
+};
+
+/** The phases of GameLogic() outside of town, in the order they run. */
+const std::array<Phase, 7> Phases = { {
+	{ "ProcessPlayers", GameLogicStep::ProcessPlayers, ProcessPlayers },
+	{ "ProcessMonsters", GameLogicStep::ProcessMonsters, ProcessMonsters },
+	{ "ProcessObjects", GameLogicStep::ProcessObjects, ProcessObjects },
+	{ "ProcessMissiles", GameLogicStep::ProcessMissiles, ProcessMissiles },
+	{ "ProcessItems", GameLogicStep::ProcessItems, ProcessItems },
+	// GameLogic() does not change the step for lighting and vision
+	{ "ProcessLightList", GameLogicStep::ProcessItems, ProcessLightList },
+	{ "ProcessVisionList", GameLogicStep::ProcessItems, ProcessVisionList },
+} };
+
+struct PhaseStats {
+	SampleSet samples;
+	std::uint64_t allocations = 0;
+};
+
+Point RandomTile(std::minstd_rand &rng)
+{
+	return { PlacementMin + static_cast<int>(rng() % PlacementSize), PlacementMin + static_cast<int>(rng() % PlacementSize) };
+}
+
+/**
+ * @brief Registers a monster type like InitMonsterGFX() does, but with synthetic sprites.
+ */
+void AddSyntheticMonsterType(_monster_id type, placeflag placeFlag)
+{
+	CMonster &monsterType = LevelMonsterTypes[LevelMonsterTypeCount++];
+	const MonsterDataStruct &monsterData = MonsterData[type];
+
+	monsterType.mtype = type;
+	monsterType.mPlaceFlags |= placeFlag;
+	for (int anim = 0; anim < 6; anim++) {
+		AnimStruct &animData = monsterType.Anims[anim];
+		const int frames = monsterData.Frames[anim];
+		animData.CMem = BuildSyntheticCl2(std::max(frames, 1), monsterData.width, SpriteHeight, 8);
+		for (int i = 0; i < 8; i++)
+			animData.CelSpritesForDirections[i].emplace(CelGetFrame(animData.CMem.get(), i), monsterData.width);
+		animData.Frames = frames;
+		animData.Rate = monsterData.Rate[anim];
+	}
+	monsterType.mMinHP = monsterData.mMinHP;
+	monsterType.mMaxHP = monsterData.mMaxHP;
+	monsterType.mAFNum = monsterData.mAFNum;
+	monsterType.MData = &monsterData;
+}
+
+/**
+ * @brief Picks the monster types of the level the same way GetLevelMTypes() does for a level without quests.
+ */
+void SetupMonsterTypes()
+{
+	AddSyntheticMonsterType(MT_GOLEM, PLACE_SPECIAL);
+
+	const char availabilityMask = gbIsSpawn ? 1 : 3;
+	std::vector<_monster_id> candidates;
+	for (int i = MT_NZOMBIE; i < NUM_MTYPES; i++) {
+		int minl = 15 * MonsterData[i].mMinDLvl / 30 + 1;
+		int maxl = 15 * MonsterData[i].mMaxDLvl / 30 + 1;
+		if (currlevel >= minl && currlevel <= maxl && (MonstAvailTbl[i] & availabilityMask) != 0)
+			candidates.push_back(static_cast<_monster_id>(i));
+	}
+
+	int imageBudget = 4000;
+	while (!candidates.empty() && LevelMonsterTypeCount < MAX_LVLMTYPES) {
+		const int pick = GenerateRnd(candidates.size());
+		const _monster_id type = candidates[pick];
+		candidates.erase(candidates.begin() + pick);
+		if (MonsterData[type].mImage > imageBudget)
+			continue;
+		imageBudget -= MonsterData[type].mImage;
+		AddSyntheticMonsterType(type, PLACE_SCATTER);
+	}
+}
+
+/**
+ * @brief Spawns the hero at the level entrance with synthetic sprites.
+ */
+void SetupHero()
+{
+	auto &player = Players[MyPlayerId];
+	for (auto &animationData : player.AnimationData) {
+		animationData.RawData = BuildSyntheticCl2(PlayerSpriteFrames, PlayerSpriteWidth, SpriteHeight, 8);
+		for (int i = 0; i < 8; i++)
+			animationData.CelSpritesForDirections[i].emplace(CelGetFrame(animationData.RawData.get(), i), PlayerSpriteWidth);
+	}
+	SpawnHero();
+
+	// The hero is only there to be chased, so make sure it survives the whole run
+	player._pInvincible = true;
+}
+
+int PlaceMonsters(int count, std::minstd_rand &rng)
+{
+	if (LevelMonsterTypeCount < 2)
+		return 0;
+
+	const Point heroPosition = Players[MyPlayerId].position.tile;
+	int placed = 0;
+	for (int attempt = 0; placed < count && attempt < count * 100 && ActiveMonsterCount < MAXMONSTERS; attempt++) {
+		const Point position = RandomTile(rng);
+		if (!IsFreeFloor(position) || position.WalkingDistance(heroPosition) < MinimumHeroDistance)
+			continue;
+		const int mtype = 1 + static_cast<int>(rng() % (LevelMonsterTypeCount - 1));
+		AddMonster(position, static_cast<Direction>(rng() % 8), mtype, true);
+		placed++;
+	}
+
+	return placed;
+}
+
+int PlaceItems(int count, std::minstd_rand &rng)
+{
+	int placed = 0;
+	for (int attempt = 0; placed < count && attempt < count * 100 && ActiveItemCount < MAXITEMS; attempt++) {
+		const Point position = RandomTile(rng);
+		if (!IsFreeFloor(position))
+			continue;
+		CreateRndItem(position, false, false, false);
+		placed++;
+	}
+
+	return placed;
+}
+
+/**
+ * @brief Keeps a constant number of missiles in flight: hero firebolts into the level and monster arrows at the hero.
+ */
+void SpawnMissiles(int target, std::minstd_rand &rng)
+{
+	const auto &player = Players[MyPlayerId];
+	for (int attempt = 0; ActiveMissileCount < target && attempt < target; attempt++) {
+		if (attempt % 2 == 0) {
+			const Point destination = RandomTile(rng);
+			if (destination == player.position.tile)
+				continue;
+			AddMissile(player.position.tile, destination, GetDirection(player.position.tile, destination), MIS_FIREBOLT, TARGET_MONSTERS, MyPlayerId, 0, 1);
+		} else if (ActiveMonsterCount > 0) {
+			const int mi = ActiveMonsters[rng() % ActiveMonsterCount];
+			const auto &monster = Monsters[mi];
+			if (mi < MAX_PLRS || monster.position.tile == player.position.tile)
+				continue;
+			AddMissile(monster.position.tile, player.position.tile, GetDirection(monster.position.tile, player.position.tile), MIS_ARROW, TARGET_PLAYERS, mi, 4, 0);
+		}
+	}
+}
+
+std::uint64_t HashGameState()
+{
+	StateHash hash;
+	hash.Add(GetLCGEngineState());
+
+	hash.Add(ActiveMonsterCount);
+	for (int i = 0; i < ActiveMonsterCount; i++) {
+		const auto &monster = Monsters[ActiveMonsters[i]];
+		hash.Add(ActiveMonsters[i]);
+		hash.Add(monster._mmode);
+		hash.Add(monster._mgoal);
+		hash.Add(monster.position.tile.x);
+		hash.Add(monster.position.tile.y);
+		hash.Add(monster.position.future.x);
+		hash.Add(monster.position.future.y);
+		hash.Add(monster._mdir);
+		hash.Add(monster._menemy);
+		hash.Add(monster._mhitpoints);
+		hash.Add(monster._mVar1);
+		hash.Add(monster._mVar2);
+		hash.Add(monster._mVar3);
+		hash.Add(monster.AnimInfo.CurrentFrame);
+	}
+
+	const auto &player = Players[MyPlayerId];
+	hash.Add(player._pmode);
+	hash.Add(player.position.tile.x);
+	hash.Add(player.position.tile.y);
+	hash.Add(player._pdir);
+	hash.Add(player._pHitPoints);
+	hash.Add(player.AnimInfo.CurrentFrame);
+
+	hash.Add(ActiveMissileCount);
+	for (int i = 0; i < ActiveMissileCount; i++) {
+		const auto &missile = Missiles[ActiveMissiles[i]];
+		hash.Add(missile._mitype);
+		hash.Add(missile.position.tile.x);
+		hash.Add(missile.position.tile.y);
+		hash.Add(missile._mirange);
+		hash.Add(missile._miVar1);
+		hash.Add(missile._miVar2);
+	}
+
+	hash.Add(ActiveItemCount);
+	for (int i = 0; i < ActiveItemCount; i++) {
+		const auto &item = Items[ActiveItems[i]];
+		hash.Add(item.position.x);
+		hash.Add(item.position.y);
+		hash.Add(item._iSeed);
+		hash.Add(item.AnimInfo.CurrentFrame);
+	}
+
+	hash.Add(ActiveObjectCount);
+	for (int i = 0; i < ActiveObjectCount; i++) {
+		const auto &object = Objects[ActiveObjects[i]];
+		hash.Add(object._otype);
+		hash.Add(object._oAnimFrame);
+		hash.Add(object._oVar4);
+	}
+
+	hash.Add(dLight, sizeof(dLight));
+	hash.Add(dFlags, sizeof(dFlags));
+
+	return hash.Value();
+}
+
+} // namespace
+
+int RunGameLogicBenchmark(const Options &options)
+{
+	const auto seed = static_cast<uint32_t>(options.GetInt("--seed", 1));
+	const int level = std::max(1, std::min(options.GetInt("--level", 5), 16));
+	const int monsterCount = options.GetInt("--monsters", 150);
+	const int missileCount = std::min(options.GetInt("--missiles", 40), MAXMISSILES);
+	const int itemCount = options.GetInt("--items", 50);
+	const int ticks = options.GetInt("--ticks", 2000);
+	LightBudget = std::max(1, options.GetInt("--light-budget", LightBudget));
+
+	InitHeadlessEngine(options);
+	CreatePlayer(MyPlayerId, HeroClass::Warrior);
+	GenerateLevel(level, seed);
+	SetupMonsterTypes();
+	InitObjectGFX(false);
+	SetupHero();
+
+	// Mirrors the population order of LoadGameLevel()
+	SetRndSeed(seed);
+	std::minstd_rand rng(seed);
+	for (int i = 0; i < MAX_PLRS; i++)
+		AddMonster({ 1, 0 }, DIR_S, 0, false);
+	const int monstersPlaced = PlaceMonsters(monsterCount, rng);
+	InitObjects();
+	InitItems();
+	const int itemsPlaced = PlaceItems(itemCount, rng);
+	InitMissiles();
+	InitDead();
+	SavePreLighting();
+	InitLightMax();
+	ProcessLightList();
+	ProcessVisionList();
+
+	std::array<PhaseStats, Phases.size()> phaseStats;
+	SampleSet tickSamples;
+
+	gbProcessPlayers = true;
+	LightStats = {};
+	const std::uint64_t allocationsBefore = AllocationCount();
+	const std::uint64_t bytesBefore = AllocatedBytes();
+	for (int tick = 0; tick < ticks; tick++) {
+		DriveHero(rng);
+		SpawnMissiles(missileCount, rng);
+
+		const std::uint64_t tickStart = NowNanoseconds();
+		for (size_t i = 0; i < Phases.size(); i++) {
+			gGameLogicStep = Phases[i].step;
+			const std::uint64_t phaseAllocations = AllocationCount();
+			const std::uint64_t phaseStart = NowNanoseconds();
+			Phases[i].process();
+			phaseStats[i].samples.Add(NowNanoseconds() - phaseStart);
+			phaseStats[i].allocations += AllocationCount() - phaseAllocations;
+		}
+		gGameLogicStep = GameLogicStep::None;
+		tickSamples.Add(NowNanoseconds() - tickStart);
+
+		multi_process_network_packets();
+	}
+
+	fmt::print("gamelogic: level {} seed {} ticks {} monsters {} items {} missiles {} ({})\n",
+	    level, seed, ticks, monstersPlaced, itemsPlaced, missileCount, gbIsHellfire ? "hellfire" : "diablo");
+	fmt::print("{:<20}{:>12}{:>12}{:>12}{:>12}{:>10}\n", "phase", "total ms", "mean us", "p95 us", "max us", "allocs");
+	for (size_t i = 0; i < Phases.size(); i++) {
+		const SampleSet &samples = phaseStats[i].samples;
+		fmt::print("{:<20}{:>12.2f}{:>12.2f}{:>12.2f}{:>12.2f}{:>10}\n",
+		    Phases[i].name, samples.Total() / 1e6, samples.MeanMicroseconds(),
+		    samples.PercentileMicroseconds(95), samples.PercentileMicroseconds(100), phaseStats[i].allocations);
+	}
+	fmt::print("{:<20}{:>12.2f}{:>12.2f}{:>12.2f}{:>12.2f}\n",
+	    "tick", tickSamples.Total() / 1e6, tickSamples.MeanMicroseconds(),
+	    tickSamples.PercentileMicroseconds(95), tickSamples.PercentileMicroseconds(100));
+	fmt::print("lights per tick: {:.2f} drawn, {:.2f} merged, {:.2f} put off (budget {})\n",
+	    static_cast<double>(LightStats.stamped) / ticks, static_cast<double>(LightStats.merged) / ticks,
+	    static_cast<double>(LightStats.deferred) / ticks, LightBudget);
+	fmt::print("allocations: {} ({} bytes)\n", AllocationCount() - allocationsBefore, AllocatedBytes() - bytesBefore);
+	fmt::print("state hash: {:016x}\n", HashGameState());
+
+	return 0;
+}
+
+} // namespace bench
+} // namespace devilution
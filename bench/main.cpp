@@ -0,0 +1,50 @@
+/**
+ * @file main.cpp
+ *
+ * Entry point of the headless benchmark harness.
+ */
+#include <cstring>
+
+#include <fmt/format.h>
+
+#include "bench_common.hpp"
+
+namespace {
+
+struct Scenario {
+	const char *name;
+	const char *description;
+	int (*run)(const devilution::bench::Options &options);
+};
+
+const Scenario Scenarios[] = {
+	{ "gamelogic", "Game logic tick on a populated dungeon level", devilution::bench::RunGameLogicBenchmark },
+	{ "path", "FindPath() against the original implementation on generated levels", devilution::bench::RunPathBenchmark },
+	{ "render", "DrawView() along a recorded camera path at several resolutions", devilution::bench::RunRenderBenchmark },
+	{ "sprites", "CL2 and CEL sprite blitters on the monster and special graphics of a level", devilution::bench::RunSpriteBenchmark },
+};
+
+void PrintUsage(const char *program)
+{
+	fmt::print("Usage: {} <scenario> [--data-dir <path>] [options]\n\nScenarios:\n", program);
+	for (const auto &scenario : Scenarios)
+		fmt::print("  {:<12}{}\n", scenario.name, scenario.description);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	for (const auto &scenario : Scenarios) {
+		if (std::strcmp(argv[1], scenario.name) == 0)
+			return scenario.run(devilution::bench::Options(argc - 2, argv + 2));
+	}
+
+	PrintUsage(argv[0]);
+	return 1;
+}
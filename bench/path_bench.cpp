@@ -0,0 +1,129 @@
+/**
+ * @file path_bench.cpp
+ *
+ * Benchmark of FindPath() against the original linked list implementation.
+ *
+ * Random pairs of nearby floor tiles are picked on generated dungeon levels and both
+ * implementations search a path between them, reporting the time per search, how many
+ * searches succeeded and the average path length.
+ */
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "bench_common.hpp"
+#include "path.h"
+
+namespace devilution {
+namespace bench {
+
+namespace {
+
+/** Queries are placed inside the same area the level generators use. */
+constexpr int PlacementMin = 16;
+constexpr int PlacementSize = 80;
+
+struct Query {
+	Point start;
+	Point destination;
+};
+
+struct Implementation {
+	const char *name;
+	int (*findPath)(bool (*)(int, Point), int, int, int, int, int, int8_t[MAX_PATH_LENGTH]);
+};
+
+const std::array<Implementation, 2> Implementations = { {
+	{ "legacy", FindPathLegacy },
+	{ "heap", FindPath },
+} };
+
+struct ImplementationStats {
+	SampleSet samples;
+	int found = 0;
+	std::uint64_t steps = 0;
+};
+
+bool PosOkFloor(int /*arg*/, Point position)
+{
+	return IsFreeFloor(position);
+}
+
+std::vector<Query> GenerateQueries(int count, int maxDistance, std::minstd_rand &rng)
+{
+	std::vector<Query> queries;
+	for (int attempt = 0; static_cast<int>(queries.size()) < count && attempt < count * 100; attempt++) {
+		const Point start { PlacementMin + static_cast<int>(rng() % PlacementSize), PlacementMin + static_cast<int>(rng() % PlacementSize) };
+		const Displacement offset { static_cast<int>(rng() % (2 * maxDistance + 1)) - maxDistance, static_cast<int>(rng() % (2 * maxDistance + 1)) - maxDistance };
+		const Point destination = start + offset;
+		if (destination == start || !IsFreeFloor(start) || !IsFreeFloor(destination))
+			continue;
+		queries.push_back({ start, destination });
+	}
+	return queries;
+}
+
+} // namespace
+
+int RunPathBenchmark(const Options &options)
+{
+	const auto seed = static_cast<uint32_t>(options.GetInt("--seed", 1));
+	const int onlyLevel = options.GetInt("--level", 0);
+	const int queryCount = options.GetInt("--queries", 2000);
+	const int maxDistance = std::max(1, std::min(options.GetInt("--distance", 16), MAX_PATH_LENGTH - 1));
+	const int repeat = std::max(1, options.GetInt("--repeat", 5));
+
+	InitHeadlessEngine(options);
+
+	std::array<ImplementationStats, Implementations.size()> stats;
+	int onlyFoundByHeap = 0;
+	int onlyFoundByLegacy = 0;
+	int totalQueries = 0;
+
+	const int firstLevel = onlyLevel != 0 ? onlyLevel : 1;
+	const int lastLevel = onlyLevel != 0 ? onlyLevel : 16;
+	for (int level = firstLevel; level <= lastLevel; level++) {
+		GenerateLevel(level, seed);
+		std::minstd_rand rng(seed + level);
+		const std::vector<Query> queries = GenerateQueries(queryCount, maxDistance, rng);
+		totalQueries += queries.size();
+
+		for (const Query &query : queries) {
+			std::array<int, Implementations.size()> steps;
+			for (size_t i = 0; i < Implementations.size(); i++) {
+				int8_t path[MAX_PATH_LENGTH];
+				const std::uint64_t start = NowNanoseconds();
+				for (int r = 0; r < repeat; r++)
+					steps[i] = Implementations[i].findPath(PosOkFloor, 0, query.start.x, query.start.y, query.destination.x, query.destination.y, path);
+				stats[i].samples.Add((NowNanoseconds() - start) / repeat);
+				if (steps[i] != 0) {
+					stats[i].found++;
+					stats[i].steps += steps[i];
+				}
+			}
+			if (steps[0] == 0 && steps[1] != 0)
+				onlyFoundByHeap++;
+			if (steps[0] != 0 && steps[1] == 0)
+				onlyFoundByLegacy++;
+		}
+	}
+
+	fmt::print("path: levels {}-{} seed {} queries {} max distance {}\n", firstLevel, lastLevel, seed, totalQueries, maxDistance);
+	fmt::print("{:<20}{:>12}{:>12}{:>12}{:>12}{:>10}{:>12}\n", "implementation", "total ms", "mean us", "p95 us", "max us", "found", "mean steps");
+	for (size_t i = 0; i < Implementations.size(); i++) {
+		const ImplementationStats &implementation = stats[i];
+		fmt::print("{:<20}{:>12.2f}{:>12.2f}{:>12.2f}{:>12.2f}{:>10}{:>12.2f}\n",
+		    Implementations[i].name, implementation.samples.Total() / 1e6, implementation.samples.MeanMicroseconds(),
+		    implementation.samples.PercentileMicroseconds(95), implementation.samples.PercentileMicroseconds(100),
+		    implementation.found, implementation.found != 0 ? static_cast<double>(implementation.steps) / implementation.found : 0.0);
+	}
+	fmt::print("only found by heap: {}, only found by legacy: {}\n", onlyFoundByHeap, onlyFoundByLegacy);
+
+	return 0;
+}
+
+} // namespace bench
+} // namespace devilution
@@ -0,0 +1,273 @@
+/**
+ * @file render_bench.cpp
+ *
+ * Headless benchmark of the dungeon renderer.
+ *
+ * A dungeon level is generated and populated from a fixed seed using the MPQ graphics. The hero then
+ * walks through the level while the camera, hero and lighting state is recorded every tick. The
+ * recording is played back through DrawView() into a plain memory surface at several resolutions and
+ * zoom modes, reporting frame time percentiles, the calls and pixels of the tile and sprite primitives,
+ * and a hash of the rendered frames so that optimisations can be checked for visual changes.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "bench_common.hpp"
+#include "control.h"
+#include "cursor.h"
+#include "dead.h"
+#include "diablo.h"
+#include "engine/random.hpp"
+#include "engine/render/render_stats.hpp"
+#include "engine/surface.hpp"
+#include "gendung.h"
+#include "items.h"
+#include "lighting.h"
+#include "missiles.h"
+#include "monster.h"
+#include "objects.h"
+#include "options.h"
+#include "player.h"
+#include "scrollrt.h"
+#include "utils/ui_fwd.h"
+
+namespace devilution {
+namespace bench {
+
+namespace {
+
+struct Resolution {
+	int width;
+	int height;
+};
+
+/** Snapshot of everything DrawView() reads that changes while the hero walks. */
+struct CameraFrame {
+	Point view;
+	ScrollStruct scroll;
+	ActorPosition position;
+	PLR_MODE mode;
+	Direction direction;
+	AnimationInfo animInfo;
+	std::vector<char> light;
+	std::vector<int8_t> flags;
+	std::vector<int8_t> players;
+};
+
+std::vector<Resolution> ParseResolutions(const std::string &list)
+{
+	std::vector<Resolution> resolutions;
+	std::istringstream stream(list);
+	std::string entry;
+	while (std::getline(stream, entry, ',')) {
+		Resolution resolution;
+		if (std::sscanf(entry.c_str(), "%dx%d", &resolution.width, &resolution.height) != 2)
+			continue;
+		// The panels drawn by DrawView() need at least the original resolution
+		if (resolution.width < PANEL_WIDTH || resolution.height < 480) {
+			fmt::print("skipping {}x{}: smaller than {}x480\n", resolution.width, resolution.height, PANEL_WIDTH);
+			continue;
+		}
+		resolutions.push_back(resolution);
+	}
+	return resolutions;
+}
+
+std::vector<bool> ParseZoomModes(const std::string &mode)
+{
+	if (mode == "on")
+		return { true };
+	if (mode == "off")
+		return { false };
+	return { false, true };
+}
+
+/**
+ * @brief Populates the generated level and the UI like LoadGameLevel() does for a new game.
+ */
+void SetupLevel(uint32_t seed)
+{
+	LoadLevelGraphics();
+	GetLevelMTypes();
+	InitObjectGFX();
+	InitMissileGFX();
+	InitItemGFX();
+	InitPlayerGFX(Players[MyPlayerId]);
+	SpawnHero();
+	InitMultiView();
+
+	SetRndSeed(seed);
+	InitMonsters();
+	InitObjects();
+	InitItems();
+	InitMissiles();
+	InitDead();
+	SavePreLighting();
+
+	SetDungeonMicros();
+	InitLightMax();
+	InitControlPan();
+	ProcessLightList();
+	ProcessVisionList();
+
+	// Nothing is under the (nonexistent) mouse cursor
+	pcursmonst = -1;
+	pcursitem = -1;
+	pcursobj = -1;
+	pcursplr = -1;
+}
+
+CameraFrame CaptureCameraFrame()
+{
+	const auto &player = Players[MyPlayerId];
+
+	CameraFrame frame;
+	frame.view = { ViewX, ViewY };
+	frame.scroll = ScrollInfo;
+	frame.position = player.position;
+	frame.mode = player._pmode;
+	frame.direction = player._pdir;
+	frame.animInfo = player.AnimInfo;
+	frame.light.assign(&dLight[0][0], &dLight[0][0] + sizeof(dLight));
+	frame.flags.assign(&dFlags[0][0], &dFlags[0][0] + sizeof(dFlags));
+	frame.players.assign(&dPlayer[0][0], &dPlayer[0][0] + sizeof(dPlayer));
+	return frame;
+}
+
+void RestoreCameraFrame(const CameraFrame &frame)
+{
+	auto &player = Players[MyPlayerId];
+
+	ViewX = frame.view.x;
+	ViewY = frame.view.y;
+	ScrollInfo = frame.scroll;
+	player.position = frame.position;
+	player._pmode = frame.mode;
+	player._pdir = frame.direction;
+	player.AnimInfo = frame.animInfo;
+	memcpy(dLight, frame.light.data(), sizeof(dLight));
+	memcpy(dFlags, frame.flags.data(), sizeof(dFlags));
+	memcpy(dPlayer, frame.players.data(), sizeof(dPlayer));
+}
+
+/**
+ * @brief Lets the hero wander through the level and records the camera state of every tick.
+ */
+std::vector<CameraFrame> RecordCameraPath(int frames, std::minstd_rand &rng)
+{
+	std::vector<CameraFrame> path;
+	path.reserve(frames);
+
+	gbProcessPlayers = true;
+	while (static_cast<int>(path.size()) < frames) {
+		DriveHero(rng);
+		ProcessPlayers();
+		ProcessLightList();
+		ProcessVisionList();
+		path.push_back(CaptureCameraFrame());
+	}
+
+	return path;
+}
+
+void HashSurface(StateHash &hash, const Surface &out)
+{
+	for (int y = 0; y < out.h(); y++)
+		hash.Add(out.at(0, y), out.w());
+}
+
+void PrintRenderStats(int frames)
+{
+	fmt::print("  {:<28}{:>14}{:>16}{:>14}\n", "primitive", "calls/frame", "pixels/frame", "pixels/call");
+	for (size_t i = 0; i < RenderPrimitiveCount; i++) {
+		const RenderPrimitiveStats &stats = RenderStats[i];
+		if (stats.calls == 0)
+			continue;
+		fmt::print("  {:<28}{:>14.1f}{:>16.0f}{:>14.1f}\n",
+		    RenderPrimitiveName(static_cast<RenderPrimitive>(i)),
+		    static_cast<double>(stats.calls) / frames,
+		    static_cast<double>(stats.pixels) / frames,
+		    static_cast<double>(stats.pixels) / stats.calls);
+	}
+}
+
+} // namespace
+
+int RunRenderBenchmark(const Options &options)
+{
+	const auto seed = static_cast<uint32_t>(options.GetInt("--seed", 1));
+	const int level = std::max(1, std::min(options.GetInt("--level", 5), 16));
+	const int frameCount = std::max(1, options.GetInt("--frames", 600));
+	const int passes = std::max(1, options.GetInt("--passes", 1));
+	const std::vector<Resolution> resolutions = ParseResolutions(options.GetString("--resolutions", "640x480,1280x720,1920x1080"));
+	const std::vector<bool> zoomModes = ParseZoomModes(options.GetString("--zoom", "both"));
+	sgOptions.Graphics.bBlendedTransparancy = options.Has("--blended");
+	sgOptions.Graphics.bTileCache = options.Has("--tile-cache");
+	sgOptions.Graphics.bTileAtlas = options.Has("--tile-atlas");
+
+	InitHeadlessEngine(options);
+	CreatePlayer(MyPlayerId, HeroClass::Warrior);
+	GenerateLevel(level, seed);
+	SetupLevel(seed);
+
+	std::minstd_rand rng(seed);
+	const std::vector<CameraFrame> path = RecordCameraPath(frameCount, rng);
+
+	fmt::print("render: level {} seed {} frames {} passes {} monsters {} items {} objects {} ({}, {} transparency{}{})\n",
+	    level, seed, frameCount, passes, ActiveMonsterCount, ActiveItemCount, ActiveObjectCount,
+	    gbIsHellfire ? "hellfire" : "diablo", sgOptions.Graphics.bBlendedTransparancy ? "blended" : "stippled",
+	    sgOptions.Graphics.bTileCache ? ", tile cache" : "", sgOptions.Graphics.bTileAtlas ? ", tile atlas" : "");
+
+	for (const Resolution &resolution : resolutions) {
+		for (const bool zoomed : zoomModes) {
+			gnScreenWidth = resolution.width;
+			gnScreenHeight = resolution.height;
+			gnViewportHeight = gnScreenHeight;
+			if (gnScreenWidth <= PANEL_WIDTH) {
+				// Part of the screen is fully obscured by the UI, same as AdjustToScreenGeometry()
+				gnViewportHeight -= PANEL_HEIGHT;
+			}
+			zoomflag = !zoomed;
+			CalcViewportGeometry();
+
+			Surface out = Surface::Alloc(resolution.width, resolution.height);
+			SampleSet samples;
+			StateHash frameHash;
+			ResetRenderStats();
+
+			std::uint64_t allocations = 0;
+			for (int pass = 0; pass < passes; pass++) {
+				for (const CameraFrame &frame : path) {
+					RestoreCameraFrame(frame);
+					const std::uint64_t frameAllocations = AllocationCount();
+					const std::uint64_t frameStart = NowNanoseconds();
+					DrawView(out, ViewX, ViewY);
+					samples.Add(NowNanoseconds() - frameStart);
+					allocations += AllocationCount() - frameAllocations;
+					if (pass == 0)
+						HashSurface(frameHash, out);
+				}
+			}
+			out.Free();
+
+			fmt::print("\n{}x{} zoom {}: mean {:.1f} us, p50 {:.1f} us, p95 {:.1f} us, p99 {:.1f} us, max {:.1f} us, allocs {}\n",
+			    resolution.width, resolution.height, zoomed ? "on" : "off",
+			    samples.MeanMicroseconds(), samples.PercentileMicroseconds(50), samples.PercentileMicroseconds(95),
+			    samples.PercentileMicroseconds(99), samples.PercentileMicroseconds(100), allocations);
+			PrintRenderStats(static_cast<int>(samples.Count()));
+			fmt::print("  frame hash: {:016x}\n", frameHash.Value());
+		}
+	}
+
+	return 0;
+}
+
+} // namespace bench
+} // namespace devilution
@@ -0,0 +1,183 @@
+/**
+ * @file sprite_bench.cpp
+ *
+ * Microbenchmark of the CL2 and CEL sprite blitters.
+ *
+ * The monster graphics of a generated level are drawn frame by frame through every lighting variant of
+ * the CL2 blitter, both fully visible and clipped at the left edge of the buffer. The special CELs of the
+ * level (arches and doors) go through the CEL blitter in every combination of lighting and transparency.
+ * Reports the time per call and per pixel written, and a hash of the output so that optimisations can be
+ * checked for visual changes.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "bench_common.hpp"
+#include "engine/render/cel_render.hpp"
+#include "engine/render/cl2_render.hpp"
+#include "engine/render/render_stats.hpp"
+#include "engine/surface.hpp"
+#include "gendung.h"
+#include "lighting.h"
+#include "monster.h"
+#include "options.h"
+#include "scrollrt.h"
+#include "utils/endian.hpp"
+
+namespace devilution {
+namespace bench {
+
+namespace {
+
+struct SpriteFrame {
+	const CelSprite *cel;
+	int frame;
+};
+
+enum class Placement {
+	Unclipped,
+	Clipped,
+};
+
+struct Variant {
+	const char *name;
+	/** Light table index used for the draw, see LightTableIndex. */
+	int light;
+	bool transparent;
+	bool blended;
+	void (*draw)(const Surface &out, Point position, const SpriteFrame &sprite);
+};
+
+const Variant Cl2Variants[] = {
+	{ "Cl2Draw", 0, false, false, [](const Surface &out, Point position, const SpriteFrame &sprite) { Cl2Draw(out, position.x, position.y, *sprite.cel, sprite.frame); } },
+	{ "Cl2DrawLight lit", 0, false, false, [](const Surface &out, Point position, const SpriteFrame &sprite) { Cl2DrawLight(out, position.x, position.y, *sprite.cel, sprite.frame); } },
+	{ "Cl2DrawLight shaded", 6, false, false, [](const Surface &out, Point position, const SpriteFrame &sprite) { Cl2DrawLight(out, position.x, position.y, *sprite.cel, sprite.frame); } },
+	{ "Cl2DrawLight dark", -1, false, false, [](const Surface &out, Point position, const SpriteFrame &sprite) { Cl2DrawLight(out, position.x, position.y, *sprite.cel, sprite.frame); } },
+	{ "Cl2DrawLightTbl", 0, false, false, [](const Surface &out, Point position, const SpriteFrame &sprite) { Cl2DrawLightTbl(out, position.x, position.y, *sprite.cel, sprite.frame, 2); } },
+};
+
+const auto DrawCelTrans = [](const Surface &out, Point position, const SpriteFrame &sprite) {
+	CelClippedBlitLightTransTo(out, position, *sprite.cel, sprite.frame);
+};
+
+const Variant CelVariants[] = {
+	{ "CelTrans lit", 0, false, false, DrawCelTrans },
+	{ "CelTrans shaded", 6, false, false, DrawCelTrans },
+	{ "CelTrans dark", -1, false, false, DrawCelTrans },
+	{ "CelTrans stippled lit", 0, true, false, DrawCelTrans },
+	{ "CelTrans stippled shaded", 6, true, false, DrawCelTrans },
+	{ "CelTrans stippled dark", -1, true, false, DrawCelTrans },
+	{ "CelTrans blended lit", 0, true, true, DrawCelTrans },
+	{ "CelTrans blended shaded", 6, true, true, DrawCelTrans },
+	{ "CelTrans blended dark", -1, true, true, DrawCelTrans },
+};
+
+std::vector<SpriteFrame> CollectMonsterFrames()
+{
+	std::vector<SpriteFrame> frames;
+	for (int i = 0; i < LevelMonsterTypeCount; i++) {
+		for (const AnimStruct &anim : LevelMonsterTypes[i].Anims) {
+			for (const auto &cel : anim.CelSpritesForDirections) {
+				if (!cel)
+					continue;
+				for (int frame = 1; frame <= anim.Frames; frame++)
+					frames.push_back({ &*cel, frame });
+			}
+		}
+	}
+	return frames;
+}
+
+std::vector<SpriteFrame> CollectSpecialFrames()
+{
+	std::vector<SpriteFrame> frames;
+	if (!pSpecialCels)
+		return frames;
+	const auto count = static_cast<int>(LoadLE32(pSpecialCels->Data()));
+	for (int frame = 1; frame <= count; frame++)
+		frames.push_back({ &*pSpecialCels, frame });
+	return frames;
+}
+
+/**
+ * @brief Position of a sprite, either well inside the buffer or cut in half by its left edge.
+ */
+Point PlaceSprite(const Surface &out, const SpriteFrame &sprite, Placement placement)
+{
+	const int width = sprite.cel->Width(sprite.frame);
+	const int y = out.h() / 2 + 64;
+	if (placement == Placement::Clipped)
+		return { -width / 2, y };
+	return { (out.w() - width) / 2, y };
+}
+
+void RunVariants(const Surface &out, const std::vector<SpriteFrame> &frames, const Variant *variants, size_t variantCount, int iterations)
+{
+	for (size_t i = 0; i < variantCount; i++) {
+		const Variant &variant = variants[i];
+		LightTableIndex = variant.light >= 0 ? variant.light : LightsMax;
+		cel_transparency_active = variant.transparent;
+		sgOptions.Graphics.bBlendedTransparancy = variant.blended;
+
+		for (const Placement placement : { Placement::Unclipped, Placement::Clipped }) {
+			for (int y = 0; y < out.h(); y++)
+				memset(out.at(0, y), 0, out.w());
+
+			StateHash hash;
+			const std::uint64_t pixelsBefore = RenderedPixels;
+			const std::uint64_t start = NowNanoseconds();
+			for (int iteration = 0; iteration < iterations; iteration++) {
+				for (const SpriteFrame &sprite : frames)
+					variant.draw(out, PlaceSprite(out, sprite, placement), sprite);
+			}
+			const std::uint64_t elapsed = NowNanoseconds() - start;
+			const std::uint64_t pixels = RenderedPixels - pixelsBefore;
+			for (int y = 0; y < out.h(); y++)
+				hash.Add(out.at(0, y), out.w());
+
+			const auto calls = static_cast<double>(frames.size()) * iterations;
+			fmt::print("  {:<28}{:<11}{:>12.1f}{:>14.0f}{:>12.3f}  {:016x}\n",
+			    variant.name, placement == Placement::Clipped ? "clipped" : "unclipped",
+			    static_cast<double>(elapsed) / calls, static_cast<double>(pixels) / calls,
+			    pixels != 0 ? static_cast<double>(elapsed) / pixels : 0.0, hash.Value());
+		}
+	}
+
+	LightTableIndex = 0;
+	cel_transparency_active = false;
+}
+
+} // namespace
+
+int RunSpriteBenchmark(const Options &options)
+{
+	const auto seed = static_cast<uint32_t>(options.GetInt("--seed", 1));
+	const int level = std::max(1, std::min(options.GetInt("--level", 5), 16));
+	const int iterations = std::max(1, options.GetInt("--iterations", 20));
+
+	InitHeadlessEngine(options);
+	GenerateLevel(level, seed);
+	LoadLevelGraphics();
+	GetLevelMTypes();
+	InitLightMax();
+
+	const std::vector<SpriteFrame> monsterFrames = CollectMonsterFrames();
+	const std::vector<SpriteFrame> specialFrames = CollectSpecialFrames();
+	fmt::print("sprites: level {} seed {} iterations {}, {} monster types with {} CL2 frames, {} special CEL frames\n",
+	    level, seed, iterations, LevelMonsterTypeCount, monsterFrames.size(), specialFrames.size());
+	fmt::print("  {:<28}{:<11}{:>12}{:>14}{:>12}  {}\n", "variant", "placement", "ns/call", "pixels/call", "ns/pixel", "hash");
+
+	Surface out = Surface::Alloc(640, 480);
+	RunVariants(out, monsterFrames, Cl2Variants, sizeof(Cl2Variants) / sizeof(Cl2Variants[0]), iterations);
+	RunVariants(out, specialFrames, CelVariants, sizeof(CelVariants) / sizeof(CelVariants[0]), iterations);
+	out.Free();
+
+	return 0;
+}
+
+} // namespace bench
+} // namespace devilution
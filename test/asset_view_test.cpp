@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "engine/asset_view.hpp"
+#include "storm/storm.h"
+#include "utils/file_util.h"
+
+namespace devilution {
+namespace {
+
+std::vector<char> WriteTestFile(const char *path, size_t size)
+{
+	std::vector<char> contents(size);
+	for (size_t i = 0; i < size; i++)
+		contents[i] = static_cast<char>(i * 7 + i / 251);
+
+	std::ofstream file(path, std::ios::binary);
+	file.write(contents.data(), contents.size());
+	return contents;
+}
+
+void ExpectContents(const AssetView &view, const std::vector<char> &expected)
+{
+	ASSERT_EQ(view.Size(), expected.size());
+	ASSERT_NE(view.Data(), nullptr);
+	EXPECT_EQ(memcmp(view.Data(), expected.data(), expected.size()), 0);
+}
+
+TEST(AssetView, LoadsLocalFiles)
+{
+	const char *largePath = "test_asset_view_large.bin";
+	const char *smallPath = "test_asset_view_small.bin";
+	const std::vector<char> large = WriteTestFile(largePath, 300 * 1024 + 13);
+	const std::vector<char> small = WriteTestFile(smallPath, 100);
+
+	SFileSetBasePath("");
+	SFileEnableDirectAccess(true);
+
+	{
+		AssetView largeView = LoadAssetView(largePath, alignof(std::uint32_t));
+		ExpectContents(largeView, large);
+#if defined(__unix__) || defined(__APPLE__) || defined(_WIN32)
+		EXPECT_TRUE(largeView.IsMapped());
+#endif
+
+		// Moving a view keeps the data where it is
+		const byte *data = largeView.Data();
+		const AssetView movedView = std::move(largeView);
+		EXPECT_EQ(movedView.Data(), data);
+		ExpectContents(movedView, large);
+
+		const AssetView smallView = LoadAssetView(smallPath);
+		ExpectContents(smallView, small);
+		EXPECT_FALSE(smallView.IsMapped());
+	}
+
+	SFileEnableDirectAccess(false);
+	RemoveFile(largePath);
+	RemoveFile(smallPath);
+}
+
+} // namespace
+} // namespace devilution
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "engine/cel_sprite.hpp"
+#include "engine/render/cl2_render.hpp"
+#include "engine/surface.hpp"
+#include "lighting.h"
+#include "scrollrt.h"
+
+namespace devilution {
+namespace {
+
+constexpr int SpriteWidth = 37;
+constexpr int SpriteHeight = 29;
+constexpr int BufferWidth = 64;
+constexpr int BufferHeight = 48;
+
+/** @brief Sprite pixels, top row first, 0 is transparent. */
+std::vector<std::uint8_t> MakeSpritePixels(std::mt19937 &rng)
+{
+	std::vector<std::uint8_t> pixels(SpriteWidth * SpriteHeight);
+	for (std::size_t i = 0; i < pixels.size();) {
+		// Mix transparent runs, solid runs and noise so that every kind of CL2 command is used
+		const int length = 1 + rng() % 70;
+		const int kind = rng() % 3;
+		const auto color = static_cast<std::uint8_t>(1 + rng() % 255);
+		for (int j = 0; j < length && i < pixels.size(); j++, i++) {
+			if (kind == 0)
+				pixels[i] = 0;
+			else if (kind == 1)
+				pixels[i] = color;
+			else
+				pixels[i] = static_cast<std::uint8_t>(1 + rng() % 255);
+		}
+	}
+	return pixels;
+}
+
+/** @brief Encodes the pixels as a CL2 sprite with a single frame. */
+std::vector<byte> EncodeCl2(const std::vector<std::uint8_t> &pixels)
+{
+	// CL2 lines are stored bottom to top
+	std::vector<std::uint8_t> stream;
+	for (int y = SpriteHeight - 1; y >= 0; y--)
+		stream.insert(stream.end(), &pixels[y * SpriteWidth], &pixels[(y + 1) * SpriteWidth]);
+
+	// Only transparent runs may continue on the next line
+	const auto lineEnd = [](std::size_t i) {
+		return (i / SpriteWidth + 1) * SpriteWidth;
+	};
+	const auto sameColorRun = [&stream, &lineEnd](std::size_t i) {
+		std::size_t j = i;
+		while (j < lineEnd(i) && stream[j] == stream[i] && j - i < 63)
+			j++;
+		return j - i;
+	};
+
+	std::vector<std::uint8_t> rle;
+	for (std::size_t i = 0; i < stream.size();) {
+		if (stream[i] == 0) {
+			std::size_t j = i;
+			while (j < stream.size() && stream[j] == 0 && j - i < 127)
+				j++;
+			rle.push_back(static_cast<std::uint8_t>(j - i));
+			i = j;
+		} else if (sameColorRun(i) >= 3) {
+			const std::size_t length = sameColorRun(i);
+			rle.push_back(static_cast<std::uint8_t>(0xBF - length));
+			rle.push_back(stream[i]);
+			i += length;
+		} else {
+			std::size_t j = i;
+			while (j < lineEnd(i) && stream[j] != 0 && j - i < 65 && (j == i || sameColorRun(j) < 3))
+				j++;
+			rle.push_back(static_cast<std::uint8_t>(256 - (j - i)));
+			rle.insert(rle.end(), &stream[i], &stream[j]);
+			i = j;
+		}
+	}
+
+	// Frame table with a single frame, followed by the frame header with the offset of the pixel data
+	constexpr std::uint32_t FrameTableSize = 3 * sizeof(std::uint32_t);
+	constexpr std::uint16_t FrameHeaderSize = 10;
+	const auto frameEnd = static_cast<std::uint32_t>(FrameTableSize + FrameHeaderSize + rle.size());
+	std::vector<byte> data(frameEnd);
+	const std::uint32_t frameTable[] = { 1, FrameTableSize, frameEnd };
+	for (int i = 0; i < 3; i++) {
+		for (int b = 0; b < 4; b++)
+			data[i * 4 + b] = static_cast<byte>((frameTable[i] >> (8 * b)) & 0xFF);
+	}
+	data[FrameTableSize] = static_cast<byte>(FrameHeaderSize);
+	for (std::size_t i = 0; i < rle.size(); i++)
+		data[FrameTableSize + FrameHeaderSize + i] = static_cast<byte>(rle[i]);
+	return data;
+}
+
+/**
+ * @brief Draws the sprite pixel by pixel.
+ * @param tbl Light table, or nullptr to draw the pixels as they are
+ */
+void DrawReference(std::vector<std::uint8_t> &buffer, const std::vector<std::uint8_t> &pixels, int sx, int sy, const std::uint8_t *tbl)
+{
+	for (int y = 0; y < SpriteHeight; y++) {
+		const int dy = sy - (SpriteHeight - 1 - y);
+		for (int x = 0; x < SpriteWidth; x++) {
+			const int dx = sx + x;
+			const std::uint8_t pixel = pixels[y * SpriteWidth + x];
+			if (pixel == 0 || dx < 0 || dx >= BufferWidth || dy < 0 || dy >= BufferHeight)
+				continue;
+			buffer[dy * BufferWidth + dx] = tbl != nullptr ? tbl[pixel] : pixel;
+		}
+	}
+}
+
+class Cl2RenderTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		std::mt19937 rng(5);
+		for (std::uint8_t &entry : LightTables)
+			entry = static_cast<std::uint8_t>(rng());
+		InitLightMax();
+		std::fill_n(&LightTables[LightsMax * 256], 256, 0);
+
+		pixels_ = MakeSpritePixels(rng);
+		data_ = EncodeCl2(pixels_);
+
+		surface_.w = BufferWidth;
+		surface_.h = BufferHeight;
+		surface_.pitch = BufferWidth;
+	}
+
+	void TearDown() override
+	{
+		LightTableIndex = 0;
+	}
+
+	/** @brief Draws the sprite at every clipping position and compares the result with the reference. */
+	template <typename DrawFn>
+	void ExpectMatchesReference(const DrawFn &draw, const std::uint8_t *tbl)
+	{
+		const CelSprite cel(data_.data(), SpriteWidth);
+		for (int sy = -2; sy < BufferHeight + SpriteHeight; sy += 3) {
+			for (int sx = -SpriteWidth - 1; sx <= BufferWidth; sx += 5) {
+				std::vector<std::uint8_t> expected(BufferWidth * BufferHeight, 0xAA);
+				std::vector<std::uint8_t> actual = expected;
+				DrawReference(expected, pixels_, sx, sy, tbl);
+				surface_.pixels = actual.data();
+				draw(Surface(&surface_), sx, sy, cel);
+				ASSERT_EQ(actual, expected) << "at " << sx << ", " << sy;
+			}
+		}
+	}
+
+	std::vector<std::uint8_t> pixels_;
+	std::vector<byte> data_;
+	SDL_Surface surface_ {};
+};
+
+TEST_F(Cl2RenderTest, Draw)
+{
+	ExpectMatchesReference([](const Surface &out, int sx, int sy, const CelSprite &cel) { Cl2Draw(out, sx, sy, cel, 1); }, nullptr);
+}
+
+TEST_F(Cl2RenderTest, DrawLightFullyLit)
+{
+	LightTableIndex = 0;
+	ExpectMatchesReference([](const Surface &out, int sx, int sy, const CelSprite &cel) { Cl2DrawLight(out, sx, sy, cel, 1); }, nullptr);
+}
+
+TEST_F(Cl2RenderTest, DrawLightPartiallyLit)
+{
+	LightTableIndex = 6;
+	ExpectMatchesReference([](const Surface &out, int sx, int sy, const CelSprite &cel) { Cl2DrawLight(out, sx, sy, cel, 1); }, &LightTables[6 * 256]);
+}
+
+TEST_F(Cl2RenderTest, DrawLightFullyDark)
+{
+	LightTableIndex = LightsMax;
+	ExpectMatchesReference([](const Surface &out, int sx, int sy, const CelSprite &cel) { Cl2DrawLight(out, sx, sy, cel, 1); }, &LightTables[LightsMax * 256]);
+}
+
+TEST_F(Cl2RenderTest, DrawLightTbl)
+{
+	ExpectMatchesReference([](const Surface &out, int sx, int sy, const CelSprite &cel) { Cl2DrawLightTbl(out, sx, sy, cel, 1, 2); }, &LightTables[4096 + 256]);
+}
+
+} // namespace
+} // namespace devilution
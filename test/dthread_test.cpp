@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "dthread.h"
+
+namespace devilution {
+namespace {
+
+/** @brief Queues a delta whose single byte tells it apart from the others. */
+bool Push(DeltaQueue &queue, uint8_t pnum, uint32_t generation, uint8_t value)
+{
+	const byte data[] = { static_cast<byte>(value) };
+	return queue.TryPush(pnum, generation, CMD_DLEVEL_0, data, sizeof(data));
+}
+
+uint8_t PopValue(DeltaQueue &queue)
+{
+	DeltaPacket *delta = queue.Front();
+	EXPECT_NE(delta, nullptr);
+	if (delta == nullptr)
+		return 0;
+	EXPECT_EQ(delta->data.size(), 1U);
+	const auto value = static_cast<uint8_t>(delta->data[0]);
+	queue.Pop();
+	return value;
+}
+
+TEST(DeltaQueue, WrapAround)
+{
+	auto queue = std::make_unique<DeltaQueue>();
+	EXPECT_EQ(queue->Front(), nullptr);
+
+	// Keep a few deltas in the queue while going round the ring several times
+	int pushed = 0;
+	int popped = 0;
+	for (; pushed < 3; pushed++)
+		ASSERT_TRUE(Push(*queue, 0, 0, pushed));
+	for (; pushed < 3 * static_cast<int>(DeltaQueueSize); pushed++) {
+		ASSERT_TRUE(Push(*queue, 0, 0, pushed % 256));
+		EXPECT_EQ(PopValue(*queue), popped % 256);
+		popped++;
+	}
+	for (; popped < pushed; popped++)
+		EXPECT_EQ(PopValue(*queue), popped % 256);
+	EXPECT_EQ(queue->Front(), nullptr);
+}
+
+TEST(DeltaQueue, FullRing)
+{
+	auto queue = std::make_unique<DeltaQueue>();
+	for (size_t i = 0; i < DeltaQueueSize; i++)
+		ASSERT_TRUE(Push(*queue, 0, 0, i % 256));
+	EXPECT_FALSE(Push(*queue, 0, 0, 0xAA));
+
+	// Popping one delta makes room for exactly one more, the retry goes to the back
+	EXPECT_EQ(PopValue(*queue), 0);
+	EXPECT_TRUE(Push(*queue, 0, 0, 0xAA));
+	EXPECT_FALSE(Push(*queue, 0, 0, 0xBB));
+	for (size_t i = 1; i < DeltaQueueSize; i++)
+		EXPECT_EQ(PopValue(*queue), i % 256);
+	EXPECT_EQ(PopValue(*queue), 0xAA);
+	EXPECT_EQ(queue->Front(), nullptr);
+}
+
+TEST(DeltaQueue, StaleGenerations)
+{
+	auto queue = std::make_unique<DeltaQueue>();
+	// Player 1 left after two deltas were queued for it (generation 0), and another player took the
+	// slot (generation 1)
+	ASSERT_TRUE(Push(*queue, 1, 0, 1));
+	ASSERT_TRUE(Push(*queue, 1, 0, 2));
+	ASSERT_TRUE(Push(*queue, 1, 1, 3));
+	ASSERT_TRUE(Push(*queue, 2, 0, 4));
+
+	// A batch for the new player skips the deltas of the one that left
+	DeltaPacket *delta = queue->FrontFor(1, 1, 1);
+	ASSERT_NE(delta, nullptr);
+	EXPECT_EQ(static_cast<uint8_t>(delta->data[0]), 3);
+	queue->Pop();
+	// The batch ends at the delta of another player
+	EXPECT_EQ(queue->FrontFor(1, 1, 1), nullptr);
+	EXPECT_EQ(PopValue(*queue), 4);
+}
+
+TEST(DeltaQueue, PlayerLeavesDuringBatch)
+{
+	auto queue = std::make_unique<DeltaQueue>();
+	ASSERT_TRUE(Push(*queue, 1, 0, 1));
+	ASSERT_TRUE(Push(*queue, 1, 1, 2));
+
+	// The batch started for generation 0, the player left and the slot was taken again
+	DeltaPacket *delta = queue->FrontFor(1, 0, 1);
+	ASSERT_NE(delta, nullptr);
+	queue->Pop();
+	// The delta of the new player is kept for the next batch
+	EXPECT_EQ(queue->FrontFor(1, 0, 1), nullptr);
+	EXPECT_EQ(PopValue(*queue), 2);
+}
+
+TEST(DeltaQueue, ConcurrentProducers)
+{
+	constexpr int Producers = 4;
+	constexpr int DeltasPerProducer = 2000;
+	auto queue = std::make_unique<DeltaQueue>();
+
+	std::vector<std::thread> threads;
+	for (int producer = 0; producer < Producers; producer++) {
+		threads.emplace_back([&queue, producer]() {
+			for (int i = 0; i < DeltasPerProducer; i++) {
+				while (!Push(*queue, producer, i, i % 256))
+					std::this_thread::yield();
+			}
+		});
+	}
+
+	// Every producer's deltas arrive complete and in the order it queued them
+	int next[Producers] = {};
+	for (int received = 0; received < Producers * DeltasPerProducer;) {
+		DeltaPacket *delta = queue->Front();
+		if (delta == nullptr) {
+			std::this_thread::yield();
+			continue;
+		}
+		ASSERT_LT(delta->pnum, Producers);
+		int &expected = next[delta->pnum];
+		EXPECT_EQ(delta->generation, static_cast<uint32_t>(expected));
+		EXPECT_EQ(static_cast<uint8_t>(delta->data[0]), expected % 256);
+		expected++;
+		queue->Pop();
+		received++;
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+	EXPECT_EQ(queue->Front(), nullptr);
+}
+
+} // namespace
+} // namespace devilution
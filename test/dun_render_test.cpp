@@ -0,0 +1,398 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "engine/render/dun_render.hpp"
+#include "engine/surface.hpp"
+#include "gendung.h"
+#include "lighting.h"
+#include "objects.h"
+#include "options.h"
+#include "palette.h"
+#include "scrollrt.h"
+
+namespace devilution {
+namespace {
+
+constexpr int BufferWidth = 64;
+constexpr int BufferHeight = 48;
+
+/** @brief Tile types in the order of their encoding in the level piece blocks. */
+enum TileEncoding : std::uint16_t {
+	Square,
+	TransparentSquare,
+	LeftTriangle,
+	RightTriangle,
+	LeftTrapezoid,
+	RightTrapezoid,
+	TileEncodingCount,
+};
+
+void AppendPixels(std::vector<std::uint8_t> &frame, std::mt19937 &rng, int count)
+{
+	for (int i = 0; i < count; i++)
+		frame.push_back(static_cast<std::uint8_t>(rng()));
+}
+
+/** @brief Appends the lower triangle and, unless it is part of a trapezoid, the upper triangle. */
+void AppendTriangle(std::vector<std::uint8_t> &frame, std::mt19937 &rng, bool left, int upperHeight)
+{
+	const auto appendRow = [&](int i, int width) {
+		if (left && i % 2 != 0)
+			AppendPixels(frame, rng, 2);
+		AppendPixels(frame, rng, width);
+		if (!left && i % 2 != 0)
+			AppendPixels(frame, rng, 2);
+	};
+	for (int i = 1; i <= 16; i++)
+		appendRow(i, 2 * i);
+	for (int i = 1; i <= upperHeight; i++)
+		appendRow(i, 32 - 2 * i);
+}
+
+std::vector<std::uint8_t> EncodeTile(TileEncoding type, std::mt19937 &rng)
+{
+	std::vector<std::uint8_t> frame;
+	switch (type) {
+	case Square:
+		AppendPixels(frame, rng, 32 * 32);
+		break;
+	case TransparentSquare:
+		for (int row = 0; row < 32; row++) {
+			for (int x = 0; x < 32;) {
+				const int length = 1 + rng() % (32 - x);
+				if (rng() % 2 == 0) {
+					frame.push_back(static_cast<std::uint8_t>(length));
+					AppendPixels(frame, rng, length);
+				} else {
+					frame.push_back(static_cast<std::uint8_t>(-length));
+				}
+				x += length;
+			}
+		}
+		break;
+	case LeftTriangle:
+	case RightTriangle:
+		AppendTriangle(frame, rng, type == LeftTriangle, 15);
+		break;
+	default:
+		AppendTriangle(frame, rng, type == LeftTrapezoid, 0);
+		AppendPixels(frame, rng, 16 * 32);
+		break;
+	}
+	return frame;
+}
+
+enum class MaskMode {
+	Solid,
+	Wall,
+	LeftArch,
+	RightArch,
+	LeftFoliage,
+	RightFoliage,
+};
+
+class DunRenderTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		std::mt19937 rng(7);
+		for (std::uint8_t &entry : LightTables)
+			entry = static_cast<std::uint8_t>(rng());
+		InitLightMax();
+		std::fill_n(&LightTables[LightsMax * 256], 256, 0);
+		for (auto &row : paletteTransparencyLookup) {
+			for (Uint8 &entry : row)
+				entry = static_cast<Uint8>(rng());
+		}
+
+		// One frame of each type, twice, with every tile type used by a level piece
+		std::vector<std::vector<std::uint8_t>> frames;
+		for (int i = 0; i < 2 * TileEncodingCount; i++) {
+			const auto type = static_cast<TileEncoding>(i % TileEncodingCount);
+			frames.push_back(EncodeTile(type, rng));
+			pieces_.push_back(static_cast<std::uint16_t>((type << 12) | (i + 1)));
+		}
+
+		std::vector<std::uint32_t> frameTable { static_cast<std::uint32_t>(frames.size()) };
+		std::size_t size = (frames.size() + 2) * sizeof(std::uint32_t);
+		for (const auto &frame : frames) {
+			frameTable.push_back(static_cast<std::uint32_t>(size));
+			size += frame.size();
+		}
+		frameTable.push_back(static_cast<std::uint32_t>(size));
+		std::unique_ptr<byte[]> data { new byte[size] };
+		std::size_t offset = 0;
+		for (const std::uint32_t entry : frameTable) {
+			for (int b = 0; b < 4; b++)
+				data[offset++] = static_cast<byte>((entry >> (8 * b)) & 0xFF);
+		}
+		for (const auto &frame : frames) {
+			for (const std::uint8_t pixel : frame)
+				data[offset++] = static_cast<byte>(pixel);
+		}
+		pDungeonCels = AssetView(std::move(data), size);
+
+		surface_.w = BufferWidth;
+		surface_.h = BufferHeight;
+		surface_.pitch = BufferWidth;
+	}
+
+	void TearDown() override
+	{
+		FreeTileAtlas();
+		pDungeonCels = {};
+		LightTableIndex = 0;
+		cel_transparency_active = false;
+		cel_foliage_active = false;
+		arch_draw_type = 0;
+		sgOptions.Graphics.bBlendedTransparancy = false;
+	}
+
+	static void SetMaskMode(MaskMode mode)
+	{
+		cel_transparency_active = mode == MaskMode::Wall || mode == MaskMode::LeftArch || mode == MaskMode::RightArch;
+		cel_foliage_active = mode == MaskMode::LeftFoliage || mode == MaskMode::RightFoliage;
+		arch_draw_type = 0;
+		if (mode == MaskMode::LeftArch || mode == MaskMode::LeftFoliage)
+			arch_draw_type = 1;
+		if (mode == MaskMode::RightArch || mode == MaskMode::RightFoliage)
+			arch_draw_type = 2;
+		level_piece_id = 1;
+		block_lvid[level_piece_id] = 3;
+	}
+
+	std::vector<std::uint8_t> Render(int x, int y)
+	{
+		std::vector<std::uint8_t> buffer(BufferWidth * BufferHeight, 0xAA);
+		surface_.pixels = buffer.data();
+		RenderTile(Surface(&surface_), x, y);
+		return buffer;
+	}
+
+	/** @brief Renders every tile at every clipping position from the CEL data and from the atlas and compares them. */
+	void ExpectAtlasMatchesCel()
+	{
+		for (const std::uint16_t block : pieces_) {
+			level_cel_block = block;
+			std::vector<std::vector<std::uint8_t>> expected;
+			for (int y = -2; y < BufferHeight + 34; y += 3) {
+				for (int x = -33; x <= BufferWidth; x += 3)
+					expected.push_back(Render(x, y));
+			}
+
+			BuildTileAtlas(pieces_.data(), pieces_.size());
+			auto it = expected.begin();
+			for (int y = -2; y < BufferHeight + 34; y += 3) {
+				for (int x = -33; x <= BufferWidth; x += 3)
+					ASSERT_EQ(Render(x, y), *it++) << "block " << std::hex << block << std::dec << " at " << x << ", " << y;
+			}
+			FreeTileAtlas();
+		}
+	}
+
+	std::vector<std::uint16_t> pieces_;
+	SDL_Surface surface_ {};
+};
+
+TEST_F(DunRenderTest, AtlasMatchesCel)
+{
+	for (const bool blended : { false, true }) {
+		sgOptions.Graphics.bBlendedTransparancy = blended;
+		for (const MaskMode mode : { MaskMode::Solid, MaskMode::Wall, MaskMode::LeftArch, MaskMode::RightArch, MaskMode::LeftFoliage, MaskMode::RightFoliage }) {
+			SetMaskMode(mode);
+			for (const int light : { 0, 6, static_cast<int>(LightsMax) }) {
+				LightTableIndex = light;
+				ExpectAtlasMatchesCel();
+				if (HasFatalFailure())
+					return;
+			}
+		}
+	}
+}
+
+constexpr int ViewWidth = 160;
+constexpr int ViewHeight = 96;
+
+int FloorDivide(int value, int divisor)
+{
+	return value >= 0 ? value / divisor : -((divisor - 1 - value) / divisor);
+}
+
+/** @brief Compares the floor drawn through the floor cache with the one drawn by the uncached walk over the same map. */
+class FloorCacheTest : public DunRenderTest {
+protected:
+	void SetUp() override
+	{
+		DunRenderTest::SetUp();
+		gnScreenWidth = ViewWidth;
+		gnViewportHeight = ViewHeight;
+
+		// Like the floors of the levels, each half covers its side of the diamond and nothing is transparent
+		for (const std::uint16_t block : pieces_) {
+			const auto type = static_cast<TileEncoding>(block >> 12);
+			if (type == Square || type == LeftTriangle || type == LeftTrapezoid)
+				leftBlocks_.push_back(block);
+			if (type == Square || type == RightTriangle || type == RightTrapezoid)
+				rightBlocks_.push_back(block);
+		}
+		for (int x = 0; x < MAXDUNX; x++) {
+			for (int y = 0; y < MAXDUNY; y++) {
+				dPiece[x][y] = rng_() % 16 == 0 ? 0 : 1;
+				dpiece_defs_map_2[x][y].mt[0] = RandomBlock(leftBlocks_);
+				dpiece_defs_map_2[x][y].mt[1] = RandomBlock(rightBlocks_);
+				dLight[x][y] = RandomLight();
+			}
+		}
+	}
+
+	void TearDown() override
+	{
+		FreeFloorCache();
+		sgOptions.Graphics.bTileCache = false;
+		pLevelPieces = nullptr;
+		leveltype = DTYPE_TOWN;
+		memset(dPiece, 0, sizeof(dPiece));
+		memset(dpiece_defs_map_2, 0, sizeof(dpiece_defs_map_2));
+		memset(dLight, 0, sizeof(dLight));
+		DunRenderTest::TearDown();
+	}
+
+	std::uint16_t RandomBlock(const std::vector<std::uint16_t> &blocks)
+	{
+		return blocks[rng_() % blocks.size()];
+	}
+
+	char RandomLight()
+	{
+		return static_cast<char>(rng_() % (LightsMax + 1));
+	}
+
+	/** @brief Draws the view with its top left corner at the given world pixel position, the way DrawGame() does. */
+	std::vector<std::uint8_t> RenderFloor(int viewX, int viewY, bool cached)
+	{
+		std::vector<std::uint8_t> buffer(ViewWidth * ViewHeight, 0xAA);
+		SDL_Surface surface {};
+		surface.w = ViewWidth;
+		surface.h = ViewHeight;
+		surface.pitch = ViewWidth;
+		surface.pixels = buffer.data();
+
+		// Start the walk above and left of the view, so that the rows cover all of it
+		const int sum = FloorDivide(viewY, TILE_HEIGHT / 2);
+		int difference = FloorDivide(viewX, TILE_WIDTH / 2) - 4;
+		if (((sum - difference) & 1) != 0)
+			difference--;
+		const int sx = difference * (TILE_WIDTH / 2) - viewX;
+		const int sy = sum * (TILE_HEIGHT / 2) - viewY;
+
+		sgOptions.Graphics.bTileCache = cached;
+		DrawFloorLayer(Surface(&surface), (sum + difference) / 2, (sum - difference) / 2, sx, sy, ViewHeight / (TILE_HEIGHT / 2) + 4, ViewWidth / TILE_WIDTH + 4);
+		return buffer;
+	}
+
+	void ExpectCacheMatches(int viewX, int viewY)
+	{
+		ASSERT_EQ(RenderFloor(viewX, viewY, true), RenderFloor(viewX, viewY, false)) << "view at " << viewX << ", " << viewY;
+	}
+
+	std::mt19937 rng_ { 11 };
+	std::vector<std::uint16_t> leftBlocks_;
+	std::vector<std::uint16_t> rightBlocks_;
+};
+
+constexpr int StartX = -80;
+constexpr int StartY = 1700;
+
+TEST_F(FloorCacheTest, SmallMoves)
+{
+	for (const Displacement move : { Displacement { 0, 0 }, { 1, 0 }, { 7, 3 }, { -20, -11 }, { 127, 63 }, { -128, -64 }, { 64, -64 }, { -5, 40 } }) {
+		ExpectCacheMatches(StartX + move.deltaX, StartY + move.deltaY);
+		if (HasFatalFailure())
+			return;
+	}
+}
+
+TEST_F(FloorCacheTest, MovesPastMargin)
+{
+	int viewX = StartX;
+	int viewY = StartY;
+	ExpectCacheMatches(viewX, viewY);
+	// Every direction, by a little more than the margin, by most of the cache and past all of it
+	for (const Displacement move : { Displacement { 130, 0 }, { -130, 0 }, { 0, 70 }, { 0, -70 }, { 150, 90 }, { -150, -90 }, { 150, -90 }, { -150, 90 },
+	         { 300, 5 }, { -3, -200 }, { 1000, 0 }, { 0, -600 }, { 3, 1 } }) {
+		viewX += move.deltaX;
+		viewY += move.deltaY;
+		ExpectCacheMatches(viewX, viewY);
+		if (HasFatalFailure())
+			return;
+	}
+}
+
+TEST_F(FloorCacheTest, LightChanges)
+{
+	ExpectCacheMatches(StartX, StartY);
+	// Tiles in the middle of the view, across its edges, only inside the margin and outside the cache
+	for (const Point tile : { Point { 55, 54 }, Point { 56, 53 }, Point { 57, 56 }, Point { 52, 55 }, Point { 53, 53 }, Point { 58, 53 }, Point { 51, 51 } }) {
+		const char light = dLight[tile.x][tile.y];
+		dLight[tile.x][tile.y] = static_cast<char>((light + 1) % (LightsMax + 1));
+		ExpectCacheMatches(StartX, StartY);
+		if (HasFatalFailure())
+			return;
+		dLight[tile.x][tile.y] = light;
+		ExpectCacheMatches(StartX + 3, StartY - 2);
+		if (HasFatalFailure())
+			return;
+	}
+	// Neighbouring tiles changing in the same frame
+	dLight[55][54] = 0;
+	dLight[56][54] = 0;
+	dLight[55][55] = 0;
+	ExpectCacheMatches(StartX, StartY);
+}
+
+TEST_F(FloorCacheTest, DoorMicro)
+{
+	constexpr int Blocks = 10;
+	leveltype = DTYPE_CATHEDRAL;
+	pLevelPieces = std::make_unique<uint16_t[]>(2 * Blocks);
+	// The floor micros of a piece are the last two blocks
+	pLevelPieces[Blocks - 2] = leftBlocks_[0];
+	pLevelPieces[Blocks - 1] = rightBlocks_[0];
+	pLevelPieces[2 * Blocks - 2] = leftBlocks_[1];
+	pLevelPieces[2 * Blocks - 1] = rightBlocks_[1];
+
+	ExpectCacheMatches(StartX, StartY);
+	ObjSetMicro({ 55, 54 }, 1);
+	ExpectCacheMatches(StartX, StartY);
+	ObjSetMicro({ 55, 54 }, 2);
+	ExpectCacheMatches(StartX, StartY);
+	ObjSetMicro({ 54, 54 }, 2);
+	ObjSetMicro({ 55, 53 }, 2);
+	ExpectCacheMatches(StartX, StartY);
+}
+
+TEST_F(FloorCacheTest, FullRedraw)
+{
+	ExpectCacheMatches(StartX, StartY);
+	// Changing most of the tiles redraws the whole cache instead of the single tiles
+	for (int x = 0; x < MAXDUNX; x++) {
+		for (int y = 0; y < MAXDUNY; y++)
+			dLight[x][y] = RandomLight();
+	}
+	ExpectCacheMatches(StartX, StartY);
+	for (int x = 0; x < MAXDUNX; x++) {
+		for (int y = 0; y < MAXDUNY; y++)
+			dPiece[x][y] = dPiece[x][y] == 0 ? 1 : 0;
+	}
+	ExpectCacheMatches(StartX + 10, StartY);
+	FreeFloorCache();
+	ExpectCacheMatches(StartX, StartY);
+}
+
+} // namespace
+} // namespace devilution
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "dvlnet/frame_queue.h"
+#include "dvlnet/packet.h"
+
+namespace devilution {
+namespace net {
+namespace {
+
+TEST(FrameQueue, SplitWrites)
+{
+	std::mt19937 rng(5);
+	std::vector<buffer_t> packets;
+	buffer_t stream;
+	for (int i = 0; i < 200; i++) {
+		buffer_t packet(1 + rng() % (i % 10 == 0 ? frame_queue::max_frame_size : 300));
+		for (unsigned char &b : packet)
+			b = static_cast<unsigned char>(rng());
+		buffer_t frame = frame_queue::MakeFrame(packet);
+		stream.insert(stream.end(), frame.begin(), frame.end());
+		packets.push_back(std::move(packet));
+	}
+
+	frame_queue queue;
+	size_t read = 0;
+	for (size_t offset = 0; offset < stream.size();) {
+		const size_t size = std::min<size_t>(stream.size() - offset, rng() % 2000);
+		if (rng() % 2 == 0) {
+			queue.Write(&stream[offset], size);
+		} else {
+			unsigned char *dst = queue.PrepareWrite(frame_queue::max_frame_size);
+			std::copy_n(&stream[offset], size, dst);
+			queue.CommitWrite(size);
+		}
+		offset += size;
+		while (queue.PacketReady()) {
+			ASSERT_LT(read, packets.size());
+			const frame_view frame = queue.ReadPacket();
+			ASSERT_EQ(buffer_t(frame.begin(), frame.end()), packets[read]) << "packet " << read;
+			read++;
+		}
+	}
+	EXPECT_EQ(read, packets.size());
+}
+
+TEST(FrameQueue, InvalidSize)
+{
+	const unsigned char empty[] = { 0, 0, 0, 0 };
+	frame_queue queue;
+	queue.Write(empty, sizeof(empty));
+	EXPECT_THROW(queue.PacketReady(), frame_queue_exception);
+
+	// The size is in host byte order, like MakeFrame() writes it
+	const framesize_t tooLargeSize = frame_queue::max_frame_size + 1;
+	unsigned char tooLarge[sizeof(tooLargeSize)];
+	memcpy(tooLarge, &tooLargeSize, sizeof(tooLargeSize));
+	frame_queue queue2;
+	queue2.Write(tooLarge, sizeof(tooLarge));
+	EXPECT_THROW(queue2.PacketReady(), frame_queue_exception);
+}
+
+TEST(FrameQueue, ParsePacket)
+{
+	packet_factory factory("pass");
+	const buffer_t message { 1, 2, 3, 4, 5 };
+	auto sent = factory.make_packet<PT_MESSAGE>(plr_t { 1 }, plr_t { 2 }, message);
+	buffer_t frame = frame_queue::MakeFrame(sent->Data());
+
+	frame_queue queue;
+	queue.Write(frame.data(), frame.size());
+	ASSERT_TRUE(queue.PacketReady());
+	auto received = factory.make_packet(queue.ReadPacket());
+	EXPECT_EQ(received->Type(), PT_MESSAGE);
+	EXPECT_EQ(received->Source(), 1);
+	EXPECT_EQ(received->Destination(), 2);
+	EXPECT_EQ(received->Message(), message);
+	EXPECT_EQ(received->Data(), sent->Data());
+
+	frame[frame.size() - 1] ^= 1;
+	queue.Write(frame.data(), frame.size());
+	ASSERT_TRUE(queue.PacketReady());
+#ifdef NONET
+	EXPECT_NE(factory.make_packet(queue.ReadPacket())->Message(), message);
+#else
+	EXPECT_THROW(factory.make_packet(queue.ReadPacket()), packet_exception);
+#endif
+}
+
+} // namespace
+} // namespace net
+} // namespace devilution
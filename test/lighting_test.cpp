@@ -1,7 +1,14 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "automap.h"
 #include "control.h"
+#include "gendung.h"
 #include "lighting.h"
+#include "multi.h"
 
 using namespace devilution;
 
@@ -36,3 +43,319 @@ TEST(Lighting, CrawlTables)
 		}
 	}
 }
+
+namespace {
+
+void CheckLightMapMatchesFullRedraw()
+{
+	char incremental[MAXDUNX][MAXDUNY];
+	memcpy(incremental, dLight, sizeof(dLight));
+
+	memcpy(dLight, dPreLight, sizeof(dLight));
+	for (int i = 0; i < ActiveLightCount; i++) {
+		const int lid = ActiveLights[i];
+		DoLighting(Lights[lid].position.tile, Lights[lid]._lradius, lid);
+	}
+
+	for (int x = 0; x < MAXDUNX; x++) {
+		for (int y = 0; y < MAXDUNY; y++) {
+			ASSERT_EQ(incremental[x][y], dLight[x][y]) << "at " << x << ":" << y;
+		}
+	}
+}
+
+void TestIncrementalLightUpdates(int level)
+{
+	currlevel = level;
+	MakeLightTable();
+	InitLighting();
+	for (int x = 0; x < MAXDUNX; x++) {
+		for (int y = 0; y < MAXDUNY; y++) {
+			dPreLight[x][y] = (x * 7 + y * 3) % 16 == 0 ? 5 : 15;
+		}
+	}
+	memcpy(dLight, dPreLight, sizeof(dLight));
+
+	int lights[8];
+	for (int i = 0; i < 7; i++)
+		lights[i] = AddLight({ 10 + i * 12, 20 + i * 9 }, 1 + i * 2);
+	lights[7] = AddLight({ 0, 0 }, 15);
+	ProcessLightList();
+	CheckLightMapMatchesFullRedraw();
+
+	ChangeLightXY(lights[0], { 12, 21 });
+	ChangeLightXY(lights[0], { 30, 40 });
+	ChangeLightRadius(lights[1], 10);
+	ChangeLightOffset(lights[2], { -3, 5 });
+	ChangeLight(lights[3], { 100, 5 }, 4);
+	ChangeLightXY(lights[7], { MAXDUNX - 1, MAXDUNY - 1 });
+	AddUnLight(lights[4]);
+	ProcessLightList();
+	CheckLightMapMatchesFullRedraw();
+
+	ChangeLightOffset(lights[2], { 4, -6 });
+	AddUnLight(lights[5]);
+	AddLight({ 60, 60 }, 3);
+	ProcessLightList();
+	CheckLightMapMatchesFullRedraw();
+}
+
+} // namespace
+
+TEST(Lighting, IncrementalUpdateMatchesFullRedraw)
+{
+	TestIncrementalLightUpdates(1);
+}
+
+TEST(Lighting, IncrementalUpdateMatchesFullRedrawHellfire)
+{
+	TestIncrementalLightUpdates(21);
+}
+
+namespace {
+
+void InitLightMap()
+{
+	currlevel = 1;
+	MakeLightTable();
+	InitLighting();
+	memset(dPreLight, 15, sizeof(dPreLight));
+	memcpy(dLight, dPreLight, sizeof(dLight));
+	LightStats = {};
+}
+
+/** @brief Calls ProcessLightList() until every light is drawn, checking that no call draws more than the budget. */
+void ProcessAllLights()
+{
+	for (int frame = 0; frame < 100 && UpdateLighting; frame++) {
+		const uint64_t stampedBefore = LightStats.stamped;
+		ProcessLightList();
+		ASSERT_LE(LightStats.stamped - stampedBefore, static_cast<uint64_t>(LightBudget));
+	}
+	ASSERT_FALSE(UpdateLighting);
+	CheckLightMapMatchesFullRedraw();
+}
+
+} // namespace
+
+TEST(Lighting, PoolGrowsPastSavegameLights)
+{
+	InitLightMap();
+	std::vector<int> ids;
+	for (int i = 0; i < 4 * MAXLIGHTS; i++) {
+		ids.push_back(AddLight({ 5 + i % 100, 5 + i / 100 * 20 }, 1 + i % 8));
+		ASSERT_NE(ids.back(), NO_LIGHT);
+	}
+	std::sort(ids.begin(), ids.end());
+	EXPECT_EQ(std::unique(ids.begin(), ids.end()), ids.end());
+	ProcessAllLights();
+
+	// Freed ids are reused lowest first
+	AddUnLight(3);
+	AddUnLight(40);
+	AddUnLight(70);
+	ProcessAllLights();
+	EXPECT_EQ(AddLight({ 50, 50 }, 2), 3);
+	EXPECT_EQ(AddLight({ 50, 50 }, 2), 40);
+}
+
+TEST(Lighting, BudgetDrawsLightsClosestToTheViewFirst)
+{
+	InitLightMap();
+	ViewX = 20;
+	ViewY = 20;
+	LightBudget = 5;
+	std::vector<int> ids;
+	for (int i = 0; i < 30; i++)
+		ids.push_back(AddLight({ 20 + 3 * i, 20 + 2 * i }, 4));
+	ProcessLightList();
+	EXPECT_EQ(LightStats.stamped, 5U);
+	EXPECT_EQ(LightStats.deferred, 25U);
+	for (int i = 0; i < 30; i++)
+		EXPECT_EQ(Lights[ids[i]].undrawn, i >= 5) << "light " << i;
+	ProcessAllLights();
+
+	// Moved lights that are put off must not leave anything behind
+	for (int i = 0; i < 30; i += 2)
+		ChangeLightXY(ids[i], { 90 - 2 * i, 25 + i });
+	ProcessAllLights();
+	for (int i = 1; i < 30; i += 4)
+		AddUnLight(ids[i]);
+	ProcessAllLights();
+
+	// A light that is only put off because a light next to it moved is still partly drawn
+	LightBudget = 1;
+	const int nearLight = AddLight({ 22, 22 }, 6);
+	const int farLight = AddLight({ 30, 22 }, 6);
+	ProcessAllLights();
+	ChangeLightXY(nearLight, { 21, 22 });
+	ProcessLightList();
+	EXPECT_TRUE(UpdateLighting);
+	ChangeLightXY(farLight, { 100, 100 });
+	ProcessAllLights();
+
+	LightBudget = 64;
+}
+
+TEST(Lighting, MultiplayerDrawsEveryLight)
+{
+	InitLightMap();
+	gbIsMultiplayer = true;
+	LightBudget = 5;
+	for (int i = 0; i < 30; i++)
+		AddLight({ 20 + 3 * i, 20 + 2 * i }, 4);
+	ProcessLightList();
+	EXPECT_EQ(LightStats.stamped, 30U);
+	EXPECT_EQ(LightStats.deferred, 0U);
+	EXPECT_FALSE(UpdateLighting);
+	CheckLightMapMatchesFullRedraw();
+
+	gbIsMultiplayer = false;
+	LightBudget = 64;
+}
+
+TEST(Lighting, LightsOnTheSameSpotAreDrawnOnce)
+{
+	InitLightMap();
+	std::vector<int> ids;
+	for (int radius = 2; radius <= 7; radius++)
+		ids.push_back(AddLight({ 40, 40 }, radius));
+	AddLight({ 42, 40 }, 3);
+	ProcessAllLights();
+	EXPECT_EQ(LightStats.stamped, 2U);
+	EXPECT_EQ(LightStats.merged, 5U);
+
+	AddUnLight(ids.back());
+	ProcessAllLights();
+	ChangeLightOffset(ids[0], { 3, 3 });
+	ProcessAllLights();
+}
+
+namespace {
+
+/** @brief DoVision() before it cached its results, casting the rays every time. */
+void DoVisionReference(Point position, int nRadius)
+{
+	const uint8_t radiusAdj[23] = { 0, 0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 4, 3, 2, 2, 2, 1, 1, 1, 0, 0, 0, 0 };
+	const auto reveal = [](int x, int y) {
+		if (dFlags[x][y] != 0)
+			SetAutomapView({ x, y });
+		dFlags[x][y] |= BFLAG_EXPLORED | BFLAG_LIT | BFLAG_VISIBLE;
+	};
+	const auto inBounds = [](int x, int y) {
+		return x >= 0 && x < MAXDUNX && y >= 0 && y < MAXDUNY;
+	};
+
+	reveal(position.x, position.y);
+	// Quadrant signs and the neighbours that let the rays see past diagonal walls
+	const int signs[4][2] = { { 1, 1 }, { -1, -1 }, { 1, -1 }, { -1, 1 } };
+	const int adjacent[4][4] = { { -1, 0, 0, -1 }, { 0, 1, 1, 0 }, { -1, 0, 0, 1 }, { 0, -1, 1, 0 } };
+	for (int v = 0; v < 4; v++) {
+		for (int j = 0; j < 23; j++) {
+			bool blocked = false;
+			for (int k = 0; k < 2 * (nRadius - radiusAdj[j]) && !blocked; k += 2) {
+				const int x = position.x + signs[v][0] * VisionCrawlTable[j][k];
+				const int y = position.y + signs[v][1] * VisionCrawlTable[j][k + 1];
+				const bool diagonal = VisionCrawlTable[j][k] > 0 && VisionCrawlTable[j][k + 1] > 0;
+				const int x1 = x + (diagonal ? adjacent[v][0] : 0);
+				const int y1 = y + (diagonal ? adjacent[v][1] : 0);
+				const int x2 = x + (diagonal ? adjacent[v][2] : 0);
+				const int y2 = y + (diagonal ? adjacent[v][3] : 0);
+				if (!inBounds(x, y))
+					continue;
+				blocked = nBlockTable[dPiece[x][y]];
+				if ((inBounds(x1, y1) && !nBlockTable[dPiece[x1][y1]]) || (inBounds(x2, y2) && !nBlockTable[dPiece[x2][y2]])) {
+					reveal(x, y);
+					if (!blocked && dTransVal[x][y] != 0)
+						TransList[dTransVal[x][y]] = true;
+				}
+			}
+		}
+	}
+}
+
+class VisionTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		std::mt19937 rng(11);
+		nBlockTable = {};
+		for (int piece = 1; piece < 8; piece++)
+			nBlockTable[piece] = piece >= 5;
+		for (int x = 0; x < MAXDUNX; x++) {
+			for (int y = 0; y < MAXDUNY; y++) {
+				dPiece[x][y] = rng() % 8;
+				dTransVal[x][y] = static_cast<int8_t>((x / 8 + y / 8 * 14) % 100);
+				baseFlags_[x][y] = rng() % 4 == 0 ? BFLAG_POPULATED : 0;
+			}
+		}
+		ClearVisionCache();
+	}
+
+	void TearDown() override
+	{
+		ClearVisionCache();
+	}
+
+	void Reset()
+	{
+		memcpy(dFlags, baseFlags_, sizeof(dFlags));
+		memset(TransList, 0, sizeof(TransList));
+		memset(AutomapView, 0, sizeof(AutomapView));
+	}
+
+	/** @brief Checks DoVision() against the reference, twice so that the second call comes from the cache. */
+	void ExpectVisionMatchesReference(Point position, int radius)
+	{
+		Reset();
+		DoVisionReference(position, radius);
+		int8_t expectedFlags[MAXDUNX][MAXDUNY];
+		bool expectedTrans[256];
+		bool expectedAutomap[DMAXX][DMAXY];
+		memcpy(expectedFlags, dFlags, sizeof(dFlags));
+		memcpy(expectedTrans, TransList, sizeof(TransList));
+		memcpy(expectedAutomap, AutomapView, sizeof(AutomapView));
+
+		for (int pass = 0; pass < 2; pass++) {
+			Reset();
+			DoVision(position, radius, true, true);
+			ASSERT_EQ(memcmp(expectedFlags, dFlags, sizeof(dFlags)), 0) << "flags at " << position.x << ":" << position.y << " radius " << radius << " pass " << pass;
+			ASSERT_EQ(memcmp(expectedTrans, TransList, sizeof(TransList)), 0) << "rooms at " << position.x << ":" << position.y << " radius " << radius << " pass " << pass;
+			ASSERT_EQ(memcmp(expectedAutomap, AutomapView, sizeof(AutomapView)), 0) << "automap at " << position.x << ":" << position.y << " radius " << radius << " pass " << pass;
+		}
+	}
+
+	int8_t baseFlags_[MAXDUNX][MAXDUNY];
+};
+
+TEST_F(VisionTest, CachedFieldsMatchRayCasting)
+{
+	std::mt19937 rng(12);
+	for (int i = 0; i < 200; i++) {
+		const Point position { static_cast<int>(rng() % MAXDUNX), static_cast<int>(rng() % MAXDUNY) };
+		ExpectVisionMatchesReference(position, 1 + rng() % 15);
+		if (HasFatalFailure())
+			return;
+	}
+	for (const Point corner : { Point { 0, 0 }, Point { MAXDUNX - 1, 0 }, Point { 0, MAXDUNY - 1 }, Point { MAXDUNX - 1, MAXDUNY - 1 } })
+		ExpectVisionMatchesReference(corner, 15);
+}
+
+TEST_F(VisionTest, InvalidatedByChangedTiles)
+{
+	const Point position { 50, 50 };
+	ExpectVisionMatchesReference(position, 10);
+
+	// Open and close "doors" around the vision source
+	std::mt19937 rng(13);
+	for (int i = 0; i < 50; i++) {
+		const Point tile { position.x - 12 + static_cast<int>(rng() % 25), position.y - 12 + static_cast<int>(rng() % 25) };
+		dPiece[tile.x][tile.y] = nBlockTable[dPiece[tile.x][tile.y]] ? 1 : 7;
+		InvalidateVision(tile);
+		ExpectVisionMatchesReference(position, 10);
+		if (HasFatalFailure())
+			return;
+	}
+}
+
+} // namespace
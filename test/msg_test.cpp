@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+
+#include "msg.h"
+
+namespace devilution {
+namespace {
+
+/** @brief A level delta with a few entries of every kind used, like delta_init() leaves the others. */
+std::unique_ptr<DLevel> MakeLevel()
+{
+	auto level = std::make_unique<DLevel>();
+	memset(level.get(), 0xFF, sizeof(DLevel));
+	for (int i : { 0, 5, MAXITEMS - 1 }) {
+		TCmdPItem &item = level->item[i];
+		memset(&item, 0, sizeof(item));
+		item.bCmd = CMD_ACK_PLRINFO;
+		item.x = 10 + i;
+		item.y = 20;
+		item.dwSeed = 0x1234 * (i + 1);
+	}
+	level->object[3].bCmd = CMD_OPENDOOR;
+	level->object[MAXOBJECTS - 1].bCmd = CMD_BREAKOBJ;
+	for (int i : { 0, 42, MAXMONSTERS - 1 }) {
+		DMonsterStr &monster = level->monster[i];
+		monster._mx = 30;
+		monster._my = i % 100;
+		monster._mdir = DIR_SW;
+		monster._menemy = 0;
+		monster._mactive = 0;
+		monster._mhitpoints = 0;
+	}
+	return level;
+}
+
+TEST(Msg, DeltaLevelRoundTrip)
+{
+	std::unique_ptr<DLevel> level = MakeLevel();
+	std::unique_ptr<byte[]> buffer { new byte[MaxDeltaLevelSize] };
+	const byte *end = DeltaExportLevel(buffer.get(), *level);
+	// Format byte, three counts and the used entries after their index
+	EXPECT_EQ(end - buffer.get(), 1 + 3 + 3 * (1 + sizeof(TCmdPItem)) + 2 * (1 + sizeof(DObjectStr)) + 3 * (1 + sizeof(DMonsterStr)));
+
+	auto imported = std::make_unique<DLevel>();
+	memset(imported.get(), 0, sizeof(DLevel));
+	DeltaImportLevel(buffer.get(), end, *imported);
+	EXPECT_EQ(memcmp(imported.get(), level.get(), sizeof(DLevel)), 0);
+}
+
+TEST(Msg, DeltaLevelFull)
+{
+	auto level = std::make_unique<DLevel>();
+	memset(level.get(), 0, sizeof(DLevel));
+	for (DMonsterStr &monster : level->monster)
+		monster._mx = 1;
+	std::unique_ptr<byte[]> buffer { new byte[MaxDeltaLevelSize] };
+	const byte *end = DeltaExportLevel(buffer.get(), *level);
+	EXPECT_EQ(static_cast<size_t>(end - buffer.get()), MaxDeltaLevelSize);
+
+	auto imported = std::make_unique<DLevel>();
+	DeltaImportLevel(buffer.get(), end, *imported);
+	EXPECT_EQ(memcmp(imported.get(), level.get(), sizeof(DLevel)), 0);
+}
+
+TEST(Msg, DeltaLevelTruncated)
+{
+	std::unique_ptr<DLevel> level = MakeLevel();
+	std::unique_ptr<byte[]> buffer { new byte[MaxDeltaLevelSize] };
+	const byte *end = DeltaExportLevel(buffer.get(), *level);
+
+	DLevel imported;
+	EXPECT_EXIT(DeltaImportLevel(buffer.get(), end - 1, imported), ::testing::ExitedWithCode(1), "Truncated level delta");
+	// Cut right after the item entries, before the object count
+	EXPECT_EXIT(DeltaImportLevel(buffer.get(), buffer.get() + 2 + 3 * (1 + sizeof(TCmdPItem)), imported), ::testing::ExitedWithCode(1), "Truncated level delta");
+	EXPECT_EXIT(DeltaImportLevel(buffer.get(), buffer.get(), imported), ::testing::ExitedWithCode(1), "Truncated level delta");
+}
+
+TEST(Msg, DeltaLevelOverCounted)
+{
+	std::unique_ptr<DLevel> level = MakeLevel();
+	std::unique_ptr<byte[]> buffer { new byte[MaxDeltaLevelSize] };
+	const byte *end = DeltaExportLevel(buffer.get(), *level);
+
+	DLevel imported;
+	// More items than a level has
+	buffer[1] = static_cast<byte>(MAXITEMS + 1);
+	EXPECT_EXIT(DeltaImportLevel(buffer.get(), end, imported), ::testing::ExitedWithCode(1), "Invalid level delta entry count");
+	// More items than were sent, the entries run into the end of the data
+	buffer[1] = static_cast<byte>(MAXITEMS);
+	EXPECT_EXIT(DeltaImportLevel(buffer.get(), end, imported), ::testing::ExitedWithCode(1), "Truncated level delta");
+}
+
+} // namespace
+} // namespace devilution
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "engine/palette_blend.hpp"
+
+namespace devilution {
+namespace {
+
+struct SkipRange {
+	int from;
+	int to;
+};
+
+constexpr SkipRange SkipRanges[] = { { -1, -1 }, { 1, 31 }, { 1, 15 } };
+
+/** @brief Random palette, optionally squeezed into a small part of the color cube to produce many ties. */
+void GeneratePalette(std::mt19937 &rng, SDL_Color *palette, int range)
+{
+	std::uniform_int_distribution<int> dist(0, range - 1);
+	for (int i = 0; i < 256; i++) {
+		palette[i].r = dist(rng);
+		palette[i].g = dist(rng);
+		palette[i].b = dist(rng);
+	}
+}
+
+TEST(PaletteBlend, GridMatchesLinearSearch)
+{
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<int> channel(0, 255);
+	SDL_Color palette[256];
+
+	for (int range : { 256, 64, 4 }) {
+		for (const SkipRange &skip : SkipRanges) {
+			GeneratePalette(rng, palette, range);
+			PaletteColorGrid grid(palette, skip.from, skip.to);
+			for (int i = 0; i < 20000; i++) {
+				SDL_Color color;
+				color.r = channel(rng);
+				color.g = channel(rng);
+				color.b = channel(rng);
+				ASSERT_EQ(grid.FindBestMatch(color), FindBestMatchForColorLinear(palette, color, skip.from, skip.to))
+				    << "range " << range << " skip " << skip.from << "-" << skip.to
+				    << " color " << (int)color.r << "," << (int)color.g << "," << (int)color.b;
+			}
+		}
+	}
+}
+
+TEST(PaletteBlend, LookupTableMatchesLinearSearch)
+{
+	std::mt19937 rng(2);
+	SDL_Color palette[256];
+	static std::uint8_t table[256][256];
+
+	for (const SkipRange &skip : SkipRanges) {
+		GeneratePalette(rng, palette, 256);
+		GenerateBlendedLookupTable(palette, skip.from, skip.to, table);
+		for (int i = 0; i < 256; i++) {
+			for (int j = 0; j < 256; j++) {
+				if (i == j) {
+					ASSERT_EQ(table[i][j], j);
+					continue;
+				}
+				SDL_Color blendedColor;
+				blendedColor.r = (palette[i].r + palette[j].r) / 2;
+				blendedColor.g = (palette[i].g + palette[j].g) / 2;
+				blendedColor.b = (palette[i].b + palette[j].b) / 2;
+				ASSERT_EQ(table[i][j], FindBestMatchForColorLinear(palette, blendedColor, skip.from, skip.to)) << i << "," << j;
+			}
+		}
+	}
+}
+
+} // namespace
+} // namespace devilution
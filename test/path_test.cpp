@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "gendung.h"
+#include "path.h"
+
+namespace devilution {
+namespace {
+
+/** Walls for the tests, indexed like dPiece. */
+bool Walls[MAXDUNX][MAXDUNY];
+
+bool PosOkWall(int /*arg*/, Point position)
+{
+	return !Walls[position.x][position.y];
+}
+
+/** Displacement of every step number FindPath() writes. */
+const Displacement StepDisplacements[9] = {
+	{ 0, 0 }, { 0, -1 }, { -1, 0 }, { 1, 0 }, { 0, 1 }, { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 }
+};
+
+void ClearMap()
+{
+	memset(Walls, 0, sizeof(Walls));
+	memset(dPiece, 0, sizeof(dPiece));
+	nSolidTable[0] = false;
+}
+
+/** @brief Replays a path and checks that it only steps on walkable tiles and ends at the destination. */
+void ExpectValidPath(Point start, Point destination, const int8_t *path, int steps)
+{
+	Point position = start;
+	for (int i = 0; i < steps; i++) {
+		ASSERT_GE(path[i], 1);
+		ASSERT_LE(path[i], 8);
+		position += StepDisplacements[path[i]];
+		if (i != steps - 1)
+			EXPECT_FALSE(Walls[position.x][position.y]) << "step " << i;
+	}
+	EXPECT_EQ(position, destination);
+}
+
+TEST(PathTest, StraightAndDiagonal)
+{
+	ClearMap();
+	int8_t path[MAX_PATH_LENGTH];
+
+	ASSERT_EQ(FindPath(PosOkWall, 0, 10, 10, 15, 10, path), 5);
+	for (int i = 0; i < 5; i++)
+		EXPECT_EQ(path[i], 3);
+
+	ASSERT_EQ(FindPath(PosOkWall, 0, 10, 10, 14, 14, path), 4);
+	for (int i = 0; i < 4; i++)
+		EXPECT_EQ(path[i], 7);
+
+	EXPECT_EQ(FindPath(PosOkWall, 0, 10, 10, 10, 10, path), 0);
+}
+
+TEST(PathTest, AroundWall)
+{
+	ClearMap();
+	for (int y = 20; y < 40; y++)
+		Walls[30][y] = true;
+
+	int8_t path[MAX_PATH_LENGTH];
+	const int steps = FindPath(PosOkWall, 0, 28, 30, 32, 30, path);
+	ASSERT_GT(steps, 4);
+	ExpectValidPath({ 28, 30 }, { 32, 30 }, path, steps);
+}
+
+TEST(PathTest, LongDetour)
+{
+	ClearMap();
+	// A pocket open to the north that the straight line to the destination runs into
+	for (int x = 40; x <= 50; x++)
+		Walls[x][60] = true;
+	for (int y = 52; y <= 60; y++) {
+		Walls[40][y] = true;
+		Walls[50][y] = true;
+	}
+
+	int8_t path[MAX_PATH_LENGTH];
+	const int steps = FindPath(PosOkWall, 0, 45, 58, 45, 63, path);
+	ASSERT_GT(steps, 0);
+	ExpectValidPath({ 45, 58 }, { 45, 63 }, path, steps);
+}
+
+TEST(PathTest, NoCornerCutting)
+{
+	ClearMap();
+	dPiece[21][20] = 1;
+	nSolidTable[1] = true;
+	Walls[21][20] = true;
+
+	int8_t path[MAX_PATH_LENGTH];
+	const int steps = FindPath(PosOkWall, 0, 20, 20, 21, 21, path);
+	ASSERT_EQ(steps, 2);
+	ExpectValidPath({ 20, 20 }, { 21, 21 }, path, steps);
+	nSolidTable[1] = false;
+}
+
+TEST(PathTest, BlockedDestination)
+{
+	ClearMap();
+	Walls[25][25] = true;
+
+	// The destination may be occupied as long as it is next to a walkable tile
+	int8_t path[MAX_PATH_LENGTH];
+	const int steps = FindPath(PosOkWall, 0, 20, 25, 25, 25, path);
+	ASSERT_EQ(steps, 5);
+	ExpectValidPath({ 20, 25 }, { 25, 25 }, path, steps);
+
+	// Fully enclosed destination
+	for (auto dir : PathDirs)
+		Walls[35 + dir.deltaX][35 + dir.deltaY] = true;
+	EXPECT_EQ(FindPath(PosOkWall, 0, 30, 30, 35, 35, path), 0);
+}
+
+TEST(PathTest, MaximumLength)
+{
+	ClearMap();
+	int8_t path[MAX_PATH_LENGTH];
+	EXPECT_EQ(FindPath(PosOkWall, 0, 10, 10, 34, 10, path), 24);
+	EXPECT_EQ(FindPath(PosOkWall, 0, 10, 10, 35, 10, path), 0);
+}
+
+int PosOkCalls;
+
+bool PosOkWallCounted(int arg, Point position)
+{
+	PosOkCalls++;
+	return PosOkWall(arg, position);
+}
+
+TEST(PathTest, UnreachableGivesUp)
+{
+	ClearMap();
+	for (int i = -2; i <= 2; i++) {
+		Walls[60 + i][58] = true;
+		Walls[60 + i][62] = true;
+		Walls[58][60 + i] = true;
+		Walls[62][60 + i] = true;
+	}
+
+	// The search stops after a few hundred tiles instead of exploring the whole area around the walls
+	PosOkCalls = 0;
+	int8_t path[MAX_PATH_LENGTH];
+	EXPECT_EQ(FindPath(PosOkWallCounted, 0, 50, 60, 60, 60, path), 0);
+	EXPECT_LT(PosOkCalls, 8 * 300);
+}
+
+} // namespace
+} // namespace devilution
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "engine/render/present.hpp"
+
+namespace devilution {
+namespace {
+
+constexpr int Pitch = 96;
+constexpr int Rows = 40;
+
+std::vector<std::uint8_t> RandomBuffer(std::mt19937 &rng, size_t size)
+{
+	std::vector<std::uint8_t> buffer(size);
+	for (std::uint8_t &pixel : buffer)
+		pixel = static_cast<std::uint8_t>(rng());
+	return buffer;
+}
+
+/** @brief The scalar loop Zoom() in scrollrt.cpp used before ZoomBuffer(), for even heights. */
+void ZoomLegacy(std::uint8_t *buffer, int pitch, int viewportOffsetX, int viewportWidth, int height)
+{
+	const int srcWidth = (viewportWidth + 1) / 2;
+	const int doubleableWidth = viewportWidth / 2;
+	const int srcHeight = (height + 1) / 2;
+	const int doubleableHeight = height / 2;
+
+	std::uint8_t *src = &buffer[(srcHeight - 1) * pitch + srcWidth - 1];
+	std::uint8_t *dst = &buffer[(height - 1) * pitch + viewportOffsetX + viewportWidth - 1];
+	const bool oddViewportWidth = (viewportWidth % 2) == 1;
+
+	for (int hgt = 0; hgt < doubleableHeight; hgt++) {
+		for (int i = 0; i < doubleableWidth; i++) {
+			*dst-- = *src;
+			*dst-- = *src;
+			--src;
+		}
+		if (oddViewportWidth) {
+			*dst-- = *src;
+			--src;
+		}
+		src -= (pitch - srcWidth);
+		memcpy(dst - pitch + 1, dst + 1, viewportWidth);
+		dst -= 2 * pitch - viewportWidth;
+	}
+}
+
+/** @brief Source coordinate of an output coordinate, the first one is not doubled if the size is odd. */
+int SourceCoordinate(int coordinate, int size)
+{
+	const int extra = size % 2;
+	if (coordinate < extra)
+		return 0;
+	return (coordinate - extra) / 2 + extra;
+}
+
+TEST(Present, DoublePixels)
+{
+	std::mt19937 rng(1);
+	for (int width = 0; width <= 70; width++) {
+		const std::vector<std::uint8_t> src = RandomBuffer(rng, width);
+		std::vector<std::uint8_t> dst(2 * width + 1, 0xAB);
+		DoublePixels(src.data(), dst.data(), width);
+		for (int i = 0; i < width; i++) {
+			ASSERT_EQ(dst[2 * i], src[i]) << "width " << width;
+			ASSERT_EQ(dst[2 * i + 1], src[i]) << "width " << width;
+		}
+		EXPECT_EQ(dst[2 * width], 0xAB);
+
+		// In place, with the output starting at or after the input
+		for (int offset = 0; offset <= 2; offset++) {
+			std::vector<std::uint8_t> buffer(2 * width + offset);
+			std::copy(src.begin(), src.end(), buffer.begin());
+			DoublePixels(buffer.data(), buffer.data() + offset, width);
+			for (int i = 0; i < width; i++) {
+				ASSERT_EQ(buffer[offset + 2 * i], src[i]) << "width " << width << " offset " << offset;
+				ASSERT_EQ(buffer[offset + 2 * i + 1], src[i]) << "width " << width << " offset " << offset;
+			}
+		}
+	}
+}
+
+TEST(Present, ZoomMatchesLegacy)
+{
+	std::mt19937 rng(2);
+	for (int offsetX : { 0, 5, 32 }) {
+		for (int width = 1; width + offsetX <= Pitch; width += 3) {
+			for (int height = 2; height <= Rows; height += 2) {
+				std::vector<std::uint8_t> expected = RandomBuffer(rng, Pitch * Rows);
+				std::vector<std::uint8_t> actual = expected;
+				ZoomLegacy(expected.data(), Pitch, offsetX, width, height);
+				ZoomBuffer(actual.data(), Pitch, offsetX, width, height);
+				ASSERT_EQ(actual, expected) << "offset " << offsetX << " width " << width << " height " << height;
+			}
+		}
+	}
+}
+
+TEST(Present, ZoomOddHeight)
+{
+	std::mt19937 rng(3);
+	for (int offsetX : { 0, 7 }) {
+		for (int width : { 1, 2, 33, 64, 81 }) {
+			for (int height : { 1, 3, 17, 39 }) {
+				const std::vector<std::uint8_t> original = RandomBuffer(rng, Pitch * Rows);
+				std::vector<std::uint8_t> buffer = original;
+				ZoomBuffer(buffer.data(), Pitch, offsetX, width, height);
+				for (int y = 0; y < Rows; y++) {
+					for (int x = 0; x < Pitch; x++) {
+						std::uint8_t expected = original[y * Pitch + x];
+						if (y < height && x >= offsetX && x < offsetX + width)
+							expected = original[SourceCoordinate(y, height) * Pitch + SourceCoordinate(x - offsetX, width)];
+						ASSERT_EQ(buffer[y * Pitch + x], expected) << "x " << x << " y " << y << " width " << width << " height " << height;
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST(Present, ExpandPalettedPixels)
+{
+	std::mt19937 rng(4);
+	std::uint32_t lut[256];
+	for (std::uint32_t &color : lut)
+		color = rng();
+
+	for (int count = 0; count <= 37; count++) {
+		const std::vector<std::uint8_t> src = RandomBuffer(rng, count);
+		std::vector<std::uint32_t> dst(count + 1, 0xDEADBEEF);
+		ExpandPalettedPixels(src.data(), dst.data(), count, lut);
+		for (int i = 0; i < count; i++)
+			ASSERT_EQ(dst[i], lut[src[i]]);
+		EXPECT_EQ(dst[count], 0xDEADBEEF);
+	}
+}
+
+} // namespace
+} // namespace devilution
@@ -1,6 +1,26 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "cursor.h"
+#include "dead.h"
 #include "diablo.h"
+#include "engine/cel_sprite.hpp"
+#include "engine/surface.hpp"
+#include "gendung.h"
+#include "items.h"
+#include "lighting.h"
+#include "missiles.h"
+#include "monster.h"
+#include "objects.h"
+#include "player.h"
 #include "scrollrt.h"
 #include "utils/ui_fwd.h"
 
@@ -162,3 +182,300 @@ TEST(Scrool_rt, calc_tiles_covered_by_panel_960_zoom)
 	zoomflag = false;
 	EXPECT_EQ(RowsCoveredByPanel(), 2);
 }
+
+// DrawTileContent
+
+namespace {
+
+constexpr int SpriteWidth = 32;
+constexpr int SpriteHeight = 40;
+constexpr int ViewWidth = 320;
+constexpr int ViewHeight = 256;
+/** Tile that the walk of DrawTileContent() starts at, in the top left corner of the view */
+constexpr Point ViewTile { 20, 20 };
+
+/** @brief Appends a frame table for a single frame of the given size and returns the offset of the frame. */
+std::size_t AppendFrameTable(std::vector<byte> &data, std::size_t frameSize)
+{
+	constexpr std::uint32_t FrameTableSize = 3 * sizeof(std::uint32_t);
+	const std::uint32_t frameTable[] = { 1, FrameTableSize, static_cast<std::uint32_t>(FrameTableSize + frameSize) };
+	for (const std::uint32_t entry : frameTable) {
+		for (int b = 0; b < 4; b++)
+			data.push_back(static_cast<byte>((entry >> (8 * b)) & 0xFF));
+	}
+	return data.size();
+}
+
+/** @brief Encodes a random frame with transparent gaps, as CEL or as CL2. */
+std::vector<byte> MakeSprite(std::mt19937 &rng, bool cl2)
+{
+	std::vector<std::uint8_t> rle;
+	for (int y = 0; y < SpriteHeight; y++) {
+		for (int x = 0; x < SpriteWidth;) {
+			const int length = std::min<int>(1 + rng() % 12, SpriteWidth - x);
+			if (rng() % 3 == 0) {
+				rle.push_back(static_cast<std::uint8_t>(cl2 ? length : 256 - length));
+			} else {
+				rle.push_back(static_cast<std::uint8_t>(cl2 ? 256 - length : length));
+				for (int i = 0; i < length; i++)
+					rle.push_back(static_cast<std::uint8_t>(1 + rng() % 255));
+			}
+			x += length;
+		}
+	}
+
+	// The frame starts with a header, only its first entry is used when drawing
+	constexpr std::size_t FrameHeaderSize = 10;
+	std::vector<byte> data;
+	AppendFrameTable(data, FrameHeaderSize + rle.size());
+	data.push_back(static_cast<byte>(FrameHeaderSize));
+	data.resize(data.size() + FrameHeaderSize - 1);
+	for (const std::uint8_t value : rle)
+		data.push_back(static_cast<byte>(value));
+	return data;
+}
+
+/** @brief A scene with every kind of sprite DrawDungeon() draws, drawn with and without CollectDrawables(). */
+class DrawTileContentTest : public ::testing::Test {
+protected:
+	void SetUp() override
+	{
+		std::mt19937 rng(3);
+		for (std::uint8_t &entry : LightTables)
+			entry = static_cast<std::uint8_t>(rng());
+		InitLightMax();
+
+		// A level CEL with a single square frame for the walls
+		std::vector<byte> level;
+		AppendFrameTable(level, TILE_WIDTH / 2 * TILE_HEIGHT);
+		for (int i = 0; i < TILE_WIDTH / 2 * TILE_HEIGHT; i++)
+			level.push_back(static_cast<byte>(rng()));
+		const std::size_t levelSize = level.size();
+		std::unique_ptr<byte[]> levelData { new byte[levelSize] };
+		std::copy(level.begin(), level.end(), levelData.get());
+		pDungeonCels = AssetView(std::move(levelData), levelSize);
+
+		for (int i = 0; i < 4; i++)
+			cels_.push_back(MakeSprite(rng, false));
+		for (int i = 0; i < 8; i++)
+			cl2s_.push_back(MakeSprite(rng, true));
+		for (const auto &data : cels_)
+			sprites_.emplace_back(data.data(), SpriteWidth);
+		for (const auto &data : cl2s_)
+			sprites_.emplace_back(data.data(), SpriteWidth);
+		for (int x = 0; x < MAXDUNX; x++) {
+			for (int y = 0; y < MAXDUNY; y++)
+				lights_[x][y] = static_cast<char>(rng() % LightsMax);
+		}
+
+		leveltype = DTYPE_CATHEDRAL;
+		currlevel = 1;
+		MicroTileLen = 10;
+		gnScreenWidth = ViewWidth;
+		MyPlayerId = 0;
+		pcursplr = -1;
+		pcursmonst = -1;
+		pcursobj = -1;
+		pcursitem = -1;
+		BuildScene();
+	}
+
+	void TearDown() override
+	{
+		ClearScene();
+		nSolidTable[WallPiece] = false;
+		pDungeonCels = {};
+		leveltype = DTYPE_TOWN;
+		currlevel = 0;
+		LightTableIndex = 0;
+	}
+
+	static void ClearScene()
+	{
+		memset(dPiece, 0, sizeof(dPiece));
+		memset(dpiece_defs_map_2, 0, sizeof(dpiece_defs_map_2));
+		memset(dFlags, 0, sizeof(dFlags));
+		memset(dLight, 0, sizeof(dLight));
+		memset(dDead, 0, sizeof(dDead));
+		memset(dObject, 0, sizeof(dObject));
+		memset(dItem, 0, sizeof(dItem));
+		memset(dPlayer, 0, sizeof(dPlayer));
+		memset(dMonster, 0, sizeof(dMonster));
+		for (int i = 0; i < 3; i++) {
+			Players[i] = {};
+			Monsters[i] = {};
+			Objects[i] = {};
+			Items[i] = {};
+		}
+		for (int i = 0; i < 4; i++)
+			Missiles[i] = {};
+		Dead[0] = {};
+		Dead[1] = {};
+		ActiveMissileCount = 0;
+		MissilePreFlag = false;
+	}
+
+	void BuildScene()
+	{
+		ClearScene();
+		for (int x = 0; x < MAXDUNX; x++) {
+			for (int y = 0; y < MAXDUNY; y++) {
+				dPiece[x][y] = FloorPiece;
+				dFlags[x][y] = BFLAG_LIT;
+				dLight[x][y] = lights_[x][y];
+			}
+		}
+		// A low wall along the x axis, with a tile behind it that is drawn before the wall
+		nSolidTable[WallPiece] = true;
+		for (int x = 28; x < 32; x++) {
+			dPiece[x][22] = WallPiece;
+			dpiece_defs_map_2[x][22].mt[0] = 1;
+			dpiece_defs_map_2[x][22].mt[1] = 1;
+		}
+
+		// Dead monsters, one of them with a translation
+		for (int i = 0; i < 2; i++) {
+			Dead[i].data.fill(cl2s_[i].data());
+			Dead[i].width = SpriteWidth;
+			Dead[i].frame = 1;
+		}
+		Dead[1].translationPaletteIndex = 1;
+		dDead[25][21] = 1;
+		dDead[27][21] = 2 | (1 << 5);
+
+		// Objects before and after the walkers, and one drawn from a neighbouring tile
+		for (int i = 0; i < 3; i++) {
+			Objects[i]._oAnimData = const_cast<byte *>(cels_[i].data());
+			Objects[i]._oAnimWidth = SpriteWidth;
+			Objects[i]._oAnimFrame = 1;
+			Objects[i]._oLight = i != 2;
+		}
+		Objects[0]._oPreFlag = true;
+		dObject[25][21] = 1;
+		dObject[27][21] = 2;
+		Objects[2].position = { 26, 22 };
+		dObject[27][22] = -3;
+
+		// Items before and after the walkers
+		for (int i = 0; i < 2; i++) {
+			Items[i].AnimInfo.pCelSprite = &sprites_[i + 2];
+			Items[i].AnimInfo.CurrentFrame = 1;
+		}
+		Items[1]._iPostDraw = true;
+		dItem[25][21] = 1;
+		dItem[27][21] = 2;
+
+		// The own player, a player walking between two tiles and a dead player
+		for (int i = 0; i < 3; i++) {
+			Players[i].plractive = true;
+			Players[i].plrlevel = currlevel;
+			Players[i]._pHitPoints = 64;
+			Players[i].AnimInfo.pCelSprite = &sprites_[cels_.size() + 2 + i];
+			Players[i].AnimInfo.CurrentFrame = 1;
+		}
+		Players[0].position.tile = { 25, 21 };
+		dPlayer[25][21] = 1;
+		Players[1].position.tile = { 26, 23 };
+		Players[1].position.offset = { -16, 8 };
+		dPlayer[26][23] = -2;
+		dFlags[26][24] |= BFLAG_PLAYERLR;
+		Players[2]._pHitPoints = 0;
+		Players[2].position.tile = { 24, 22 };
+		dFlags[24][22] |= BFLAG_DEAD_PLAYER;
+
+		// A monster, one walking between two tiles and one behind the wall
+		for (int i = 0; i < 3; i++) {
+			Monsters[i].MType = &monsterType_;
+			Monsters[i].AnimInfo.pCelSprite = &sprites_[cels_.size() + 5 + i % 2];
+			Monsters[i].AnimInfo.CurrentFrame = 1;
+		}
+		dMonster[25][21] = 1;
+		Monsters[1].position.offset = { 16, 8 };
+		dMonster[27][24] = -2;
+		dFlags[27][25] |= BFLAG_MONSTLR;
+		dMonster[30][21] = 3;
+
+		// Missiles before and after the other sprites of their tile
+		for (int i = 0; i < 4; i++) {
+			Missiles[i]._miAnimData = cl2s_[6 + i % 2].data();
+			Missiles[i]._miAnimWidth = SpriteWidth;
+			Missiles[i]._miAnimFrame = 1;
+			Missiles[i]._miDrawFlag = true;
+			Missiles[i].position.tileForRendering = { 25, 21 };
+			ActiveMissiles[i] = 3 - i;
+		}
+		ActiveMissileCount = 4;
+		MissilePreFlag = true;
+		Missiles[0]._miPreFlag = true;
+		Missiles[1].position.offsetForRendering = { 12, -6 };
+		Missiles[1]._miLightFlag = true;
+		Missiles[2].position.tileForRendering = { 26, 22 };
+		Missiles[2]._miUniqTrans = 1;
+		Missiles[3].position.offsetForRendering = { 20, -24 };
+	}
+
+	std::vector<std::uint8_t> Render(bool collect)
+	{
+		constexpr int Rows = ViewHeight / (TILE_HEIGHT / 2);
+		constexpr int Columns = ViewWidth / TILE_WIDTH;
+
+		std::vector<std::uint8_t> buffer(ViewWidth * ViewHeight, 0);
+		SDL_Surface surface {};
+		surface.w = ViewWidth;
+		surface.h = ViewHeight;
+		surface.pitch = ViewWidth;
+		surface.pixels = buffer.data();
+
+		if (collect)
+			CollectDrawables(ViewTile.x, ViewTile.y, Rows, Columns);
+		else
+			ClearDrawables();
+		DrawTileContent(Surface(&surface), ViewTile.x, ViewTile.y, 0, 0, Rows, Columns);
+		return buffer;
+	}
+
+	static constexpr int FloorPiece = 1;
+	static constexpr int WallPiece = 2;
+
+	std::vector<std::vector<byte>> cels_;
+	std::vector<std::vector<byte>> cl2s_;
+	std::deque<CelSprite> sprites_;
+	char lights_[MAXDUNX][MAXDUNY];
+	CMonster monsterType_ {};
+};
+
+TEST_F(DrawTileContentTest, CollectedMatchesDungeonMaps)
+{
+	const std::vector<std::uint8_t> scene = Render(true);
+	EXPECT_EQ(scene, Render(false));
+
+	// Every sprite shows up, and the frame stays the same without it
+	const std::pair<const char *, std::function<void()>> removals[] = {
+		{ "pre missile", [] { Missiles[0]._miDrawFlag = false; } },
+		{ "dead", [] { dDead[25][21] = 0; } },
+		{ "translated dead", [] { dDead[27][21] = 0; } },
+		{ "pre object", [] { dObject[25][21] = 0; } },
+		{ "pre item", [] { dItem[25][21] = 0; } },
+		{ "walking player", [] { dFlags[26][24] &= ~BFLAG_PLAYERLR; } },
+		{ "walking monster", [] { dFlags[27][25] &= ~BFLAG_MONSTLR; } },
+		{ "dead player", [] { Players[2].plractive = false; } },
+		{ "player", [] { dPlayer[25][21] = 0; } },
+		{ "monster", [] { dMonster[25][21] = 0; } },
+		{ "monster behind the wall", [] { dMonster[30][21] = 0; } },
+		{ "missile", [] { Missiles[1]._miDrawFlag = false; } },
+		{ "missile with translation", [] { Missiles[2]._miDrawFlag = false; } },
+		{ "second missile on a tile", [] { Missiles[3]._miDrawFlag = false; } },
+		{ "object", [] { dObject[27][21] = 0; } },
+		{ "object from a neighbouring tile", [] { dObject[27][22] = 0; } },
+		{ "item", [] { dItem[27][21] = 0; } },
+	};
+	for (const auto &removal : removals) {
+		BuildScene();
+		removal.second();
+		const std::vector<std::uint8_t> collected = Render(true);
+		EXPECT_NE(collected, scene) << "without " << removal.first;
+		EXPECT_EQ(collected, Render(false)) << "without " << removal.first;
+	}
+}
+
+} // namespace
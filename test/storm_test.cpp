@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "init.h"
+#include "mpqapi.h"
+#include "storm/storm.h"
+#include "utils/file_util.h"
+
+namespace devilution {
+namespace {
+
+constexpr int FileCount = 48;
+
+std::string GetFileName(int index)
+{
+	return "stress\\file" + std::to_string(index) + ".bin";
+}
+
+/** @brief Contents that compress differently per file, some spanning several MPQ sectors. */
+std::vector<byte> GetFileContents(int index)
+{
+	std::vector<byte> data(200 + index * 997);
+	std::minstd_rand rng(index + 1);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = static_cast<byte>(index % 3 == 0 ? rng() : (i / (index + 1)) & 0xFF);
+	return data;
+}
+
+/**
+ * @brief Opens and reads random files of the test archive in random chunk sizes.
+ * @return Number of files that could not be read or had the wrong contents
+ */
+int ReadRandomFiles(unsigned seed, bool streamed)
+{
+	std::mt19937 rng(seed);
+	int failures = 0;
+
+	for (int n = 0; n < 200; n++) {
+		const int index = rng() % FileCount;
+		const std::string name = GetFileName(index);
+		const std::vector<byte> expected = GetFileContents(index);
+
+		HANDLE file;
+		if (!(streamed ? SFileOpenStreamedFile(name.c_str(), &file) : SFileOpenFile(name.c_str(), &file))) {
+			failures++;
+			continue;
+		}
+
+		std::vector<byte> contents(SFileGetFileSize(file));
+		size_t offset = 0;
+		while (offset < contents.size()) {
+			const size_t chunk = std::min<size_t>(1 + rng() % 6000, contents.size() - offset);
+			if (!SFileReadFileThreadSafe(file, &contents[offset], chunk))
+				break;
+			offset += chunk;
+		}
+		SFileCloseFileThreadSafe(file);
+
+		if (contents != expected)
+			failures++;
+	}
+
+	return failures;
+}
+
+TEST(Storm, ConcurrentReads)
+{
+	const char *archivePath = "Test_Storm_ConcurrentReads.mpq";
+	RemoveFile(archivePath);
+
+	ASSERT_TRUE(OpenMPQ(archivePath));
+	for (int i = 0; i < FileCount; i++) {
+		const std::vector<byte> data = GetFileContents(i);
+		ASSERT_TRUE(mpqapi_write_file(GetFileName(i).c_str(), data.data(), data.size()));
+	}
+	ASSERT_TRUE(mpqapi_flush_and_close(true));
+
+	HANDLE archive;
+	ASSERT_TRUE(SFileOpenSharedArchive(archivePath, &archive));
+	diabdat_mpq = archive;
+
+	std::atomic<int> failures { 0 };
+	std::vector<std::thread> threads;
+	for (unsigned i = 0; i < 4; i++) {
+		threads.emplace_back([i, &failures]() {
+			failures += ReadRandomFiles(i + 1, /*streamed=*/i == 3);
+		});
+	}
+	failures += ReadRandomFiles(0, /*streamed=*/false);
+	for (std::thread &thread : threads)
+		thread.join();
+
+	EXPECT_EQ(failures, 0);
+
+	diabdat_mpq = nullptr;
+	SFileCloseThreadArchives();
+	SFileCloseArchive(archive);
+	RemoveFile(archivePath);
+}
+
+TEST(Storm, ReleasedThreadArchives)
+{
+	const char *archivePath = "Test_Storm_ReleasedThreadArchives.mpq";
+	RemoveFile(archivePath);
+
+	ASSERT_TRUE(OpenMPQ(archivePath));
+	for (int i = 0; i < FileCount; i++) {
+		const std::vector<byte> data = GetFileContents(i);
+		ASSERT_TRUE(mpqapi_write_file(GetFileName(i).c_str(), data.data(), data.size()));
+	}
+	ASSERT_TRUE(mpqapi_flush_and_close(true));
+
+	HANDLE archive;
+	ASSERT_TRUE(SFileOpenSharedArchive(archivePath, &archive));
+	diabdat_mpq = archive;
+
+	// More threads than there are archive sets, each giving its set back when it is done
+	int failures = 0;
+	for (unsigned i = 0; i < 12; i++) {
+		std::thread thread([i, &failures]() {
+			failures += ReadRandomFiles(i + 1, /*streamed=*/false);
+			SFileReleaseThreadArchives();
+		});
+		thread.join();
+	}
+	EXPECT_EQ(failures, 0);
+
+	// A file handed to another thread stays readable after the thread that opened it has exited
+	HANDLE file = nullptr;
+	std::thread opener([&file]() {
+		SFileOpenFile(GetFileName(7).c_str(), &file);
+		SFileReleaseThreadArchives();
+	});
+	opener.join();
+	ASSERT_NE(file, nullptr);
+	std::vector<byte> contents(SFileGetFileSize(file));
+	EXPECT_TRUE(SFileReadFileThreadSafe(file, contents.data(), contents.size()));
+	SFileCloseFileThreadSafe(file);
+	EXPECT_EQ(contents, GetFileContents(7));
+
+	diabdat_mpq = nullptr;
+	SFileCloseThreadArchives();
+	SFileCloseArchive(archive);
+	RemoveFile(archivePath);
+}
+
+} // namespace
+} // namespace devilution
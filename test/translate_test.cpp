@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "engine/render/translate.hpp"
+
+namespace devilution {
+namespace {
+
+TEST(Translate, KernelsMatchTable)
+{
+	std::mt19937 rng(6);
+	std::uint8_t tbl[256];
+	const std::vector<TranslateKernel> kernels = SupportedTranslateKernels();
+	ASSERT_FALSE(kernels.empty());
+
+	for (int round = 0; round < 2000; round++) {
+		for (std::uint8_t &entry : tbl)
+			entry = static_cast<std::uint8_t>(rng());
+		const std::size_t n = rng() % 200;
+		const std::size_t offset = rng() % 32;
+		std::vector<std::uint8_t> src(offset + n);
+		for (std::uint8_t &pixel : src)
+			pixel = static_cast<std::uint8_t>(rng());
+
+		for (const TranslateKernel &kernel : kernels) {
+			std::vector<std::uint8_t> dst(offset + n + 1, 0xCD);
+			kernel.translate(&src[offset], &dst[offset], n, tbl);
+			for (std::size_t i = 0; i < n; i++)
+				ASSERT_EQ(dst[offset + i], tbl[src[offset + i]]) << kernel.name << " n " << n << " i " << i;
+			ASSERT_EQ(dst[offset + n], 0xCD) << kernel.name << " wrote past the end, n " << n;
+
+			// In place
+			std::vector<std::uint8_t> buffer = src;
+			kernel.translate(&buffer[offset], &buffer[offset], n, tbl);
+			for (std::size_t i = 0; i < n; i++)
+				ASSERT_EQ(buffer[offset + i], tbl[src[offset + i]]) << kernel.name << " in place, n " << n << " i " << i;
+		}
+	}
+}
+
+TEST(Translate, EveryIndex)
+{
+	std::uint8_t tbl[256];
+	std::uint8_t src[256];
+	for (int i = 0; i < 256; i++) {
+		tbl[i] = static_cast<std::uint8_t>(255 - i);
+		src[i] = static_cast<std::uint8_t>(i);
+	}
+	for (const TranslateKernel &kernel : SupportedTranslateKernels()) {
+		std::uint8_t dst[256];
+		kernel.translate(src, dst, 256, tbl);
+		for (int i = 0; i < 256; i++)
+			ASSERT_EQ(dst[i], 255 - i) << kernel.name;
+	}
+
+	std::uint8_t dst[256];
+	for (std::size_t n : { 0, 1, 15, 16, 31, 32, 33, 256 }) {
+		TranslatePixels(src, dst, n, tbl);
+		for (std::size_t i = 0; i < n; i++)
+			ASSERT_EQ(dst[i], 255 - i) << "n " << n;
+	}
+}
+
+} // namespace
+} // namespace devilution
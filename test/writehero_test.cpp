@@ -370,10 +370,11 @@ TEST(Writehero, pfile_write_hero)
 	UnPackPlayer(&pks, MyPlayerId, true);
 	AssertPlayer(Players[0]);
 	pfile_write_hero();
+	pfile_wait_for_save();
 
 	std::ifstream f("multi_0.sv", std::ios::binary);
 	std::vector<unsigned char> s(picosha2::k_digest_size);
 	picosha2::hash256(f, s.begin(), s.end());
 	EXPECT_EQ(picosha2::bytes_to_hex_string(s.begin(), s.end()),
-	    "08e9807d1281e4273268f4e265757b4429cfec7c3e8b6deb89dfa109d6797b1c");
+	    "6748ce86c0fea469cf119955cba3b35dfca34f9dad8588e2f974737cb3059d7e");
 }